@@ -2,6 +2,7 @@ import { NextRequest, NextResponse } from "next/server";
 import dbConnect from "@/lib/mongodb";
 import Employee from "@/models/Employee";
 import Attendance from "@/models/Attendance"; // Optional: to cascade delete if needed
+import { deleteTemplate } from "@/lib/templates";
 
 export async function GET(req: NextRequest) {
     await dbConnect();
@@ -64,6 +65,9 @@ export async function DELETE(req: NextRequest) {
             return NextResponse.json({ success: false, error: "Employee not found" }, { status: 404 });
         }
 
+        // Readers drop the fingerprint on their next template sync
+        await deleteTemplate(deleted.uid);
+
         return NextResponse.json({ success: true, message: "Employee deleted" });
     } catch (error) {
         return NextResponse.json({ success: false, error: "Failed to delete employee" }, { status: 500 });
@@ -2,7 +2,15 @@ import { NextRequest, NextResponse } from 'next/server';
 import dbConnect from '@/lib/mongodb';
 import Attendance from '@/models/Attendance';
 import Employee from '@/models/Employee';
-import { createBlockHash, getLastHash } from '@/lib/blockchain';
+import { appendToChain } from '@/lib/blockchain';
+
+const MAX_BATCH = 200;
+
+interface IngestEvent {
+    uid?: number;
+    timestamp?: string;
+    seq?: number; // record number on the device, see ingestBatch()
+}
 
 export async function POST(req: NextRequest) {
     try {
@@ -12,8 +20,29 @@ export async function POST(req: NextRequest) {
             return NextResponse.json({ error: 'Unauthorized' }, { status: 401 });
         }
 
+        // Compact snapshot of on-device metrics (firmware/src/Metrics.h),
+        // sent with uploads; only logged, the full set is on GET /metrics
+        const deviceMetrics = req.headers.get('x-device-metrics');
+        if (deviceMetrics) {
+            console.info('Device metrics:', deviceMetrics);
+        }
+
         // 2. Parse Body
         const body = await req.json();
+
+        // Batch from the device outbox: JSON array of { uid, timestamp, seq }
+        if (Array.isArray(body)) {
+            if (body.length === 0 || body.length > MAX_BATCH) {
+                return NextResponse.json(
+                    { error: `Batch must contain 1-${MAX_BATCH} events` },
+                    { status: 400 }
+                );
+            }
+            await dbConnect();
+            const device = req.headers.get('x-device-id') || undefined;
+            return NextResponse.json(await ingestBatch(body, device));
+        }
+
         const { uid, timestamp } = body;
 
         if (!uid) {
@@ -36,20 +65,16 @@ export async function POST(req: NextRequest) {
         const lastRecord = await Attendance.findOne({ uid }).sort({ timestamp: -1 });
         const newStatus = lastRecord && lastRecord.status === 'In' ? 'Out' : 'In';
 
-        // 5. Get previous hash and create new block hash
-        const previousHash = await getLastHash();
+        // 5. Append to the chain (links to the tail and hashes atomically)
         const recordTimestamp = timestamp ? new Date(timestamp) : new Date();
-        const hash = createBlockHash(uid, recordTimestamp, newStatus, previousHash);
-
-        // 6. Create Attendance Record with blockchain data
-        const attendance = await Attendance.create({
-            uid,
-            timestamp: recordTimestamp,
-            status: newStatus,
-            hash,
-            previousHash,
-            deviceAuthToken: 'ESP32_DEV_V1',
-        });
+        const [attendance] = await appendToChain([
+            {
+                uid: Number(uid),
+                timestamp: recordTimestamp,
+                status: newStatus,
+                deviceAuthToken: 'ESP32_DEV_V1',
+            },
+        ]);
 
         return NextResponse.json({
             message: 'Success',
@@ -66,3 +91,121 @@ export async function POST(req: NextRequest) {
         );
     }
 }
+
+/**
+ * Stores a batch with a fixed number of round trips: one employee query,
+ * one last-status query and one chain append (a tail read and an insert,
+ * shared with concurrent requests). Events are chained in timestamp order.
+ * Per-event results are returned in request order.
+ *
+ * A device that never got the reply to a batch sends it again. Events
+ * carrying a seq are keyed by (x-device-id, seq); those already stored are
+ * answered as duplicates and take no part in the status toggle.
+ */
+async function ingestBatch(events: IngestEvent[], device?: string) {
+    const results: object[] = new Array(events.length);
+
+    type Valid = { index: number; uid: number; timestamp: Date; deviceSeq?: number };
+    const valid: Valid[] = [];
+    const inBatch = new Set<number>();
+    events.forEach((event, index) => {
+        const uid = Number(event?.uid);
+        const timestamp = event?.timestamp ? new Date(event.timestamp) : new Date();
+        if (!uid || isNaN(timestamp.getTime())) {
+            results[index] = { uid: event?.uid ?? null, error: 'Invalid event' };
+            return;
+        }
+        const seq = Number(event.seq);
+        const deviceSeq = device && Number.isInteger(seq) && seq > 0 ? seq : undefined;
+        if (deviceSeq !== undefined) {
+            if (inBatch.has(deviceSeq)) {
+                results[index] = { uid, duplicate: true };
+                return;
+            }
+            inBatch.add(deviceSeq);
+        }
+        valid.push({ index, uid, timestamp, deviceSeq });
+    });
+
+    // 1. Events this device already delivered, in one query
+    const fresh: Valid[] = [];
+    if (inBatch.size > 0) {
+        const seen = await Attendance.find(
+            { device, deviceSeq: { $in: [...inBatch] } },
+            { deviceSeq: 1, status: 1, hash: 1 }
+        ).lean();
+        const stored = new Map(seen.map((r) => [r.deviceSeq, r]));
+        valid.forEach((e) => {
+            const r = e.deviceSeq !== undefined && stored.get(e.deviceSeq);
+            if (!r) {
+                fresh.push(e);
+                return;
+            }
+            results[e.index] = { uid: e.uid, duplicate: true, status: r.status, hash: r.hash };
+        });
+    } else {
+        fresh.push(...valid);
+    }
+
+    // 2. Known employees in one query
+    const uids = [...new Set(fresh.map((e) => e.uid))];
+    const employees = await Employee.find({ uid: { $in: uids } }, { uid: 1, name: 1 });
+    const names = new Map<number, string>(employees.map((e) => [e.uid, e.name]));
+
+    // 3. Latest status per uid in one query
+    const lastStatus = new Map<number, string>();
+    const latest = await Attendance.aggregate([
+        { $match: { uid: { $in: uids } } },
+        { $sort: { timestamp: -1 } },
+        { $group: { _id: '$uid', status: { $first: '$status' } } },
+    ]);
+    latest.forEach((r) => lastStatus.set(r._id, r.status));
+
+    // 4. Toggle status in time order
+    const ordered = fresh
+        .filter((e) => {
+            if (names.has(e.uid)) return true;
+            results[e.index] = { uid: e.uid, error: 'Employee not found' };
+            return false;
+        })
+        .sort((a, b) => a.timestamp.getTime() - b.timestamp.getTime() || a.index - b.index);
+
+    const entries = ordered.map((e) => {
+        const status: 'In' | 'Out' = lastStatus.get(e.uid) === 'In' ? 'Out' : 'In';
+        lastStatus.set(e.uid, status);
+        return {
+            uid: e.uid,
+            timestamp: e.timestamp,
+            status,
+            deviceAuthToken: 'ESP32_DEV_V1',
+            ...(e.deviceSeq !== undefined && { device, deviceSeq: e.deviceSeq }),
+        };
+    });
+
+    // 5. Single append. A resend racing the original comes back duplicate.
+    const blocks = await appendToChain(entries);
+    let stored = 0;
+    blocks.forEach((block, i) => {
+        const e = ordered[i];
+        if (block.duplicate) {
+            results[e.index] = { uid: e.uid, duplicate: true, status: block.status, hash: block.hash };
+            return;
+        }
+        stored++;
+        results[e.index] = {
+            uid: e.uid,
+            employee: names.get(e.uid),
+            status: block.status,
+            hash: block.hash,
+        };
+    });
+
+    const duplicates = results.filter((r) => (r as { duplicate?: boolean }).duplicate).length;
+    return {
+        message: 'Success',
+        stored,
+        duplicates,
+        rejected: events.length - stored - duplicates,
+        results,
+    };
+}
@@ -0,0 +1,202 @@
+import { NextRequest, NextResponse } from 'next/server';
+import dbConnect from '@/lib/mongodb';
+import Employee from '@/models/Employee';
+import Template from '@/models/Template';
+import {
+    TEMPLATE_CHUNK_BYTES,
+    TEMPLATE_MAX_BYTES,
+    crc32,
+    deleteTemplate,
+    publishTemplateVersion,
+} from '@/lib/templates';
+
+interface RouteContext {
+    params: Promise<{ uid: string }>;
+}
+
+function authorized(req: NextRequest) {
+    return req.headers.get('x-api-key') === process.env.HARDWARE_API_KEY;
+}
+
+async function parseUid(ctx: RouteContext) {
+    const uid = Number((await ctx.params).uid);
+    return Number.isInteger(uid) && uid > 0 ? uid : null;
+}
+
+/**
+ * One chunk of a stored template, hex encoded:
+ * GET /api/templates/7?offset=0&length=256
+ */
+export async function GET(req: NextRequest, ctx: RouteContext) {
+    try {
+        if (!authorized(req)) {
+            return NextResponse.json({ error: 'Unauthorized' }, { status: 401 });
+        }
+        const uid = await parseUid(ctx);
+        if (!uid) {
+            return NextResponse.json({ error: 'Invalid UID' }, { status: 400 });
+        }
+
+        const { searchParams } = new URL(req.url);
+        const offset = Math.max(0, Number(searchParams.get('offset')) || 0);
+        const length = Math.min(
+            TEMPLATE_CHUNK_BYTES,
+            Math.max(1, Number(searchParams.get('length')) || TEMPLATE_CHUNK_BYTES)
+        );
+
+        await dbConnect();
+        const template = await Template.findOne({ uid, deleted: false });
+        if (!template || !template.data) {
+            return NextResponse.json({ error: 'Template not found', uid }, { status: 404 });
+        }
+        if (offset >= template.size) {
+            return NextResponse.json({ error: 'Offset out of range' }, { status: 416 });
+        }
+
+        const chunk = template.data.subarray(offset, offset + length);
+        return NextResponse.json({
+            uid,
+            version: template.version,
+            crc: template.crc,
+            size: template.size,
+            offset,
+            data: chunk.toString('hex'),
+        });
+    } catch (error) {
+        console.error('Template Download Error:', error);
+        return NextResponse.json(
+            { error: 'Internal Server Error' },
+            { status: 500 }
+        );
+    }
+}
+
+/**
+ * Chunked, resumable upload: { crc, size, offset, data (hex) }.
+ * Chunks are appended to a staging buffer keyed by the template CRC; a
+ * chunk at the wrong offset is answered with 409 and the number of bytes
+ * already received, so the reader continues from there. The last chunk
+ * publishes the template under a new version.
+ */
+export async function POST(req: NextRequest, ctx: RouteContext) {
+    try {
+        if (!authorized(req)) {
+            return NextResponse.json({ error: 'Unauthorized' }, { status: 401 });
+        }
+        const uid = await parseUid(ctx);
+        if (!uid) {
+            return NextResponse.json({ error: 'Invalid UID' }, { status: 400 });
+        }
+
+        const body = await req.json();
+        const crc = Number(body?.crc) >>> 0;
+        const size = Number(body?.size);
+        const offset = Number(body?.offset);
+        const chunk = Buffer.from(typeof body?.data === 'string' ? body.data : '', 'hex');
+        if (
+            !Number.isInteger(size) || size <= 0 || size > TEMPLATE_MAX_BYTES ||
+            !Number.isInteger(offset) || offset < 0 ||
+            chunk.length === 0 || chunk.length > TEMPLATE_CHUNK_BYTES ||
+            offset + chunk.length > size
+        ) {
+            return NextResponse.json({ error: 'Invalid chunk' }, { status: 400 });
+        }
+
+        await dbConnect();
+
+        const employee = await Employee.findOne({ uid }, { _id: 1 });
+        if (!employee) {
+            return NextResponse.json({ error: 'Employee not found', uid }, { status: 404 });
+        }
+
+        const template = await Template.findOne({ uid });
+
+        // Same template already published (e.g. the reply to the last chunk was lost)
+        if (template && !template.deleted && template.crc === crc && template.size === size) {
+            return NextResponse.json({ received: size, version: template.version });
+        }
+
+        const staged =
+            template?.upload && template.upload.crc === crc && template.upload.size === size
+                ? template.upload.received
+                : Buffer.alloc(0);
+        if (offset !== staged.length) {
+            return NextResponse.json(
+                { error: 'Offset mismatch', received: staged.length },
+                { status: 409 }
+            );
+        }
+
+        const received = Buffer.concat([staged, chunk]);
+        if (received.length < size) {
+            // New uid: placeholder with version 0 stays out of the delta list
+            await Template.updateOne(
+                { uid },
+                {
+                    $set: { upload: { crc, size, received } },
+                    $setOnInsert: { version: 0, deleted: true },
+                },
+                { upsert: true }
+            );
+            return NextResponse.json({ received: received.length });
+        }
+
+        if (crc32(received) !== crc) {
+            await Template.updateOne({ uid }, { $unset: { upload: 1 } });
+            return NextResponse.json(
+                { error: 'CRC mismatch', received: 0 },
+                { status: 422 }
+            );
+        }
+
+        const version = await publishTemplateVersion((version) =>
+            Template.updateOne(
+                { uid },
+                {
+                    $set: {
+                        version,
+                        crc,
+                        size,
+                        data: received,
+                        deleted: false,
+                        updatedAt: new Date(),
+                    },
+                    $unset: { upload: 1 },
+                },
+                { upsert: true }
+            )
+        );
+        return NextResponse.json({ received: size, version });
+    } catch (error) {
+        console.error('Template Upload Error:', error);
+        return NextResponse.json(
+            { error: 'Internal Server Error' },
+            { status: 500 }
+        );
+    }
+}
+
+/**
+ * Removes the template from every reader on their next sync
+ */
+export async function DELETE(req: NextRequest, ctx: RouteContext) {
+    try {
+        if (!authorized(req)) {
+            return NextResponse.json({ error: 'Unauthorized' }, { status: 401 });
+        }
+        const uid = await parseUid(ctx);
+        if (!uid) {
+            return NextResponse.json({ error: 'Invalid UID' }, { status: 400 });
+        }
+        if (!(await deleteTemplate(uid))) {
+            return NextResponse.json({ error: 'Template not found', uid }, { status: 404 });
+        }
+        return NextResponse.json({ message: 'Deleted', uid });
+    } catch (error) {
+        console.error('Template Delete Error:', error);
+        return NextResponse.json(
+            { error: 'Internal Server Error' },
+            { status: 500 }
+        );
+    }
+}
@@ -0,0 +1,59 @@
+import { NextRequest, NextResponse } from 'next/server';
+import dbConnect from '@/lib/mongodb';
+import Template from '@/models/Template';
+import { visibleTemplateVersion } from '@/lib/templates';
+
+const DEFAULT_LIMIT = 50;
+const MAX_LIMIT = 200;
+
+/**
+ * Template changes after version `since`, oldest first. Readers apply
+ * them in order and continue with the last version they applied; the
+ * template bytes are fetched separately from /api/templates/[uid].
+ * Versions above one still being written are held back until it lands.
+ */
+export async function GET(req: NextRequest) {
+    try {
+        const apiKey = req.headers.get('x-api-key');
+        if (apiKey !== process.env.HARDWARE_API_KEY) {
+            return NextResponse.json({ error: 'Unauthorized' }, { status: 401 });
+        }
+
+        const { searchParams } = new URL(req.url);
+        const since = Math.max(0, Number(searchParams.get('since')) || 0);
+        const limit = Math.min(
+            MAX_LIMIT,
+            Math.max(1, Number(searchParams.get('limit')) || DEFAULT_LIMIT)
+        );
+
+        await dbConnect();
+
+        // One extra row tells whether another page follows
+        const visible = await visibleTemplateVersion();
+        const rows = await Template.find(
+            { version: { $gt: since, $lte: visible } },
+            { uid: 1, version: 1, crc: 1, size: 1, deleted: 1 }
+        )
+            .sort({ version: 1 })
+            .limit(limit + 1);
+
+        const page = rows.slice(0, limit);
+        return NextResponse.json({
+            version: page.length > 0 ? page[page.length - 1].version : since,
+            more: rows.length > limit,
+            templates: page.map((t) => ({
+                uid: t.uid,
+                version: t.version,
+                crc: t.crc,
+                size: t.size,
+                deleted: t.deleted,
+            })),
+        });
+    } catch (error) {
+        console.error('Template Sync Error:', error);
+        return NextResponse.json(
+            { error: 'Internal Server Error' },
+            { status: 500 }
+        );
+    }
+}
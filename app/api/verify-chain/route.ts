@@ -1,9 +1,11 @@
-import { NextResponse } from 'next/server';
+import { NextRequest, NextResponse } from 'next/server';
 import { verifyChain } from '@/lib/blockchain';
 
-export async function GET() {
+export async function GET(req: NextRequest) {
     try {
-        const result = await verifyChain();
+        // ?full=1 ignores the checkpoint and re-hashes from the genesis block
+        const full = req.nextUrl.searchParams.get('full') === '1';
+        const result = await verifyChain({ full });
 
         return NextResponse.json({
             ...result,
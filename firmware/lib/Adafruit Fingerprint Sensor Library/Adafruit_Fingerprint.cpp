@@ -35,13 +35,11 @@
  */
 #define GET_CMD_PACKET(...)                                                    \
   uint8_t data[] = {__VA_ARGS__};                                              \
-  Adafruit_Fingerprint_Packet packet(FINGERPRINT_COMMANDPACKET, sizeof(data),  \
-                                     data);                                    \
-  writeStructuredPacket(packet);                                               \
-  if (getStructuredPacket(&packet) != FINGERPRINT_OK)                          \
+  beginCommand(data, sizeof(data));                                            \
+  waitCommand();                                                               \
+  if (!rxAcked)                                                                \
     return FINGERPRINT_PACKETRECIEVEERR;                                       \
-  if (packet.type != FINGERPRINT_ACKPACKET)                                    \
-    return FINGERPRINT_PACKETRECIEVEERR;
+  Adafruit_Fingerprint_Packet &packet = rxPacket;
 
 /*!
  * @brief Sends the command packet
@@ -195,7 +193,8 @@ uint8_t Adafruit_Fingerprint::getParameters(void) {
 */
 /**************************************************************************/
 uint8_t Adafruit_Fingerprint::getImage(void) {
-  SEND_CMD_PACKET(FINGERPRINT_GETIMAGE);
+  beginGetImage();
+  return waitCommand();
 }
 
 /**************************************************************************/
@@ -212,7 +211,8 @@ uint8_t Adafruit_Fingerprint::getImage(void) {
    fingerprint features
 */
 uint8_t Adafruit_Fingerprint::image2Tz(uint8_t slot) {
-  SEND_CMD_PACKET(FINGERPRINT_IMAGE2TZ, slot);
+  beginImage2Tz(slot);
+  return waitCommand();
 }
 
 /**************************************************************************/
@@ -238,7 +238,22 @@ uint8_t Adafruit_Fingerprint::createModel(void) {
     @returns <code>FINGERPRINT_PACKETRECIEVEERR</code> on communication error
 */
 uint8_t Adafruit_Fingerprint::storeModel(uint16_t location) {
-  SEND_CMD_PACKET(FINGERPRINT_STORE, 0x01, (uint8_t)(location >> 8),
+  return storeModel(location, 1);
+}
+
+/**************************************************************************/
+/*!
+    @brief   Ask the sensor to store the template in a character buffer
+    @param   location The model location #
+    @param   slot Character buffer to store (1 or 2)
+    @returns <code>FINGERPRINT_OK</code> on success
+    @returns <code>FINGERPRINT_BADLOCATION</code> if the location is invalid
+    @returns <code>FINGERPRINT_FLASHERR</code> if the model couldn't be written
+   to flash memory
+    @returns <code>FINGERPRINT_PACKETRECIEVEERR</code> on communication error
+*/
+uint8_t Adafruit_Fingerprint::storeModel(uint16_t location, uint8_t slot) {
+  SEND_CMD_PACKET(FINGERPRINT_STORE, slot, (uint8_t)(location >> 8),
                   (uint8_t)(location & 0xFF));
 }
 
@@ -251,7 +266,21 @@ uint8_t Adafruit_Fingerprint::storeModel(uint16_t location) {
     @returns <code>FINGERPRINT_PACKETRECIEVEERR</code> on communication error
 */
 uint8_t Adafruit_Fingerprint::loadModel(uint16_t location) {
-  SEND_CMD_PACKET(FINGERPRINT_LOAD, 0x01, (uint8_t)(location >> 8),
+  return loadModel(location, 1);
+}
+
+/**************************************************************************/
+/*!
+    @brief   Ask the sensor to load a fingerprint model from flash into a
+   character buffer
+    @param   location The model location #
+    @param   slot Character buffer to load into (1 or 2)
+    @returns <code>FINGERPRINT_OK</code> on success
+    @returns <code>FINGERPRINT_BADLOCATION</code> if the location is invalid
+    @returns <code>FINGERPRINT_PACKETRECIEVEERR</code> on communication error
+*/
+uint8_t Adafruit_Fingerprint::loadModel(uint16_t location, uint8_t slot) {
+  SEND_CMD_PACKET(FINGERPRINT_LOAD, slot, (uint8_t)(location >> 8),
                   (uint8_t)(location & 0xFF));
 }
 
@@ -266,6 +295,94 @@ uint8_t Adafruit_Fingerprint::getModel(void) {
   SEND_CMD_PACKET(FINGERPRINT_UPLOAD, 0x01);
 }
 
+/**************************************************************************/
+/*!
+    @brief   Transfer the template in a character buffer to the host,
+   collecting all the data packets that follow the acknowledge
+    @param   buf Where to put the template
+    @param   len Expected template size (512 bytes for the AS608)
+    @param   slot Character buffer to read (1 or 2)
+    @returns <code>FINGERPRINT_OK</code> on success
+    @returns <code>FINGERPRINT_PACKETRECIEVEERR</code> on communication error
+   or if the template is not exactly len bytes
+*/
+uint8_t Adafruit_Fingerprint::readModel(uint8_t *buf, uint16_t len,
+                                        uint8_t slot) {
+  uint8_t cmd[] = {FINGERPRINT_UPLOAD, slot};
+  beginCommand(cmd, sizeof(cmd));
+  uint8_t r = waitCommand();
+  if (r != FINGERPRINT_OK)
+    return r;
+
+  uint16_t got = 0;
+  while (true) {
+    if (getStructuredPacket(&rxPacket) != FINGERPRINT_OK)
+      return FINGERPRINT_PACKETRECIEVEERR;
+    if (rxPacket.type != FINGERPRINT_DATAPACKET &&
+        rxPacket.type != FINGERPRINT_ENDDATAPACKET)
+      return FINGERPRINT_PACKETRECIEVEERR;
+
+    uint16_t n = rxPacket.length - 2;
+    if (got + n > len)
+      return FINGERPRINT_PACKETRECIEVEERR;
+    memcpy(buf + got, rxPacket.data, n);
+    got += n;
+
+    if (rxPacket.type == FINGERPRINT_ENDDATAPACKET)
+      return (got == len) ? FINGERPRINT_OK : FINGERPRINT_PACKETRECIEVEERR;
+  }
+}
+
+/**************************************************************************/
+/*!
+    @brief   Transfer a template from the host into a character buffer, in
+   data packets of packet_len bytes (call getParameters() first)
+    @param   buf The template
+    @param   len Template size
+    @param   slot Character buffer to fill (1 or 2)
+    @returns <code>FINGERPRINT_OK</code> on success
+    @returns <code>FINGERPRINT_PACKETRECIEVEERR</code> on communication error
+*/
+uint8_t Adafruit_Fingerprint::writeModel(const uint8_t *buf, uint16_t len,
+                                         uint8_t slot) {
+  uint8_t cmd[] = {FINGERPRINT_DOWNLOAD, slot};
+  beginCommand(cmd, sizeof(cmd));
+  uint8_t r = waitCommand();
+  if (r != FINGERPRINT_OK)
+    return r;
+
+  uint16_t chunk = packet_len;
+  if (chunk == 0 || chunk > FINGERPRINT_MAX_PAYLOAD)
+    chunk = 128;
+  for (uint16_t off = 0; off < len; off += chunk) {
+    uint16_t n = (len - off < chunk) ? (len - off) : chunk;
+    bool last = (off + n) >= len;
+    Adafruit_Fingerprint_Packet packet(
+        last ? FINGERPRINT_ENDDATAPACKET : FINGERPRINT_DATAPACKET, n,
+        (uint8_t *)buf + off);
+    writeStructuredPacket(packet);
+  }
+  return FINGERPRINT_OK;
+}
+
+/**************************************************************************/
+/*!
+    @brief   Ask the sensor to compare the templates in character buffers 1
+   and 2. The match score is stored in <b>confidence</b>
+    @returns <code>FINGERPRINT_OK</code> if the templates match
+    @returns <code>FINGERPRINT_NOMATCH</code> if they do not
+    @returns <code>FINGERPRINT_PACKETRECIEVEERR</code> on communication error
+*/
+uint8_t Adafruit_Fingerprint::matchModels(void) {
+  GET_CMD_PACKET(FINGERPRINT_MATCH);
+
+  confidence = packet.data[1];
+  confidence <<= 8;
+  confidence |= packet.data[2];
+
+  return packet.data[0];
+}
+
 /**************************************************************************/
 /*!
     @brief   Ask the sensor to delete a model in memory
@@ -305,20 +422,9 @@ uint8_t Adafruit_Fingerprint::emptyDatabase(void) {
 */
 /**************************************************************************/
 uint8_t Adafruit_Fingerprint::fingerFastSearch(void) {
-  // high speed search of slot #1 starting at page 0x0000 and page #0x00A3
-  GET_CMD_PACKET(FINGERPRINT_HISPEEDSEARCH, 0x01, 0x00, 0x00, 0x00, 0xA3);
-  fingerID = 0xFFFF;
-  confidence = 0xFFFF;
-
-  fingerID = packet.data[1];
-  fingerID <<= 8;
-  fingerID |= packet.data[2];
-
-  confidence = packet.data[3];
-  confidence <<= 8;
-  confidence |= packet.data[4];
-
-  return packet.data[0];
+  // fingerID and confidence are filled in by finishCommand()
+  beginFingerFastSearch();
+  return waitCommand();
 }
 
 /**************************************************************************/
@@ -366,22 +472,8 @@ uint8_t Adafruit_Fingerprint::LEDcontrol(uint8_t control, uint8_t speed,
 */
 /**************************************************************************/
 uint8_t Adafruit_Fingerprint::fingerSearch(uint8_t slot) {
-  // search of slot starting thru the capacity
-  GET_CMD_PACKET(FINGERPRINT_SEARCH, slot, 0x00, 0x00, (uint8_t)(capacity >> 8),
-                 (uint8_t)(capacity & 0xFF));
-
-  fingerID = 0xFFFF;
-  confidence = 0xFFFF;
-
-  fingerID = packet.data[1];
-  fingerID <<= 8;
-  fingerID |= packet.data[2];
-
-  confidence = packet.data[3];
-  confidence <<= 8;
-  confidence |= packet.data[4];
-
-  return packet.data[0];
+  beginFingerSearch(slot);
+  return waitCommand();
 }
 
 /**************************************************************************/
@@ -515,7 +607,7 @@ void Adafruit_Fingerprint::writeStructuredPacket(
 #endif
 
   uint16_t sum = ((wire_length) >> 8) + ((wire_length)&0xFF) + packet.type;
-  for (uint8_t i = 0; i < packet.length; i++) {
+  for (uint16_t i = 0; i < packet.length; i++) {
     mySerial->write(packet.data[i]);
     sum += packet.data[i];
 #ifdef FINGERPRINT_DEBUG
@@ -544,78 +636,335 @@ void Adafruit_Fingerprint::writeStructuredPacket(
     @param   packet A structure containing the bytes received
     @param   timeout how many milliseconds we're willing to wait
     @returns <code>FINGERPRINT_OK</code> on success
-    @returns <code>FINGERPRINT_TIMEOUT</code> or
-   <code>FINGERPRINT_BADPACKET</code> on failure
+    @returns <code>FINGERPRINT_TIMEOUT</code> if no valid packet arrives in
+   time
 */
 /**************************************************************************/
 uint8_t
 Adafruit_Fingerprint::getStructuredPacket(Adafruit_Fingerprint_Packet *packet,
                                           uint16_t timeout) {
-  uint8_t byte;
-  uint16_t idx = 0, timer = 0;
+  uint32_t start = millis();
+  rxIdx = 0;
 
 #ifdef FINGERPRINT_DEBUG
   Serial.print("<- ");
 #endif
 
   while (true) {
-    while (!mySerial->available()) {
-      delay(1);
-      timer++;
-      if (timer >= timeout) {
-#ifdef FINGERPRINT_DEBUG
-        Serial.println("Timed out");
-#endif
-        return FINGERPRINT_TIMEOUT;
-      }
+    while (mySerial->available()) {
+      uint8_t r = parseByte(packet, mySerial->read());
+      if (r != FINGERPRINT_BUSY)
+        return r;
     }
-    byte = mySerial->read();
+    if ((uint32_t)(millis() - start) >= timeout) {
 #ifdef FINGERPRINT_DEBUG
-    Serial.print("0x");
-    Serial.print(byte, HEX);
-    Serial.print(", ");
+      Serial.println("Timed out");
 #endif
-    switch (idx) {
-    case 0:
-      if (byte != (FINGERPRINT_STARTCODE >> 8))
-        continue;
-      packet->start_code = (uint16_t)byte << 8;
-      break;
-    case 1:
-      packet->start_code |= byte;
-      if (packet->start_code != FINGERPRINT_STARTCODE)
-        return FINGERPRINT_BADPACKET;
-      break;
-    case 2:
-    case 3:
-    case 4:
-    case 5:
-      packet->address[idx - 2] = byte;
-      break;
-    case 6:
-      packet->type = byte;
-      break;
-    case 7:
-      packet->length = (uint16_t)byte << 8;
-      break;
-    case 8:
-      packet->length |= byte;
-      break;
-    default:
-      packet->data[idx - 9] = byte;
-      if ((idx - 8) == packet->length) {
+      return FINGERPRINT_TIMEOUT;
+    }
+    delay(1);
+  }
+}
+
+/**************************************************************************/
+/*!
+    @brief   Feed one received byte to the packet state machine. Bytes before
+   a start code are skipped, and a frame with a bad length or checksum is
+   dropped and the search for the next start code resumes, so line noise
+   between or inside packets is tolerated.
+    @param   packet A structure containing the bytes received so far
+    @param   byte The byte read from the UART
+    @returns <code>FINGERPRINT_BUSY</code> if no valid packet is complete yet
+    @returns <code>FINGERPRINT_OK</code> when a packet with a valid checksum
+   is complete
+*/
+/**************************************************************************/
+uint8_t Adafruit_Fingerprint::parseByte(Adafruit_Fingerprint_Packet *packet,
+                                        uint8_t byte) {
+  uint8_t r = parseFrameByte(packet, byte);
+  return (r == FINGERPRINT_BADPACKET) ? resync(packet) : r;
+}
+
+/**************************************************************************/
+/*!
+    @brief   Number of wire bytes, start code included, of the frame the
+   receiver just rejected
+    @param   packet The rejected frame
+*/
+/**************************************************************************/
+static uint16_t rejectedLength(const Adafruit_Fingerprint_Packet &packet) {
+  // A bad length is rejected right after the 9 header bytes
+  if (packet.length < 2 || packet.length > sizeof(packet.data))
+    return 9;
+  return 9 + packet.length;
+}
+
+/**************************************************************************/
+/*!
+    @brief   Recover from a rejected frame. Its start code may have been noise
+   that happened to read 0xEF01, with the real packet starting somewhere in
+   the bytes already consumed, so those are scanned again from the byte after
+   the rejected start code.
+    @param   packet The rejected frame, reused for the next one
+    @returns <code>FINGERPRINT_OK</code> if a valid packet ends inside the
+   replayed bytes (any bytes after it are dropped)
+    @returns <code>FINGERPRINT_BUSY</code> otherwise, with the receiver
+   positioned inside the next partial frame if there is one
+*/
+/**************************************************************************/
+uint8_t Adafruit_Fingerprint::resync(Adafruit_Fingerprint_Packet *packet) {
+  uint8_t raw[9 + sizeof(packet->data)];
+  uint16_t n = rejectedLength(*packet);
+  raw[0] = packet->start_code >> 8;
+  raw[1] = packet->start_code & 0xFF;
+  memcpy(raw + 2, packet->address, 4);
+  raw[6] = packet->type;
+  raw[7] = packet->length >> 8;
+  raw[8] = packet->length & 0xFF;
+  memcpy(raw + 9, packet->data, n - 9);
+
+  rxIdx = 0;
+  for (uint16_t i = 1; i < n; i++) {
+    uint8_t r = parseFrameByte(packet, raw[i]);
+    if (r == FINGERPRINT_OK)
+      return r;
+    // Rejected again: that frame started inside raw, go on from the byte
+    // after its start code
+    if (r == FINGERPRINT_BADPACKET)
+      i -= rejectedLength(*packet) - 1;
+  }
+  return FINGERPRINT_BUSY;
+}
+
+/**************************************************************************/
+/*!
+    @brief   One step of the packet state machine, see parseByte()
+    @param   packet A structure containing the bytes received so far
+    @param   byte The byte read from the UART
+    @returns <code>FINGERPRINT_BUSY</code> if the packet is not complete yet
+    @returns <code>FINGERPRINT_OK</code> when a packet with a valid checksum
+   is complete
+    @returns <code>FINGERPRINT_BADPACKET</code> on a bad length or checksum
+*/
+/**************************************************************************/
+uint8_t
+Adafruit_Fingerprint::parseFrameByte(Adafruit_Fingerprint_Packet *packet,
+                                     uint8_t byte) {
 #ifdef FINGERPRINT_DEBUG
-        Serial.println(" OK ");
+  Serial.print("0x");
+  Serial.print(byte, HEX);
+  Serial.print(", ");
 #endif
-        return FINGERPRINT_OK;
-      }
-      break;
+  switch (rxIdx) {
+  case 0:
+    if (byte != (FINGERPRINT_STARTCODE >> 8))
+      return FINGERPRINT_BUSY;
+    packet->start_code = (uint16_t)byte << 8;
+    break;
+  case 1:
+    if (byte != (FINGERPRINT_STARTCODE & 0xFF)) {
+      // Not a start code after all, this byte may begin the real one
+      rxIdx = (byte == (FINGERPRINT_STARTCODE >> 8)) ? 1 : 0;
+      return FINGERPRINT_BUSY;
     }
-    idx++;
-    if ((idx + 9) >= sizeof(packet->data)) {
+    packet->start_code |= byte;
+    break;
+  case 2:
+  case 3:
+  case 4:
+  case 5:
+    packet->address[rxIdx - 2] = byte;
+    break;
+  case 6:
+    packet->type = byte;
+    rxSum = byte;
+    break;
+  case 7:
+    packet->length = (uint16_t)byte << 8;
+    rxSum += byte;
+    break;
+  case 8:
+    packet->length |= byte;
+    rxSum += byte;
+    // Length covers the payload plus the 2 checksum bytes
+    if (packet->length < 2 || packet->length > sizeof(packet->data)) {
+      rxIdx = 0;
       return FINGERPRINT_BADPACKET;
     }
+    break;
+  default:
+    packet->data[rxIdx - 9] = byte;
+    if ((rxIdx - 9) < (packet->length - 2))
+      rxSum += byte;
+    if ((rxIdx - 8) == packet->length) {
+      uint16_t sum = ((uint16_t)packet->data[packet->length - 2] << 8) |
+                     packet->data[packet->length - 1];
+      rxIdx = 0;
+#ifdef FINGERPRINT_DEBUG
+      Serial.println(sum == rxSum ? " OK " : " BAD CHECKSUM ");
+#endif
+      return (sum == rxSum) ? FINGERPRINT_OK : FINGERPRINT_BADPACKET;
+    }
+    break;
+  }
+  rxIdx++;
+  return FINGERPRINT_BUSY;
+}
+
+/**************************************************************************/
+/*!
+    @brief   Send a command packet and return without waiting for the reply.
+   Any command still in flight is abandoned.
+    @param   cmd Instruction code followed by its parameters
+    @param   len Number of bytes in cmd
+    @param   timeout how many milliseconds poll() waits for the reply
+    @returns <code>FINGERPRINT_OK</code>
+*/
+/**************************************************************************/
+uint8_t Adafruit_Fingerprint::beginCommand(const uint8_t *cmd, uint8_t len,
+                                           uint16_t timeout) {
+  // Drop whatever is left of an earlier, abandoned reply
+  while (mySerial->available())
+    mySerial->read();
+
+  Adafruit_Fingerprint_Packet packet(FINGERPRINT_COMMANDPACKET, len,
+                                     (uint8_t *)cmd);
+  writeStructuredPacket(packet);
+
+  rxIdx = 0;
+  rxCommand = cmd[0];
+  rxTimeout = timeout;
+  rxStart = millis();
+  rxAcked = false;
+  rxResult = FINGERPRINT_BUSY;
+  rxActive = true;
+  return FINGERPRINT_OK;
+}
+
+/**************************************************************************/
+/*!
+    @brief   Start getImage() without waiting for the reply
+    @returns <code>FINGERPRINT_OK</code>
+*/
+/**************************************************************************/
+uint8_t Adafruit_Fingerprint::beginGetImage(void) {
+  uint8_t cmd[] = {FINGERPRINT_GETIMAGE};
+  return beginCommand(cmd, sizeof(cmd));
+}
+
+/**************************************************************************/
+/*!
+    @brief   Start image2Tz() without waiting for the reply
+    @param   slot Location to place feature template
+    @returns <code>FINGERPRINT_OK</code>
+*/
+/**************************************************************************/
+uint8_t Adafruit_Fingerprint::beginImage2Tz(uint8_t slot) {
+  uint8_t cmd[] = {FINGERPRINT_IMAGE2TZ, slot};
+  return beginCommand(cmd, sizeof(cmd));
+}
+
+/**************************************************************************/
+/*!
+    @brief   Start fingerFastSearch() without waiting for the reply
+    @returns <code>FINGERPRINT_OK</code>
+*/
+/**************************************************************************/
+uint8_t Adafruit_Fingerprint::beginFingerFastSearch(void) {
+  // high speed search of slot #1 starting at page 0x0000 and page #0x00A3
+  uint8_t cmd[] = {FINGERPRINT_HISPEEDSEARCH, 0x01, 0x00, 0x00, 0x00, 0xA3};
+  return beginCommand(cmd, sizeof(cmd));
+}
+
+/**************************************************************************/
+/*!
+    @brief   Start fingerSearch() without waiting for the reply
+    @param   slot The slot to use for the print search
+    @returns <code>FINGERPRINT_OK</code>
+*/
+/**************************************************************************/
+uint8_t Adafruit_Fingerprint::beginFingerSearch(uint8_t slot) {
+  // search of slot starting thru the capacity
+  uint8_t cmd[] = {FINGERPRINT_SEARCH, slot, 0x00, 0x00,
+                   (uint8_t)(capacity >> 8), (uint8_t)(capacity & 0xFF)};
+  return beginCommand(cmd, sizeof(cmd));
+}
+
+/**************************************************************************/
+/*!
+    @brief   Consume any received bytes of the command in flight. Never
+   blocks.
+    @returns <code>FINGERPRINT_BUSY</code> while the reply is incomplete
+    @returns the result the blocking method would return once done, or
+   <code>FINGERPRINT_PACKETRECIEVEERR</code> if no valid acknowledge packet
+   arrives before the timeout. Corrupt frames are skipped, see parseByte()
+*/
+/**************************************************************************/
+uint8_t Adafruit_Fingerprint::poll(void) {
+  if (!rxActive)
+    return rxResult;
+
+  while (mySerial->available()) {
+    uint8_t r = parseByte(&rxPacket, mySerial->read());
+    if (r == FINGERPRINT_BUSY)
+      continue;
+    finishCommand(r);
+    return rxResult;
+  }
+
+  if ((uint32_t)(millis() - rxStart) >= rxTimeout)
+    finishCommand(FINGERPRINT_TIMEOUT);
+  return rxResult;
+}
+
+/**************************************************************************/
+/*!
+    @brief   Block until the command in flight completes
+    @returns the same value as poll() once it is no longer busy
+*/
+/**************************************************************************/
+uint8_t Adafruit_Fingerprint::waitCommand(void) {
+  uint8_t r;
+  while ((r = poll()) == FINGERPRINT_BUSY)
+    delay(1);
+  return r;
+}
+
+/**************************************************************************/
+/*!
+    @brief   Forget the command in flight, a late reply is discarded by the
+   next beginCommand()
+*/
+/**************************************************************************/
+void Adafruit_Fingerprint::abortCommand(void) {
+  if (rxActive)
+    finishCommand(FINGERPRINT_TIMEOUT);
+}
+
+/**************************************************************************/
+/*!
+    @brief   Complete the command in flight and decode its reply
+    @param   status Result of the packet receiver
+*/
+/**************************************************************************/
+void Adafruit_Fingerprint::finishCommand(uint8_t status) {
+  rxActive = false;
+  rxAcked = (status == FINGERPRINT_OK) &&
+            (rxPacket.type == FINGERPRINT_ACKPACKET);
+  if (!rxAcked) {
+    rxResult = FINGERPRINT_PACKETRECIEVEERR;
+    return;
+  }
+  rxResult = rxPacket.data[0];
+
+  if (rxCommand == FINGERPRINT_HISPEEDSEARCH ||
+      rxCommand == FINGERPRINT_SEARCH) {
+    fingerID = rxPacket.data[1];
+    fingerID <<= 8;
+    fingerID |= rxPacket.data[2];
+
+    confidence = rxPacket.data[3];
+    confidence <<= 8;
+    confidence |= rxPacket.data[4];
   }
-  // Shouldn't get here so...
-  return FINGERPRINT_BADPACKET;
 }
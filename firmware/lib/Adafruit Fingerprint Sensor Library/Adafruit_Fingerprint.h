@@ -56,15 +56,18 @@
 
 #define FINGERPRINT_TIMEOUT 0xFF   //!< Timeout was reached
 #define FINGERPRINT_BADPACKET 0xFE //!< Bad packet was sent
+#define FINGERPRINT_BUSY 0xFD      //!< Async command still waiting for reply
 
 #define FINGERPRINT_GETIMAGE 0x01 //!< Collect finger image
 #define FINGERPRINT_IMAGE2TZ 0x02 //!< Generate character file from image
+#define FINGERPRINT_MATCH 0x03    //!< Compare character buffers 1 and 2
 #define FINGERPRINT_SEARCH 0x04   //!< Search for fingerprint in slot
 #define FINGERPRINT_REGMODEL                                                   \
   0x05 //!< Combine character files and generate template
 #define FINGERPRINT_STORE 0x06          //!< Store template
 #define FINGERPRINT_LOAD 0x07           //!< Read/load template
 #define FINGERPRINT_UPLOAD 0x08         //!< Upload template
+#define FINGERPRINT_DOWNLOAD 0x09       //!< Download template to buffer
 #define FINGERPRINT_DELETE 0x0C         //!< Delete templates
 #define FINGERPRINT_EMPTY 0x0D          //!< Empty library
 #define FINGERPRINT_READSYSPARAM 0x0F   //!< Read system parameters
@@ -124,6 +127,8 @@
 //#define FINGERPRINT_DEBUG
 
 #define DEFAULTTIMEOUT 1000 //!< UART reading timeout in milliseconds
+#define FINGERPRINT_MAX_PAYLOAD                                                \
+  256 //!< Largest data packet the sensor can be set to (packet size register)
 
 ///! Helper class to craft UART packets
 struct Adafruit_Fingerprint_Packet {
@@ -146,16 +151,16 @@ struct Adafruit_Fingerprint_Packet {
     address[1] = 0xFF;
     address[2] = 0xFF;
     address[3] = 0xFF;
-    if (length < 64)
+    if (length < sizeof(this->data))
       memcpy(this->data, data, length);
     else
-      memcpy(this->data, data, 64);
+      memcpy(this->data, data, sizeof(this->data));
   }
   uint16_t start_code; ///< "Wakeup" code for packet detection
   uint8_t address[4];  ///< 32-bit Fingerprint sensor address
   uint8_t type;        ///< Type of packet
   uint16_t length;     ///< Length of packet
-  uint8_t data[64];    ///< The raw buffer for packet payload
+  uint8_t data[FINGERPRINT_MAX_PAYLOAD + 2]; ///< Payload plus checksum
 };
 
 ///! Helper class to communicate with and keep state for fingerprint sensors
@@ -178,8 +183,13 @@ public:
 
   uint8_t emptyDatabase(void);
   uint8_t storeModel(uint16_t id);
+  uint8_t storeModel(uint16_t id, uint8_t slot);
   uint8_t loadModel(uint16_t id);
+  uint8_t loadModel(uint16_t id, uint8_t slot);
   uint8_t getModel(void);
+  uint8_t readModel(uint8_t *buf, uint16_t len, uint8_t slot = 1);
+  uint8_t writeModel(const uint8_t *buf, uint16_t len, uint8_t slot = 1);
+  uint8_t matchModels(void);
   uint8_t deleteModel(uint16_t id);
   uint8_t fingerFastSearch(void);
   uint8_t fingerSearch(uint8_t slot = 1);
@@ -197,6 +207,23 @@ public:
   uint8_t getStructuredPacket(Adafruit_Fingerprint_Packet *p,
                               uint16_t timeout = DEFAULTTIMEOUT);
 
+  // Non-blocking interface: start a command, then call poll() until it
+  // returns something other than FINGERPRINT_BUSY. The result is the same
+  // value the blocking method returns.
+  uint8_t beginCommand(const uint8_t *cmd, uint8_t len,
+                       uint16_t timeout = DEFAULTTIMEOUT);
+  uint8_t beginGetImage(void);
+  uint8_t beginImage2Tz(uint8_t slot = 1);
+  uint8_t beginFingerFastSearch(void);
+  uint8_t beginFingerSearch(uint8_t slot = 1);
+  uint8_t poll(void);
+  uint8_t waitCommand(void);
+  void abortCommand(void);
+  /// True while an async command is waiting for its reply
+  bool busy(void) { return rxActive; }
+  /// The acknowledge packet of the last completed command
+  const Adafruit_Fingerprint_Packet &reply(void) { return rxPacket; }
+
   /// The matching location that is set by fingerFastSearch()
   uint16_t fingerID;
   /// The confidence of the fingerFastSearch() match, higher numbers are more
@@ -217,10 +244,26 @@ public:
 private:
   uint8_t checkPassword(void);
   uint8_t writeRegister(uint8_t regAdd, uint8_t value);
+  uint8_t parseByte(Adafruit_Fingerprint_Packet *packet, uint8_t byte);
+  uint8_t parseFrameByte(Adafruit_Fingerprint_Packet *packet, uint8_t byte);
+  uint8_t resync(Adafruit_Fingerprint_Packet *packet);
+  void finishCommand(uint8_t status);
   uint32_t thePassword;
   uint32_t theAddress;
   uint8_t recvPacket[20];
 
+  // Receive state machine, shared by the blocking and async paths
+  Adafruit_Fingerprint_Packet rxPacket =
+      Adafruit_Fingerprint_Packet(FINGERPRINT_ACKPACKET, 0, recvPacket);
+  uint16_t rxIdx = 0;     ///< Bytes of the current packet consumed
+  uint16_t rxSum = 0;     ///< Running checksum
+  bool rxActive = false;  ///< Async command in flight
+  bool rxAcked = false;   ///< Last command got a valid acknowledge packet
+  uint8_t rxCommand = 0;  ///< Instruction code of the command in flight
+  uint8_t rxResult = FINGERPRINT_PACKETRECIEVEERR;
+  uint16_t rxTimeout = DEFAULTTIMEOUT;
+  uint32_t rxStart = 0;
+
   Stream *mySerial;
 #if defined(__AVR__) || defined(ESP8266) || defined(FREEDOM_E300_HIFIVE1)
   SoftwareSerial *swSerial;
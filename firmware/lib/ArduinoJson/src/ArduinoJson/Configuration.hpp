@@ -145,6 +145,19 @@
 #  endif
 #endif
 
+// Index the string pool with a hash table, so that deduplicating a string
+// costs O(1) instead of a scan of every string already in the document.
+// Adds 4 bytes per string and a small bucket array to each document.
+#ifndef ARDUINOJSON_STRING_POOL_HASH
+#  define ARDUINOJSON_STRING_POOL_HASH 0
+#endif
+
+// Initial bucket count of the string pool index (power of two, stored
+// inside the document; larger tables go through the allocator)
+#ifndef ARDUINOJSON_STRING_POOL_INITIAL_BUCKETS
+#  define ARDUINOJSON_STRING_POOL_INITIAL_BUCKETS 8
+#endif
+
 #ifdef ARDUINO
 
 // Enable support for Arduino's String class
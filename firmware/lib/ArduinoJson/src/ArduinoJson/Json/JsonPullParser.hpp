@@ -0,0 +1,577 @@
+// ArduinoJson - https://arduinojson.org
+// Copyright © 2014-2025, Benoit BLANCHON
+// MIT License
+
+#pragma once
+
+#include <ArduinoJson/Deserialization/DeserializationError.hpp>
+#include <ArduinoJson/Deserialization/Reader.hpp>
+#include <ArduinoJson/Document/JsonDocument.hpp>
+#include <ArduinoJson/Json/EscapeSequence.hpp>
+#include <ArduinoJson/Json/Latch.hpp>
+#include <ArduinoJson/Json/Utf16.hpp>
+#include <ArduinoJson/Json/Utf8.hpp>
+#include <ArduinoJson/Numbers/parseNumber.hpp>
+#include <ArduinoJson/Polyfills/utility.hpp>
+
+ARDUINOJSON_BEGIN_PUBLIC_NAMESPACE
+
+enum class JsonToken : uint8_t {
+  None,  // next() not called yet
+  ObjectStart,
+  ObjectEnd,
+  ArrayStart,
+  ArrayEnd,
+  Key,  // str() is the member name, the value comes next
+  String,
+  Number,
+  Boolean,
+  Null,
+  End,    // the top-level value is complete
+  Error,  // see error()
+};
+
+// Reads JSON one token at a time, from any input deserializeJson() takes,
+// without building a document. It only holds the reader, a 32-level
+// nesting stack and an N-byte buffer for the current key, string or number,
+// so memory use does not depend on the input. Strings longer than N - 1
+// bytes are truncated (see truncated()); read() fails with NoMemory rather
+// than store a truncated key or string.
+//
+//   auto parser = makeJsonPullParser(stream);
+//   parser.next();  // ArrayStart
+//   while (parser.next() == JsonToken::ObjectStart) {
+//     JsonDocument item;
+//     parser.read(item);  // one element at a time
+//   }
+template <typename TReader, size_t N = 64>
+class JsonPullParser {
+  static_assert(N >= 2, "the buffer needs room for one char");
+
+ public:
+  static const uint8_t maxDepth = 32;
+
+  explicit JsonPullParser(TReader reader) : latch_(reader) {}
+
+  // Advance to the next token. After End or Error, keeps returning it.
+  JsonToken next() {
+    if (token_ == JsonToken::End || token_ == JsonToken::Error)
+      return token_;
+    // Don't touch the reader after the last value: a Stream would block
+    if (state_ == Done)
+      return token_ = JsonToken::End;
+
+    auto err = skipSpacesAndComments();
+    if (err)
+      return fail(err);
+
+    switch (state_) {
+      case AfterKey:
+        if (!eat(':'))
+          return fail(DeserializationError::InvalidInput);
+        err = skipSpacesAndComments();
+        if (err)
+          return fail(err);
+        return parseValue();
+
+      case AfterOpen:
+        if (current() == closing())
+          return close();
+        return inObject() ? parseKey() : parseValue();
+
+      case AfterValue:
+        if (current() == closing())
+          return close();
+        if (!eat(','))
+          return fail(DeserializationError::InvalidInput);
+        err = skipSpacesAndComments();
+        if (err)
+          return fail(err);
+        return inObject() ? parseKey() : parseValue();
+
+      default:
+        return parseValue();
+    }
+  }
+
+  JsonToken token() const {
+    return token_;
+  }
+
+  DeserializationError error() const {
+    return error_;
+  }
+
+  // Number of objects and arrays currently open
+  uint8_t depth() const {
+    return depth_;
+  }
+
+  // Text of the current Key, String or Number token. Only valid until the
+  // next call to next().
+  JsonString str() const {
+    return JsonString(buffer_.data, buffer_.size);
+  }
+
+  // The current Key or String did not fit in the buffer
+  bool truncated() const {
+    return buffer_.truncated;
+  }
+
+  // Value of the current Number or Boolean token, converted like
+  // JsonVariant::as<T>()
+  template <typename T>
+  T as() const {
+    if (token_ == JsonToken::Boolean)
+      return T(boolean_);
+    if (token_ == JsonToken::Number)
+      return number_.template convertTo<T>();
+    return T();
+  }
+
+  // Skip the rest of the current value: after ObjectStart or ArrayStart,
+  // up to the matching end; after Key, the member's value. The next call
+  // to next() continues behind it.
+  bool skip() {
+    if (token_ == JsonToken::Key)
+      next();
+    if (token_ == JsonToken::ObjectStart || token_ == JsonToken::ArrayStart) {
+      uint8_t depth = depth_;
+      while (depth_ >= depth && next() != JsonToken::Error) {
+      }
+    }
+    return token_ != JsonToken::Error;
+  }
+
+  // Copy the current value (or, after Key, the member's value) into dst.
+  // Containers are read up to their end. Use it for the elements of a large
+  // array, so that only one of them is in RAM at a time. A key or string
+  // longer than N - 1 bytes is NoMemory: pick N for the longest one.
+  DeserializationError read(JsonVariant dst) {
+    if (token_ == JsonToken::Key)
+      next();
+    auto err = readValue(dst);
+    if (err && token_ != JsonToken::Error)
+      fail(err);
+    return err;
+  }
+
+ private:
+  enum State : uint8_t { Start, AfterOpen, AfterKey, AfterValue, Done };
+
+  struct Buffer {
+    char data[N];
+    size_t size = 0;
+    bool truncated = false;
+
+    void clear() {
+      size = 0;
+      truncated = false;
+      data[0] = 0;
+    }
+
+    void append(char c) {
+      if (size < N - 1) {
+        data[size++] = c;
+        data[size] = 0;
+      } else {
+        truncated = true;
+      }
+    }
+  };
+
+  char current() {
+    return latch_.current();
+  }
+
+  void move() {
+    latch_.clear();
+  }
+
+  bool eat(char charToSkip) {
+    if (current() != charToSkip)
+      return false;
+    move();
+    return true;
+  }
+
+  JsonToken fail(DeserializationError::Code err) {
+    error_ = err;
+    return token_ = JsonToken::Error;
+  }
+
+  bool inObject() const {
+    return (stack_ >> (depth_ - 1)) & 1;
+  }
+
+  char closing() const {
+    return inObject() ? '}' : ']';
+  }
+
+  JsonToken close() {
+    bool object = inObject();
+    move();
+    buffer_.clear();
+    depth_--;
+    state_ = depth_ ? AfterValue : Done;
+    return token_ = object ? JsonToken::ObjectEnd : JsonToken::ArrayEnd;
+  }
+
+  JsonToken valueDone(JsonToken token) {
+    state_ = depth_ ? AfterValue : Done;
+    return token_ = token;
+  }
+
+  JsonToken parseValue() {
+    DeserializationError::Code err;
+    buffer_.clear();
+
+    char c = current();
+    switch (c) {
+      case '{':
+      case '[':
+        if (depth_ >= maxDepth)
+          return fail(DeserializationError::TooDeep);
+        move();
+        if (c == '{')
+          stack_ |= uint32_t(1) << depth_;
+        else
+          stack_ &= ~(uint32_t(1) << depth_);
+        depth_++;
+        state_ = AfterOpen;
+        token_ = c == '{' ? JsonToken::ObjectStart : JsonToken::ArrayStart;
+        return token_;
+
+      case '\"':
+      case '\'':
+        err = parseQuotedString();
+        if (err)
+          return fail(err);
+        return valueDone(JsonToken::String);
+
+      case 't':
+      case 'f':
+        boolean_ = c == 't';
+        err = skipKeyword(boolean_ ? "true" : "false");
+        if (err)
+          return fail(err);
+        return valueDone(JsonToken::Boolean);
+
+      case 'n':
+        err = skipKeyword("null");
+        if (err)
+          return fail(err);
+        return valueDone(JsonToken::Null);
+
+      default:
+        while (canBeInNumber(c)) {
+          move();
+          buffer_.append(c);
+          c = current();
+        }
+        if (buffer_.truncated)
+          return fail(DeserializationError::InvalidInput);
+        number_ = detail::parseNumber(buffer_.data);
+        if (number_.type() == detail::NumberType::Invalid)
+          return fail(DeserializationError::InvalidInput);
+        return valueDone(JsonToken::Number);
+    }
+  }
+
+  JsonToken parseKey() {
+    DeserializationError::Code err;
+    buffer_.clear();
+
+    char c = current();
+    if (isQuote(c)) {
+      err = parseQuotedString();
+      if (err)
+        return fail(err);
+    } else if (canBeInNonQuotedString(c)) {
+      do {
+        move();
+        buffer_.append(c);
+        c = current();
+      } while (canBeInNonQuotedString(c));
+    } else {
+      return fail(DeserializationError::InvalidInput);
+    }
+    state_ = AfterKey;
+    return token_ = JsonToken::Key;
+  }
+
+  // Same rules as JsonDeserializer::parseQuotedString()
+  DeserializationError::Code parseQuotedString() {
+#if ARDUINOJSON_DECODE_UNICODE
+    detail::Utf16::Codepoint codepoint;
+    DeserializationError::Code err;
+#endif
+    const char stopChar = current();
+
+    move();
+    for (;;) {
+      char c = current();
+      move();
+      if (c == stopChar)
+        break;
+
+      if (c == '\0')
+        return DeserializationError::IncompleteInput;
+
+      if (c == '\\') {
+        c = current();
+
+        if (c == '\0')
+          return DeserializationError::IncompleteInput;
+
+        if (c == 'u') {
+#if ARDUINOJSON_DECODE_UNICODE
+          move();
+          uint16_t codeunit;
+          err = parseHex4(codeunit);
+          if (err)
+            return err;
+          if (codepoint.append(codeunit))
+            detail::Utf8::encodeCodepoint(codepoint.value(), buffer_);
+#else
+          buffer_.append('\\');
+#endif
+          continue;
+        }
+
+        c = detail::EscapeSequence::unescapeChar(c);
+        if (c == '\0')
+          return DeserializationError::InvalidInput;
+        move();
+      }
+
+      buffer_.append(c);
+    }
+
+    return DeserializationError::Ok;
+  }
+
+  DeserializationError::Code parseHex4(uint16_t& result) {
+    result = 0;
+    for (uint8_t i = 0; i < 4; ++i) {
+      char digit = current();
+      if (!digit)
+        return DeserializationError::IncompleteInput;
+      uint8_t value = decodeHex(digit);
+      if (value > 0x0F)
+        return DeserializationError::InvalidInput;
+      result = uint16_t((result << 4) | value);
+      move();
+    }
+    return DeserializationError::Ok;
+  }
+
+  DeserializationError::Code skipKeyword(const char* s) {
+    while (*s) {
+      char c = current();
+      if (c == '\0')
+        return DeserializationError::IncompleteInput;
+      if (*s != c)
+        return DeserializationError::InvalidInput;
+      ++s;
+      move();
+    }
+    return DeserializationError::Ok;
+  }
+
+  DeserializationError::Code skipSpacesAndComments() {
+    for (;;) {
+      switch (current()) {
+        case '\0':
+          return foundSomething_ ? DeserializationError::IncompleteInput
+                                 : DeserializationError::EmptyInput;
+
+        case ' ':
+        case '\t':
+        case '\r':
+        case '\n':
+          move();
+          continue;
+
+#if ARDUINOJSON_ENABLE_COMMENTS
+        case '/':
+          move();  // skip '/'
+          switch (current()) {
+            case '*': {
+              move();  // skip '*'
+              bool wasStar = false;
+              for (;;) {
+                char c = current();
+                if (c == '\0')
+                  return DeserializationError::IncompleteInput;
+                if (c == '/' && wasStar) {
+                  move();
+                  break;
+                }
+                wasStar = c == '*';
+                move();
+              }
+              break;
+            }
+
+            case '/':
+              for (;;) {
+                move();
+                char c = current();
+                if (c == '\0')
+                  return DeserializationError::IncompleteInput;
+                if (c == '\n')
+                  break;
+              }
+              break;
+
+            default:
+              return DeserializationError::InvalidInput;
+          }
+          break;
+#endif
+
+        default:
+          foundSomething_ = true;
+          return DeserializationError::Ok;
+      }
+    }
+  }
+
+  DeserializationError::Code readValue(JsonVariant dst) {
+    switch (token_) {
+      case JsonToken::ObjectStart: {
+        JsonObject object = dst.to<JsonObject>();
+        if (object.isNull())
+          return DeserializationError::NoMemory;
+        while (next() == JsonToken::Key) {
+          if (buffer_.truncated)
+            return DeserializationError::NoMemory;
+          JsonVariant member = object[str()].template to<JsonVariant>();
+          next();
+          auto err = readValue(member);
+          if (err)
+            return err;
+        }
+        return token_ == JsonToken::ObjectEnd ? DeserializationError::Ok
+                                              : error_.code();
+      }
+
+      case JsonToken::ArrayStart: {
+        JsonArray array = dst.to<JsonArray>();
+        if (array.isNull())
+          return DeserializationError::NoMemory;
+        for (;;) {
+          JsonToken t = next();
+          if (t == JsonToken::ArrayEnd)
+            return DeserializationError::Ok;
+          if (t == JsonToken::Error)
+            return error_.code();
+          auto err = readValue(array.add<JsonVariant>());
+          if (err)
+            return err;
+        }
+      }
+
+      case JsonToken::String:
+        if (buffer_.truncated)
+          return DeserializationError::NoMemory;
+        return dst.set(str()) ? DeserializationError::Ok
+                              : DeserializationError::NoMemory;
+
+      case JsonToken::Number: {
+        bool ok;
+        switch (number_.type()) {
+          case detail::NumberType::SignedInteger:
+            ok = dst.set(number_.asSignedInteger());
+            break;
+          case detail::NumberType::UnsignedInteger:
+            ok = dst.set(number_.asUnsignedInteger());
+            break;
+          default:
+            ok = dst.set(number_.template convertTo<JsonFloat>());
+            break;
+        }
+        return ok ? DeserializationError::Ok : DeserializationError::NoMemory;
+      }
+
+      case JsonToken::Boolean:
+        return dst.set(boolean_) ? DeserializationError::Ok
+                                 : DeserializationError::NoMemory;
+
+      case JsonToken::Null:
+        dst.clear();
+        return DeserializationError::Ok;
+
+      case JsonToken::Error:
+        return error_.code();
+
+      default:
+        return DeserializationError::InvalidInput;
+    }
+  }
+
+  static inline bool isBetween(char c, char min, char max) {
+    return min <= c && c <= max;
+  }
+
+  static inline bool canBeInNumber(char c) {
+    return isBetween(c, '0', '9') || c == '+' || c == '-' || c == '.' ||
+#if ARDUINOJSON_ENABLE_NAN || ARDUINOJSON_ENABLE_INFINITY
+           isBetween(c, 'A', 'Z') || isBetween(c, 'a', 'z');
+#else
+           c == 'e' || c == 'E';
+#endif
+  }
+
+  static inline bool canBeInNonQuotedString(char c) {
+    return isBetween(c, '0', '9') || isBetween(c, '_', 'z') ||
+           isBetween(c, 'A', 'Z');
+  }
+
+  static inline bool isQuote(char c) {
+    return c == '\'' || c == '\"';
+  }
+
+  static inline uint8_t decodeHex(char c) {
+    if (c < 'A')
+      return uint8_t(c - '0');
+    c = char(c & ~0x20);  // uppercase
+    return uint8_t(c - 'A' + 10);
+  }
+
+  detail::Latch<TReader> latch_;
+  Buffer buffer_;
+  detail::Number number_;
+  DeserializationError error_;
+  uint32_t stack_ = 0;  // bit i set: level i is an object
+  uint8_t depth_ = 0;
+  State state_ = Start;
+  JsonToken token_ = JsonToken::None;
+  bool boolean_ = false;
+  bool foundSomething_ = false;
+};
+
+// Pull parser over a Stream, String, std::istream, const char*, ...
+template <size_t N = 64, typename TInput>
+JsonPullParser<detail::Reader<detail::remove_reference_t<TInput>>, N>
+makeJsonPullParser(TInput&& input) {
+  return JsonPullParser<detail::Reader<detail::remove_reference_t<TInput>>, N>(
+      detail::makeReader(detail::forward<TInput>(input)));
+}
+
+// Pull parser over a zero-terminated string
+template <size_t N = 64, typename TChar>
+JsonPullParser<detail::Reader<TChar*>, N> makeJsonPullParser(TChar* input) {
+  return JsonPullParser<detail::Reader<TChar*>, N>(detail::makeReader(input));
+}
+
+// Pull parser over a buffer of known size
+template <size_t N = 64, typename TChar>
+JsonPullParser<detail::BoundedReader<TChar*>, N> makeJsonPullParser(
+    TChar* input, size_t inputSize) {
+  return JsonPullParser<detail::BoundedReader<TChar*>, N>(
+      detail::makeReader(input, inputSize));
+}
+
+ARDUINOJSON_END_PUBLIC_NAMESPACE
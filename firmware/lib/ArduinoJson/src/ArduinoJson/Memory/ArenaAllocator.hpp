@@ -0,0 +1,149 @@
+// ArduinoJson - https://arduinojson.org
+// Copyright © 2014-2025, Benoit BLANCHON
+// MIT License
+
+#pragma once
+
+#include <ArduinoJson/Memory/Allocator.hpp>
+
+#include <stddef.h>  // size_t
+#include <string.h>  // memcpy
+
+ARDUINOJSON_BEGIN_PUBLIC_NAMESPACE
+
+// Bump allocator over a caller-owned buffer, for documents that live for
+// one request. Pool growth, strings and shrinkToFit() all land in the same
+// fixed block of RAM instead of the general heap, so a burst of parsing
+// cannot fragment it.
+//
+// Freed blocks are reclaimed as soon as everything above them is freed
+// too, so nested documents destroyed in scope order give their memory
+// back. The newest block is resized in place, which is what StringBuilder
+// and shrinkToFit() ask for. reset() drops everything at once; only call
+// it when no document still uses the arena.
+//
+//   static char buffer[4096];
+//   ArenaAllocator arena(buffer, sizeof(buffer));
+//   JsonDocument doc(&arena);
+class ArenaAllocator : public Allocator {
+ public:
+  ArenaAllocator(void* buffer, size_t capacity) {
+    size_t addr = reinterpret_cast<size_t>(buffer);
+    size_t skip = pad(addr) - addr;
+    begin_ = static_cast<char*>(buffer) + skip;
+    capacity_ = capacity > skip ? (capacity - skip) & ~(alignment - 1) : 0;
+    reset();
+  }
+
+  void* allocate(size_t size) override {
+    size_t need = blockSize(size);
+    if (size > capacity_ || need > capacity_ - top_) {
+      failures_++;
+      return nullptr;
+    }
+    Header* h = header(top_);
+    h->size = size;
+    h->prev = last_;
+    last_ = top_;
+    top_ += need;
+    if (top_ > peak_)
+      peak_ = top_;
+    return h + 1;
+  }
+
+  void deallocate(void* ptr) override {
+    if (!ptr)
+      return;
+    Header* h = static_cast<Header*>(ptr) - 1;
+    h->prev |= freed;
+    // Pop every freed block from the top
+    while (top_ && (header(last_)->prev & freed)) {
+      top_ = last_;
+      last_ = header(last_)->prev & ~freed;
+    }
+  }
+
+  void* reallocate(void* ptr, size_t size) override {
+    if (!ptr)
+      return allocate(size);
+    Header* h = static_cast<Header*>(ptr) - 1;
+    size_t offset = static_cast<size_t>(reinterpret_cast<char*>(h) - begin_);
+    if (offset == last_) {
+      // Newest block: grow or shrink in place
+      if (size > capacity_ || blockSize(size) > capacity_ - offset) {
+        failures_++;
+        return nullptr;
+      }
+      h->size = size;
+      top_ = offset + blockSize(size);
+      if (top_ > peak_)
+        peak_ = top_;
+      return ptr;
+    }
+    if (size <= h->size)
+      return ptr;
+    void* p = allocate(size);
+    if (p) {
+      memcpy(p, ptr, h->size);
+      deallocate(ptr);
+    }
+    return p;
+  }
+
+  // Forget every block. The high-water mark is kept.
+  void reset() {
+    top_ = 0;
+    last_ = 0;
+  }
+
+  size_t capacity() const {
+    return capacity_;
+  }
+
+  // Bytes in use, including block headers and freed blocks that are not
+  // on top yet
+  size_t used() const {
+    return top_;
+  }
+
+  // Largest used() since construction; size the buffer from this
+  size_t highWaterMark() const {
+    return peak_;
+  }
+
+  // Requests refused because the buffer was full
+  size_t failures() const {
+    return failures_;
+  }
+
+ private:
+  struct Header {
+    size_t size;
+    size_t prev;  // offset of the previous block, low bit = freed
+  };
+
+  static const size_t alignment =
+      sizeof(double) > sizeof(void*) ? sizeof(double) : sizeof(void*);
+  static const size_t freed = 1;
+
+  static size_t pad(size_t n) {
+    return (n + alignment - 1) & ~(alignment - 1);
+  }
+
+  static size_t blockSize(size_t size) {
+    return pad(sizeof(Header)) + pad(size);
+  }
+
+  Header* header(size_t offset) const {
+    return reinterpret_cast<Header*>(begin_ + offset);
+  }
+
+  char* begin_;
+  size_t capacity_;
+  size_t top_ = 0;
+  size_t last_ = 0;
+  size_t peak_ = 0;
+  size_t failures_ = 0;
+};
+
+ARDUINOJSON_END_PUBLIC_NAMESPACE
@@ -24,6 +24,9 @@ struct StringNode {
   struct StringNode* next;
   references_type references;
   length_type length;
+#if ARDUINOJSON_STRING_POOL_HASH
+  uint32_t hash;  // set by StringPool when the node is added
+#endif
   char data[1];
 
   static constexpr size_t maxLength = numeric_limits<length_type>::highest();
@@ -0,0 +1,280 @@
+// ArduinoJson - https://arduinojson.org
+// Copyright © 2014-2025, Benoit BLANCHON
+// MIT License
+
+#pragma once
+
+#include <ArduinoJson/Memory/Allocator.hpp>
+#include <ArduinoJson/Memory/StringNode.hpp>
+#include <ArduinoJson/Polyfills/assert.hpp>
+#include <ArduinoJson/Polyfills/utility.hpp>
+#include <ArduinoJson/Strings/StringAdapters.hpp>
+
+#include <stddef.h>  // offsetof
+
+ARDUINOJSON_BEGIN_PRIVATE_NAMESPACE
+
+#if ARDUINOJSON_STRING_POOL_HASH
+
+// Same interface as the list below, but StringNode::next chains the
+// strings of one hash bucket. The first buckets live inside the pool; the
+// table doubles through the allocator at 3/4 load, and if that fails it
+// keeps working with longer chains.
+class StringPool {
+  static const size_t initialBuckets = ARDUINOJSON_STRING_POOL_INITIAL_BUCKETS;
+  static_assert((initialBuckets & (initialBuckets - 1)) == 0,
+                "ARDUINOJSON_STRING_POOL_INITIAL_BUCKETS must be a power of 2");
+
+ public:
+  StringPool() = default;
+  StringPool(const StringPool&) = delete;
+  void operator=(StringPool&& src) = delete;
+
+  ~StringPool() {
+    ARDUINOJSON_ASSERT(count_ == 0);
+  }
+
+  friend void swap(StringPool& a, StringPool& b) {
+    bool aInline = a.buckets_ == a.inlineBuckets_;
+    bool bInline = b.buckets_ == b.inlineBuckets_;
+    for (size_t i = 0; i < initialBuckets; i++)
+      swap_(a.inlineBuckets_[i], b.inlineBuckets_[i]);
+    swap_(a.buckets_, b.buckets_);
+    swap_(a.bucketCount_, b.bucketCount_);
+    swap_(a.count_, b.count_);
+    if (aInline)
+      b.buckets_ = b.inlineBuckets_;
+    if (bInline)
+      a.buckets_ = a.inlineBuckets_;
+  }
+
+  void clear(Allocator* allocator) {
+    for (size_t i = 0; i < bucketCount_; i++) {
+      while (buckets_[i]) {
+        auto node = buckets_[i];
+        buckets_[i] = node->next;
+        StringNode::destroy(node, allocator);
+      }
+    }
+    if (buckets_ != inlineBuckets_) {
+      allocator->deallocate(buckets_);
+      buckets_ = inlineBuckets_;
+      bucketCount_ = initialBuckets;
+    }
+    count_ = 0;
+  }
+
+  size_t size() const {
+    size_t total = 0;
+    if (buckets_ != inlineBuckets_)
+      total += bucketCount_ * sizeof(StringNode*);
+    for (size_t i = 0; i < bucketCount_; i++)
+      for (auto node = buckets_[i]; node; node = node->next)
+        total += sizeofString(node->length);
+    return total;
+  }
+
+  template <typename TAdaptedString>
+  StringNode* add(TAdaptedString str, Allocator* allocator) {
+    ARDUINOJSON_ASSERT(str.isNull() == false);
+
+    uint32_t h = hash(str);
+    auto node = find(str, h);
+    if (node) {
+      node->references++;
+      return node;
+    }
+
+    size_t n = str.size();
+
+    node = StringNode::create(n, allocator);
+    if (!node)
+      return nullptr;
+
+    stringGetChars(str, node->data, n);
+    node->data[n] = 0;  // force NUL terminator
+    insert(node, h, allocator);
+    return node;
+  }
+
+  void add(StringNode* node, Allocator* allocator) {
+    ARDUINOJSON_ASSERT(node != nullptr);
+    insert(node, hash(adaptString(node->data, node->length)), allocator);
+  }
+
+  template <typename TAdaptedString>
+  StringNode* get(const TAdaptedString& str) const {
+    return find(str, hash(str));
+  }
+
+  void dereference(const char* s, Allocator* allocator) {
+    // Owned strings always point into their node
+    auto node = reinterpret_cast<StringNode*>(const_cast<char*>(s) -
+                                              offsetof(StringNode, data));
+    StringNode** link = &buckets_[node->hash & (bucketCount_ - 1)];
+    while (*link && *link != node)
+      link = &(*link)->next;
+    if (!*link)
+      return;
+    if (--node->references == 0) {
+      *link = node->next;
+      count_--;
+      StringNode::destroy(node, allocator);
+    }
+  }
+
+ private:
+  // FNV-1a
+  template <typename TAdaptedString>
+  static uint32_t hash(const TAdaptedString& str) {
+    uint32_t h = 2166136261u;
+    size_t n = str.size();
+    for (size_t i = 0; i < n; i++) {
+      h ^= static_cast<uint8_t>(str[i]);
+      h *= 16777619u;
+    }
+    return h;
+  }
+
+  template <typename TAdaptedString>
+  StringNode* find(const TAdaptedString& str, uint32_t h) const {
+    for (auto node = buckets_[h & (bucketCount_ - 1)]; node;
+         node = node->next) {
+      if (node->hash == h &&
+          stringEquals(str, adaptString(node->data, node->length)))
+        return node;
+    }
+    return nullptr;
+  }
+
+  void insert(StringNode* node, uint32_t h, Allocator* allocator) {
+    if (count_ >= bucketCount_ - bucketCount_ / 4)
+      grow(allocator);
+    node->hash = h;
+    StringNode*& head = buckets_[h & (bucketCount_ - 1)];
+    node->next = head;
+    head = node;
+    count_++;
+  }
+
+  void grow(Allocator* allocator) {
+    size_t newCount = bucketCount_ * 2;
+    auto table = reinterpret_cast<StringNode**>(
+        allocator->allocate(newCount * sizeof(StringNode*)));
+    if (!table)
+      return;
+    for (size_t i = 0; i < newCount; i++)
+      table[i] = nullptr;
+    for (size_t i = 0; i < bucketCount_; i++) {
+      while (buckets_[i]) {
+        auto node = buckets_[i];
+        buckets_[i] = node->next;
+        StringNode*& head = table[node->hash & (newCount - 1)];
+        node->next = head;
+        head = node;
+      }
+    }
+    if (buckets_ != inlineBuckets_)
+      allocator->deallocate(buckets_);
+    buckets_ = table;
+    bucketCount_ = newCount;
+  }
+
+  StringNode** buckets_ = inlineBuckets_;
+  size_t bucketCount_ = initialBuckets;
+  size_t count_ = 0;
+  StringNode* inlineBuckets_[initialBuckets] = {};
+};
+
+#else
+
+class StringPool {
+ public:
+  StringPool() = default;
+  StringPool(const StringPool&) = delete;
+  void operator=(StringPool&& src) = delete;
+
+  ~StringPool() {
+    ARDUINOJSON_ASSERT(strings_ == nullptr);
+  }
+
+  friend void swap(StringPool& a, StringPool& b) {
+    swap_(a.strings_, b.strings_);
+  }
+
+  void clear(Allocator* allocator) {
+    while (strings_) {
+      auto node = strings_;
+      strings_ = node->next;
+      StringNode::destroy(node, allocator);
+    }
+  }
+
+  size_t size() const {
+    size_t total = 0;
+    for (auto node = strings_; node; node = node->next)
+      total += sizeofString(node->length);
+    return total;
+  }
+
+  template <typename TAdaptedString>
+  StringNode* add(TAdaptedString str, Allocator* allocator) {
+    ARDUINOJSON_ASSERT(str.isNull() == false);
+
+    auto node = get(str);
+    if (node) {
+      node->references++;
+      return node;
+    }
+
+    size_t n = str.size();
+
+    node = StringNode::create(n, allocator);
+    if (!node)
+      return nullptr;
+
+    stringGetChars(str, node->data, n);
+    node->data[n] = 0;  // force NUL terminator
+    add(node, allocator);
+    return node;
+  }
+
+  void add(StringNode* node, Allocator*) {
+    ARDUINOJSON_ASSERT(node != nullptr);
+    node->next = strings_;
+    strings_ = node;
+  }
+
+  template <typename TAdaptedString>
+  StringNode* get(const TAdaptedString& str) const {
+    for (auto node = strings_; node; node = node->next) {
+      if (stringEquals(str, adaptString(node->data, node->length)))
+        return node;
+    }
+    return nullptr;
+  }
+
+  void dereference(const char* s, Allocator* allocator) {
+    StringNode* prev = nullptr;
+    for (auto node = strings_; node; node = node->next) {
+      if (node->data == s) {
+        if (--node->references == 0) {
+          if (prev)
+            prev->next = node->next;
+          else
+            strings_ = node->next;
+          StringNode::destroy(node, allocator);
+        }
+        return;
+      }
+      prev = node;
+    }
+  }
+
+ private:
+  StringNode* strings_ = nullptr;
+};
+
+#endif
+
+ARDUINOJSON_END_PRIVATE_NAMESPACE
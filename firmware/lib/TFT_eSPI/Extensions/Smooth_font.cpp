@@ -165,6 +165,7 @@ void TFT_eSPI::loadMetrics(void)
     gdY       =  (int16_t*)ps_malloc( gFont.gCount * 2); // offset from bitmap top edge from lowest point in any character
     gdX       =   (int8_t*)ps_malloc( gFont.gCount );    // offset for bitmap left edge relative to cursor X
     gBitmap   = (uint32_t*)ps_malloc( gFont.gCount * 4); // seek pointer to glyph bitmap in the file
+    gSorted   = (uint16_t*)ps_malloc( gFont.gCount * 2); // glyph numbers in Unicode order
   }
   else
 #endif
@@ -176,6 +177,7 @@ void TFT_eSPI::loadMetrics(void)
     gdY       =  (int16_t*)malloc( gFont.gCount * 2); // offset from bitmap top edge from lowest point in any character
     gdX       =   (int8_t*)malloc( gFont.gCount );    // offset for bitmap left edge relative to cursor X
     gBitmap   = (uint32_t*)malloc( gFont.gCount * 4); // seek pointer to glyph bitmap in the file
+    gSorted   = (uint16_t*)malloc( gFont.gCount * 2); // glyph numbers in Unicode order
   }
 
 #ifdef SHOW_ASCENT_DESCENT
@@ -245,6 +247,23 @@ void TFT_eSPI::loadMetrics(void)
   gFont.yAdvance = gFont.maxAscent + gFont.maxDescent;
 
   gFont.spaceWidth = (gFont.ascent + gFont.descent) * 2/7;  // Guess at space width
+
+  // Build the Unicode index. Insertion sort is stable, so for a duplicated code the
+  // first glyph in the file is found as before, and vlw files are normally already
+  // in Unicode order so this is a single pass.
+  if (gSorted)
+  {
+    for (uint16_t i = 0; i < gFont.gCount; i++)
+    {
+      uint16_t j = i;
+      while (j > 0 && gUnicode[gSorted[j - 1]] > gUnicode[i])
+      {
+        gSorted[j] = gSorted[j - 1];
+        j--;
+      }
+      gSorted[j] = i;
+    }
+  }
 }
 
 
@@ -296,9 +315,16 @@ void TFT_eSPI::unloadFont( void )
     gBitmap = NULL;
   }
 
+  if (gSorted)
+  {
+    free(gSorted);
+    gSorted = NULL;
+  }
+
   gFont.gArray = nullptr;
 
 #ifdef FONT_FS_AVAILABLE
+  clearGlyphCache();
   if (fs_font && fontFile) fontFile.close();
 #endif
 
@@ -340,18 +366,132 @@ uint32_t TFT_eSPI::readInt32(void)
 *************************************************************************************x*/
 bool TFT_eSPI::getUnicodeIndex(uint16_t unicode, uint16_t *index)
 {
-  for (uint16_t i = 0; i < gFont.gCount; i++)
+  if (gSorted == NULL)
   {
-    if (gUnicode[i] == unicode)
+    for (uint16_t i = 0; i < gFont.gCount; i++)
     {
-      *index = i;
-      return true;
+      if (gUnicode[i] == unicode)
+      {
+        *index = i;
+        return true;
+      }
     }
+    return false;
+  }
+
+  // Binary search for the first entry not less than unicode
+  uint16_t lo = 0;
+  uint16_t hi = gFont.gCount;
+  while (lo < hi)
+  {
+    uint16_t mid = lo + (hi - lo) / 2;
+    if (gUnicode[gSorted[mid]] < unicode) lo = mid + 1;
+    else hi = mid;
+  }
+
+  if (lo < gFont.gCount && gUnicode[gSorted[lo]] == unicode)
+  {
+    *index = gSorted[lo];
+    return true;
   }
   return false;
 }
 
 
+#ifdef FONT_FS_AVAILABLE
+/***************************************************************************************
+** Function name:           getGlyphBitmap
+** Description:             Get the alpha bitmap of a file font glyph from the cache,
+**                          reading it from the file on a miss
+*************************************************************************************x*/
+// Returns nullptr if the glyph cannot be cached, caller then reads it row by row
+const uint8_t* TFT_eSPI::getGlyphBitmap(uint16_t gNum)
+{
+#if (SMOOTH_FONT_CACHE_GLYPHS > 0)
+  uint32_t size = gWidth[gNum] * gHeight[gNum];
+  if (size == 0 || size > SMOOTH_FONT_CACHE_BYTES) return nullptr;
+
+  gCacheTick++;
+
+  uint8_t slot = SMOOTH_FONT_CACHE_GLYPHS;
+  for (uint8_t i = 0; i < SMOOTH_FONT_CACHE_GLYPHS; i++)
+  {
+    if (gCache[i].bitmap == nullptr)
+    {
+      if (slot == SMOOTH_FONT_CACHE_GLYPHS) slot = i;
+    }
+    else if (gCache[i].gNum == gNum)
+    {
+      gCache[i].lastUse = gCacheTick;
+      glyphCacheHits++;
+      return gCache[i].bitmap;
+    }
+  }
+  glyphCacheMisses++;
+
+  // Drop least recently used glyphs until there is a free slot and enough space
+  while (slot == SMOOTH_FONT_CACHE_GLYPHS || gCacheBytes + size > SMOOTH_FONT_CACHE_BYTES)
+  {
+    uint8_t lru = SMOOTH_FONT_CACHE_GLYPHS;
+    for (uint8_t i = 0; i < SMOOTH_FONT_CACHE_GLYPHS; i++)
+    {
+      if (gCache[i].bitmap == nullptr) continue;
+      if (lru == SMOOTH_FONT_CACHE_GLYPHS || gCache[i].lastUse < gCache[lru].lastUse) lru = i;
+    }
+    if (lru == SMOOTH_FONT_CACHE_GLYPHS) break; // Cache is empty
+
+    gCacheBytes -= gWidth[gCache[lru].gNum] * gHeight[gCache[lru].gNum];
+    free(gCache[lru].bitmap);
+    gCache[lru].bitmap = nullptr;
+    slot = lru;
+  }
+
+  uint8_t* bitmap = nullptr;
+#if defined (ESP32) && defined (CONFIG_SPIRAM_SUPPORT)
+  if ( psramFound() ) bitmap = (uint8_t*)ps_malloc(size);
+  else
+#endif
+  bitmap = (uint8_t*)malloc(size);
+  if (bitmap == nullptr) return nullptr;
+
+  fontFile.seek(gBitmap[gNum], fs::SeekSet);
+  if (fontFile.read(bitmap, size) != size)
+  {
+    free(bitmap);
+    return nullptr;
+  }
+
+  gCache[slot].bitmap  = bitmap;
+  gCache[slot].lastUse = gCacheTick;
+  gCache[slot].gNum    = gNum;
+  gCacheBytes += size;
+  return bitmap;
+#else
+  gNum = gNum; // Avoid unused variable warning
+  return nullptr;
+#endif
+}
+
+
+/***************************************************************************************
+** Function name:           clearGlyphCache
+** Description:             Free all cached glyph bitmaps
+*************************************************************************************x*/
+void TFT_eSPI::clearGlyphCache(void)
+{
+#if (SMOOTH_FONT_CACHE_GLYPHS > 0)
+  for (uint8_t i = 0; i < SMOOTH_FONT_CACHE_GLYPHS; i++)
+  {
+    if (gCache[i].bitmap) free(gCache[i].bitmap);
+    gCache[i].bitmap = nullptr;
+  }
+  gCacheBytes = 0;
+  gCacheTick  = 0;
+#endif
+}
+#endif
+
+
 /***************************************************************************************
 ** Function name:           drawGlyph
 ** Description:             Write a character to the TFT cursor position
@@ -408,10 +548,15 @@ void TFT_eSPI::drawGlyph(uint16_t code)
     const uint8_t* gPtr = (const uint8_t*) gFont.gArray;
 
 #ifdef FONT_FS_AVAILABLE
+    const uint8_t* gCached = nullptr;
     if (fs_font)
     {
-      fontFile.seek(gBitmap[gNum], fs::SeekSet);
-      pbuffer =  (uint8_t*)malloc(gWidth[gNum]);
+      gCached = getGlyphBitmap(gNum);
+      if (gCached == nullptr)
+      {
+        fontFile.seek(gBitmap[gNum], fs::SeekSet);
+        pbuffer =  (uint8_t*)malloc(gWidth[gNum]);
+      }
     }
 #endif
 
@@ -461,7 +606,7 @@ void TFT_eSPI::drawGlyph(uint16_t code)
     for (int32_t y = 0; y < gHeight[gNum]; y++)
     {
 #ifdef FONT_FS_AVAILABLE
-      if (fs_font) {
+      if (pbuffer) {
         if (spiffs)
         {
           fontFile.read(pbuffer, gWidth[gNum]);
@@ -480,7 +625,8 @@ void TFT_eSPI::drawGlyph(uint16_t code)
       for (int32_t x = 0; x < gWidth[gNum]; x++)
       {
 #ifdef FONT_FS_AVAILABLE
-        if (fs_font) pixel = pbuffer[x];
+        if (gCached) pixel = gCached[x + gWidth[gNum] * y];
+        else if (fs_font) pixel = pbuffer[x];
         else
 #endif
         pixel = pgm_read_byte(gPtr + gBitmap[gNum] + x + gWidth[gNum] * y);
@@ -33,6 +33,7 @@ fontMetrics gFont = { nullptr, 0, 0, 0, 0, 0, 0, 0 };
 
   // These are for the metrics for each individual glyph (so we don't need to seek this in file and waste time)
   uint16_t* gUnicode = NULL;  //UTF-16 code, the codes are searched so do not need to be sequential
+  uint16_t* gSorted = NULL;   //glyph numbers sorted by gUnicode value, for a binary search
   uint8_t*  gHeight = NULL;   //cheight
   uint8_t*  gWidth = NULL;    //cwidth
   uint8_t*  gxAdvance = NULL; //setWidth
@@ -52,10 +53,42 @@ fontMetrics gFont = { nullptr, 0, 0, 0, 0, 0, 0, 0 };
   bool     fontFile = true;
 #endif
 
+#ifdef FONT_FS_AVAILABLE
+  // Cache of glyph alpha bitmaps read from a font file, least recently used glyph is
+  // dropped when either limit is reached. Set SMOOTH_FONT_CACHE_GLYPHS to 0 to disable.
+  #ifndef SMOOTH_FONT_CACHE_GLYPHS
+    #define SMOOTH_FONT_CACHE_GLYPHS 48
+  #endif
+  #ifndef SMOOTH_FONT_CACHE_BYTES
+    #define SMOOTH_FONT_CACHE_BYTES 12288
+  #endif
+
+  uint32_t glyphCacheHits   = 0;
+  uint32_t glyphCacheMisses = 0;
+#endif
+
   private:
 
   void     loadMetrics(void);
   uint32_t readInt32(void);
 
+#ifdef FONT_FS_AVAILABLE
+  const uint8_t* getGlyphBitmap(uint16_t gNum); // nullptr if glyph cannot be cached
+  void     clearGlyphCache(void);
+
+  #if (SMOOTH_FONT_CACHE_GLYPHS > 0)
+  typedef struct
+  {
+    uint8_t* bitmap;   // gWidth x gHeight alpha values, nullptr if slot is free
+    uint32_t lastUse;  // gCacheTick value when last drawn
+    uint16_t gNum;
+  } glyphCacheEntry;
+
+  glyphCacheEntry gCache[SMOOTH_FONT_CACHE_GLYPHS] = {};
+  uint32_t gCacheBytes = 0;
+  uint32_t gCacheTick  = 0;
+  #endif
+#endif
+
   uint8_t* fontPtr = nullptr;
 
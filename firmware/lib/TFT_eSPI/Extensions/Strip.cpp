@@ -0,0 +1,184 @@
+/**************************************************************************************
+** Code for the double buffered strip renderer, see Strip.h
+***************************************************************************************/
+
+/***************************************************************************************
+** Function name:           TFT_eStrip
+** Description:             Class constructor
+***************************************************************************************/
+TFT_eStrip::TFT_eStrip(TFT_eSPI *tft) : _sprA(tft), _sprB(tft)
+{
+  _tft     = tft;
+  _spr[0]  = &_sprA;
+  _spr[1]  = &_sprB;
+  _cur     = 0;
+  _stripW  = 0;
+  _stripH  = TFT_STRIP_HEIGHT;
+  _inFrame = false;
+  _oldSwapBytes = false;
+  _frameStart   = 0;
+  resetStats();
+}
+
+/***************************************************************************************
+** Function name:           ~TFT_eStrip
+** Description:             Class destructor
+***************************************************************************************/
+TFT_eStrip::~TFT_eStrip(void)
+{
+  end();
+}
+
+/***************************************************************************************
+** Function name:           begin
+** Description:             Create the strip Sprites and initialise DMA
+***************************************************************************************/
+bool TFT_eStrip::begin(int16_t width, uint16_t stripHeight)
+{
+  _stripW = width;
+  if (!setStripHeight(stripHeight)) return false;
+
+  if (!_tft->DMA_Enabled) _tft->initDMA();
+  resetStats();
+  return true;
+}
+
+/***************************************************************************************
+** Function name:           end
+** Description:             Delete the strip Sprites
+***************************************************************************************/
+void TFT_eStrip::end(void)
+{
+  if (_inFrame) endFrame();
+  _sprA.deleteSprite();
+  _sprB.deleteSprite();
+}
+
+/***************************************************************************************
+** Function name:           setStripHeight
+** Description:             Re-create the strip Sprites with a new height
+***************************************************************************************/
+bool TFT_eStrip::setStripHeight(uint16_t stripHeight)
+{
+  if (stripHeight == 0 || _stripW <= 0) return false;
+
+  // Strips may still be in use by the DMA engine
+  if (_tft->DMA_Enabled) _tft->dmaWait();
+
+  _stripH = stripHeight;
+  for (uint8_t i = 0; i < 2; i++) {
+    _spr[i]->deleteSprite();
+    _spr[i]->setColorDepth(16);
+    if (!_spr[i]->createSprite(_stripW, _stripH)) {
+      end();
+      return false;
+    }
+  }
+  _cur = 0;
+  return true;
+}
+
+/***************************************************************************************
+** Function name:           beginFrame
+** Description:             Start a frame, TFT chip select is held low until endFrame()
+***************************************************************************************/
+void TFT_eStrip::beginFrame(void)
+{
+  if (_inFrame) return;
+  _inFrame = true;
+  _frameStart = micros();
+
+  _stats.strips = 0;
+  _stats.lastFrameBytes = 0;
+  _stats.renderUs = 0;
+  _stats.waitUs = 0;
+
+  // Sprite 16-bit buffers already hold the colours in TFT byte order
+  _oldSwapBytes = _tft->getSwapBytes();
+  _tft->setSwapBytes(false);
+  _tft->startWrite();
+}
+
+/***************************************************************************************
+** Function name:           endFrame
+** Description:             Wait for the last strip to be sent and update statistics
+***************************************************************************************/
+void TFT_eStrip::endFrame(void)
+{
+  if (!_inFrame) return;
+  _inFrame = false;
+
+  if (_tft->DMA_Enabled) _tft->dmaWait();
+  _tft->endWrite();
+  _tft->setSwapBytes(_oldSwapBytes);
+
+  uint32_t dt = micros() - _frameStart;
+  _stats.frames++;
+  _stats.lastFrameUs = dt;
+  if (dt > _stats.maxFrameUs) _stats.maxFrameUs = dt;
+  if (_stats.avgFrameUs) _stats.avgFrameUs += ((int32_t)dt - (int32_t)_stats.avgFrameUs) / 8;
+  else _stats.avgFrameUs = dt;
+  _stats.totalBytes += _stats.lastFrameBytes;
+}
+
+/***************************************************************************************
+** Function name:           pushRect
+** Description:             Render an area strip by strip and push it to the TFT
+***************************************************************************************/
+uint32_t TFT_eStrip::pushRect(int32_t x, int32_t y, int32_t w, int32_t h,
+                              StripRenderCB render, void* arg, int32_t sx, int32_t sy)
+{
+  if (!_sprA.created() || !_sprB.created()) return 0;
+  if (w <= 0 || h <= 0 || sx < 0 || sx + w > _stripW) return 0;
+
+  bool ownFrame = !_inFrame;
+  if (ownFrame) beginFrame();
+
+  uint32_t bytes = 0;
+  for (int32_t oy = 0; oy < h; oy += _stripH) {
+    int32_t bh = h - oy;
+    if (bh > _stripH) bh = _stripH;
+
+    // With a DMA queue depth of 1 the transfer of this buffer was waited for by the
+    // previous pushImageDMA(), so it is safe to draw while the other one is sent
+    TFT_eSprite *spr = _spr[_cur];
+    _cur ^= 1;
+
+    uint32_t t0 = micros();
+    render(*spr, sy + oy, arg);
+    _stats.renderUs += micros() - t0;
+
+    // Pack columns sx to sx + w - 1 into a contiguous block
+    uint16_t* buf = (uint16_t*)spr->getPointer();
+    if (sx != 0 || w != _stripW) {
+      for (int32_t j = 0; j < bh; j++)
+        memmove(buf + j * w, buf + j * _stripW + sx, w * sizeof(uint16_t));
+    }
+
+    if (_tft->DMA_Enabled) {
+      if (_tft->dmaBusy()) {
+        t0 = micros();
+        _tft->dmaWait();
+        _stats.waitUs += micros() - t0;
+      }
+      _tft->pushImageDMA(x, y + oy, w, bh, buf);
+    }
+    else _tft->pushImage(x, y + oy, w, bh, buf);
+
+    _stats.strips++;
+    bytes += (uint32_t)w * bh * 2;
+  }
+  _stats.lastFrameBytes += bytes;
+
+  if (ownFrame) endFrame();
+  return bytes;
+}
+
+/***************************************************************************************
+** Function name:           resetStats
+** Description:             Clear the frame statistics
+***************************************************************************************/
+void TFT_eStrip::resetStats(void)
+{
+  memset(&_stats, 0, sizeof(_stats));
+}
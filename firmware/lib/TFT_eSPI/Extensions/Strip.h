@@ -0,0 +1,84 @@
+/***************************************************************************************
+// The following class renders screen areas through two small 16-bit Sprites used as
+// strip buffers. The sketch supplies a render callback that draws one strip at a time,
+// and the strips are pushed with pushImageDMA() alternately, so the processor draws
+// strip N+1 while the DMA engine is still sending strip N.
+// If DMA is not available (not initialised or not supported) the strips are pushed
+// with the normal blocking pushImage() instead and no overlap takes place.
+//
+// RAM required is 2 x width x strip height x 2 bytes, e.g. 2 x 240 x 16 x 2 = 15360
+***************************************************************************************/
+
+// Default strip height, can be changed with build flag -DTFT_STRIP_HEIGHT=n or
+// at run time with setStripHeight()
+#ifndef TFT_STRIP_HEIGHT
+  #define TFT_STRIP_HEIGHT 16
+#endif
+
+// Render callback: draw content rows oy to oy + strip height - 1 into spr, with content
+// row oy landing on Sprite row 0. Every pixel in the columns being pushed must be drawn
+// as the strip buffers are re-used without being cleared.
+typedef void (*StripRenderCB)(TFT_eSprite& spr, int32_t oy, void* arg);
+
+// Frame statistics, times in microseconds
+typedef struct {
+  uint32_t frames;         // Frames completed with endFrame()
+  uint32_t strips;         // Strips pushed in the last frame
+  uint32_t lastFrameBytes; // Pixel bytes sent in the last frame
+  uint32_t lastFrameUs;    // Time from beginFrame() to the end of the last DMA transfer
+  uint32_t maxFrameUs;
+  uint32_t avgFrameUs;     // Moving average (1/8 weight)
+  uint32_t renderUs;       // Time spent in render callbacks in the last frame
+  uint32_t waitUs;         // Time blocked waiting for a DMA buffer in the last frame
+  uint64_t totalBytes;     // Pixel bytes sent since begin()
+} StripStats;
+
+class TFT_eStrip {
+
+ public:
+
+  explicit TFT_eStrip(TFT_eSPI *tft);
+  ~TFT_eStrip(void);
+
+           // Create the two strip Sprites, width is normally tft.width(), and initialise
+           // DMA if not already done. Returns false if there is not enough RAM.
+  bool     begin(int16_t width, uint16_t stripHeight = TFT_STRIP_HEIGHT);
+
+           // Delete the strip Sprites
+  void     end(void);
+
+           // Re-create the strip Sprites with a new height. Small strips use less RAM,
+           // larger strips mean fewer DMA transactions and render callbacks per frame.
+  bool     setStripHeight(uint16_t stripHeight);
+  uint16_t getStripHeight(void) { return _stripH; }
+
+           // A frame brackets one or more pushRect() calls: the TFT chip select is held
+           // low throughout and endFrame() waits for the last DMA transfer to complete
+  void     beginFrame(void);
+  void     endFrame(void);
+
+           // Push the area w x h at TFT position x, y. The callback draws the area content,
+           // sx, sy is the top left corner of the area within that content, so the
+           // callback draws from content row sy and columns sx to sx + w - 1 are sent.
+           // sx + w must not exceed the strip width. Returns the number of bytes sent.
+           // If called outside beginFrame()/endFrame() the push is a frame on its own.
+  uint32_t pushRect(int32_t x, int32_t y, int32_t w, int32_t h,
+                    StripRenderCB render, void* arg, int32_t sx = 0, int32_t sy = 0);
+
+  const StripStats& stats(void) { return _stats; }
+  void     resetStats(void);
+
+ private:
+
+  TFT_eSPI    *_tft;
+  TFT_eSprite  _sprA, _sprB;
+  TFT_eSprite *_spr[2];
+  uint8_t      _cur;        // Strip buffer to draw next
+  int16_t      _stripW;
+  uint16_t     _stripH;
+  bool         _inFrame;
+  bool         _oldSwapBytes;
+  uint32_t     _frameStart;
+
+  StripStats   _stats;
+};
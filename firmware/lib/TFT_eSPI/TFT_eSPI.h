@@ -1008,4 +1008,7 @@ fastBlend(A alpha, F fgc, B bgc)
 // Load the Sprite Class
 #include "Extensions/Sprite.h"
 
+// Load the double buffered strip renderer Class
+#include "Extensions/Strip.h"
+
 #endif // ends #ifndef _TFT_eSPIH_
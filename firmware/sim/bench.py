@@ -0,0 +1,23 @@
+# Custom target for the native env: replay every scenario and print the
+# sim report (scan -> upload latency, loop iteration jitter, bus traffic).
+# A scenario whose "expect" lines fail exits 1 and stops the target.
+#
+#   pio run -e native -t bench
+
+import glob
+import os
+
+Import("env")
+
+scenarios = sorted(glob.glob(os.path.join(env.subst("$PROJECT_DIR"), "sim", "scenarios", "*.txt")))
+
+env.AddCustomTarget(
+    name="bench",
+    dependencies="$BUILD_DIR/${PROGNAME}",
+    actions=[
+        'echo "== %s" && "$BUILD_DIR/${PROGNAME}" --fs "$BUILD_DIR/sim_fs" "%s"' % (os.path.basename(s), s)
+        for s in scenarios
+    ],
+    title="Scan benchmark",
+    description="Replay sim/scenarios on the native build",
+)
@@ -0,0 +1,33 @@
+#ifndef Adafruit_I2CDevice_h
+#define Adafruit_I2CDevice_h
+
+#include <Arduino.h>
+#include <Wire.h>
+
+class Adafruit_I2CDevice {
+public:
+  Adafruit_I2CDevice(uint8_t addr, TwoWire *theWire = &Wire)
+      : _addr(addr), _wire(theWire) {}
+  uint8_t address(void) { return _addr; }
+  bool begin(bool addr_detect = true);
+  void end(void) {}
+  bool detected(void);
+
+  bool read(uint8_t *buffer, size_t len, bool stop = true);
+  bool write(const uint8_t *buffer, size_t len, bool stop = true,
+             const uint8_t *prefix_buffer = nullptr, size_t prefix_len = 0);
+  bool write_then_read(const uint8_t *write_buffer, size_t write_len,
+                       uint8_t *read_buffer, size_t read_len,
+                       bool stop = false);
+  bool setSpeed(uint32_t desiredclk) {
+    _wire->setClock(desiredclk);
+    return true;
+  }
+  size_t maxBufferSize() { return 128; }
+
+private:
+  uint8_t _addr;
+  TwoWire *_wire;
+};
+
+#endif // Adafruit_I2CDevice_h
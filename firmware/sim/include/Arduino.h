@@ -0,0 +1,284 @@
+#pragma once
+
+// Host replacement for the ESP32 Arduino core used by the native env.
+// Only the surface the firmware and its libraries touch is provided; time
+// is virtual and advanced by the sim kernel (see SimKernel.h).
+
+#include <ctype.h>
+#include <math.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+
+#include "SimKernel.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+
+#ifndef ARDUINO
+#define ARDUINO 10805
+#endif
+#define ARDUINO_RUNNING_CORE 1
+
+typedef bool boolean;
+typedef uint8_t byte;
+
+#define HIGH 0x1
+#define LOW 0x0
+#define INPUT 0x01
+#define OUTPUT 0x03
+#define INPUT_PULLUP 0x05
+#define RISING 0x01
+#define FALLING 0x02
+#define CHANGE 0x03
+
+#define DEC 10
+#define HEX 16
+#define OCT 8
+#define BIN 2
+
+#define SERIAL_8N1 0x800001c
+
+#define IRAM_ATTR
+#define PROGMEM
+#define PGM_P const char *
+#define F(s) (reinterpret_cast<const __FlashStringHelper *>(s))
+#define pgm_read_byte(addr) (*(const unsigned char *)(addr))
+#define pgm_read_word(addr) (*(const unsigned short *)(addr))
+#define pgm_read_dword(addr) (*(const unsigned long *)(addr))
+#define digitalPinToInterrupt(p) (p)
+#define memcpy_P memcpy
+#define strcpy_P strcpy
+#define strlen_P strlen
+#define strncmp_P strncmp
+
+using std::max;
+using std::min;
+#define constrain(amt, low, high)                                              \
+  ((amt) < (low) ? (low) : ((amt) > (high) ? (high) : (amt)))
+
+class __FlashStringHelper;
+
+unsigned long millis();
+unsigned long micros();
+void delay(uint32_t ms);
+void delayMicroseconds(uint32_t us);
+void yield();
+
+void pinMode(uint8_t pin, uint8_t mode);
+int digitalRead(uint8_t pin);
+void digitalWrite(uint8_t pin, uint8_t val);
+void attachInterrupt(uint8_t pin, void (*isr)(void), int mode);
+void detachInterrupt(uint8_t pin);
+
+long random(long howbig);
+long random(long howsmall, long howbig);
+void randomSeed(unsigned long seed);
+// Hardware RNG; its own sequence, so it does not shift random()
+uint32_t esp_random();
+
+// esp32-hal-time
+struct tm;
+void configTime(long gmtOffset_sec, int daylightOffset_sec,
+                const char *server1, const char *server2 = nullptr,
+                const char *server3 = nullptr);
+bool getLocalTime(struct tm *info, uint32_t ms = 5000);
+
+// ================== String ==================
+class String {
+public:
+  String(const char *cstr = "");
+  String(const String &s);
+  String(String &&s);
+  String(const __FlashStringHelper *s);
+  explicit String(char c);
+  explicit String(unsigned char v, unsigned char base = 10);
+  explicit String(int v, unsigned char base = 10);
+  explicit String(unsigned int v, unsigned char base = 10);
+  explicit String(long v, unsigned char base = 10);
+  explicit String(unsigned long v, unsigned char base = 10);
+  explicit String(float v, unsigned int decimals = 2);
+  explicit String(double v, unsigned int decimals = 2);
+  ~String();
+
+  String &operator=(const String &rhs);
+  String &operator=(String &&rhs);
+  String &operator=(const char *cstr);
+
+  bool concat(const String &s);
+  bool concat(const char *cstr);
+  bool concat(const char *cstr, unsigned int len);
+  bool concat(char c);
+  bool concat(int v);
+  bool concat(unsigned int v);
+  bool concat(long v);
+  bool concat(unsigned long v);
+
+  String &operator+=(const String &rhs) {
+    concat(rhs);
+    return *this;
+  }
+  String &operator+=(const char *cstr) {
+    concat(cstr);
+    return *this;
+  }
+  String &operator+=(char c) {
+    concat(c);
+    return *this;
+  }
+  String &operator+=(int v) {
+    concat(v);
+    return *this;
+  }
+  String &operator+=(unsigned long v) {
+    concat(v);
+    return *this;
+  }
+
+  unsigned int length() const { return len_; }
+  const char *c_str() const { return buf_ ? buf_ : ""; }
+  bool isEmpty() const { return len_ == 0; }
+  bool reserve(unsigned int size);
+
+  bool equals(const String &s) const;
+  bool equals(const char *cstr) const;
+  bool operator==(const String &rhs) const { return equals(rhs); }
+  bool operator==(const char *cstr) const { return equals(cstr); }
+  bool operator!=(const String &rhs) const { return !equals(rhs); }
+  bool operator!=(const char *cstr) const { return !equals(cstr); }
+  char operator[](unsigned int i) const { return i < len_ ? buf_[i] : 0; }
+  char charAt(unsigned int i) const { return (*this)[i]; }
+
+  int indexOf(char c, unsigned int from = 0) const;
+  int indexOf(const char *s, unsigned int from = 0) const;
+  bool startsWith(const char *s) const;
+  String substring(unsigned int from) const;
+  String substring(unsigned int from, unsigned int to) const;
+  void trim();
+  long toInt() const;
+  float toFloat() const;
+
+private:
+  void assign(const char *cstr, unsigned int len);
+  char *buf_;
+  unsigned int len_;
+  unsigned int cap_;
+};
+
+String operator+(const String &lhs, const String &rhs);
+String operator+(const String &lhs, const char *rhs);
+String operator+(const char *lhs, const String &rhs);
+String operator+(const String &lhs, char rhs);
+
+// ================== Print / Stream ==================
+class Print;
+class Printable {
+public:
+  virtual ~Printable() {}
+  virtual size_t printTo(Print &p) const = 0;
+};
+
+class Print {
+public:
+  virtual ~Print() {}
+  virtual size_t write(uint8_t c) = 0;
+  virtual size_t write(const uint8_t *buffer, size_t size);
+  size_t write(const char *str) {
+    return str ? write((const uint8_t *)str, strlen(str)) : 0;
+  }
+  size_t write(const char *buffer, size_t size) {
+    return write((const uint8_t *)buffer, size);
+  }
+  virtual void flush() {}
+
+  size_t printf(const char *format, ...) __attribute__((format(printf, 2, 3)));
+  size_t print(const char *s) { return write(s); }
+  size_t print(const String &s) { return write(s.c_str()); }
+  size_t print(const __FlashStringHelper *s) {
+    return print(reinterpret_cast<const char *>(s));
+  }
+  size_t print(char c) { return write((uint8_t)c); }
+  size_t print(int v, int base = DEC) { return print((long)v, base); }
+  size_t print(unsigned int v, int base = DEC) {
+    return print((unsigned long)v, base);
+  }
+  size_t print(long v, int base = DEC);
+  size_t print(unsigned long v, int base = DEC);
+  size_t print(unsigned char v, int base = DEC) {
+    return print((unsigned long)v, base);
+  }
+  size_t print(double v, int digits = 2);
+  size_t println() { return write("\r\n"); }
+  template <typename T> size_t println(const T &v) {
+    size_t n = print(v);
+    return n + println();
+  }
+  template <typename T> size_t println(const T &v, int base) {
+    size_t n = print(v, base);
+    return n + println();
+  }
+};
+
+class Stream : public Print {
+public:
+  virtual int available() = 0;
+  virtual int read() = 0;
+  virtual int peek() = 0;
+  void setTimeout(unsigned long timeout) { timeout_ = timeout; }
+  size_t readBytes(char *buffer, size_t length);
+  size_t readBytes(uint8_t *buffer, size_t length) {
+    return readBytes((char *)buffer, length);
+  }
+  String readStringUntil(char terminator);
+
+protected:
+  int timedRead();
+  unsigned long timeout_ = 1000;
+};
+
+// ================== HardwareSerial ==================
+// Port 0 is the console, any other port is wired to a sim device
+// (sim::attachUart) which sees bytes with UART timing.
+class HardwareSerial : public Stream {
+public:
+  explicit HardwareSerial(int uart_nr);
+  void begin(unsigned long baud, uint32_t config = SERIAL_8N1,
+             int8_t rxPin = -1, int8_t txPin = -1);
+  void end() {}
+  int available() override;
+  int read() override;
+  int peek() override;
+  size_t write(uint8_t c) override;
+  size_t write(const uint8_t *buffer, size_t size) override;
+  using Print::write;
+  operator bool() const { return true; }
+
+  int port() const { return nr_; }
+  unsigned long baud() const { return baud_; }
+
+private:
+  int nr_;
+  unsigned long baud_;
+};
+
+extern HardwareSerial Serial;
+
+// ================== ESP ==================
+class EspClass {
+public:
+  uint32_t getFreeHeap();
+  uint32_t getMinFreeHeap();
+  uint32_t getMaxAllocHeap();
+  uint32_t getHeapSize();
+  uint32_t getCycleCount();
+  uint32_t getCpuFreqMHz() { return 240; }
+  void restart();
+};
+
+extern EspClass ESP;
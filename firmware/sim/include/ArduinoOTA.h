@@ -0,0 +1,57 @@
+#pragma once
+
+#include <Arduino.h>
+
+#include <functional>
+
+#define U_FLASH 0
+#define U_SPIFFS 100
+
+typedef enum {
+  OTA_AUTH_ERROR,
+  OTA_BEGIN_ERROR,
+  OTA_CONNECT_ERROR,
+  OTA_RECEIVE_ERROR,
+  OTA_END_ERROR
+} ota_error_t;
+
+class ArduinoOTAClass {
+public:
+  typedef std::function<void(void)> THandlerFunction;
+  typedef std::function<void(ota_error_t)> THandlerFunction_Error;
+  typedef std::function<void(unsigned int, unsigned int)>
+      THandlerFunction_Progress;
+
+  ArduinoOTAClass &setHostname(const char *) { return *this; }
+  ArduinoOTAClass &setPassword(const char *) { return *this; }
+  ArduinoOTAClass &setPort(uint16_t) { return *this; }
+  ArduinoOTAClass &onStart(THandlerFunction fn) {
+    start_ = fn;
+    return *this;
+  }
+  ArduinoOTAClass &onEnd(THandlerFunction fn) {
+    end_ = fn;
+    return *this;
+  }
+  ArduinoOTAClass &onError(THandlerFunction_Error fn) {
+    error_ = fn;
+    return *this;
+  }
+  ArduinoOTAClass &onProgress(THandlerFunction_Progress fn) {
+    progress_ = fn;
+    return *this;
+  }
+  void begin() { begun_ = true; }
+  void end() { begun_ = false; }
+  // Polls the OTA UDP socket: a few microseconds when idle
+  void handle() { sim::charge(begun_ ? 15 : 1); }
+  int getCommand() { return U_FLASH; }
+
+private:
+  bool begun_ = false;
+  THandlerFunction start_, end_;
+  THandlerFunction_Error error_;
+  THandlerFunction_Progress progress_;
+};
+
+extern ArduinoOTAClass ArduinoOTA;
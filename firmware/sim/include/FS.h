@@ -0,0 +1,96 @@
+#pragma once
+
+#include <Arduino.h>
+
+#include <memory>
+
+#define FILE_READ "r"
+#define FILE_WRITE "w"
+#define FILE_APPEND "a"
+
+namespace fs {
+
+enum SeekMode { SeekSet = 0, SeekCur = 1, SeekEnd = 2 };
+
+class FileImpl;
+typedef std::shared_ptr<FileImpl> FileImplPtr;
+
+// Files live in a host directory. Writes stay in a RAM cache until
+// flush()/close(), so a simulated power cut loses them like on target.
+class File : public Stream {
+public:
+  File(FileImplPtr p = FileImplPtr()) : p_(p) {}
+
+  size_t write(uint8_t c) override;
+  size_t write(const uint8_t *buf, size_t size) override;
+  using Print::write;
+  int available() override;
+  int read() override;
+  int peek() override;
+  void flush() override;
+  size_t read(uint8_t *buf, size_t size);
+  size_t readBytes(char *buffer, size_t length) {
+    return read((uint8_t *)buffer, length);
+  }
+  bool seek(uint32_t pos, SeekMode mode = SeekSet);
+  size_t position() const;
+  size_t size() const;
+  void close();
+  operator bool() const;
+  const char *name() const;
+  const char *path() const;
+  bool isDirectory() const;
+  File openNextFile(const char *mode = FILE_READ);
+  void rewindDirectory();
+
+private:
+  FileImplPtr p_;
+};
+
+class FS {
+public:
+  File open(const char *path, const char *mode = FILE_READ,
+            bool create = false);
+  File open(const String &path, const char *mode = FILE_READ,
+            bool create = false) {
+    return open(path.c_str(), mode, create);
+  }
+  bool exists(const char *path);
+  bool exists(const String &path) { return exists(path.c_str()); }
+  bool remove(const char *path);
+  bool remove(const String &path) { return remove(path.c_str()); }
+  bool rename(const char *from, const char *to);
+  bool rename(const String &from, const String &to) {
+    return rename(from.c_str(), to.c_str());
+  }
+  bool mkdir(const char *path);
+  bool mkdir(const String &path) { return mkdir(path.c_str()); }
+  bool rmdir(const char *path);
+  bool rmdir(const String &path) { return rmdir(path.c_str()); }
+};
+
+} // namespace fs
+
+using fs::File;
+using fs::FS;
+using fs::SeekCur;
+using fs::SeekEnd;
+using fs::SeekMode;
+using fs::SeekSet;
+
+namespace sim {
+// Host directory backing the flash filesystem.
+void fsSetRoot(const char *dir, bool wipe);
+// Drop every unflushed write (power cut).
+void fsPowerCut();
+// Power back on, e.g. to see what the next boot recovers.
+void fsPowerRestore();
+// Operations that changed the flash so far (file sync, rename, remove).
+uint32_t fsOps();
+// Cut the power when operation number `op` (as counted by fsOps()) starts:
+// it and everything after it never reach the flash. 0 = never.
+void fsPowerCutAt(uint32_t op);
+// The next `n` operations on `path` (written, renamed to or removed) fail,
+// like a full or worn-out flash.
+void fsFailNext(const char *path, uint32_t n = 1);
+} // namespace sim
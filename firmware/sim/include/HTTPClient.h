@@ -0,0 +1,59 @@
+#pragma once
+
+#include <Arduino.h>
+
+#include "WiFiClient.h"
+
+#define HTTPC_ERROR_CONNECTION_REFUSED (-1)
+#define HTTPC_ERROR_SEND_HEADER_FAILED (-2)
+#define HTTPC_ERROR_SEND_PAYLOAD_FAILED (-3)
+#define HTTPC_ERROR_NOT_CONNECTED (-4)
+#define HTTPC_ERROR_CONNECTION_LOST (-5)
+#define HTTPC_ERROR_NO_STREAM (-6)
+#define HTTPC_ERROR_NO_HTTP_SERVER (-7)
+#define HTTPC_ERROR_TOO_LESS_RAM (-8)
+#define HTTPC_ERROR_ENCODING (-9)
+#define HTTPC_ERROR_STREAM_WRITE (-10)
+#define HTTPC_ERROR_READ_TIMEOUT (-11)
+
+#define HTTP_CODE_OK 200
+
+// Requests are answered by the in-process backend model (SimServer.h).
+class HTTPClient {
+public:
+  // Like the real one: destroying the client drops the connection
+  ~HTTPClient() {
+    if (client_)
+      client_->stop();
+  }
+  bool begin(WiFiClient &client, const String &url);
+  void end();
+  void setReuse(bool reuse) { reuse_ = reuse; }
+  void setTimeout(uint16_t ms) { timeoutMs_ = ms; }
+  void setConnectTimeout(int32_t ms) { connectTimeoutMs_ = ms; }
+  void addHeader(const String &name, const String &value);
+  int GET();
+  int POST(const String &payload) {
+    return POST((const uint8_t *)payload.c_str(), payload.length());
+  }
+  int POST(const uint8_t *payload, size_t size);
+  int sendRequest(const char *type, const uint8_t *payload, size_t size);
+  String getString();
+  // Body as it arrives on the socket: Content-Length bytes, or chunked
+  // encoding when getSize() is -1
+  WiFiClient &getStream() { return *client_; }
+  int getSize() { return size_; }
+  bool connected();
+  static String errorToString(int error);
+
+private:
+  WiFiClient *client_ = nullptr;
+  String url_;
+  String contentType_;
+  String headers_;
+  String response_;
+  int size_ = -1;
+  bool reuse_ = true;
+  uint16_t timeoutMs_ = 5000;
+  int32_t connectTimeoutMs_ = 5000;
+};
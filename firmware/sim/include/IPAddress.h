@@ -0,0 +1,27 @@
+#pragma once
+
+#include <Arduino.h>
+
+class IPAddress {
+public:
+  IPAddress() : addr_(0) {}
+  IPAddress(uint8_t a, uint8_t b, uint8_t c, uint8_t d)
+      : addr_((uint32_t)a | ((uint32_t)b << 8) | ((uint32_t)c << 16) |
+              ((uint32_t)d << 24)) {}
+  IPAddress(uint32_t addr) : addr_(addr) {}
+  operator uint32_t() const { return addr_; }
+  uint8_t operator[](int i) const { return (addr_ >> (8 * i)) & 0xFF; }
+  bool operator==(const IPAddress &o) const { return addr_ == o.addr_; }
+  bool operator!=(const IPAddress &o) const { return addr_ != o.addr_; }
+  String toString() const {
+    char b[16];
+    snprintf(b, sizeof(b), "%u.%u.%u.%u", (*this)[0], (*this)[1], (*this)[2],
+             (*this)[3]);
+    return String(b);
+  }
+
+private:
+  uint32_t addr_;
+};
+
+extern const IPAddress INADDR_NONE;
@@ -0,0 +1,20 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace sim {
+
+// A finger "identity" is what the scenario touches with; the module stores
+// identities in library pages like the real template flash.
+void as608Attach();
+void as608Enroll(uint16_t page, uint32_t identity);
+void as608Forget(uint16_t page);
+// The 512-byte template UpChar returns for an identity
+void as608TemplateBytes(uint32_t identity, uint8_t *out);
+void as608Touch(uint32_t identity, bool bad = false);
+void as608Lift();
+uint32_t as608Commands();
+size_t as608LibrarySize();
+
+} // namespace sim
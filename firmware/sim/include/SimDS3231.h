@@ -0,0 +1,16 @@
+#pragma once
+
+#include <stdint.h>
+
+namespace sim {
+
+void ds3231Attach(uint32_t unixtime);
+// Crystal error of the RTC against true (sim) time.
+void ds3231SetDriftPpm(double ppm);
+// Wire the SQW/INT output to a GPIO, with optional edge jitter.
+void ds3231WireSqw(uint8_t pin, uint32_t jitterUs = 0);
+uint32_t ds3231Reads();
+// True RTC time (fractional unix seconds) for checking the firmware clock.
+double ds3231Seconds();
+
+} // namespace sim
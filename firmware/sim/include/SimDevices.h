@@ -0,0 +1,49 @@
+#pragma once
+
+// Hooks between the fake Arduino core and the simulated peripherals.
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace sim {
+
+// ================== GPIO ==================
+void setPin(uint8_t pin, int level);
+int pinLevel(uint8_t pin);
+
+// ================== UART ==================
+class UartDevice {
+public:
+  virtual ~UartDevice() {}
+  // Byte written by the firmware, delivered after its wire time.
+  virtual void onRx(uint8_t b) = 0;
+};
+
+void attachUart(int port, UartDevice *dev);
+// Device -> firmware bytes; they become readable one byte-time apart
+// starting at `atUs`.
+void uartSend(int port, const uint8_t *data, size_t n, uint64_t atUs);
+uint64_t uartByteUs(int port);
+
+// ================== I2C ==================
+class I2cDevice {
+public:
+  virtual ~I2cDevice() {}
+  virtual void onWrite(const uint8_t *data, size_t n) = 0;
+  virtual size_t onRead(uint8_t *data, size_t n) = 0;
+};
+
+void attachI2c(uint8_t addr, I2cDevice *dev);
+I2cDevice *i2cDevice(uint8_t addr);
+
+// ================== Heap ==================
+size_t heapUsed();
+size_t heapPeak();
+// Allocations on this thread while one is alive belong to the simulated
+// backend, not to the device heap
+struct HostHeapScope {
+  HostHeapScope();
+  ~HostHeapScope();
+};
+
+} // namespace sim
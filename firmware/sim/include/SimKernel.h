@@ -0,0 +1,49 @@
+#pragma once
+
+// Virtual-time kernel for the native env. Every FreeRTOS task (and the
+// Arduino loop task) runs on its own host thread, but only one holds the
+// host CPU at a time. Each task is pinned to core 0 or 1, and a charge
+// only holds up tasks on the same core. Time only moves when code charges
+// work or blocks, so the firmware runs at full host speed and every run is
+// deterministic.
+
+#include <stdint.h>
+
+#include <functional>
+
+namespace sim {
+
+uint64_t nowUs();
+
+// Current task spends `us` of CPU/bus time. Its core is busy meanwhile;
+// tasks pinned to the other core run in the gap.
+void charge(uint64_t us);
+// Another task is suspended inside charge(), e.g. halfway through a flash
+// write on the other core.
+bool othersCharging();
+// Current task blocks for `us` (vTaskDelay, delay()).
+void sleepUs(uint64_t us);
+// Let other ready tasks run without advancing time.
+void yieldNow();
+
+// Run `fn` (in whichever task is current) once time reaches `atUs`.
+void schedule(uint64_t atUs, std::function<void()> fn);
+
+void spawn(void (*fn)(void *), void *arg, const char *name, int core);
+const char *currentTaskName();
+void *currentTask();
+// 0 (PRO CPU) or 1 (APP CPU, where the Arduino loop task runs)
+int currentCore();
+
+// Entry point used by SimMain: runs setup() then loop() until the
+// scenario ends.
+void runArduino(void (*setupFn)(), void (*loopFn)(), uint64_t endUs,
+                std::function<void(uint64_t, uint64_t)> onLoopDone);
+
+// Stop the simulation from any task (prints reports, exits the process).
+void finish();
+void onFinish(std::function<void()> fn);
+// Process exit status used by finish(), e.g. 1 after a failed expect
+void setExitStatus(int status);
+
+} // namespace sim
@@ -0,0 +1,59 @@
+#pragma once
+
+// Simulated access point, backend and their knobs for scenarios.
+
+#include <Arduino.h>
+
+namespace sim {
+
+void netSetAp(bool up);
+// AP restarts on another channel (cached BSSID/channel hint goes stale)
+void netSetApChannel(int32_t channel);
+bool netApUp();
+// Next WebServer::handleClient() serves GET `path` (a LAN scrape)
+void netScrape(const char *path);
+void netSetServer(bool up);
+void netSetRttMs(uint32_t ms);
+// Lease time the AP's DHCP server hands out (default one day)
+void netSetDhcpLease(uint32_t seconds);
+// Leases obtained, and links that kept using a leased IP as a static IP
+// after that lease had expired
+uint32_t netDhcpLeases();
+uint32_t netExpiredLeaseLinks();
+void netSetWallClock(uint32_t unixtime);
+uint32_t netWallClock();
+
+struct HttpReply {
+  int code;
+  String body;
+};
+
+// Backend model of app/api/*: called once the request reached the server.
+HttpReply serverHandle(const char *method, const String &path,
+                       const String &contentType, const String &headers,
+                       const uint8_t *body, size_t size);
+uint32_t serverRecords();
+// Events skipped because their x-device-id and seq were stored already
+uint32_t serverDuplicates();
+// Ingest requests answered 422 (see serverRejectUid)
+uint32_t serverRejectedBatches();
+// The next `n` ingest requests are stored but their replies are lost
+void serverDropAcks(uint32_t n);
+// Ingest requests holding an event for `uid` are rejected with a 422
+// (-1 = none)
+void serverRejectUid(int uid);
+// An ingested record with this uid and timestamp exists
+bool serverHasRecord(uint16_t uid, uint32_t unixtime);
+// x-device-metrics header of the last upload, empty if none
+String serverLastMetrics();
+
+// Template store of app/api/templates
+// version from serverReserveTemplateVersion(), 0 = next one
+void serverPutTemplate(uint16_t uid, const uint8_t *tpl, size_t n,
+                       uint32_t version = 0);
+// Version taken by a writer whose update has not landed yet
+uint32_t serverReserveTemplateVersion();
+void serverDeleteTemplate(uint16_t uid);
+size_t serverTemplates();
+
+} // namespace sim
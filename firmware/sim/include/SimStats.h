@@ -0,0 +1,29 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <vector>
+
+namespace sim {
+
+// Latency samples in microseconds with percentile reporting.
+class Samples {
+public:
+  void add(uint64_t us) { v_.push_back(us); }
+  size_t count() const { return v_.size(); }
+  uint64_t percentile(double p) const;
+  uint64_t max() const;
+  double mean() const;
+  void report(const char *name) const;
+
+private:
+  std::vector<uint64_t> v_;
+};
+
+// Scan-to-upload tracking: a touch opens a sample, the backend storing an
+// event for the same uid closes it.
+void noteTouch(uint16_t uid);
+void noteIngest(uint16_t uid);
+
+} // namespace sim
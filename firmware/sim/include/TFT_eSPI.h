@@ -0,0 +1,186 @@
+#pragma once
+
+// Host stand-in for TFT_eSPI: draws into an RGB565 framebuffer and charges
+// the SPI wire time of every pixel that would reach the ST7789.
+
+#include <Arduino.h>
+#include <LittleFS.h>
+
+#define TFT_WIDTH 240
+#define TFT_HEIGHT 240
+
+// Smooth (vlw) fonts are the real library extension, read from the
+// simulated flash the way the ESP32 build reads them from SPIFFS
+#define SMOOTH_FONT
+#define FONT_FS_AVAILABLE
+#define SPIFFS LittleFS
+
+#define TL_DATUM 0
+#define TC_DATUM 1
+#define TR_DATUM 2
+#define ML_DATUM 3
+#define CL_DATUM 3
+#define MC_DATUM 4
+#define CC_DATUM 4
+#define MR_DATUM 5
+#define CR_DATUM 5
+#define BL_DATUM 6
+#define BC_DATUM 7
+#define BR_DATUM 8
+
+#define TFT_BLACK 0x0000
+#define TFT_NAVY 0x000F
+#define TFT_DARKGREEN 0x03E0
+#define TFT_DARKCYAN 0x03EF
+#define TFT_MAROON 0x7800
+#define TFT_PURPLE 0x780F
+#define TFT_OLIVE 0x7BE0
+#define TFT_LIGHTGREY 0xD69A
+#define TFT_DARKGREY 0x7BEF
+#define TFT_BLUE 0x001F
+#define TFT_GREEN 0x07E0
+#define TFT_CYAN 0x07FF
+#define TFT_RED 0xF800
+#define TFT_MAGENTA 0xF81F
+#define TFT_YELLOW 0xFFE0
+#define TFT_WHITE 0xFFFF
+#define TFT_ORANGE 0xFDA0
+
+class TFT_eSPI : public Print {
+public:
+  TFT_eSPI(int16_t w = TFT_WIDTH, int16_t h = TFT_HEIGHT);
+  virtual ~TFT_eSPI();
+
+  void init(uint8_t tc = 0) { begin(tc); }
+  void begin(uint8_t tc = 0);
+  void setRotation(uint8_t r) { rotation = r; }
+  uint8_t getRotation() const { return rotation; }
+  int16_t width() const { return _width; }
+  int16_t height() const { return _height; }
+
+  virtual void drawPixel(int32_t x, int32_t y, uint32_t color);
+  virtual void fillRect(int32_t x, int32_t y, int32_t w, int32_t h,
+                        uint32_t color);
+  void fillScreen(uint32_t color) { fillRect(0, 0, _width, _height, color); }
+  void drawRect(int32_t x, int32_t y, int32_t w, int32_t h, uint32_t color);
+  void drawFastHLine(int32_t x, int32_t y, int32_t w, uint32_t color) {
+    fillRect(x, y, w, 1, color);
+  }
+  void drawFastVLine(int32_t x, int32_t y, int32_t h, uint32_t color) {
+    fillRect(x, y, 1, h, color);
+  }
+  void fillRoundRect(int32_t x, int32_t y, int32_t w, int32_t h, int32_t r,
+                     uint32_t color);
+  void drawRoundRect(int32_t x, int32_t y, int32_t w, int32_t h, int32_t r,
+                     uint32_t color);
+  void fillCircle(int32_t x, int32_t y, int32_t r, uint32_t color);
+
+  void setTextColor(uint16_t c) {
+    textcolor = c;
+    textbgcolor = c;
+  }
+  void setTextColor(uint16_t c, uint16_t b, bool fill = false) {
+    textcolor = c;
+    textbgcolor = b;
+    _fillbg = fill;
+  }
+  void setTextDatum(uint8_t d) { textdatum = d; }
+  uint8_t getTextDatum() const { return textdatum; }
+  void setTextSize(uint8_t s) { textsize = s ? s : 1; }
+  void setTextFont(uint8_t f) { textfont = f; }
+  void setCursor(int16_t x, int16_t y) {
+    cursor_x = x;
+    cursor_y = y;
+  }
+  int16_t textWidth(const char *s, uint8_t font);
+  int16_t textWidth(const String &s, uint8_t font) {
+    return textWidth(s.c_str(), font);
+  }
+  int16_t fontHeight(uint8_t font);
+  int16_t fontHeight() { return fontHeight(textfont); }
+  int16_t drawString(const char *s, int32_t x, int32_t y, uint8_t font);
+  int16_t drawString(const String &s, int32_t x, int32_t y, uint8_t font) {
+    return drawString(s.c_str(), x, y, font);
+  }
+  int16_t drawString(const char *s, int32_t x, int32_t y) {
+    return drawString(s, x, y, textfont);
+  }
+
+  size_t write(uint8_t c) override;
+  using Print::write;
+
+  void pushImage(int32_t x, int32_t y, int32_t w, int32_t h,
+                 const uint16_t *data);
+
+  bool initDMA(bool ctrl_cs = false);
+  void deInitDMA();
+  void pushImageDMA(int32_t x, int32_t y, int32_t w, int32_t h,
+                    uint16_t *data, uint16_t *buffer = nullptr);
+  bool dmaBusy();
+  void dmaWait();
+  void startWrite() { inTransaction = true; }
+  void endWrite() { inTransaction = false; }
+  void setSwapBytes(bool swap) { _swapBytes = swap; }
+  bool getSwapBytes() const { return _swapBytes; }
+
+  uint16_t readPixel(int32_t x, int32_t y);
+  uint16_t *frame() { return fb; }
+
+  uint16_t alphaBlend(uint8_t alpha, uint16_t fgc, uint16_t bgc);
+  uint16_t decodeUTF8(uint8_t *buf, uint16_t *index, uint16_t remaining);
+
+  bool DMA_Enabled = false;
+
+  // Bus accounting (screen only, sprites are free)
+  static uint64_t spiBytes;
+  static uint64_t spiPixels;
+  static uint64_t spiWindows;
+
+#include <TFT_eSPI/Extensions/Smooth_font.h>
+
+protected:
+  void blit(int32_t x, int32_t y, int32_t w, int32_t h, const uint16_t *data,
+            bool charge);
+  void account(int32_t w, int32_t h, bool async);
+  bool clip(int32_t &x, int32_t &y, int32_t &w, int32_t &h);
+
+  int16_t _width, _height;
+  uint16_t *fb;
+  bool isSprite = false;
+  uint8_t rotation = 0;
+  uint16_t textcolor = TFT_WHITE, textbgcolor = TFT_BLACK;
+  uint8_t textdatum = TL_DATUM, textsize = 1, textfont = 1;
+  int16_t cursor_x = 0, cursor_y = 0;
+  // Smooth font state, as in the library
+  int32_t bg_cursor_x = 0, last_cursor_x = 0;
+  bool textwrapX = false, textwrapY = false;
+  bool _fillbg = false;
+  uint16_t (*getColor)(uint16_t x, uint16_t y) = nullptr;
+  bool inTransaction = false;
+  bool _swapBytes = false;
+  uint64_t dmaDoneAt = 0;
+};
+
+class TFT_eSprite : public TFT_eSPI {
+public:
+  explicit TFT_eSprite(TFT_eSPI *tft);
+  ~TFT_eSprite();
+
+  void *createSprite(int16_t width, int16_t height, uint8_t frames = 1);
+  void deleteSprite();
+  bool created() const { return fb != nullptr; }
+  void *getPointer() { return fb; }
+  void *setColorDepth(int8_t b);
+  int8_t getColorDepth() const { return 16; }
+  void fillSprite(uint32_t color) { fillRect(0, 0, _width, _height, color); }
+  void pushSprite(int32_t x, int32_t y);
+  bool pushSprite(int32_t tx, int32_t ty, int32_t sx, int32_t sy, int32_t sw,
+                  int32_t sh);
+
+private:
+  TFT_eSPI *_tft;
+};
+
+// The strip renderer only uses the public API above, so the real library
+// extension is compiled against this backend (see SimTFT.cpp).
+#include <TFT_eSPI/Extensions/Strip.h>
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <Arduino.h>
+
+#include <functional>
+
+#define CONTENT_LENGTH_UNKNOWN ((size_t)-1)
+
+typedef enum { HTTP_ANY, HTTP_GET, HTTP_POST } HTTPMethod;
+
+// Local HTTP server. Requests come from the scenario (sim::netScrape)
+// rather than a socket; handleClient() serves at most one per call, like
+// the real one, and prints the response.
+class WebServer {
+public:
+  typedef std::function<void(void)> THandlerFunction;
+
+  explicit WebServer(int port = 80) : port_(port) {}
+  void begin() { begun_ = true; }
+  // Real server delay(1)s on every idle handleClient() unless disabled
+  void enableDelay(bool value) { nullDelay_ = value; }
+  void on(const String &uri, HTTPMethod method, THandlerFunction fn);
+  void on(const String &uri, THandlerFunction fn) { on(uri, HTTP_ANY, fn); }
+  void onNotFound(THandlerFunction fn) { notFound_ = fn; }
+  void handleClient();
+
+  void setContentLength(size_t len) { contentLength_ = len; }
+  void send(int code, const char *contentType, const String &content);
+  void sendContent(const char *content, size_t size);
+  void sendContent(const String &content) {
+    sendContent(content.c_str(), content.length());
+  }
+
+private:
+  struct Route {
+    String uri;
+    HTTPMethod method;
+    THandlerFunction fn;
+  };
+  int port_;
+  bool begun_ = false;
+  bool nullDelay_ = true;
+  Route routes_[4];
+  uint8_t routeCount_ = 0;
+  THandlerFunction notFound_;
+  size_t contentLength_ = 0;
+  int code_ = 0;
+  size_t sent_ = 0;
+};
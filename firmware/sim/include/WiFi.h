@@ -0,0 +1,60 @@
+#pragma once
+
+#include <Arduino.h>
+
+#include "IPAddress.h"
+
+typedef enum {
+  WL_NO_SHIELD = 255,
+  WL_IDLE_STATUS = 0,
+  WL_NO_SSID_AVAIL = 1,
+  WL_SCAN_COMPLETED = 2,
+  WL_CONNECTED = 3,
+  WL_CONNECT_FAILED = 4,
+  WL_CONNECTION_LOST = 5,
+  WL_DISCONNECTED = 6
+} wl_status_t;
+
+typedef enum { WIFI_OFF = 0, WIFI_STA = 1, WIFI_AP = 2, WIFI_AP_STA = 3 } wifi_mode_t;
+
+// Station side of the simulated access point (see SimNet.cpp).
+class WiFiClass {
+public:
+  bool mode(wifi_mode_t m) {
+    mode_ = m;
+    return true;
+  }
+  wifi_mode_t getMode() const { return mode_; }
+  wl_status_t begin(const char *ssid, const char *passphrase = nullptr,
+                    int32_t channel = 0, const uint8_t *bssid = nullptr,
+                    bool connect = true);
+  bool config(IPAddress local_ip, IPAddress gateway, IPAddress subnet,
+              IPAddress dns1 = (uint32_t)0, IPAddress dns2 = (uint32_t)0);
+  bool disconnect(bool wifioff = false, bool eraseap = false);
+  bool reconnect();
+  bool setAutoReconnect(bool on) {
+    autoReconnect_ = on;
+    return true;
+  }
+  bool getAutoReconnect() const { return autoReconnect_; }
+  bool setSleep(bool) { return true; }
+  bool persistent(bool) { return true; }
+
+  wl_status_t status();
+  bool isConnected() { return status() == WL_CONNECTED; }
+  IPAddress localIP();
+  IPAddress gatewayIP();
+  IPAddress subnetMask();
+  IPAddress dnsIP(uint8_t i = 0);
+  uint8_t *BSSID();
+  int32_t channel();
+  int8_t RSSI();
+  String SSID();
+  String macAddress() { return String("24:6F:28:00:00:01"); }
+
+private:
+  wifi_mode_t mode_ = WIFI_OFF;
+  bool autoReconnect_ = true;
+};
+
+extern WiFiClass WiFi;
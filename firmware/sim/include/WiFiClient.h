@@ -0,0 +1,38 @@
+#pragma once
+
+#include <Arduino.h>
+
+#include "IPAddress.h"
+
+// TCP socket to the simulated backend. Tracks connection state and
+// charges connect/handshake time; HTTPClient exchanges the payloads and
+// leaves the response body here for getStream().
+class WiFiClient : public Stream {
+public:
+  virtual ~WiFiClient() {}
+  virtual int connect(const char *host, uint16_t port);
+  virtual uint8_t connected();
+  virtual void stop();
+  void setTimeout(uint32_t seconds) { timeoutSec_ = seconds; }
+
+  int available() override { return (int)(rx_.length() - rxPos_); }
+  int read() override { return available() ? (uint8_t)rx_[rxPos_++] : -1; }
+  int read(uint8_t *buf, size_t size);
+  int peek() override { return available() ? (uint8_t)rx_[rxPos_] : -1; }
+  size_t write(uint8_t) override { return 1; }
+  using Print::write;
+  operator bool() { return connected(); }
+
+  // sim: connection generation, bumps on every (re)connect
+  uint32_t simEpoch() const { return epoch_; }
+
+protected:
+  bool open_ = false;
+  uint32_t epoch_ = 0;
+  uint32_t linkEpoch_ = 0;
+  uint32_t timeoutSec_ = 5;
+  uint64_t lastUseUs_ = 0;
+  String rx_; // response body as sent on the wire
+  size_t rxPos_ = 0;
+  friend class HTTPClient;
+};
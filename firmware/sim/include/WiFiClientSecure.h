@@ -0,0 +1,18 @@
+#pragma once
+
+#include "WiFiClient.h"
+
+class WiFiClientSecure : public WiFiClient {
+public:
+  int connect(const char *host, uint16_t port) override;
+  void setInsecure() { insecure_ = true; }
+  void setCACert(const char *) { insecure_ = false; }
+  void setHandshakeTimeout(unsigned long seconds) { hsTimeout_ = seconds; }
+
+  // sim: number of TLS handshakes
+  static uint32_t handshakes;
+
+private:
+  bool insecure_ = false;
+  unsigned long hsTimeout_ = 120;
+};
@@ -0,0 +1,9 @@
+#pragma once
+
+#include <Arduino.h>
+
+class WiFiUDP {
+public:
+  uint8_t begin(uint16_t) { return 1; }
+  void stop() {}
+};
@@ -0,0 +1,21 @@
+#pragma once
+
+#include <Arduino.h>
+
+// I2C bus: transactions are routed to sim::I2cDevice models by address.
+class TwoWire {
+public:
+  explicit TwoWire(uint8_t bus) : bus_(bus) {}
+  bool begin(int sda = -1, int scl = -1, uint32_t frequency = 0);
+  void setClock(uint32_t hz) { clock_ = hz; }
+  uint32_t getClock() const { return clock_; }
+
+  // Wire time for `bytes` payload bytes plus address and start/stop.
+  uint64_t transferUs(size_t bytes) const;
+
+private:
+  uint8_t bus_;
+  uint32_t clock_ = 100000;
+};
+
+extern TwoWire Wire;
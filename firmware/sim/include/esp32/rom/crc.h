@@ -0,0 +1,16 @@
+#pragma once
+
+#include <stdint.h>
+
+// Same contract as the ESP32 ROM routine: standard reflected CRC-32
+// (poly 0xEDB88320), pass 0 to start and the previous result to chain.
+static inline uint32_t crc32_le(uint32_t crc, const uint8_t *buf,
+                                uint32_t len) {
+  crc = ~crc;
+  while (len--) {
+    crc ^= *buf++;
+    for (int k = 0; k < 8; k++)
+      crc = (crc >> 1) ^ (0xEDB88320UL & (0 - (crc & 1)));
+  }
+  return ~crc;
+}
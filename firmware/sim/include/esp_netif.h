@@ -0,0 +1,8 @@
+#pragma once
+
+// Just enough of esp_netif to reach the station's lwIP netif (see
+// lwip/dhcp.h).
+
+typedef struct esp_netif_obj esp_netif_t;
+
+esp_netif_t *esp_netif_get_handle_from_ifkey(const char *if_key);
@@ -0,0 +1,6 @@
+#pragma once
+
+#include "esp_netif.h"
+
+// The lwIP struct netif behind an esp_netif handle
+void *esp_netif_get_netif_impl(esp_netif_t *esp_netif);
@@ -0,0 +1,15 @@
+#pragma once
+
+#include <stdint.h>
+
+// DHCP client state of the station, as lwIP keeps it after the last ACK
+// (lease times in seconds). Filled in by the simulated AP.
+struct netif;
+
+struct dhcp {
+  uint32_t offered_t0_lease;
+  uint32_t offered_t1_renew;
+  uint32_t offered_t2_rebind;
+};
+
+struct dhcp *netif_dhcp_data(struct netif *netif);
@@ -0,0 +1,328 @@
+// AS608 optical fingerprint module on UART2, speaking the real packet
+// protocol so the unmodified Adafruit_Fingerprint driver runs against it.
+
+#include <Arduino.h>
+
+#include <map>
+#include <vector>
+
+#include "SimAS608.h"
+#include "SimDevices.h"
+#include "SimKernel.h"
+
+#define AS608_PORT 2
+#define AS608_CAPACITY 162
+#define AS608_TEMPLATE_BYTES 512
+
+// Processing times measured on a ZFM-20 class module
+#define T_IMAGE_FINGER_US 150000
+#define T_IMAGE_EMPTY_US 40000
+#define T_TZ_US 300000
+#define T_SEARCH_BASE_US 20000
+#define T_SEARCH_PER_TPL_US 600
+#define T_REGMODEL_US 120000
+#define T_STORE_US 80000
+#define T_LOAD_US 40000
+#define T_DELETE_US 60000
+#define T_MATCH_US 60000
+#define T_SMALL_US 5000
+
+namespace {
+
+class AS608 : public sim::UartDevice {
+public:
+  void onRx(uint8_t b) override;
+
+  // Identity under the window (0 = nothing)
+  uint32_t finger = 0;
+  bool fingerBad = false;
+  std::map<uint16_t, uint32_t> library; // page -> identity
+  uint32_t imageId = 0;
+  bool imageBad = false;
+  uint32_t charBuf[3] = {0, 0, 0};
+  uint32_t modelId = 0;
+  uint8_t packetLen = 128;
+  uint32_t commands = 0;
+
+private:
+  void handle(uint8_t type, const std::vector<uint8_t> &payload);
+  void reply(uint64_t delayUs, uint8_t code, const uint8_t *data = nullptr,
+             size_t n = 0);
+  void sendPacket(uint64_t atUs, uint8_t type, const uint8_t *data, size_t n);
+  void uploadTemplate(uint64_t atUs, uint32_t id);
+
+  // Receive state
+  size_t idx_ = 0;
+  uint8_t type_ = 0;
+  uint16_t len_ = 0;
+  std::vector<uint8_t> payload_;
+  // Download (host -> module) in progress
+  int downSlot_ = 0;
+  std::vector<uint8_t> down_;
+};
+
+AS608 sensor;
+
+void templateBytes(uint32_t id, uint8_t *out) {
+  uint32_t s = id * 2654435761u + 1;
+  for (int i = 0; i < AS608_TEMPLATE_BYTES; i++) {
+    s ^= s << 13;
+    s ^= s >> 17;
+    s ^= s << 5;
+    out[i] = (uint8_t)s;
+  }
+  out[0] = 0x03;
+  out[1] = 0x01;
+  out[2] = (uint8_t)(id >> 24);
+  out[3] = (uint8_t)(id >> 16);
+  out[4] = (uint8_t)(id >> 8);
+  out[5] = (uint8_t)id;
+}
+
+uint32_t templateId(const uint8_t *tpl) {
+  return ((uint32_t)tpl[2] << 24) | ((uint32_t)tpl[3] << 16) |
+         ((uint32_t)tpl[4] << 8) | tpl[5];
+}
+
+void AS608::onRx(uint8_t b) {
+  switch (idx_) {
+  case 0:
+    if (b != 0xEF)
+      return;
+    break;
+  case 1:
+    if (b != 0x01) {
+      idx_ = 0;
+      return;
+    }
+    break;
+  case 2:
+  case 3:
+  case 4:
+  case 5:
+    break;
+  case 6:
+    type_ = b;
+    break;
+  case 7:
+    len_ = (uint16_t)b << 8;
+    break;
+  case 8:
+    len_ |= b;
+    payload_.clear();
+    break;
+  default:
+    payload_.push_back(b);
+    if (payload_.size() == len_) {
+      idx_ = 0;
+      payload_.resize(len_ - 2); // checksum
+      handle(type_, payload_);
+      return;
+    }
+    break;
+  }
+  idx_++;
+}
+
+void AS608::sendPacket(uint64_t atUs, uint8_t type, const uint8_t *data,
+                       size_t n) {
+  std::vector<uint8_t> p = {0xEF, 0x01, 0xFF, 0xFF, 0xFF, 0xFF, type};
+  uint16_t len = (uint16_t)(n + 2);
+  p.push_back(len >> 8);
+  p.push_back(len & 0xFF);
+  uint16_t sum = (len >> 8) + (len & 0xFF) + type;
+  for (size_t i = 0; i < n; i++) {
+    p.push_back(data[i]);
+    sum += data[i];
+  }
+  p.push_back(sum >> 8);
+  p.push_back(sum & 0xFF);
+  sim::uartSend(AS608_PORT, p.data(), p.size(), atUs);
+}
+
+void AS608::reply(uint64_t delayUs, uint8_t code, const uint8_t *data,
+                  size_t n) {
+  uint8_t buf[32];
+  buf[0] = code;
+  if (n)
+    memcpy(buf + 1, data, n);
+  sendPacket(sim::nowUs() + delayUs, 0x07, buf, n + 1);
+}
+
+void AS608::uploadTemplate(uint64_t atUs, uint32_t id) {
+  uint8_t tpl[AS608_TEMPLATE_BYTES];
+  templateBytes(id, tpl);
+  for (size_t off = 0; off < sizeof(tpl); off += packetLen) {
+    bool last = off + packetLen >= sizeof(tpl);
+    sendPacket(atUs, last ? 0x08 : 0x02, tpl + off, packetLen);
+  }
+}
+
+void AS608::handle(uint8_t type, const std::vector<uint8_t> &p) {
+  commands++;
+  if (type == 0x02 || type == 0x08) {
+    // Template download data
+    down_.insert(down_.end(), p.begin(), p.end());
+    if (type == 0x08 && downSlot_) {
+      charBuf[downSlot_] =
+          down_.size() >= 6 ? templateId(down_.data()) : 0;
+      downSlot_ = 0;
+    }
+    return;
+  }
+  if (type != 0x01 || p.empty())
+    return;
+
+  uint8_t out[16];
+  switch (p[0]) {
+  case 0x01: // GetImage
+    if (finger) {
+      imageId = finger;
+      imageBad = fingerBad;
+      reply(T_IMAGE_FINGER_US, 0x00);
+    } else {
+      reply(T_IMAGE_EMPTY_US, 0x02);
+    }
+    break;
+  case 0x02: { // Img2Tz
+    uint8_t slot = p.size() > 1 ? p[1] : 1;
+    if (!imageId) {
+      reply(T_SMALL_US, 0x15);
+    } else if (imageBad) {
+      reply(T_TZ_US, 0x06);
+    } else {
+      charBuf[slot == 2 ? 2 : 1] = imageId;
+      reply(T_TZ_US, 0x00);
+    }
+    break;
+  }
+  case 0x03: // Match CharBuffer1 vs CharBuffer2
+    out[0] = 0;
+    out[1] = charBuf[1] && charBuf[1] == charBuf[2] ? 180 : 0;
+    reply(T_MATCH_US, out[1] ? 0x00 : 0x08, out, 2);
+    break;
+  case 0x04:   // Search
+  case 0x1B: { // HighSpeedSearch
+    uint32_t id = charBuf[p.size() > 1 && p[1] == 2 ? 2 : 1];
+    uint16_t start = p.size() > 3 ? ((p[2] << 8) | p[3]) : 0;
+    uint16_t count = p.size() > 5 ? ((p[4] << 8) | p[5]) : AS608_CAPACITY;
+    uint64_t t = T_SEARCH_BASE_US;
+    for (auto &e : library) {
+      if (e.first < start || e.first >= start + count)
+        continue;
+      t += T_SEARCH_PER_TPL_US;
+      if (e.second == id && id) {
+        out[0] = e.first >> 8;
+        out[1] = e.first & 0xFF;
+        out[2] = 0;
+        out[3] = 150;
+        reply(t, 0x00, out, 4);
+        return;
+      }
+    }
+    memset(out, 0, 4);
+    reply(t, 0x09, out, 4);
+    break;
+  }
+  case 0x05: // RegModel
+    if (charBuf[1] && charBuf[1] == charBuf[2]) {
+      modelId = charBuf[1];
+      reply(T_REGMODEL_US, 0x00);
+    } else {
+      reply(T_REGMODEL_US, 0x0A);
+    }
+    break;
+  case 0x06: { // Store
+    uint16_t page = (p[2] << 8) | p[3];
+    uint32_t id = modelId ? modelId : charBuf[p[1] == 2 ? 2 : 1];
+    if (page >= AS608_CAPACITY) {
+      reply(T_SMALL_US, 0x0B);
+    } else {
+      library[page] = id;
+      modelId = 0;
+      reply(T_STORE_US, 0x00);
+    }
+    break;
+  }
+  case 0x07: { // LoadChar
+    uint16_t page = (p[2] << 8) | p[3];
+    auto it = library.find(page);
+    if (it == library.end()) {
+      reply(T_LOAD_US, 0x0C);
+    } else {
+      charBuf[p[1] == 2 ? 2 : 1] = it->second;
+      reply(T_LOAD_US, 0x00);
+    }
+    break;
+  }
+  case 0x08: { // UpChar
+    uint32_t id = charBuf[p.size() > 1 && p[1] == 2 ? 2 : 1];
+    reply(T_SMALL_US, 0x00);
+    uploadTemplate(sim::nowUs() + T_SMALL_US, id);
+    break;
+  }
+  case 0x09: // DownChar
+    downSlot_ = p.size() > 1 && p[1] == 2 ? 2 : 1;
+    down_.clear();
+    reply(T_SMALL_US, 0x00);
+    break;
+  case 0x0C: { // DeletChar
+    uint16_t page = (p[1] << 8) | p[2];
+    uint16_t n = (p[3] << 8) | p[4];
+    for (uint16_t i = 0; i < n; i++)
+      library.erase(page + i);
+    reply(T_DELETE_US, 0x00);
+    break;
+  }
+  case 0x0D: // Empty
+    library.clear();
+    reply(T_DELETE_US * 3, 0x00);
+    break;
+  case 0x0F: { // ReadSysPara
+    uint8_t sp[16] = {0x00, 0x00, 0x00, 0x09, 0, AS608_CAPACITY, 0x00, 0x03,
+                      0xFF, 0xFF, 0xFF, 0xFF, 0x00, 0x02, 0x00, 0x06};
+    reply(T_SMALL_US, 0x00, sp, sizeof(sp));
+    break;
+  }
+  case 0x13: // VfyPwd
+    reply(T_SMALL_US, 0x00);
+    break;
+  case 0x1D: // TempleteNum
+    out[0] = library.size() >> 8;
+    out[1] = library.size() & 0xFF;
+    reply(T_SMALL_US, 0x00, out, 2);
+    break;
+  default:
+    reply(T_SMALL_US, 0x00);
+    break;
+  }
+}
+
+} // namespace
+
+namespace sim {
+
+void as608Attach() { attachUart(AS608_PORT, &sensor); }
+
+void as608Enroll(uint16_t page, uint32_t identity) {
+  sensor.library[page] = identity;
+}
+
+void as608Forget(uint16_t page) { sensor.library.erase(page); }
+
+void as608TemplateBytes(uint32_t identity, uint8_t *out) {
+  templateBytes(identity, out);
+}
+
+void as608Touch(uint32_t identity, bool bad) {
+  sensor.finger = identity;
+  sensor.fingerBad = bad;
+}
+
+void as608Lift() { sensor.finger = 0; }
+
+uint32_t as608Commands() { return sensor.commands; }
+
+size_t as608LibrarySize() { return sensor.library.size(); }
+
+} // namespace sim
@@ -0,0 +1,581 @@
+#include <Arduino.h>
+
+#include <atomic>
+#include <deque>
+#include <map>
+#include <new>
+#include <utility>
+
+#include "SimDevices.h"
+
+// ================== TIME ==================
+unsigned long millis() { return (unsigned long)(sim::nowUs() / 1000); }
+
+unsigned long micros() { return (unsigned long)sim::nowUs(); }
+
+void delay(uint32_t ms) { sim::sleepUs((uint64_t)ms * 1000); }
+
+void delayMicroseconds(uint32_t us) { sim::charge(us); }
+
+void yield() { sim::yieldNow(); }
+
+// ================== GPIO ==================
+static int pinLevels[64];
+static bool pinInit[64];
+static void (*pinIsr[64])(void);
+static int pinIsrMode[64];
+
+namespace sim {
+
+void setPin(uint8_t pin, int level) {
+  if (pin >= 64)
+    return;
+  int old = pinLevel(pin);
+  pinLevels[pin] = level;
+  pinInit[pin] = true;
+  if (!pinIsr[pin] || old == level)
+    return;
+  int mode = pinIsrMode[pin];
+  if (mode == CHANGE || (mode == RISING && level) ||
+      (mode == FALLING && !level))
+    pinIsr[pin]();
+}
+
+int pinLevel(uint8_t pin) {
+  if (pin >= 64)
+    return LOW;
+  return pinInit[pin] ? pinLevels[pin] : HIGH;
+}
+
+} // namespace sim
+
+void pinMode(uint8_t pin, uint8_t mode) {
+  if (pin < 64 && !pinInit[pin] && mode == INPUT_PULLUP)
+    sim::setPin(pin, HIGH);
+}
+
+int digitalRead(uint8_t pin) {
+  sim::charge(1);
+  return sim::pinLevel(pin);
+}
+
+void digitalWrite(uint8_t pin, uint8_t val) {
+  sim::charge(1);
+  sim::setPin(pin, val);
+}
+
+void attachInterrupt(uint8_t pin, void (*isr)(void), int mode) {
+  if (pin >= 64)
+    return;
+  pinIsr[pin] = isr;
+  pinIsrMode[pin] = mode;
+}
+
+void detachInterrupt(uint8_t pin) {
+  if (pin < 64)
+    pinIsr[pin] = nullptr;
+}
+
+// ================== RANDOM ==================
+static uint32_t rngState = 0x12345678;
+
+void randomSeed(unsigned long seed) { rngState = seed ? seed : 1; }
+
+long random(long howbig) {
+  if (howbig <= 0)
+    return 0;
+  rngState ^= rngState << 13;
+  rngState ^= rngState >> 17;
+  rngState ^= rngState << 5;
+  return rngState % howbig;
+}
+
+uint32_t esp_random() {
+  static uint32_t hwState = 0x9E3779B9;
+  hwState ^= hwState << 13;
+  hwState ^= hwState >> 17;
+  hwState ^= hwState << 5;
+  return hwState;
+}
+
+long random(long howsmall, long howbig) {
+  if (howsmall >= howbig)
+    return howsmall;
+  return howsmall + random(howbig - howsmall);
+}
+
+// ================== String ==================
+// String buffers come from the counted heap below, like malloc on target
+static void *heapRealloc(void *ptr, size_t n);
+static void heapFree(void *ptr);
+
+String::String(const char *cstr) : buf_(nullptr), len_(0), cap_(0) {
+  if (cstr)
+    assign(cstr, strlen(cstr));
+}
+
+String::String(const String &s) : buf_(nullptr), len_(0), cap_(0) {
+  assign(s.c_str(), s.len_);
+}
+
+String::String(String &&s) : buf_(s.buf_), len_(s.len_), cap_(s.cap_) {
+  s.buf_ = nullptr;
+  s.len_ = s.cap_ = 0;
+}
+
+String::String(const __FlashStringHelper *s)
+    : String(reinterpret_cast<const char *>(s)) {}
+
+String::String(char c) : buf_(nullptr), len_(0), cap_(0) { assign(&c, 1); }
+
+static void formatInt(char *buf, size_t n, unsigned long long v, int base,
+                      bool neg) {
+  char tmp[72];
+  int i = 0;
+  do {
+    int d = v % base;
+    tmp[i++] = d < 10 ? '0' + d : 'A' + d - 10;
+    v /= base;
+  } while (v);
+  size_t o = 0;
+  if (neg)
+    buf[o++] = '-';
+  while (i && o + 1 < n)
+    buf[o++] = tmp[--i];
+  buf[o] = 0;
+}
+
+String::String(unsigned char v, unsigned char base)
+    : String((unsigned long)v, base) {}
+String::String(int v, unsigned char base) : String((long)v, base) {}
+String::String(unsigned int v, unsigned char base)
+    : String((unsigned long)v, base) {}
+
+String::String(long v, unsigned char base) : buf_(nullptr), len_(0), cap_(0) {
+  char b[72];
+  if (base == 10 && v < 0)
+    formatInt(b, sizeof(b), -(unsigned long long)v, 10, true);
+  else
+    formatInt(b, sizeof(b), (unsigned long)v, base, false);
+  assign(b, strlen(b));
+}
+
+String::String(unsigned long v, unsigned char base)
+    : buf_(nullptr), len_(0), cap_(0) {
+  char b[72];
+  formatInt(b, sizeof(b), v, base, false);
+  assign(b, strlen(b));
+}
+
+String::String(float v, unsigned int decimals)
+    : String((double)v, decimals) {}
+
+String::String(double v, unsigned int decimals)
+    : buf_(nullptr), len_(0), cap_(0) {
+  char b[64];
+  snprintf(b, sizeof(b), "%.*f", decimals, v);
+  assign(b, strlen(b));
+}
+
+String::~String() { heapFree(buf_); }
+
+String &String::operator=(const String &rhs) {
+  if (this != &rhs)
+    assign(rhs.c_str(), rhs.len_);
+  return *this;
+}
+
+String &String::operator=(String &&rhs) {
+  if (this != &rhs) {
+    heapFree(buf_);
+    buf_ = rhs.buf_;
+    len_ = rhs.len_;
+    cap_ = rhs.cap_;
+    rhs.buf_ = nullptr;
+    rhs.len_ = rhs.cap_ = 0;
+  }
+  return *this;
+}
+
+String &String::operator=(const char *cstr) {
+  if (cstr)
+    assign(cstr, strlen(cstr));
+  else {
+    heapFree(buf_);
+    buf_ = nullptr;
+    len_ = cap_ = 0;
+  }
+  return *this;
+}
+
+bool String::reserve(unsigned int size) {
+  if (size <= cap_ && buf_)
+    return true;
+  char *nb = (char *)heapRealloc(buf_, size + 1);
+  if (!nb)
+    return false;
+  if (!buf_)
+    nb[0] = 0;
+  buf_ = nb;
+  cap_ = size;
+  return true;
+}
+
+void String::assign(const char *cstr, unsigned int len) {
+  if (!reserve(len))
+    return;
+  memmove(buf_, cstr, len);
+  buf_[len] = 0;
+  len_ = len;
+}
+
+bool String::concat(const char *cstr, unsigned int len) {
+  if (!cstr)
+    return false;
+  if (!reserve(len_ + len))
+    return false;
+  memmove(buf_ + len_, cstr, len);
+  len_ += len;
+  buf_[len_] = 0;
+  return true;
+}
+
+bool String::concat(const String &s) { return concat(s.c_str(), s.len_); }
+bool String::concat(const char *cstr) {
+  return cstr && concat(cstr, strlen(cstr));
+}
+bool String::concat(char c) { return concat(&c, 1); }
+bool String::concat(int v) { return concat(String(v)); }
+bool String::concat(unsigned int v) { return concat(String(v)); }
+bool String::concat(long v) { return concat(String(v)); }
+bool String::concat(unsigned long v) { return concat(String(v)); }
+
+bool String::equals(const String &s) const {
+  return len_ == s.len_ && strcmp(c_str(), s.c_str()) == 0;
+}
+
+bool String::equals(const char *cstr) const {
+  return strcmp(c_str(), cstr ? cstr : "") == 0;
+}
+
+int String::indexOf(char c, unsigned int from) const {
+  if (from >= len_)
+    return -1;
+  const char *p = strchr(c_str() + from, c);
+  return p ? (int)(p - c_str()) : -1;
+}
+
+int String::indexOf(const char *s, unsigned int from) const {
+  if (from >= len_)
+    return -1;
+  const char *p = strstr(c_str() + from, s);
+  return p ? (int)(p - c_str()) : -1;
+}
+
+bool String::startsWith(const char *s) const {
+  return strncmp(c_str(), s, strlen(s)) == 0;
+}
+
+String String::substring(unsigned int from) const {
+  return substring(from, len_);
+}
+
+String String::substring(unsigned int from, unsigned int to) const {
+  if (from > to)
+    std::swap(from, to);
+  if (from >= len_)
+    return String();
+  if (to > len_)
+    to = len_;
+  String out;
+  out.assign(c_str() + from, to - from);
+  return out;
+}
+
+void String::trim() {
+  unsigned int b = 0, e = len_;
+  while (b < e && isspace((unsigned char)buf_[b]))
+    b++;
+  while (e > b && isspace((unsigned char)buf_[e - 1]))
+    e--;
+  String t = substring(b, e);
+  *this = std::move(t);
+}
+
+long String::toInt() const { return atol(c_str()); }
+float String::toFloat() const { return (float)atof(c_str()); }
+
+String operator+(const String &lhs, const String &rhs) {
+  String s(lhs);
+  s.concat(rhs);
+  return s;
+}
+
+String operator+(const String &lhs, const char *rhs) {
+  String s(lhs);
+  s.concat(rhs);
+  return s;
+}
+
+String operator+(const char *lhs, const String &rhs) {
+  String s(lhs);
+  s.concat(rhs);
+  return s;
+}
+
+String operator+(const String &lhs, char rhs) {
+  String s(lhs);
+  s.concat(rhs);
+  return s;
+}
+
+// ================== Print / Stream ==================
+size_t Print::write(const uint8_t *buffer, size_t size) {
+  size_t n = 0;
+  while (size--)
+    n += write(*buffer++);
+  return n;
+}
+
+size_t Print::printf(const char *format, ...) {
+  char buf[512];
+  va_list ap;
+  va_start(ap, format);
+  int n = vsnprintf(buf, sizeof(buf), format, ap);
+  va_end(ap);
+  if (n < 0)
+    return 0;
+  return write((const uint8_t *)buf, std::min<size_t>(n, sizeof(buf) - 1));
+}
+
+size_t Print::print(long v, int base) { return print(String(v, base)); }
+
+size_t Print::print(unsigned long v, int base) {
+  return print(String(v, base));
+}
+
+size_t Print::print(double v, int digits) { return print(String(v, digits)); }
+
+int Stream::timedRead() {
+  unsigned long start = millis();
+  do {
+    int c = read();
+    if (c >= 0)
+      return c;
+    delay(1);
+  } while (millis() - start < timeout_);
+  return -1;
+}
+
+size_t Stream::readBytes(char *buffer, size_t length) {
+  size_t n = 0;
+  while (n < length) {
+    int c = timedRead();
+    if (c < 0)
+      break;
+    buffer[n++] = (char)c;
+  }
+  return n;
+}
+
+String Stream::readStringUntil(char terminator) {
+  String s;
+  int c = timedRead();
+  while (c >= 0 && c != terminator) {
+    s += (char)c;
+    c = timedRead();
+  }
+  return s;
+}
+
+// ================== UART ==================
+struct UartPort {
+  sim::UartDevice *dev = nullptr;
+  unsigned long baud = 115200;
+  std::deque<std::pair<uint64_t, uint8_t>> rx;
+  uint64_t txDoneUs = 0; // last queued TX byte leaves the wire
+};
+
+
+static UartPort uarts[3];
+
+namespace sim {
+
+void attachUart(int port, UartDevice *dev) { uarts[port].dev = dev; }
+
+uint64_t uartByteUs(int port) {
+  return 10000000ULL / (uarts[port].baud ? uarts[port].baud : 115200);
+}
+
+void uartSend(int port, const uint8_t *data, size_t n, uint64_t atUs) {
+  uint64_t t = atUs;
+  uint64_t step = uartByteUs(port);
+  if (!uarts[port].rx.empty())
+    t = std::max(t, uarts[port].rx.back().first + step);
+  for (size_t i = 0; i < n; i++, t += step)
+    uarts[port].rx.push_back(std::make_pair(t, data[i]));
+}
+
+} // namespace sim
+
+// Bytes leave one after another at the line rate, however they were
+// written; the caller does not wait for the wire.
+static uint64_t txSlot(int port) {
+  UartPort &u = uarts[port];
+  u.txDoneUs = std::max(u.txDoneUs, sim::nowUs()) + sim::uartByteUs(port);
+  return u.txDoneUs;
+}
+
+HardwareSerial Serial(0);
+
+HardwareSerial::HardwareSerial(int uart_nr) : nr_(uart_nr), baud_(115200) {}
+
+void HardwareSerial::begin(unsigned long baud, uint32_t, int8_t, int8_t) {
+  baud_ = baud;
+  uarts[nr_].baud = baud;
+}
+
+int HardwareSerial::available() {
+  if (nr_ == 0)
+    return 0;
+  uint64_t now = sim::nowUs();
+  int n = 0;
+  for (auto &e : uarts[nr_].rx) {
+    if (e.first > now)
+      break;
+    n++;
+  }
+  return n;
+}
+
+int HardwareSerial::peek() {
+  if (!available())
+    return -1;
+  return uarts[nr_].rx.front().second;
+}
+
+int HardwareSerial::read() {
+  if (!available())
+    return -1;
+  uint8_t b = uarts[nr_].rx.front().second;
+  uarts[nr_].rx.pop_front();
+  return b;
+}
+
+size_t HardwareSerial::write(uint8_t c) {
+  if (nr_ == 0) {
+    fputc(c, stdout);
+    return 1;
+  }
+  // TX FIFO drains in the background; the device sees the byte on time.
+  if (uarts[nr_].dev) {
+    sim::UartDevice *dev = uarts[nr_].dev;
+    sim::schedule(txSlot(nr_), [dev, c] { dev->onRx(c); });
+  }
+  return 1;
+}
+
+size_t HardwareSerial::write(const uint8_t *buffer, size_t size) {
+  if (nr_ == 0) {
+    fwrite(buffer, 1, size, stdout);
+    return size;
+  }
+  sim::UartDevice *dev = uarts[nr_].dev;
+  for (size_t i = 0; i < size; i++) {
+    uint64_t t = txSlot(nr_);
+    uint8_t c = buffer[i];
+    if (dev)
+      sim::schedule(t, [dev, c] { dev->onRx(c); });
+  }
+  return size;
+}
+
+// ================== HEAP ==================
+// Counts live bytes (operator new and String buffers) so ESP.getFreeHeap()
+// moves like it does on target. Allocations inside a HostHeapScope (the
+// backend model) are not device heap; the second header word remembers
+// whether a block is counted.
+static std::atomic<size_t> heapLive(0);
+static std::atomic<size_t> heapMax(0);
+static thread_local int hostHeapDepth = 0;
+static const size_t HEAP_SIZE = 320 * 1024;
+
+static void count(size_t *p, size_t n) {
+  p[0] = n;
+  if (p[1]) {
+    heapLive += n;
+    if (heapLive > heapMax)
+      heapMax = heapLive.load();
+  }
+}
+
+static void *heapRealloc(void *ptr, size_t n) {
+  size_t *old = ptr ? (size_t *)ptr - 2 : nullptr;
+  size_t was = old ? old[0] : 0;
+  size_t *p = (size_t *)realloc(old, n + sizeof(size_t) * 2);
+  if (!p)
+    return nullptr;
+  if (old && p[1])
+    heapLive -= was;
+  // Re-decided on every resize: backend state first touched by device code
+  // (or the other way round) follows whoever grows it
+  p[1] = hostHeapDepth == 0;
+  count(p, n);
+  return p + 2;
+}
+
+static void heapFree(void *ptr) {
+  if (!ptr)
+    return;
+  size_t *p = (size_t *)ptr - 2;
+  if (p[1])
+    heapLive -= p[0];
+  free(p);
+}
+
+void *operator new(size_t n) {
+  void *p = heapRealloc(nullptr, n);
+  if (!p)
+    throw std::bad_alloc();
+  return p;
+}
+
+void operator delete(void *ptr) noexcept { heapFree(ptr); }
+
+void operator delete(void *ptr, size_t) noexcept { operator delete(ptr); }
+void *operator new[](size_t n) { return operator new(n); }
+void operator delete[](void *ptr) noexcept { operator delete(ptr); }
+void operator delete[](void *ptr, size_t) noexcept { operator delete(ptr); }
+
+namespace sim {
+size_t heapUsed() { return heapLive; }
+size_t heapPeak() { return heapMax; }
+HostHeapScope::HostHeapScope() { hostHeapDepth++; }
+HostHeapScope::~HostHeapScope() { hostHeapDepth--; }
+} // namespace sim
+
+EspClass ESP;
+
+uint32_t EspClass::getFreeHeap() {
+  return heapLive < HEAP_SIZE ? HEAP_SIZE - heapLive : 0;
+}
+uint32_t EspClass::getMinFreeHeap() {
+  return heapMax < HEAP_SIZE ? HEAP_SIZE - heapMax : 0;
+}
+uint32_t EspClass::getMaxAllocHeap() { return getFreeHeap(); }
+uint32_t EspClass::getHeapSize() { return HEAP_SIZE; }
+// CCOUNT is per core; the APP CPU is released later in boot, so its
+// counter runs behind the PRO CPU's by a constant amount
+#define SIM_APP_CPU_START_US 187345ULL
+
+uint32_t EspClass::getCycleCount() {
+  uint64_t us = sim::nowUs();
+  if (sim::currentCore() == 1)
+    us -= SIM_APP_CPU_START_US;
+  return (uint32_t)(us * getCpuFreqMHz());
+}
+
+void EspClass::restart() {
+  printf("[sim] ESP.restart()\n");
+  sim::finish();
+}
@@ -0,0 +1,175 @@
+// DS3231 register model on I2C address 0x68 with an optional 1 Hz SQW
+// output wired to a GPIO.
+
+#include <Arduino.h>
+#include <time.h>
+
+#include "SimDS3231.h"
+#include "SimDevices.h"
+#include "SimKernel.h"
+
+namespace {
+
+uint8_t bin2bcd(uint8_t v) { return v + 6 * (v / 10); }
+uint8_t bcd2bin(uint8_t v) { return v - 6 * (v >> 4); }
+
+class DS3231 : public sim::I2cDevice {
+public:
+  void onWrite(const uint8_t *data, size_t n) override;
+  size_t onRead(uint8_t *data, size_t n) override;
+
+  // RTC seconds = base + elapsed sim time scaled by the crystal error
+  uint32_t baseUnix = 0;
+  uint64_t baseUs = 0;
+  double ppm = 0;
+  uint8_t ctrl = 0x1C; // INTCN=1 after power-up, SQW off
+  uint8_t status = 0x00;
+  uint8_t ptr = 0;
+  uint32_t reads = 0;
+  int sqwPin = -1;
+  uint32_t sqwJitterUs = 0;
+  uint32_t sqwGen = 0;
+
+  double rtcSeconds() const {
+    double el = (double)(sim::nowUs() - baseUs) / 1e6;
+    return baseUnix + el * (1.0 + ppm * 1e-6);
+  }
+  void armSqw();
+};
+
+DS3231 rtc;
+
+void DS3231::onWrite(const uint8_t *data, size_t n) {
+  if (!n)
+    return;
+  ptr = data[0];
+  if (n == 1)
+    return;
+  if (ptr == 0x00 && n >= 8) {
+    struct tm t;
+    memset(&t, 0, sizeof(t));
+    t.tm_sec = bcd2bin(data[1] & 0x7F);
+    t.tm_min = bcd2bin(data[2]);
+    t.tm_hour = bcd2bin(data[3]);
+    t.tm_mday = bcd2bin(data[5]);
+    t.tm_mon = bcd2bin(data[6] & 0x7F) - 1;
+    t.tm_year = bcd2bin(data[7]) + 100;
+    // Writing seconds resets the countdown chain
+    baseUnix = (uint32_t)timegm(&t);
+    baseUs = sim::nowUs();
+    armSqw();
+    return;
+  }
+  for (size_t i = 1; i < n; i++, ptr++) {
+    if (ptr == 0x0E) {
+      ctrl = data[i];
+      armSqw();
+    } else if (ptr == 0x0F) {
+      status = data[i];
+    }
+  }
+}
+
+size_t DS3231::onRead(uint8_t *data, size_t n) {
+  reads++;
+  time_t now = (time_t)rtcSeconds();
+  struct tm t;
+  gmtime_r(&now, &t);
+  for (size_t i = 0; i < n; i++, ptr++) {
+    switch (ptr) {
+    case 0x00:
+      data[i] = bin2bcd(t.tm_sec);
+      break;
+    case 0x01:
+      data[i] = bin2bcd(t.tm_min);
+      break;
+    case 0x02:
+      data[i] = bin2bcd(t.tm_hour);
+      break;
+    case 0x03:
+      data[i] = bin2bcd(t.tm_wday ? t.tm_wday : 7);
+      break;
+    case 0x04:
+      data[i] = bin2bcd(t.tm_mday);
+      break;
+    case 0x05:
+      data[i] = bin2bcd(t.tm_mon + 1);
+      break;
+    case 0x06:
+      data[i] = bin2bcd(t.tm_year - 100);
+      break;
+    case 0x0E:
+      data[i] = ctrl;
+      break;
+    case 0x0F:
+      data[i] = status;
+      break;
+    case 0x11:
+      data[i] = 25;
+      break;
+    default:
+      data[i] = 0;
+      break;
+    }
+  }
+  return n;
+}
+
+// 1 Hz output: falling edge when the seconds register increments, rising
+// edge half a second later. Writing the time restarts the chain.
+static bool sqwOn() { return !(rtc.ctrl & 0x04) && (rtc.ctrl & 0x18) == 0; }
+
+static void sqwFire(uint64_t at, uint32_t gen) {
+  if (gen != rtc.sqwGen || !sqwOn())
+    return;
+  uint32_t j = rtc.sqwJitterUs ? (uint32_t)random(rtc.sqwJitterUs) : 0;
+  sim::schedule(at + j, [gen] {
+    if (gen == rtc.sqwGen)
+      sim::setPin(rtc.sqwPin, LOW);
+  });
+  sim::schedule(at + 500000, [gen] {
+    if (gen == rtc.sqwGen)
+      sim::setPin(rtc.sqwPin, HIGH);
+  });
+  uint64_t nextAt = at + (uint64_t)(1e6 / (1.0 + rtc.ppm * 1e-6));
+  sim::schedule(at + 600000, [nextAt, gen] { sqwFire(nextAt, gen); });
+}
+
+void DS3231::armSqw() {
+  uint32_t gen = ++sqwGen;
+  if (!sqwOn() || sqwPin < 0)
+    return;
+  double next = floor(rtcSeconds()) + 1.0;
+  uint64_t at =
+      baseUs + (uint64_t)((next - baseUnix) / (1.0 + ppm * 1e-6) * 1e6);
+  sim::setPin(sqwPin, HIGH);
+  sqwFire(at, gen);
+}
+
+} // namespace
+
+namespace sim {
+
+void ds3231Attach(uint32_t unixtime) {
+  rtc.baseUnix = unixtime;
+  rtc.baseUs = nowUs();
+  attachI2c(0x68, &rtc);
+}
+
+void ds3231SetDriftPpm(double ppm) {
+  rtc.baseUnix = (uint32_t)rtc.rtcSeconds();
+  rtc.baseUs = nowUs();
+  rtc.ppm = ppm;
+}
+
+void ds3231WireSqw(uint8_t pin, uint32_t jitterUs) {
+  rtc.sqwPin = pin;
+  rtc.sqwJitterUs = jitterUs;
+  rtc.armSqw();
+}
+
+uint32_t ds3231Reads() { return rtc.reads; }
+
+double ds3231Seconds() { return rtc.rtcSeconds(); }
+
+} // namespace sim
@@ -0,0 +1,313 @@
+#include <FS.h>
+#include <LittleFS.h>
+#include <dirent.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#define SIM_FS_OPEN_US 300
+#define SIM_FS_SYNC_US 1200
+#define SIM_FS_PAGE_US 500 // per 4 KiB programmed
+#define SIM_FS_SIZE (1536 * 1024)
+
+fs::LittleFSFS LittleFS;
+
+static std::string fsRoot = ".sim_fs";
+static bool powerCut = false;
+static uint32_t durableOps = 0;
+static uint32_t cutAtOp = 0;
+static std::string failPath;
+static uint32_t failCount = 0;
+
+// Called before every operation that changes the flash; false if it must
+// not reach it (power already gone, or an injected write error on `path`)
+static bool durable(const std::string &path) {
+  durableOps++;
+  if (cutAtOp && durableOps >= cutAtOp)
+    powerCut = true;
+  if (powerCut)
+    return false;
+  if (failCount && path == failPath) {
+    failCount--;
+    return false;
+  }
+  return true;
+}
+
+static std::string hostPath(const char *path) {
+  std::string p = path ? path : "/";
+  if (p.empty() || p[0] != '/')
+    p = "/" + p;
+  return fsRoot + p;
+}
+
+namespace fs {
+
+class FileImpl {
+public:
+  std::string path;
+  std::string name;
+  bool dir = false;
+  bool writable = false;
+  bool append = false;
+  bool dirty = false;
+  size_t pos = 0;
+  std::vector<uint8_t> data;
+  std::vector<std::string> entries;
+  size_t nextEntry = 0;
+
+  ~FileImpl() { sync(); }
+
+  void sync() {
+    if (!dirty)
+      return;
+    if (!durable(path)) {
+      // Lost for good, also once the power is back
+      dirty = false;
+      return;
+    }
+    std::string tmp = hostPath(path.c_str()) + ".~sim";
+    FILE *f = fopen(tmp.c_str(), "wb");
+    if (!f)
+      return;
+    if (!data.empty())
+      fwrite(data.data(), 1, data.size(), f);
+    fclose(f);
+    ::rename(tmp.c_str(), hostPath(path.c_str()).c_str());
+    sim::charge(SIM_FS_SYNC_US + (data.size() / 4096 + 1) * SIM_FS_PAGE_US);
+    dirty = false;
+  }
+};
+
+size_t File::write(uint8_t c) { return write(&c, 1); }
+
+size_t File::write(const uint8_t *buf, size_t size) {
+  if (!p_ || !p_->writable)
+    return 0;
+  if (p_->append)
+    p_->pos = p_->data.size();
+  if (p_->pos + size > p_->data.size())
+    p_->data.resize(p_->pos + size);
+  memcpy(p_->data.data() + p_->pos, buf, size);
+  p_->pos += size;
+  p_->dirty = true;
+  sim::charge(size / 64 + 1);
+  return size;
+}
+
+int File::available() {
+  if (!p_ || p_->dir)
+    return 0;
+  return (int)(p_->data.size() - std::min(p_->pos, p_->data.size()));
+}
+
+int File::read() {
+  uint8_t c;
+  return read(&c, 1) == 1 ? c : -1;
+}
+
+int File::peek() {
+  if (!available())
+    return -1;
+  return p_->data[p_->pos];
+}
+
+size_t File::read(uint8_t *buf, size_t size) {
+  size_t n = std::min<size_t>(size, available());
+  if (!n)
+    return 0;
+  memcpy(buf, p_->data.data() + p_->pos, n);
+  p_->pos += n;
+  sim::charge(n / 64 + 1);
+  return n;
+}
+
+void File::flush() {
+  if (p_)
+    p_->sync();
+}
+
+bool File::seek(uint32_t pos, SeekMode mode) {
+  if (!p_)
+    return false;
+  size_t base = mode == SeekSet ? 0 : mode == SeekCur ? p_->pos : p_->data.size();
+  size_t np = base + pos;
+  if (np > p_->data.size())
+    return false;
+  p_->pos = np;
+  return true;
+}
+
+size_t File::position() const { return p_ ? p_->pos : 0; }
+size_t File::size() const { return p_ ? p_->data.size() : 0; }
+
+void File::close() {
+  if (p_)
+    p_->sync();
+  p_.reset();
+}
+
+File::operator bool() const { return (bool)p_; }
+const char *File::name() const { return p_ ? p_->name.c_str() : ""; }
+const char *File::path() const { return p_ ? p_->path.c_str() : ""; }
+bool File::isDirectory() const { return p_ && p_->dir; }
+
+File File::openNextFile(const char *mode) {
+  if (!p_ || !p_->dir || p_->nextEntry >= p_->entries.size())
+    return File();
+  std::string child = p_->path;
+  if (child.empty() || child.back() != '/')
+    child += "/";
+  child += p_->entries[p_->nextEntry++];
+  return LittleFS.open(child.c_str(), mode);
+}
+
+void File::rewindDirectory() {
+  if (p_)
+    p_->nextEntry = 0;
+}
+
+File FS::open(const char *path, const char *mode, bool) {
+  sim::charge(SIM_FS_OPEN_US);
+  std::string hp = hostPath(path);
+  struct stat st;
+  bool exists = ::stat(hp.c_str(), &st) == 0;
+  FileImplPtr p = std::make_shared<FileImpl>();
+  p->path = path;
+  size_t slash = p->path.find_last_of('/');
+  p->name = slash == std::string::npos ? p->path : p->path.substr(slash + 1);
+
+  if (exists && S_ISDIR(st.st_mode)) {
+    p->dir = true;
+    DIR *d = opendir(hp.c_str());
+    if (d) {
+      while (struct dirent *e = readdir(d)) {
+        std::string n = e->d_name;
+        if (n == "." || n == ".." || n.find(".~sim") != std::string::npos)
+          continue;
+        p->entries.push_back(n);
+      }
+      closedir(d);
+    }
+    std::sort(p->entries.begin(), p->entries.end());
+    return File(p);
+  }
+
+  bool w = strchr(mode, 'w') != nullptr;
+  bool a = strchr(mode, 'a') != nullptr;
+  bool plus = strchr(mode, '+') != nullptr;
+  if (!exists && !w && !a)
+    return File();
+  p->writable = w || a || plus;
+  p->append = a;
+  if (exists && !w) {
+    FILE *f = fopen(hp.c_str(), "rb");
+    if (f) {
+      p->data.resize(st.st_size);
+      if (st.st_size)
+        p->data.resize(fread(p->data.data(), 1, st.st_size, f));
+      fclose(f);
+    }
+  }
+  if (w || !exists)
+    p->dirty = true; // create/truncate on close
+  if (a)
+    p->pos = p->data.size();
+  return File(p);
+}
+
+bool FS::exists(const char *path) {
+  struct stat st;
+  return ::stat(hostPath(path).c_str(), &st) == 0;
+}
+
+bool FS::remove(const char *path) {
+  sim::charge(SIM_FS_SYNC_US);
+  if (!durable(path))
+    return false;
+  return ::unlink(hostPath(path).c_str()) == 0;
+}
+
+bool FS::rename(const char *from, const char *to) {
+  sim::charge(SIM_FS_SYNC_US);
+  if (!durable(to))
+    return false;
+  return ::rename(hostPath(from).c_str(), hostPath(to).c_str()) == 0;
+}
+
+bool FS::mkdir(const char *path) {
+  return ::mkdir(hostPath(path).c_str(), 0755) == 0 || exists(path);
+}
+
+bool FS::rmdir(const char *path) {
+  return ::rmdir(hostPath(path).c_str()) == 0;
+}
+
+bool LittleFSFS::begin(bool, const char *, uint8_t, const char *) {
+  ::mkdir(fsRoot.c_str(), 0755);
+  sim::charge(15000); // mount scans the metadata pairs
+  return true;
+}
+
+bool LittleFSFS::format() {
+  std::string cmd = "rm -rf '" + fsRoot + "'";
+  if (system(cmd.c_str()) != 0)
+    return false;
+  ::mkdir(fsRoot.c_str(), 0755);
+  return true;
+}
+
+static size_t dirBytes(const std::string &dir) {
+  size_t total = 0;
+  DIR *d = opendir(dir.c_str());
+  if (!d)
+    return 0;
+  while (struct dirent *e = readdir(d)) {
+    std::string n = e->d_name;
+    if (n == "." || n == "..")
+      continue;
+    std::string p = dir + "/" + n;
+    struct stat st;
+    if (::stat(p.c_str(), &st) != 0)
+      continue;
+    // LittleFS allocates whole 4 KiB blocks
+    total += S_ISDIR(st.st_mode) ? dirBytes(p) + 4096
+                                 : ((st.st_size + 4095) / 4096) * 4096;
+  }
+  closedir(d);
+  return total;
+}
+
+size_t LittleFSFS::totalBytes() { return SIM_FS_SIZE; }
+size_t LittleFSFS::usedBytes() { return dirBytes(fsRoot); }
+
+} // namespace fs
+
+namespace sim {
+
+void fsSetRoot(const char *dir, bool wipe) {
+  fsRoot = dir;
+  if (wipe)
+    LittleFS.format();
+}
+
+void fsPowerCut() { powerCut = true; }
+
+void fsPowerRestore() {
+  powerCut = false;
+  cutAtOp = 0;
+}
+
+uint32_t fsOps() { return durableOps; }
+
+void fsPowerCutAt(uint32_t op) { cutAtOp = op; }
+
+void fsFailNext(const char *path, uint32_t n) {
+  failPath = path;
+  failCount = n;
+}
+
+} // namespace sim
@@ -0,0 +1,70 @@
+#include <Adafruit_I2CDevice.h>
+#include <Wire.h>
+
+#include "SimDevices.h"
+
+TwoWire Wire(0);
+
+static sim::I2cDevice *i2cDevs[128];
+
+namespace sim {
+
+void attachI2c(uint8_t addr, I2cDevice *dev) { i2cDevs[addr & 0x7F] = dev; }
+
+I2cDevice *i2cDevice(uint8_t addr) { return i2cDevs[addr & 0x7F]; }
+
+} // namespace sim
+
+bool TwoWire::begin(int, int, uint32_t frequency) {
+  if (frequency)
+    clock_ = frequency;
+  return true;
+}
+
+uint64_t TwoWire::transferUs(size_t bytes) const {
+  // 9 clocks per byte (8 data + ACK), one address byte, start/stop
+  return ((bytes + 1) * 9 + 2) * 1000000ULL / clock_;
+}
+
+bool Adafruit_I2CDevice::begin(bool addr_detect) {
+  return addr_detect ? detected() : true;
+}
+
+bool Adafruit_I2CDevice::detected(void) {
+  sim::charge(_wire->transferUs(0));
+  return sim::i2cDevice(_addr) != nullptr;
+}
+
+bool Adafruit_I2CDevice::read(uint8_t *buffer, size_t len, bool) {
+  sim::I2cDevice *dev = sim::i2cDevice(_addr);
+  sim::charge(_wire->transferUs(len));
+  if (!dev)
+    return false;
+  return dev->onRead(buffer, len) == len;
+}
+
+bool Adafruit_I2CDevice::write(const uint8_t *buffer, size_t len, bool,
+                               const uint8_t *prefix_buffer,
+                               size_t prefix_len) {
+  sim::I2cDevice *dev = sim::i2cDevice(_addr);
+  sim::charge(_wire->transferUs(len + prefix_len));
+  if (!dev)
+    return false;
+  uint8_t tmp[160];
+  if (len + prefix_len > sizeof(tmp))
+    return false;
+  if (prefix_len)
+    memcpy(tmp, prefix_buffer, prefix_len);
+  memcpy(tmp + prefix_len, buffer, len);
+  dev->onWrite(tmp, len + prefix_len);
+  return true;
+}
+
+bool Adafruit_I2CDevice::write_then_read(const uint8_t *write_buffer,
+                                         size_t write_len,
+                                         uint8_t *read_buffer,
+                                         size_t read_len, bool stop) {
+  if (!write(write_buffer, write_len, stop))
+    return false;
+  return read(read_buffer, read_len);
+}
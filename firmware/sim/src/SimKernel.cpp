@@ -0,0 +1,401 @@
+#include "SimKernel.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+
+namespace sim {
+
+struct Task {
+  const char *name;
+  int core;
+  uint64_t wakeAt;
+  uint64_t busyUntil; // end of the current charge(); holds the core
+  bool charging;      // suspended inside charge(), mid-way through its work
+  std::condition_variable cv;
+};
+
+static std::mutex gLock;
+static std::vector<Task *> gTasks;
+static Task *gCurrent = nullptr;
+static uint64_t gNow = 0;
+static std::multimap<uint64_t, std::function<void()>> gTimers;
+static std::vector<std::function<void()>> gFinishHooks;
+static bool gInTimer = false;
+static int gExitStatus = 0;
+
+// Fire due timers. Called with gLock released so callbacks may call back
+// into the kernel (they run on the current task's thread).
+static void runTimers() {
+  if (gInTimer)
+    return;
+  gInTimer = true;
+  for (;;) {
+    std::function<void()> fn;
+    {
+      std::lock_guard<std::mutex> g(gLock);
+      auto it = gTimers.begin();
+      if (it == gTimers.end() || it->first > gNow)
+        break;
+      fn = it->second;
+      gTimers.erase(it);
+    }
+    fn();
+  }
+  gInTimer = false;
+}
+
+// Earliest time `t` can run: its own wake-up, or later if another task
+// on the same core is inside a charge(). Tasks on the other core are not
+// held up, like the ESP32's two cores.
+static uint64_t readyAt(const Task *t) {
+  uint64_t at = t->wakeAt;
+  for (const Task *u : gTasks)
+    if (u != t && u->core == t->core && u->busyUntil > gNow)
+      at = std::max(at, u->busyUntil);
+  return at;
+}
+
+// Pick the next task to run and hand it the CPU. Must hold `lk`.
+static void reschedule(std::unique_lock<std::mutex> &lk) {
+  Task *self = gCurrent;
+  for (;;) {
+    size_t n = gTasks.size();
+    size_t start = 0;
+    for (size_t i = 0; i < n; i++)
+      if (gTasks[i] == self)
+        start = i + 1;
+    Task *next = nullptr;
+    for (size_t i = 0; i < n; i++) {
+      Task *t = gTasks[(start + i) % n];
+      if (readyAt(t) <= gNow) {
+        next = t;
+        break;
+      }
+    }
+    if (next) {
+      if (next != self) {
+        gCurrent = next;
+        next->cv.notify_one();
+        self->cv.wait(lk, [self] { return gCurrent == self; });
+      }
+      return;
+    }
+    // Nobody ready: jump to the earliest wake-up or timer.
+    uint64_t earliest = UINT64_MAX;
+    for (Task *t : gTasks)
+      earliest = std::min(earliest, readyAt(t));
+    if (!gTimers.empty())
+      earliest = std::min(earliest, gTimers.begin()->first);
+    gNow = earliest;
+    if (!gTimers.empty() && gTimers.begin()->first <= gNow) {
+      lk.unlock();
+      runTimers();
+      lk.lock();
+    }
+  }
+}
+
+uint64_t nowUs() {
+  std::lock_guard<std::mutex> g(gLock);
+  return gNow;
+}
+
+void charge(uint64_t us) {
+  // Timers due inside the busy span fire at their own time, the way an
+  // interrupt preempts the code that is running
+  std::unique_lock<std::mutex> lk(gLock);
+  uint64_t end = gNow + us;
+  if (gCurrent && !gInTimer && us) {
+    // The task holds its core until the work is done; tasks pinned to the
+    // other core run in the meantime
+    Task *self = gCurrent;
+    self->wakeAt = self->busyUntil = end;
+    self->charging = true;
+    reschedule(lk);
+    self->charging = false;
+    lk.unlock();
+    runTimers();
+    return;
+  }
+  // Inside a timer callback, or before the first task
+  for (;;) {
+    auto it = gTimers.begin();
+    if (gInTimer || it == gTimers.end() || it->first > end) {
+      gNow = std::max(gNow, end);
+      break;
+    }
+    gNow = std::max(gNow, it->first);
+    lk.unlock();
+    runTimers();
+    lk.lock();
+  }
+}
+
+bool othersCharging() {
+  std::lock_guard<std::mutex> g(gLock);
+  for (const Task *t : gTasks)
+    if (t != gCurrent && t->charging)
+      return true;
+  return false;
+}
+
+void sleepUs(uint64_t us) {
+  std::unique_lock<std::mutex> lk(gLock);
+  gCurrent->wakeAt = gNow + (us ? us : 1);
+  reschedule(lk);
+  lk.unlock();
+  runTimers();
+}
+
+void yieldNow() {
+  std::unique_lock<std::mutex> lk(gLock);
+  if (!gCurrent) // unit tests call library code before any task runs
+    return;
+  gCurrent->wakeAt = gNow;
+  reschedule(lk);
+}
+
+void schedule(uint64_t atUs, std::function<void()> fn) {
+  std::lock_guard<std::mutex> g(gLock);
+  gTimers.insert(std::make_pair(atUs, fn));
+}
+
+struct SpawnArgs {
+  Task *task;
+  void (*fn)(void *);
+  void *arg;
+};
+
+static void taskEntry(SpawnArgs *a) {
+  {
+    std::unique_lock<std::mutex> lk(gLock);
+    a->task->cv.wait(lk, [a] { return gCurrent == a->task; });
+  }
+  a->fn(a->arg);
+  // FreeRTOS tasks never return; park this one forever.
+  std::unique_lock<std::mutex> lk(gLock);
+  a->task->wakeAt = UINT64_MAX;
+  reschedule(lk);
+  for (;;)
+    a->task->cv.wait(lk);
+}
+
+void spawn(void (*fn)(void *), void *arg, const char *name, int core) {
+  Task *t = new Task();
+  t->name = name;
+  t->core = core == 1 ? 1 : 0;
+  t->busyUntil = 0;
+  t->charging = false;
+  {
+    std::lock_guard<std::mutex> g(gLock);
+    t->wakeAt = gNow;
+    gTasks.push_back(t);
+  }
+  SpawnArgs *a = new SpawnArgs{t, fn, arg};
+  std::thread(taskEntry, a).detach();
+}
+
+const char *currentTaskName() {
+  std::lock_guard<std::mutex> g(gLock);
+  return gCurrent ? gCurrent->name : "?";
+}
+
+void *currentTask() {
+  std::lock_guard<std::mutex> g(gLock);
+  return gCurrent;
+}
+
+int currentCore() {
+  std::lock_guard<std::mutex> g(gLock);
+  return gCurrent ? gCurrent->core : 0;
+}
+
+void onFinish(std::function<void()> fn) { gFinishHooks.push_back(fn); }
+
+void setExitStatus(int status) { gExitStatus = status; }
+
+void finish() {
+  for (auto &fn : gFinishHooks)
+    fn();
+  fflush(stdout);
+  fflush(stderr);
+  _exit(gExitStatus);
+}
+
+void runArduino(void (*setupFn)(), void (*loopFn)(), uint64_t endUs,
+                std::function<void(uint64_t, uint64_t)> onLoopDone) {
+  Task *t = new Task();
+  t->name = "loopTask";
+  t->core = 1; // CONFIG_ARDUINO_RUNNING_CORE
+  t->wakeAt = 0;
+  t->busyUntil = 0;
+  t->charging = false;
+  t->charging = false;
+  {
+    std::lock_guard<std::mutex> g(gLock);
+    gTasks.push_back(t);
+    gCurrent = t;
+  }
+  schedule(endUs, finish);
+  runTimers();
+  setupFn();
+  for (;;) {
+    uint64_t start = nowUs();
+    loopFn();
+    // Arduino's loopTask body costs a little on every pass
+    charge(2);
+    yieldNow();
+    if (onLoopDone)
+      onLoopDone(start, nowUs());
+  }
+}
+
+} // namespace sim
+
+// ================== FreeRTOS ==================
+struct SimQueue {
+  size_t length;
+  size_t itemSize;
+  std::deque<std::vector<uint8_t>> items;
+  bool isMutex;
+};
+
+static bool waitFor(TickType_t ticks, const std::function<bool()> &ready) {
+  uint64_t deadline = (ticks == portMAX_DELAY)
+                          ? UINT64_MAX
+                          : sim::nowUs() + (uint64_t)ticks * 1000;
+  for (;;) {
+    if (ready())
+      return true;
+    if (sim::nowUs() >= deadline)
+      return false;
+    sim::sleepUs(std::min<uint64_t>(1000, deadline - sim::nowUs()));
+  }
+}
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t fn, const char *name,
+                                   uint32_t, void *arg, UBaseType_t,
+                                   TaskHandle_t *handle, BaseType_t core) {
+  sim::spawn(fn, arg, name, core);
+  if (handle)
+    *handle = nullptr;
+  return pdPASS;
+}
+
+BaseType_t xTaskCreate(TaskFunction_t fn, const char *name,
+                       uint32_t stackDepth, void *arg, UBaseType_t priority,
+                       TaskHandle_t *handle) {
+  return xTaskCreatePinnedToCore(fn, name, stackDepth, arg, priority, handle,
+                                 tskNO_AFFINITY);
+}
+
+void vTaskDelay(TickType_t ticks) { sim::sleepUs((uint64_t)ticks * 1000); }
+
+void vTaskDelete(TaskHandle_t) {
+  for (;;)
+    sim::sleepUs(UINT64_MAX / 2);
+}
+
+TickType_t xTaskGetTickCount() { return (TickType_t)(sim::nowUs() / 1000); }
+
+TaskHandle_t xTaskGetCurrentTaskHandle() { return sim::currentTask(); }
+
+char *pcTaskGetName(TaskHandle_t handle) {
+  // Names are string literals in the sim
+  return const_cast<char *>(
+      handle ? static_cast<sim::Task *>(handle)->name : sim::currentTaskName());
+}
+
+BaseType_t xPortGetCoreID() { return sim::currentCore(); }
+
+void taskYIELD() { sim::yieldNow(); }
+
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t itemSize) {
+  return new SimQueue{length, itemSize, {}, false};
+}
+
+BaseType_t xQueueSend(QueueHandle_t q, const void *item, TickType_t wait) {
+  if (!waitFor(wait, [q] { return q->items.size() < q->length; }))
+    return pdFALSE;
+  const uint8_t *p = (const uint8_t *)item;
+  q->items.push_back(std::vector<uint8_t>(p, p + q->itemSize));
+  return pdTRUE;
+}
+
+BaseType_t xQueueSendToBack(QueueHandle_t q, const void *item,
+                            TickType_t wait) {
+  return xQueueSend(q, item, wait);
+}
+
+BaseType_t xQueueSendFromISR(QueueHandle_t q, const void *item,
+                             BaseType_t *woken) {
+  if (woken)
+    *woken = pdFALSE;
+  return xQueueSend(q, item, 0);
+}
+
+BaseType_t xQueueReceive(QueueHandle_t q, void *item, TickType_t wait) {
+  if (!waitFor(wait, [q] { return !q->items.empty(); }))
+    return pdFALSE;
+  if (item && q->itemSize)
+    memcpy(item, q->items.front().data(), q->itemSize);
+  q->items.pop_front();
+  return pdTRUE;
+}
+
+BaseType_t xQueuePeek(QueueHandle_t q, void *item, TickType_t wait) {
+  if (!waitFor(wait, [q] { return !q->items.empty(); }))
+    return pdFALSE;
+  if (item && q->itemSize)
+    memcpy(item, q->items.front().data(), q->itemSize);
+  return pdTRUE;
+}
+
+BaseType_t xQueueReset(QueueHandle_t q) {
+  if (!q->isMutex)
+    q->items.clear();
+  return pdPASS;
+}
+
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t q) { return q->items.size(); }
+
+SemaphoreHandle_t xSemaphoreCreateMutex() {
+  SimQueue *q = new SimQueue{1, 0, {}, true};
+  q->items.push_back(std::vector<uint8_t>());
+  return q;
+}
+
+SemaphoreHandle_t xSemaphoreCreateBinary() {
+  return new SimQueue{1, 0, {}, false};
+}
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t s, TickType_t wait) {
+  return xQueueReceive(s, nullptr, wait);
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t s) {
+  if (s->items.size() >= s->length)
+    return pdFALSE;
+  s->items.push_back(std::vector<uint8_t>());
+  return pdTRUE;
+}
+
+BaseType_t xSemaphoreGiveFromISR(SemaphoreHandle_t s, BaseType_t *woken) {
+  if (woken)
+    *woken = pdFALSE;
+  return xSemaphoreGive(s);
+}
@@ -0,0 +1,634 @@
+// Native entry point: wires the simulated board, replays a scenario file
+// against setup()/loop() in virtual time and prints a benchmark report.
+//
+//   .pio/build/native/program sim/scenarios/shift_change.txt [--fs DIR]
+//                                                            [--keep-fs]
+
+#include <Arduino.h>
+#include <FS.h>
+#include <TFT_eSPI.h>
+#include <WiFiClientSecure.h>
+
+#include <algorithm>
+#include <deque>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "ApiClient.h"
+#include "Boot.h"
+#include "Clock.h"
+#include "Connectivity.h"
+#include "Events.h"
+#include "Metrics.h"
+#include "Outbox.h"
+#include "SimAS608.h"
+#include "SimDS3231.h"
+#include "SimDevices.h"
+#include "SimNet.h"
+#include "SimStats.h"
+#include "TemplateStore.h"
+
+void setup();
+void loop();
+
+namespace sim {
+
+uint64_t Samples::percentile(double p) const {
+  if (v_.empty())
+    return 0;
+  std::vector<uint64_t> s(v_);
+  std::sort(s.begin(), s.end());
+  size_t i = (size_t)(p / 100.0 * (s.size() - 1) + 0.5);
+  return s[std::min(i, s.size() - 1)];
+}
+
+uint64_t Samples::max() const {
+  uint64_t m = 0;
+  for (uint64_t v : v_)
+    m = std::max(m, v);
+  return m;
+}
+
+double Samples::mean() const {
+  if (v_.empty())
+    return 0;
+  double sum = 0;
+  for (uint64_t v : v_)
+    sum += v;
+  return sum / v_.size();
+}
+
+void Samples::report(const char *name) const {
+  printf("  %-24s n=%-7zu mean=%9.1f p50=%8llu p99=%8llu max=%8llu us\n", name,
+         count(), mean(), (unsigned long long)percentile(50),
+         (unsigned long long)percentile(99), (unsigned long long)max());
+}
+
+static std::map<uint16_t, std::deque<uint64_t>> pendingTouches;
+static Samples scanToUpload;
+static Samples loopIter;
+static uint32_t touches = 0;
+
+// Firmware clock vs the DS3231 model, sampled after every loop pass.
+// Running totals only, so the probe does not show up in the heap peak.
+static uint64_t clockLast = 0;
+static uint32_t clockBackward = 0;
+static uint32_t clockSamples = 0;
+static double clockErrSum = 0, clockErrMax = 0;
+
+static void sampleClock() {
+  uint64_t t = clockNowUs();
+  if (t < clockLast)
+    clockBackward++;
+  clockLast = t;
+  if (!clockLocked())
+    return;
+  double err = fabs((double)t - ds3231Seconds() * 1e6);
+  clockSamples++;
+  clockErrSum += err;
+  clockErrMax = std::max(clockErrMax, err);
+}
+
+void noteTouch(uint16_t uid) {
+  touches++;
+  pendingTouches[uid].push_back(nowUs());
+}
+
+void noteIngest(uint16_t uid) {
+  auto it = pendingTouches.find(uid);
+  if (it == pendingTouches.end() || it->second.empty())
+    return;
+  scanToUpload.add(nowUs() - it->second.front());
+  it->second.pop_front();
+}
+
+// What the next boot finds after a "powercut": outboxBegin() rebuilds the
+// outbox from the flash alone, so running it once the power is back shows
+// which records would be sent again and which touches are gone.
+struct PowerCut {
+  bool pending = false; // cut, recovery not checked yet
+  bool done = false;
+  uint32_t recovered = 0;
+  uint32_t replayed = 0; // already on the server, would be uploaded twice
+  uint32_t lost = 0;     // touched, not on the server, not in the outbox
+};
+static PowerCut powerCut;
+
+// Runs between two loop() passes while no other task is inside charge():
+// a task gives up the CPU inside an outbox call only there (flash writes),
+// so outboxBegin() may reset it
+static void recoverAfterPowerCut() {
+  fsPowerRestore();
+  outboxBegin();
+  std::vector<OutboxRecord> recs(outboxPending() + 1);
+  recs.resize(outboxPeek(recs.data(), recs.size()));
+  std::map<uint16_t, size_t> fresh;
+  for (const OutboxRecord &r : recs) {
+    if (serverHasRecord(r.uid, r.unixtime))
+      powerCut.replayed++;
+    else
+      fresh[r.uid]++;
+  }
+  powerCut.recovered = recs.size();
+  for (auto &e : pendingTouches)
+    if (e.second.size() > fresh[e.first])
+      powerCut.lost += e.second.size() - fresh[e.first];
+  powerCut.pending = false;
+  powerCut.done = true;
+}
+
+} // namespace sim
+
+static const uint8_t PIN_UP = 33, PIN_DOWN = 32, PIN_OK = 27;
+
+static uint8_t buttonPin(const std::string &name) {
+  if (name == "up")
+    return PIN_UP;
+  if (name == "down")
+    return PIN_DOWN;
+  return PIN_OK;
+}
+
+// Named report values that "expect" lines in a scenario can check
+static std::map<std::string, double> results;
+
+static void result(const std::string &name, double v) { results[name] = v; }
+
+static void sampleResults(const std::string &key, const sim::Samples &s) {
+  result(key + "_n", s.count());
+  result(key + "_mean_us", s.mean());
+  result(key + "_p50_us", s.percentile(50));
+  result(key + "_p99_us", s.percentile(99));
+  result(key + "_max_us", s.max());
+}
+
+struct Expect {
+  std::string name;
+  std::string op;
+  double value;
+  std::string text; // as written in the scenario
+};
+static std::vector<Expect> expects;
+
+static const char *const OPS[] = {"==", "!=", "<", "<=", ">", ">="};
+
+// Every unlabelled sample of the firmware's own /metrics (counters,
+// gauges, histogram _sum/_count) becomes a result under its Prometheus
+// name, plus <histogram>_mean, so scenarios can assert device-side
+// latencies such as axiom_scan_result_ms_mean. Samplers and apiStats()
+// may take a firmware mutex, so both are read in loopTask once the end is
+// near, not in finish() (which can fire while another task holds it).
+class StringPrint : public Print {
+public:
+  std::string text;
+  size_t write(uint8_t c) override {
+    text += (char)c;
+    return 1;
+  }
+  using Print::write;
+};
+
+#define DEVICE_METRICS_BEFORE_END_US 200000ULL
+static bool deviceRead = false;
+static std::string deviceMetrics;
+static ApiStats deviceApi = {};
+
+static void readDevice() {
+  StringPrint out;
+  metricsWrite(out);
+  deviceMetrics = out.text;
+  deviceApi = apiStats();
+  deviceRead = true;
+}
+
+static void deviceMetricResults() {
+  std::istringstream in(deviceMetrics);
+  std::map<std::string, double> sums;
+  std::string line;
+  while (std::getline(in, line)) {
+    if (line.empty() || line[0] == '#' || line.find('{') != std::string::npos)
+      continue;
+    std::istringstream fields(line);
+    std::string name;
+    double v;
+    if (!(fields >> name >> v))
+      continue;
+    result(name, v);
+    size_t cut = name.size() - 4;
+    if (name.size() > 4 && name.compare(cut, 4, "_sum") == 0)
+      sums[name.substr(0, cut)] = v;
+    cut = name.size() - 6;
+    if (name.size() > 6 && name.compare(cut, 6, "_count") == 0) {
+      std::string base = name.substr(0, cut);
+      if (sums.count(base))
+        result(base + "_mean", v ? sums[base] / v : 0);
+    }
+  }
+}
+
+static bool validOp(const std::string &op) {
+  for (const char *o : OPS)
+    if (op == o)
+      return true;
+  return false;
+}
+
+static bool compare(double got, const std::string &op, double want) {
+  if (op == "==")
+    return got == want;
+  if (op == "!=")
+    return got != want;
+  if (op == "<")
+    return got < want;
+  if (op == "<=")
+    return got <= want;
+  if (op == ">")
+    return got > want;
+  if (op == ">=")
+    return got >= want;
+  return false;
+}
+
+// Every expect line is checked once the run ends; one failure (or an
+// unknown name) makes the program exit with status 1
+static void checkExpects() {
+  if (expects.empty())
+    return;
+  unsigned failed = 0;
+  printf("  expect:\n");
+  for (const Expect &e : expects) {
+    auto it = results.find(e.name);
+    bool ok = it != results.end() && compare(it->second, e.op, e.value);
+    if (it == results.end())
+      printf("    FAIL %s (no such value)\n", e.text.c_str());
+    else
+      printf("    %s %s (got %.6g)\n", ok ? "ok  " : "FAIL", e.text.c_str(),
+             it->second);
+    failed += !ok;
+  }
+  printf("  %u of %zu expectations failed\n", failed, expects.size());
+  if (failed)
+    sim::setExitStatus(1);
+}
+
+static void report() {
+  uint64_t now = sim::nowUs();
+  printf("\n===== sim report (%.1f s virtual) =====\n", now / 1e6);
+  result("virtual_ms", now / 1000);
+  // Wall time per pass, including the idle wait in eventsWait()
+  BootStage st[BOOT_STAGE_MAX];
+  uint8_t n = bootStages(st, BOOT_STAGE_MAX);
+  printf("  boot:");
+  for (uint8_t i = 0; i < n; i++) {
+    printf(" %s=%u", st[i].name, st[i].atMs);
+    result(std::string("boot_") + st[i].name + "_ms", st[i].atMs);
+  }
+  printf(" ms\n");
+  sim::loopIter.report("loop period");
+  sampleResults("loop_period", sim::loopIter);
+  LoopStats ls = loopStats();
+  printf("  %-24s n=%-7u avg=%10u max=%8u us, %u over %u us\n", "loop busy",
+         ls.iterations, ls.avgUs, ls.maxUs, ls.slow, LOOP_SLOW_US);
+  result("loop_busy_avg_us", ls.avgUs);
+  result("loop_busy_max_us", ls.maxUs);
+  result("loop_slow", ls.slow);
+  sim::scanToUpload.report("scan -> upload");
+  sampleResults("scan_upload", sim::scanToUpload);
+  size_t lost = 0;
+  for (auto &e : sim::pendingTouches)
+    lost += e.second.size();
+  printf("  touches=%u uploaded=%zu pending=%zu server_records=%u\n",
+         sim::touches, sim::scanToUpload.count(), lost, sim::serverRecords());
+  result("touches", sim::touches);
+  result("uploaded", sim::scanToUpload.count());
+  result("pending", lost);
+  result("server_records", sim::serverRecords());
+  printf("  ingest: %u duplicate events skipped, %u batches rejected\n",
+         sim::serverDuplicates(), sim::serverRejectedBatches());
+  result("server_duplicates", sim::serverDuplicates());
+  result("server_rejected_batches", sim::serverRejectedBatches());
+  printf("  tft: %llu bytes, %llu pixels, %llu windows over SPI\n",
+         (unsigned long long)TFT_eSPI::spiBytes,
+         (unsigned long long)TFT_eSPI::spiPixels,
+         (unsigned long long)TFT_eSPI::spiWindows);
+  result("tft_bytes", TFT_eSPI::spiBytes);
+  result("tft_pixels", TFT_eSPI::spiPixels);
+  result("tft_windows", TFT_eSPI::spiWindows);
+  printf("  tls: %u handshakes, server templates=%zu\n",
+         WiFiClientSecure::handshakes, sim::serverTemplates());
+  result("tls_handshakes", WiFiClientSecure::handshakes);
+  result("server_templates", sim::serverTemplates());
+  const ApiStats &as = deviceApi;
+  printf("  api: %u requests (%u reused, %u new connections), %u failed, "
+         "last=%u avg=%u max=%u ms, with handshake=%u ms\n",
+         as.requests, as.reused, as.connects, as.failures, as.lastMs, as.avgMs,
+         as.maxMs, as.connectMs);
+  result("api_requests", as.requests);
+  result("api_reused", as.reused);
+  result("api_connects", as.connects);
+  result("api_failures", as.failures);
+  result("api_avg_ms", as.avgMs);
+  result("api_max_ms", as.maxMs);
+  TemplateFallbackStats fs = templateFallbackStats();
+  double fallbackRate = fs.busyMs ? fs.candidates * 1000.0 / fs.busyMs : 0;
+  printf("  fallback: %u scans, %u candidates in %u ms (%.1f/s), %u hits, "
+         "%u cut off\n",
+         fs.scans, fs.candidates, fs.busyMs, fallbackRate, fs.hits, fs.cutoffs);
+  result("fallback_scans", fs.scans);
+  result("fallback_hits", fs.hits);
+  result("fallback_candidates", fs.candidates);
+  result("fallback_candidates_per_s", fallbackRate);
+  result("fallback_cutoffs", fs.cutoffs);
+  printf("  templates: %u stored (capacity %u), %u refused\n",
+         templateCount(), templateCapacity(), templateRefused());
+  result("templates_stored", templateCount());
+  result("template_capacity", templateCapacity());
+  result("template_refused", templateRefused());
+  printf("  as608 commands=%u, ds3231 reads=%u, heap peak=%zu bytes\n",
+         sim::as608Commands(), sim::ds3231Reads(), sim::heapPeak());
+  result("as608_commands", sim::as608Commands());
+  result("ds3231_reads", sim::ds3231Reads());
+  result("heap_peak", sim::heapPeak());
+  printf("  %-24s n=%-7u mean=%9.1f max=%8.0f us\n", "clock |error| (locked)",
+         sim::clockSamples,
+         sim::clockSamples ? sim::clockErrSum / sim::clockSamples : 0.0,
+         sim::clockErrMax);
+  result("clock_err_max_us", sim::clockErrMax);
+  NetStats ns = netStats();
+  printf("  wifi: %u attempts, %u connects (%u from cache), %u drops, "
+         "connect last=%u max=%u ms, outage last=%u max=%u ms\n",
+         ns.attempts, ns.connects, ns.fastConnects, ns.drops, ns.lastConnectMs,
+         ns.maxConnectMs, ns.lastOutageMs, ns.maxOutageMs);
+  result("wifi_attempts", ns.attempts);
+  result("wifi_connects", ns.connects);
+  result("wifi_fast_connects", ns.fastConnects);
+  result("wifi_drops", ns.drops);
+  result("wifi_connect_max_ms", ns.maxConnectMs);
+  result("wifi_outage_max_ms", ns.maxOutageMs);
+  printf("  dhcp: %u leases, %u renew reconnects, %u links on an expired "
+         "lease\n",
+         sim::netDhcpLeases(), ns.leaseRenews, sim::netExpiredLeaseLinks());
+  result("wifi_lease_renews", ns.leaseRenews);
+  result("wifi_dhcp_leases", sim::netDhcpLeases());
+  result("wifi_expired_lease_use", sim::netExpiredLeaseLinks());
+  ClockStats cs = clockStats();
+  printf("  clock: edges=%u missed=%u spurious=%u max corr=%u us, "
+         "period=%u us, i2c reads=%u, backward=%u\n",
+         cs.edges, cs.missed, cs.spurious, cs.maxCorrUs, cs.periodUs,
+         cs.i2cReads, sim::clockBackward);
+  result("clock_edges", cs.edges);
+  result("clock_missed", cs.missed);
+  result("clock_i2c_reads", cs.i2cReads);
+  result("clock_backward", sim::clockBackward);
+  if (sim::powerCut.done) {
+    printf("  power cut: outbox recovered=%u replayed=%u lost=%u\n",
+           sim::powerCut.recovered, sim::powerCut.replayed,
+           sim::powerCut.lost);
+    result("outbox_recovered", sim::powerCut.recovered);
+    result("outbox_replayed", sim::powerCut.replayed);
+    result("outbox_lost", sim::powerCut.lost);
+  }
+  deviceMetricResults();
+  // Share of scans that found their template, for the store-size sweep
+  double matched = results.count("axiom_scan_match_total")
+                       ? results["axiom_scan_match_total"]
+                       : 0;
+  double scanned = results.count("axiom_scan_nomatch_total")
+                       ? matched + results["axiom_scan_nomatch_total"]
+                       : matched;
+  printf("  scans matched: %.0f of %.0f\n", matched, scanned);
+  result("scan_match_rate", scanned ? matched / scanned : 0);
+  if (results.count("axiom_scan_result_ms_mean"))
+    printf("  %-24s n=%-7.0f mean=%9.1f ms (finger read to ScanEvent)\n",
+           "scan -> event (device)", results["axiom_scan_result_ms_count"],
+           results["axiom_scan_result_ms_mean"]);
+  String dm = sim::serverLastMetrics();
+  if (dm.length())
+    printf("  device metrics (last upload): %s\n", dm.c_str());
+  checkExpects();
+}
+
+// One scenario line: "<ms> <verb> args..." for timed events, or a
+// directive without the leading time for board setup.
+static void applyDirective(std::istringstream &in, const std::string &verb) {
+  if (verb == "clock") {
+    uint32_t t;
+    in >> t;
+    sim::netSetWallClock(t);
+    sim::ds3231Attach(t);
+  } else if (verb == "enroll") {
+    std::string range;
+    in >> range;
+    size_t dash = range.find('-');
+    int from = atoi(range.c_str());
+    int to = dash == std::string::npos ? from : atoi(range.c_str() + dash + 1);
+    for (int i = from; i <= to; i++)
+      sim::as608Enroll(i, i);
+  } else if (verb == "srvtpl") {
+    // Templates already on the server, enrolled at another reader
+    std::string range;
+    in >> range;
+    size_t dash = range.find('-');
+    int from = atoi(range.c_str());
+    int to = dash == std::string::npos ? from : atoi(range.c_str() + dash + 1);
+    uint8_t tpl[512];
+    for (int i = from; i <= to; i++) {
+      sim::as608TemplateBytes(i, tpl);
+      sim::serverPutTemplate(i, tpl, sizeof(tpl));
+    }
+  } else if (verb == "rtc") {
+    std::string what;
+    in >> what;
+    if (what == "drift") {
+      double ppm;
+      in >> ppm;
+      sim::ds3231SetDriftPpm(ppm);
+    } else if (what == "sqw") {
+      int pin;
+      uint32_t jitter = 0;
+      in >> pin >> jitter;
+      sim::ds3231WireSqw(pin, jitter);
+    }
+  } else if (verb == "dhcp") {
+    std::string what;
+    uint32_t seconds;
+    in >> what >> seconds;
+    if (what == "lease")
+      sim::netSetDhcpLease(seconds);
+  } else if (verb == "expect") {
+    Expect e;
+    if (!(in >> e.name >> e.op >> e.value) || !validOp(e.op)) {
+      fprintf(stderr, "[sim] bad expect line\n");
+      exit(2);
+    }
+    std::ostringstream text;
+    text << e.name << " " << e.op << " " << e.value;
+    e.text = text.str();
+    expects.push_back(e);
+  } else {
+    fprintf(stderr, "[sim] unknown directive '%s'\n", verb.c_str());
+  }
+}
+
+static void scheduleEvent(uint64_t atUs, std::istringstream &in,
+                          const std::string &verb, uint64_t &endUs) {
+  if (verb == "touch") {
+    uint32_t id;
+    uint32_t hold = 700;
+    std::string quality;
+    in >> id >> hold >> quality;
+    bool bad = quality == "bad";
+    sim::schedule(atUs, [id, bad] {
+      sim::as608Touch(id, bad);
+      if (!bad)
+        sim::noteTouch(id);
+    });
+    sim::schedule(atUs + hold * 1000ULL, [] { sim::as608Lift(); });
+  } else if (verb == "forget") {
+    // Drop a page from the module library (e.g. wiped on another reader)
+    uint32_t page;
+    in >> page;
+    sim::schedule(atUs, [page] { sim::as608Forget(page); });
+  } else if (verb == "srvpub") {
+    // Template published by another writer that takes its version now
+    // but only lands ms later
+    uint32_t uid, ms = 0;
+    in >> uid >> ms;
+    auto version = std::make_shared<uint32_t>(0);
+    sim::schedule(atUs, [version] {
+      *version = sim::serverReserveTemplateVersion();
+    });
+    sim::schedule(atUs + ms * 1000ULL, [uid, version] {
+      uint8_t tpl[512];
+      sim::as608TemplateBytes(uid, tpl);
+      sim::serverPutTemplate(uid, tpl, sizeof(tpl), *version);
+    });
+  } else if (verb == "srvdel") {
+    uint32_t uid;
+    in >> uid;
+    sim::schedule(atUs, [uid] { sim::serverDeleteTemplate(uid); });
+  } else if (verb == "press") {
+    std::string name;
+    uint32_t hold = 120;
+    in >> name >> hold;
+    uint8_t pin = buttonPin(name);
+    sim::schedule(atUs, [pin] { sim::setPin(pin, LOW); });
+    sim::schedule(atUs + hold * 1000ULL, [pin] { sim::setPin(pin, HIGH); });
+  } else if (verb == "wifi") {
+    std::string s;
+    in >> s;
+    if (s == "channel") {
+      int32_t ch = 6;
+      in >> ch;
+      sim::schedule(atUs, [ch] { sim::netSetApChannel(ch); });
+    } else {
+      bool up = s == "up";
+      sim::schedule(atUs, [up] { sim::netSetAp(up); });
+    }
+  } else if (verb == "server") {
+    std::string s;
+    in >> s;
+    if (s == "dropack") {
+      uint32_t n = 1;
+      in >> n;
+      sim::schedule(atUs, [n] { sim::serverDropAcks(n); });
+    } else if (s == "reject") {
+      int uid = -1;
+      in >> uid;
+      sim::schedule(atUs, [uid] { sim::serverRejectUid(uid); });
+    } else {
+      bool up = s == "up";
+      sim::schedule(atUs, [up] { sim::netSetServer(up); });
+    }
+  } else if (verb == "rtt") {
+    uint32_t ms;
+    in >> ms;
+    sim::schedule(atUs, [ms] { sim::netSetRttMs(ms); });
+  } else if (verb == "scrape") {
+    std::string path;
+    if (!(in >> path))
+      path = "/metrics";
+    sim::schedule(atUs, [path] { sim::netScrape(path.c_str()); });
+  } else if (verb == "powercut") {
+    // Nothing reaches the flash or the server from here on; the run ends
+    // after the next loop() pass has checked what a reboot recovers
+    sim::schedule(atUs, [] {
+      printf("[sim] power cut at %.3f s\n", sim::nowUs() / 1e6);
+      sim::fsPowerCut();
+      sim::netSetServer(false);
+      sim::powerCut.pending = true;
+    });
+  } else if (verb == "end") {
+    endUs = atUs;
+  } else {
+    fprintf(stderr, "[sim] unknown event '%s'\n", verb.c_str());
+  }
+}
+
+// Unit tests (test/) bring their own main() and use the sim board directly
+#ifndef PIO_UNIT_TESTING
+int main(int argc, char **argv) {
+  const char *scenario = nullptr;
+  const char *fsDir = ".sim_fs";
+  bool keepFs = false;
+  for (int i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "--fs") && i + 1 < argc)
+      fsDir = argv[++i];
+    else if (!strcmp(argv[i], "--keep-fs"))
+      keepFs = true;
+    else
+      scenario = argv[i];
+  }
+
+  setvbuf(stdout, nullptr, _IOLBF, 0);
+  sim::fsSetRoot(fsDir, !keepFs);
+  sim::as608Attach();
+  sim::ds3231Attach(sim::netWallClock());
+
+  uint64_t endUs = 60000000ULL;
+  if (scenario) {
+    std::ifstream f(scenario);
+    if (!f) {
+      fprintf(stderr, "[sim] cannot open %s\n", scenario);
+      return 1;
+    }
+    std::string line;
+    while (std::getline(f, line)) {
+      size_t hash = line.find('#');
+      if (hash != std::string::npos)
+        line.resize(hash);
+      std::istringstream in(line);
+      std::string first;
+      if (!(in >> first))
+        continue;
+      if (isdigit((unsigned char)first[0])) {
+        std::string verb;
+        in >> verb;
+        scheduleEvent(strtoull(first.c_str(), nullptr, 10) * 1000ULL, in, verb,
+                      endUs);
+      } else {
+        applyDirective(in, first);
+      }
+    }
+  }
+
+  sim::onFinish(report);
+  sim::runArduino(setup, loop, endUs, [endUs](uint64_t start, uint64_t end) {
+    sim::loopIter.add(end - start);
+    sim::sampleClock();
+    if (!deviceRead &&
+        (end + DEVICE_METRICS_BEFORE_END_US >= endUs ||
+         (sim::powerCut.pending && !sim::othersCharging())))
+      readDevice();
+    if (sim::powerCut.pending && !sim::othersCharging()) {
+      sim::recoverAfterPowerCut();
+      sim::finish();
+    }
+  });
+  return 0;
+}
+#endif
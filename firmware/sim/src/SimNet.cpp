@@ -0,0 +1,769 @@
+#include <ArduinoJson.h>
+#include <ArduinoOTA.h>
+#include <ESPmDNS.h>
+#include <HTTPClient.h>
+#include <esp_netif_net_stack.h>
+#include <lwip/dhcp.h>
+#include <WiFi.h>
+#include <WebServer.h>
+#include <WiFiClientSecure.h>
+#include <time.h>
+
+#include <algorithm>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+#include <esp32/rom/crc.h>
+
+#include "SimDevices.h"
+#include "SimNet.h"
+#include "SimStats.h"
+
+// Link budget of the simulated network (typical 2.4 GHz office AP and a
+// serverless backend a few hundred km away).
+#define SIM_WIFI_SCAN_US 2400000ULL // full channel scan on cold begin()
+#define SIM_WIFI_ASSOC_US 250000ULL
+#define SIM_WIFI_PROBE_US 1000000ULL // hinted begin() giving up on one channel
+#define SIM_DHCP_US 600000ULL
+#define SIM_TLS_FULL_US 1400000ULL // ECDHE handshake on a busy ESP32
+#define SIM_SERVER_BASE_US 60000ULL
+#define SIM_SERVER_PER_RECORD_US 2000ULL
+#define SIM_HTTP_CHUNK 512 // longer response bodies are sent chunked
+#define SIM_NTP_US 300000ULL
+
+const IPAddress INADDR_NONE((uint32_t)0);
+WiFiClass WiFi;
+MDNSResponder MDNS;
+ArduinoOTAClass ArduinoOTA;
+
+uint32_t WiFiClientSecure::handshakes = 0;
+
+static bool apUp = true;
+static bool serverUp = true;
+static uint32_t rttMs = 60;
+static uint32_t wallBase = 1767600000; // 2026-01-05 08:00:00 UTC
+static uint32_t linkEpoch = 0;         // bumps on every association
+
+static bool staWanted = false;
+static bool staLinked = false;
+static uint64_t staUpAt = 0;
+static bool staticIp = false;
+static IPAddress staIp(192, 168, 1, 50);
+static uint8_t apBssid[6] = {0x74, 0xDA, 0x88, 0x12, 0x34, 0x56};
+static int32_t apChannel = 6;
+static uint8_t staBssid[6];
+static int32_t staChannel = 0;
+static String scrapePath;   // request waiting for WebServer::handleClient()
+static String lastMetrics;  // x-device-metrics of the last ingest
+static uint32_t dropAcks = 0;   // ingest replies still to lose
+static int rejectUid = -1;      // batches holding this uid get a 422
+static bool staHintMiss = false; // begin() hint points at another channel
+static wl_status_t staFail = WL_IDLE_STATUS; // status once begin() gave up
+static uint32_t dhcpLeaseS = 86400;
+static struct dhcp staDhcp = {};
+static IPAddress leasedIp;         // address of the last DHCP lease
+static uint64_t leaseEndUs = 0;    // 0 = nothing leased yet
+static uint32_t dhcpLeases = 0;
+static uint32_t expiredLeaseLinks = 0;
+static uint32_t expiredCheckedEpoch = 0;
+
+namespace sim {
+
+// No auto-reconnect: once the AP is gone the station stays down until
+// the firmware calls begin() again.
+void netSetAp(bool up) {
+  apUp = up;
+  if (!up && (staLinked || staWanted)) {
+    staLinked = false;
+    staWanted = false;
+    staFail = WL_CONNECTION_LOST;
+  }
+}
+
+void netSetApChannel(int32_t channel) {
+  // A channel change is an AP restart
+  netSetAp(false);
+  apChannel = channel;
+  netSetAp(true);
+}
+
+bool netApUp() { return apUp; }
+void netScrape(const char *path) { scrapePath = path; }
+void netSetServer(bool up) { serverUp = up; }
+void netSetRttMs(uint32_t ms) { rttMs = ms; }
+void netSetDhcpLease(uint32_t seconds) { dhcpLeaseS = seconds; }
+uint32_t netDhcpLeases() { return dhcpLeases; }
+uint32_t netExpiredLeaseLinks() { return expiredLeaseLinks; }
+void netSetWallClock(uint32_t unixtime) {
+  wallBase = unixtime - (uint32_t)(nowUs() / 1000000ULL);
+}
+uint32_t netWallClock() {
+  return wallBase + (uint32_t)(nowUs() / 1000000ULL);
+}
+
+} // namespace sim
+
+// ================== WiFi ==================
+wl_status_t WiFiClass::begin(const char *, const char *, int32_t channel,
+                             const uint8_t *bssid, bool connect) {
+  sim::charge(200);
+  if (!connect)
+    return WL_DISCONNECTED;
+  staWanted = true;
+  staLinked = false;
+  // Known BSSID + channel skips the scan; a stale hint fails after probing
+  // that one channel
+  bool hint = channel > 0 && bssid;
+  bool fast = hint && channel == apChannel && memcmp(bssid, apBssid, 6) == 0;
+  staHintMiss = hint && !fast;
+  uint64_t t = staHintMiss ? SIM_WIFI_PROBE_US
+                           : (fast ? 0 : SIM_WIFI_SCAN_US) + SIM_WIFI_ASSOC_US +
+                                 (staticIp ? 0 : SIM_DHCP_US);
+  staUpAt = sim::nowUs() + t;
+  return WL_DISCONNECTED;
+}
+
+bool WiFiClass::config(IPAddress local_ip, IPAddress, IPAddress, IPAddress,
+                       IPAddress) {
+  staticIp = (uint32_t)local_ip != 0;
+  if (staticIp)
+    staIp = local_ip;
+  return true;
+}
+
+bool WiFiClass::disconnect(bool, bool) {
+  staWanted = false;
+  staLinked = false;
+  staFail = WL_IDLE_STATUS;
+  return true;
+}
+
+bool WiFiClass::reconnect() {
+  begin(nullptr, nullptr, staChannel, staChannel ? staBssid : nullptr);
+  return true;
+}
+
+wl_status_t WiFiClass::status() {
+  sim::charge(3);
+  if (!staLinked && staWanted && sim::nowUs() >= staUpAt) {
+    if (apUp && !staHintMiss) {
+      staLinked = true;
+      linkEpoch++;
+      memcpy(staBssid, apBssid, 6);
+      staChannel = apChannel;
+      if (!staticIp) {
+        dhcpLeases++;
+        leasedIp = staIp;
+        leaseEndUs = sim::nowUs() + dhcpLeaseS * 1000000ULL;
+        staDhcp.offered_t0_lease = dhcpLeaseS;
+        staDhcp.offered_t1_renew = dhcpLeaseS / 2;
+        staDhcp.offered_t2_rebind = dhcpLeaseS * 7 / 8;
+      }
+    } else {
+      staWanted = false;
+      staFail = WL_NO_SSID_AVAIL;
+    }
+  }
+  // The DHCP server may hand an expired address to another client
+  if (staLinked && staticIp && staIp == leasedIp && leaseEndUs &&
+      sim::nowUs() > leaseEndUs && expiredCheckedEpoch != linkEpoch) {
+    expiredCheckedEpoch = linkEpoch;
+    expiredLeaseLinks++;
+  }
+  if (staLinked)
+    return WL_CONNECTED;
+  return staWanted ? WL_DISCONNECTED : staFail;
+}
+
+// A single station netif; the handle is never dereferenced by firmware
+esp_netif_t *esp_netif_get_handle_from_ifkey(const char *if_key) {
+  return strcmp(if_key, "WIFI_STA_DEF") ? nullptr : (esp_netif_t *)&staDhcp;
+}
+
+void *esp_netif_get_netif_impl(esp_netif_t *esp_netif) { return esp_netif; }
+
+struct dhcp *netif_dhcp_data(struct netif *netif) {
+  return netif ? &staDhcp : nullptr;
+}
+
+IPAddress WiFiClass::localIP() {
+  return status() == WL_CONNECTED ? staIp : IPAddress((uint32_t)0);
+}
+IPAddress WiFiClass::gatewayIP() { return IPAddress(192, 168, 1, 1); }
+IPAddress WiFiClass::subnetMask() { return IPAddress(255, 255, 255, 0); }
+IPAddress WiFiClass::dnsIP(uint8_t) { return IPAddress(192, 168, 1, 1); }
+uint8_t *WiFiClass::BSSID() { return staLinked ? staBssid : nullptr; }
+int32_t WiFiClass::channel() { return staLinked ? staChannel : 0; }
+int8_t WiFiClass::RSSI() { return staLinked ? -58 : 0; }
+String WiFiClass::SSID() { return String(staLinked ? "sim-ap" : ""); }
+
+// ================== NTP ==================
+static bool ntpConfigured = false;
+static long ntpOffset = 0;
+
+void configTime(long gmtOffset_sec, int, const char *, const char *,
+                const char *) {
+  ntpConfigured = true;
+  ntpOffset = gmtOffset_sec;
+}
+
+bool getLocalTime(struct tm *info, uint32_t ms) {
+  uint64_t deadline = sim::nowUs() + (uint64_t)ms * 1000;
+  if (!ntpConfigured || WiFi.status() != WL_CONNECTED) {
+    sim::sleepUs(deadline - sim::nowUs());
+    return false;
+  }
+  sim::sleepUs(SIM_NTP_US);
+  time_t t = (time_t)sim::netWallClock() + ntpOffset;
+  gmtime_r(&t, info);
+  return true;
+}
+
+// ================== TCP / TLS ==================
+int WiFiClient::connect(const char *, uint16_t) {
+  if (WiFi.status() != WL_CONNECTED) {
+    open_ = false;
+    return 0;
+  }
+  sim::sleepUs((uint64_t)rttMs * 1000 * 3 / 2);
+  open_ = true;
+  epoch_++;
+  linkEpoch_ = linkEpoch;
+  lastUseUs_ = sim::nowUs();
+  return 1;
+}
+
+uint8_t WiFiClient::connected() {
+  // The socket dies with the association, and the backend drops idle
+  // keep-alive connections after 60 s.
+  if (open_ && (linkEpoch_ != linkEpoch || WiFi.status() != WL_CONNECTED ||
+                sim::nowUs() - lastUseUs_ > 60000000ULL))
+    open_ = false;
+  return open_;
+}
+
+void WiFiClient::stop() {
+  open_ = false;
+  rx_ = "";
+  rxPos_ = 0;
+}
+
+int WiFiClient::read(uint8_t *buf, size_t size) {
+  size_t n = std::min(size, (size_t)available());
+  if (!n)
+    return -1;
+  memcpy(buf, rx_.c_str() + rxPos_, n);
+  rxPos_ += n;
+  return (int)n;
+}
+
+int WiFiClientSecure::connect(const char *host, uint16_t port) {
+  if (!WiFiClient::connect(host, port))
+    return 0;
+  // arduino-esp32 2.x has no session resumption: every connect is a full
+  // ECDHE handshake, roughly half CPU bound on the ESP32 side.
+  handshakes++;
+  sim::charge(SIM_TLS_FULL_US / 2);
+  sim::sleepUs(SIM_TLS_FULL_US / 2);
+  return 1;
+}
+
+// ================== HTTP ==================
+static bool splitUrl(const String &url, String &host, String &path) {
+  int s = url.indexOf("://");
+  if (s < 0)
+    return false;
+  int p = url.indexOf('/', s + 3);
+  host = url.substring(s + 3, p < 0 ? url.length() : p);
+  path = p < 0 ? String("/") : url.substring(p);
+  return true;
+}
+
+bool HTTPClient::begin(WiFiClient &client, const String &url) {
+  client_ = &client;
+  url_ = url;
+  headers_ = "";
+  contentType_ = "";
+  response_ = "";
+  return url.startsWith("http");
+}
+
+void HTTPClient::end() {
+  if (!client_)
+    return;
+  // Unread body bytes are flushed like the real disconnect() does
+  client_->rx_ = "";
+  client_->rxPos_ = 0;
+  if (!reuse_)
+    client_->stop();
+}
+
+String HTTPClient::getString() {
+  if (client_) {
+    client_->rx_ = "";
+    client_->rxPos_ = 0;
+  }
+  return response_;
+}
+
+bool HTTPClient::connected() { return client_ && client_->connected(); }
+
+void HTTPClient::addHeader(const String &name, const String &value) {
+  if (name == "Content-Type")
+    contentType_ = value;
+  headers_ += name + ": " + value + "\n";
+}
+
+int HTTPClient::GET() { return sendRequest("GET", nullptr, 0); }
+
+int HTTPClient::POST(const uint8_t *payload, size_t size) {
+  return sendRequest("POST", payload, size);
+}
+
+int HTTPClient::sendRequest(const char *type, const uint8_t *payload,
+                            size_t size) {
+  response_ = "";
+  if (!client_)
+    return HTTPC_ERROR_NOT_CONNECTED;
+  String host, path;
+  if (!splitUrl(url_, host, path))
+    return HTTPC_ERROR_CONNECTION_REFUSED;
+  if (!client_->connected()) {
+    if (!client_->connect(host.c_str(), 443))
+      return HTTPC_ERROR_CONNECTION_REFUSED;
+  }
+  // Request upload (~1 Mbit/s effective) then one round trip
+  sim::sleepUs((uint64_t)(size + headers_.length() + 200) * 8);
+  sim::sleepUs((uint64_t)rttMs * 1000 / 2);
+  if (!serverUp || !sim::netApUp()) {
+    sim::sleepUs((uint64_t)timeoutMs_ * 1000);
+    client_->stop();
+    return HTTPC_ERROR_READ_TIMEOUT;
+  }
+  sim::HttpReply reply;
+  {
+    sim::HostHeapScope backend;
+    reply = sim::serverHandle(type, path, contentType_, headers_, payload, size);
+  }
+  if (dropAcks && path == "/api/ingest") {
+    // Stored, but the reply never arrives
+    dropAcks--;
+    sim::sleepUs((uint64_t)timeoutMs_ * 1000);
+    client_->stop();
+    return HTTPC_ERROR_READ_TIMEOUT;
+  }
+  sim::sleepUs((uint64_t)rttMs * 1000 / 2 + reply.body.length() * 8);
+  response_ = reply.body;
+  // Like the Node backend: short bodies with Content-Length, longer ones
+  // chunked
+  String wire;
+  if (reply.body.length() > SIM_HTTP_CHUNK) {
+    size_ = -1;
+    for (size_t at = 0; at < reply.body.length(); at += SIM_HTTP_CHUNK) {
+      String part = reply.body.substring(at, at + SIM_HTTP_CHUNK);
+      char head[16];
+      snprintf(head, sizeof(head), "%x\r\n", (unsigned)part.length());
+      wire += head;
+      wire += part;
+      wire += "\r\n";
+    }
+    wire += "0\r\n\r\n";
+  } else {
+    size_ = (int)reply.body.length();
+    wire = reply.body;
+  }
+  client_->rx_ = wire;
+  client_->rxPos_ = 0;
+  client_->lastUseUs_ = sim::nowUs();
+  if (!reuse_)
+    client_->stop();
+  return reply.code;
+}
+
+String HTTPClient::errorToString(int error) {
+  switch (error) {
+  case HTTPC_ERROR_CONNECTION_REFUSED:
+    return String("connection refused");
+  case HTTPC_ERROR_NOT_CONNECTED:
+    return String("not connected");
+  case HTTPC_ERROR_CONNECTION_LOST:
+    return String("connection lost");
+  case HTTPC_ERROR_READ_TIMEOUT:
+    return String("read Timeout");
+  default:
+    return String();
+  }
+}
+
+// ================== LOCAL HTTP SERVER ==================
+// A scrape from the LAN: request parsing plus ~1 ms of socket work per
+// chunk on the loop task, body echoed to stdout.
+void WebServer::on(const String &uri, HTTPMethod method, THandlerFunction fn) {
+  if (routeCount_ < sizeof(routes_) / sizeof(routes_[0]))
+    routes_[routeCount_++] = {uri, method, fn};
+}
+
+void WebServer::handleClient() {
+  sim::charge(begun_ ? 10 : 1);
+  if (!begun_ || !scrapePath.length() || !staLinked) {
+    if (begun_ && nullDelay_)
+      delay(1);
+    return;
+  }
+  String path = scrapePath;
+  scrapePath = "";
+  sim::charge(300);
+  printf("[sim] GET http://%s:%d%s\n", staIp.toString().c_str(), port_,
+         path.c_str());
+  code_ = 0;
+  sent_ = 0;
+  for (uint8_t i = 0; i < routeCount_; i++) {
+    if (routes_[i].uri == path &&
+        (routes_[i].method == HTTP_ANY || routes_[i].method == HTTP_GET)) {
+      routes_[i].fn();
+      break;
+    }
+  }
+  if (!code_ && notFound_)
+    notFound_();
+  printf("[sim] -> %d, %u bytes\n", code_, (unsigned)sent_);
+}
+
+void WebServer::send(int code, const char *, const String &content) {
+  code_ = code;
+  sendContent(content);
+}
+
+void WebServer::sendContent(const char *content, size_t size) {
+  if (!size)
+    return;
+  sim::charge(1000 + size * 2);
+  fwrite(content, 1, size, stdout);
+  sent_ += size;
+}
+
+// ================== BACKEND MODEL ==================
+// Mirrors app/api/ingest: auth by x-api-key, employee lookup, In/Out
+// toggle per uid, events already stored under the same x-device-id and seq
+// skipped.
+static std::map<uint16_t, bool> lastIn;
+static uint32_t storedRecords = 0;
+static uint32_t duplicateRecords = 0;
+static uint32_t rejectedBatches = 0;
+static std::set<std::pair<std::string, uint32_t>> seenSeq; // device, seq
+static std::multimap<uint16_t, uint32_t> storedAt; // uid -> unixtime
+
+// "2026-01-05T08:00:00.000Z" as sent by buildPayload()
+static uint32_t parseTimestamp(const char *s) {
+  struct tm t = {};
+  if (!s || sscanf(s, "%d-%d-%dT%d:%d:%d", &t.tm_year, &t.tm_mon, &t.tm_mday,
+                   &t.tm_hour, &t.tm_min, &t.tm_sec) != 6)
+    return 0;
+  t.tm_year -= 1900;
+  t.tm_mon -= 1;
+  return (uint32_t)timegm(&t);
+}
+
+static String ingestOne(JsonVariantConst ev, const String &device,
+                        uint64_t &cost) {
+  uint16_t uid = ev["uid"] | 0;
+  uint32_t seq = ev["seq"] | 0;
+  cost += SIM_SERVER_PER_RECORD_US;
+  JsonDocument out;
+  if (!uid) {
+    out["error"] = "Missing UID";
+  } else if (device.length() && seq &&
+             !seenSeq.insert(std::make_pair(std::string(device.c_str()), seq))
+                  .second) {
+    duplicateRecords++;
+    out["uid"] = uid;
+    out["duplicate"] = true;
+  } else {
+    bool in = !lastIn[uid];
+    lastIn[uid] = in;
+    storedRecords++;
+    storedAt.insert(std::make_pair(uid, parseTimestamp(ev["timestamp"].as<const char *>())));
+    sim::noteIngest(uid);
+    out["message"] = "Success";
+    out["status"] = in ? "In" : "Out";
+  }
+  String s;
+  serializeJson(out, s);
+  return s;
+}
+
+// Value of one "name: value" line in the request headers, empty if absent
+static String headerValue(const String &headers, const char *name) {
+  String key = String(name) + ": ";
+  int at = headers.indexOf(key.c_str());
+  if (at < 0)
+    return String();
+  int eol = headers.indexOf('\n', at);
+  return headers.substring(at + key.length(),
+                           eol < 0 ? headers.length() : eol);
+}
+
+static bool holdsUid(JsonVariantConst body, uint16_t uid) {
+  if (!body.is<JsonArrayConst>())
+    return (body["uid"] | 0) == uid;
+  for (JsonVariantConst ev : body.as<JsonArrayConst>())
+    if ((ev["uid"] | 0) == uid)
+      return true;
+  return false;
+}
+
+// Mirrors app/api/templates: global version counter, tombstones, chunk
+// staging keyed by CRC with 409 + received on an offset mismatch. A version
+// can be reserved before its write lands; the list stops below the lowest
+// one still in flight.
+struct SimTemplate {
+  uint32_t version = 0;
+  uint32_t crc = 0;
+  bool deleted = true;
+  std::vector<uint8_t> data;
+  uint32_t upCrc = 0;
+  std::vector<uint8_t> staged;
+};
+static std::map<uint16_t, SimTemplate> templates;
+static uint32_t templateVersion = 0;
+static std::set<uint32_t> templateInflight;
+
+static String hexOf(const uint8_t *p, size_t n) {
+  static const char d[] = "0123456789abcdef";
+  String s;
+  for (size_t i = 0; i < n; i++) {
+    s += d[p[i] >> 4];
+    s += d[p[i] & 15];
+  }
+  return s;
+}
+
+static uint32_t queryArg(const String &path, const char *key) {
+  String k = String(key) + "=";
+  int q = path.indexOf('?');
+  int at = q < 0 ? -1 : path.indexOf(k.c_str(), q);
+  return at < 0 ? 0 : strtoul(path.c_str() + at + k.length(), nullptr, 10);
+}
+
+static sim::HttpReply templateList(const String &path) {
+  uint32_t since = queryArg(path, "since");
+  uint32_t limit = queryArg(path, "limit");
+  if (!limit)
+    limit = 50;
+  uint32_t visible = templateInflight.empty() ? templateVersion
+                                              : *templateInflight.begin() - 1;
+  std::vector<std::pair<uint32_t, uint16_t>> rows;
+  for (auto &t : templates)
+    if (t.second.version > since && t.second.version <= visible)
+      rows.push_back({t.second.version, t.first});
+  std::sort(rows.begin(), rows.end());
+
+  JsonDocument doc;
+  JsonArray arr = doc["templates"].to<JsonArray>();
+  uint32_t last = since;
+  for (size_t i = 0; i < rows.size() && i < limit; i++) {
+    SimTemplate &t = templates[rows[i].second];
+    JsonObject o = arr.add<JsonObject>();
+    o["uid"] = rows[i].second;
+    o["version"] = t.version;
+    o["crc"] = t.crc;
+    o["size"] = t.data.size();
+    o["deleted"] = t.deleted;
+    last = t.version;
+  }
+  doc["version"] = last;
+  doc["more"] = rows.size() > limit;
+  sim::HttpReply r;
+  r.code = 200;
+  serializeJson(doc, r.body);
+  return r;
+}
+
+static sim::HttpReply templateChunk(uint16_t uid, const char *method,
+                                    const String &path, const uint8_t *body,
+                                    size_t size) {
+  sim::HttpReply r;
+  r.code = 200;
+  auto it = templates.find(uid);
+  if (strcmp(method, "GET") == 0) {
+    uint32_t offset = queryArg(path, "offset");
+    uint32_t length = queryArg(path, "length");
+    if (it == templates.end() || it->second.deleted) {
+      r.code = 404;
+      r.body = "{\"error\":\"Template not found\"}";
+      return r;
+    }
+    SimTemplate &t = it->second;
+    if (offset >= t.data.size()) {
+      r.code = 416;
+      r.body = "{\"error\":\"Offset out of range\"}";
+      return r;
+    }
+    if (!length || offset + length > t.data.size())
+      length = t.data.size() - offset;
+    r.body = "{\"uid\":" + String(uid) + ",\"version\":" + String(t.version) +
+             ",\"crc\":" + String(t.crc) + ",\"size\":" +
+             String((uint32_t)t.data.size()) + ",\"offset\":" +
+             String(offset) + ",\"data\":\"" +
+             hexOf(t.data.data() + offset, length) + "\"}";
+    return r;
+  }
+
+  JsonDocument doc;
+  if (deserializeJson(doc, body, size)) {
+    r.code = 400;
+    r.body = "{\"error\":\"Invalid chunk\"}";
+    return r;
+  }
+  uint32_t crc = doc["crc"] | 0UL;
+  uint32_t total = doc["size"] | 0;
+  uint32_t offset = doc["offset"] | 0;
+  const char *hex = doc["data"] | "";
+  std::vector<uint8_t> chunk;
+  for (size_t i = 0; hex[i] && hex[i + 1]; i += 2) {
+    char b[3] = {hex[i], hex[i + 1], 0};
+    chunk.push_back((uint8_t)strtoul(b, nullptr, 16));
+  }
+  SimTemplate &t = templates[uid];
+  if (!t.deleted && t.crc == crc && t.data.size() == total) {
+    r.body = "{\"received\":" + String(total) + ",\"version\":" +
+             String(t.version) + "}";
+    return r;
+  }
+  if (t.upCrc != crc)
+    t.staged.clear();
+  if (offset != t.staged.size()) {
+    r.code = 409;
+    r.body = "{\"error\":\"Offset mismatch\",\"received\":" +
+             String((uint32_t)t.staged.size()) + "}";
+    return r;
+  }
+  t.upCrc = crc;
+  t.staged.insert(t.staged.end(), chunk.begin(), chunk.end());
+  if (t.staged.size() < total) {
+    r.body = "{\"received\":" + String((uint32_t)t.staged.size()) + "}";
+    return r;
+  }
+  if (crc32_le(0, t.staged.data(), t.staged.size()) != crc) {
+    t.staged.clear();
+    r.code = 422;
+    r.body = "{\"error\":\"CRC mismatch\",\"received\":0}";
+    return r;
+  }
+  t.data.swap(t.staged);
+  t.staged.clear();
+  t.crc = crc;
+  t.deleted = false;
+  t.version = ++templateVersion;
+  r.body = "{\"received\":" + String(total) + ",\"version\":" +
+           String(t.version) + "}";
+  return r;
+}
+
+namespace sim {
+
+uint32_t serverRecords() { return storedRecords; }
+uint32_t serverDuplicates() { return duplicateRecords; }
+uint32_t serverRejectedBatches() { return rejectedBatches; }
+void serverDropAcks(uint32_t n) { dropAcks = n; }
+void serverRejectUid(int uid) { rejectUid = uid; }
+
+bool serverHasRecord(uint16_t uid, uint32_t unixtime) {
+  auto range = storedAt.equal_range(uid);
+  for (auto it = range.first; it != range.second; ++it)
+    if (it->second == unixtime)
+      return true;
+  return false;
+}
+String serverLastMetrics() { return lastMetrics; }
+
+uint32_t serverReserveTemplateVersion() {
+  templateInflight.insert(++templateVersion);
+  return templateVersion;
+}
+
+void serverPutTemplate(uint16_t uid, const uint8_t *tpl, size_t n,
+                       uint32_t version) {
+  SimTemplate &t = templates[uid];
+  t.data.assign(tpl, tpl + n);
+  t.crc = crc32_le(0, tpl, n);
+  t.deleted = false;
+  t.version = version ? version : ++templateVersion;
+  templateInflight.erase(version);
+}
+
+void serverDeleteTemplate(uint16_t uid) {
+  auto it = templates.find(uid);
+  if (it == templates.end() || it->second.deleted)
+    return;
+  it->second.deleted = true;
+  it->second.data.clear();
+  it->second.version = ++templateVersion;
+}
+
+size_t serverTemplates() {
+  size_t n = 0;
+  for (auto &t : templates)
+    n += !t.second.deleted;
+  return n;
+}
+
+HttpReply serverHandle(const char *method, const String &path,
+                       const String &, const String &headers,
+                       const uint8_t *body, size_t size) {
+  HttpReply r;
+  uint64_t cost = SIM_SERVER_BASE_US;
+  if (headers.indexOf("x-api-key:") < 0) {
+    r.code = 401;
+    r.body = "{\"error\":\"Unauthorized\"}";
+  } else if (strcmp(method, "POST") == 0 && path == "/api/ingest") {
+    String metrics = headerValue(headers, "x-device-metrics");
+    if (metrics.length())
+      lastMetrics = metrics;
+    String device = headerValue(headers, "x-device-id");
+    JsonDocument doc;
+    if (deserializeJson(doc, body, size)) {
+      r.code = 500;
+      r.body = "{\"error\":\"Internal Server Error\"}";
+    } else if (rejectUid >= 0 && holdsUid(doc.as<JsonVariantConst>(),
+                                          (uint16_t)rejectUid)) {
+      rejectedBatches++;
+      r.code = 422;
+      r.body = "{\"error\":\"Unprocessable event\"}";
+    } else if (doc.is<JsonArrayConst>()) {
+      // Batch: one employee query, one chain-tail read, one insertMany
+      JsonArrayConst arr = doc.as<JsonArrayConst>();
+      String results = "[";
+      uint32_t stored = 0;
+      for (JsonVariantConst ev : arr) {
+        String one = ingestOne(ev, device, cost);
+        if (one.indexOf("error") < 0)
+          stored++;
+        if (results.length() > 1)
+          results += ",";
+        results += one;
+        cost -= SIM_SERVER_PER_RECORD_US / 2; // amortised round trips
+      }
+      r.code = arr.size() ? 200 : 400;
+      r.body = "{\"message\":\"Success\",\"stored\":" + String(stored) +
+               ",\"results\":" + results + "]}";
+    } else {
+      r.body = ingestOne(doc.as<JsonVariantConst>(), device, cost);
+      r.code = r.body.indexOf("error") >= 0 ? 400 : 200;
+    }
+  } else if (strcmp(method, "GET") == 0 && path.startsWith("/api/templates?")) {
+    r = templateList(path);
+  } else if (path.startsWith("/api/templates/")) {
+    uint16_t uid = strtoul(path.c_str() + strlen("/api/templates/"), nullptr, 10);
+    r = templateChunk(uid, method, path, body, size);
+  } else {
+    r.code = 404;
+    r.body = "{\"error\":\"Not found\"}";
+  }
+  sleepUs(cost);
+  return r;
+}
+
+} // namespace sim
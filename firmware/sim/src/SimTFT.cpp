@@ -0,0 +1,352 @@
+#include <TFT_eSPI.h>
+
+#include "SimKernel.h"
+
+#define SIM_SPI_HZ 27000000ULL
+#define SIM_WINDOW_BYTES 11 // CASET + RASET + RAMWR with their arguments
+
+uint64_t TFT_eSPI::spiBytes = 0;
+uint64_t TFT_eSPI::spiPixels = 0;
+uint64_t TFT_eSPI::spiWindows = 0;
+
+TFT_eSPI::TFT_eSPI(int16_t w, int16_t h) : _width(w), _height(h), fb(nullptr) {
+  if (w && h)
+    fb = (uint16_t *)calloc((size_t)w * h, sizeof(uint16_t));
+}
+
+TFT_eSPI::~TFT_eSPI() { free(fb); }
+
+void TFT_eSPI::begin(uint8_t) {
+  // Reset + init command sequence (~120 ms of sleep-out delays)
+  sim::sleepUs(120000);
+}
+
+bool TFT_eSPI::clip(int32_t &x, int32_t &y, int32_t &w, int32_t &h) {
+  if (x < 0) {
+    w += x;
+    x = 0;
+  }
+  if (y < 0) {
+    h += y;
+    y = 0;
+  }
+  if (x + w > _width)
+    w = _width - x;
+  if (y + h > _height)
+    h = _height - y;
+  return w > 0 && h > 0;
+}
+
+void TFT_eSPI::account(int32_t w, int32_t h, bool async) {
+  if (isSprite)
+    return;
+  uint64_t bytes = SIM_WINDOW_BYTES + (uint64_t)w * h * 2;
+  spiBytes += bytes;
+  spiPixels += (uint64_t)w * h;
+  spiWindows++;
+  uint64_t us = bytes * 8 * 1000000ULL / SIM_SPI_HZ;
+  if (async) {
+    uint64_t start = std::max(sim::nowUs(), dmaDoneAt);
+    dmaDoneAt = start + us;
+    sim::charge(2); // descriptor setup
+  } else {
+    dmaWait();
+    sim::charge(us ? us : 1);
+  }
+}
+
+void TFT_eSPI::blit(int32_t x, int32_t y, int32_t w, int32_t h,
+                    const uint16_t *data, bool charge) {
+  int32_t sx = x, sy = y, sw = w;
+  if (!clip(x, y, w, h))
+    return;
+  for (int32_t j = 0; j < h; j++)
+    for (int32_t i = 0; i < w; i++)
+      fb[(y + j) * _width + x + i] = data[(y - sy + j) * sw + (x - sx + i)];
+  if (charge)
+    account(w, h, false);
+}
+
+void TFT_eSPI::drawPixel(int32_t x, int32_t y, uint32_t color) {
+  if (x < 0 || y < 0 || x >= _width || y >= _height)
+    return;
+  fb[y * _width + x] = (uint16_t)color;
+  account(1, 1, false);
+}
+
+void TFT_eSPI::fillRect(int32_t x, int32_t y, int32_t w, int32_t h,
+                        uint32_t color) {
+  if (!clip(x, y, w, h))
+    return;
+  for (int32_t j = 0; j < h; j++)
+    for (int32_t i = 0; i < w; i++)
+      fb[(y + j) * _width + x + i] = (uint16_t)color;
+  account(w, h, false);
+}
+
+void TFT_eSPI::drawRect(int32_t x, int32_t y, int32_t w, int32_t h,
+                        uint32_t color) {
+  drawFastHLine(x, y, w, color);
+  drawFastHLine(x, y + h - 1, w, color);
+  drawFastVLine(x, y, h, color);
+  drawFastVLine(x + w - 1, y, h, color);
+}
+
+void TFT_eSPI::fillRoundRect(int32_t x, int32_t y, int32_t w, int32_t h,
+                             int32_t r, uint32_t color) {
+  fillRect(x, y + r, w, h - 2 * r, color);
+  for (int32_t j = 0; j < r; j++) {
+    int32_t dy = r - j;
+    int32_t dx = (int32_t)sqrt((double)(r * r - dy * dy));
+    int32_t inset = r - dx;
+    fillRect(x + inset, y + j, w - 2 * inset, 1, color);
+    fillRect(x + inset, y + h - 1 - j, w - 2 * inset, 1, color);
+  }
+}
+
+void TFT_eSPI::drawRoundRect(int32_t x, int32_t y, int32_t w, int32_t h,
+                             int32_t r, uint32_t color) {
+  drawFastHLine(x + r, y, w - 2 * r, color);
+  drawFastHLine(x + r, y + h - 1, w - 2 * r, color);
+  drawFastVLine(x, y + r, h - 2 * r, color);
+  drawFastVLine(x + w - 1, y + r, h - 2 * r, color);
+}
+
+void TFT_eSPI::fillCircle(int32_t x, int32_t y, int32_t r, uint32_t color) {
+  for (int32_t dy = -r; dy <= r; dy++) {
+    int32_t dx = (int32_t)sqrt((double)(r * r - dy * dy));
+    fillRect(x - dx, y + dy, 2 * dx + 1, 1, color);
+  }
+}
+
+// Glyph cell sizes of the built-in fonts (GLCD, 2, 4, 6, 7, 8)
+static void cellSize(uint8_t font, int16_t &w, int16_t &h) {
+  switch (font) {
+  case 2:
+    w = 8;
+    h = 16;
+    break;
+  case 4:
+    w = 14;
+    h = 26;
+    break;
+  case 6:
+  case 7:
+    w = 27;
+    h = 48;
+    break;
+  case 8:
+    w = 55;
+    h = 75;
+    break;
+  default:
+    w = 6;
+    h = 8;
+    break;
+  }
+}
+
+int16_t TFT_eSPI::textWidth(const char *s, uint8_t font) {
+  if (fontLoaded) {
+    // Same measure as the library: advance of every glyph but the last
+    int32_t w = 0;
+    uint16_t len = strlen(s), n = 0;
+    while (n < len) {
+      uint16_t code = decodeUTF8((uint8_t *)s, &n, len - n), g;
+      if (code == 0x20)
+        w += gFont.spaceWidth;
+      else if (!getUnicodeIndex(code, &g))
+        w += gFont.spaceWidth + 1;
+      else {
+        if (w == 0 && gdX[g] < 0)
+          w -= gdX[g];
+        w += n < len ? gxAdvance[g] : gdX[g] + gWidth[g];
+      }
+    }
+    return (int16_t)w;
+  }
+  int16_t w, h;
+  cellSize(font, w, h);
+  return (int16_t)(strlen(s) * w * textsize);
+}
+
+int16_t TFT_eSPI::fontHeight(uint8_t font) {
+  if (fontLoaded)
+    return gFont.yAdvance;
+  int16_t w, h;
+  cellSize(font, w, h);
+  return h * textsize;
+}
+
+int16_t TFT_eSPI::drawString(const char *s, int32_t x, int32_t y,
+                             uint8_t font) {
+  if (fontLoaded) {
+    int32_t w = textWidth(s, font), h = gFont.yAdvance;
+    x -= textdatum % 3 == 1 ? w / 2 : textdatum % 3 == 2 ? w : 0;
+    y -= textdatum / 3 == 1 ? h / 2 : textdatum / 3 == 2 ? h : 0;
+    setCursor(x, y);
+    uint16_t len = strlen(s), n = 0;
+    while (n < len)
+      drawGlyph(decodeUTF8((uint8_t *)s, &n, len - n));
+    return (int16_t)w;
+  }
+  int16_t cw, ch;
+  cellSize(font, cw, ch);
+  cw *= textsize;
+  ch *= textsize;
+  int32_t w = (int32_t)strlen(s) * cw;
+  int32_t h = ch;
+  switch (textdatum % 3) {
+  case 1:
+    x -= w / 2;
+    break;
+  case 2:
+    x -= w;
+    break;
+  }
+  switch (textdatum / 3) {
+  case 1:
+    y -= h / 2;
+    break;
+  case 2:
+    y -= h;
+    break;
+  }
+  bool opaque = textcolor != textbgcolor;
+  for (const char *p = s; *p; p++, x += cw) {
+    if (opaque)
+      fillRect(x, y, cw, ch, textbgcolor);
+    if (*p == ' ')
+      continue;
+    // Glyph stand-in: a stroke box inside the cell, one write per stroke
+    int32_t gx = x + cw / 6, gy = y + ch / 6;
+    int32_t gw = cw - cw / 3, gh = ch - ch / 3;
+    int32_t t = std::max(1, (int)textsize);
+    fillRect(gx, gy, gw, t, textcolor);
+    fillRect(gx, gy + gh - t, gw, t, textcolor);
+    fillRect(gx, gy, t, gh, textcolor);
+    fillRect(gx + gw - t, gy, t, gh, textcolor);
+  }
+  return (int16_t)w;
+}
+
+size_t TFT_eSPI::write(uint8_t c) {
+  char s[2] = {(char)c, 0};
+  if (c == '\n') {
+    cursor_x = 0;
+    cursor_y += fontHeight(textfont);
+    return 1;
+  }
+  uint8_t datum = textdatum;
+  textdatum = TL_DATUM;
+  cursor_x += drawString(s, cursor_x, cursor_y, textfont);
+  textdatum = datum;
+  return 1;
+}
+
+void TFT_eSPI::pushImage(int32_t x, int32_t y, int32_t w, int32_t h,
+                         const uint16_t *data) {
+  blit(x, y, w, h, data, true);
+}
+
+bool TFT_eSPI::initDMA(bool) {
+  DMA_Enabled = true;
+  return true;
+}
+
+void TFT_eSPI::deInitDMA() { DMA_Enabled = false; }
+
+void TFT_eSPI::pushImageDMA(int32_t x, int32_t y, int32_t w, int32_t h,
+                            uint16_t *data, uint16_t *) {
+  if (!DMA_Enabled) {
+    pushImage(x, y, w, h, data);
+    return;
+  }
+  int32_t cx = x, cy = y, cw = w, ch = h;
+  if (!clip(cx, cy, cw, ch))
+    return;
+  // Only one transfer in flight, like the real driver
+  dmaWait();
+  blit(x, y, w, h, data, false);
+  account(cw, ch, true);
+}
+
+bool TFT_eSPI::dmaBusy() { return sim::nowUs() < dmaDoneAt; }
+
+void TFT_eSPI::dmaWait() {
+  uint64_t now = sim::nowUs();
+  if (now < dmaDoneAt)
+    sim::charge(dmaDoneAt - now);
+}
+
+// Both as in TFT_eSPI.cpp, for the smooth font code
+uint16_t TFT_eSPI::alphaBlend(uint8_t alpha, uint16_t fgc, uint16_t bgc) {
+  uint32_t rxb = bgc & 0xF81F;
+  rxb += ((fgc & 0xF81F) - rxb) * (alpha >> 2) >> 6;
+  uint32_t xgx = bgc & 0x07E0;
+  xgx += ((fgc & 0x07E0) - xgx) * alpha >> 8;
+  return (rxb & 0xF81F) | (xgx & 0x07E0);
+}
+
+uint16_t TFT_eSPI::decodeUTF8(uint8_t *buf, uint16_t *index,
+                              uint16_t remaining) {
+  uint16_t c = buf[(*index)++];
+  if ((c & 0x80) == 0x00)
+    return c;
+  if ((c & 0xE0) == 0xC0 && remaining > 1)
+    return ((c & 0x1F) << 6) | (buf[(*index)++] & 0x3F);
+  if ((c & 0xF0) == 0xE0 && remaining > 2) {
+    c = ((c & 0x0F) << 12) | ((buf[(*index)++] & 0x3F) << 6);
+    return c | (buf[(*index)++] & 0x3F);
+  }
+  return c;
+}
+
+uint16_t TFT_eSPI::readPixel(int32_t x, int32_t y) {
+  if (x < 0 || y < 0 || x >= _width || y >= _height)
+    return 0;
+  return fb[y * _width + x];
+}
+
+// ================== SPRITE ==================
+TFT_eSprite::TFT_eSprite(TFT_eSPI *tft) : TFT_eSPI(0, 0), _tft(tft) {
+  isSprite = true;
+}
+
+TFT_eSprite::~TFT_eSprite() { deleteSprite(); }
+
+void *TFT_eSprite::createSprite(int16_t width, int16_t height, uint8_t) {
+  deleteSprite();
+  fb = (uint16_t *)calloc((size_t)width * height, sizeof(uint16_t));
+  if (!fb)
+    return nullptr;
+  _width = width;
+  _height = height;
+  return fb;
+}
+
+void TFT_eSprite::deleteSprite() {
+  free(fb);
+  fb = nullptr;
+  _width = _height = 0;
+}
+
+void *TFT_eSprite::setColorDepth(int8_t) { return fb; }
+
+void TFT_eSprite::pushSprite(int32_t x, int32_t y) {
+  if (fb)
+    _tft->pushImage(x, y, _width, _height, fb);
+}
+
+bool TFT_eSprite::pushSprite(int32_t tx, int32_t ty, int32_t sx, int32_t sy,
+                             int32_t sw, int32_t sh) {
+  if (!fb)
+    return false;
+  for (int32_t j = 0; j < sh; j++)
+    _tft->pushImage(tx, ty + j, sw, 1, fb + (sy + j) * _width + sx);
+  return true;
+}
+
+// ================== LIBRARY EXTENSIONS ==================
+#include <TFT_eSPI/Extensions/Smooth_font.cpp>
+#include <TFT_eSPI/Extensions/Strip.cpp>
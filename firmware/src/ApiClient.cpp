@@ -0,0 +1,275 @@
+#include "ApiClient.h"
+
+#include <HTTPClient.h>
+#include <WiFi.h>
+#include <WiFiClientSecure.h>
+
+#include "Metrics.h"
+#include "Trace.h"
+
+#define API_TIMEOUT_MS 5000
+// Vercel menutup koneksi idle setelah ~60 detik; tutup duluan supaya
+// request berikutnya tidak menulis ke socket yang sudah mati.
+#define API_IDLE_TIMEOUT_MS 45000
+#define API_BACKOFF_MIN_MS 1000
+#define API_BACKOFF_MAX_MS 30000
+// Body yang di-stream dibaca dari socket per potongan ini
+#define API_BODY_BUF 128
+
+static const char *apiBase = nullptr;
+static const char *apiKey = nullptr;
+static SemaphoreHandle_t apiMutex = nullptr;
+
+// HTTPClient ikut persistent: destructor-nya men-stop client, jadi
+// objek lokal per request akan selalu membuang koneksi keep-alive.
+static WiFiClientSecure client;
+static HTTPClient https;
+
+static ApiStats stats = {};
+static unsigned long lastUse = 0;
+static unsigned long nextConnectAt = 0;
+static uint32_t backoff = API_BACKOFF_MIN_MS;
+
+// sendRequest() kembali setelah header jawaban diterima: itu time to first
+// byte, termasuk handshake TLS kalau koneksi baru
+static const uint32_t API_BUCKETS_MS[] = {50,   100,  200,  300,  500,
+                                          750,  1000, 1500, 2500, 5000};
+static Histogram ttfbMs("axiom_http_ttfb_ms",
+                        "Request ke backend sampai header jawaban",
+                        API_BUCKETS_MS, "ttfb");
+static Histogram requestMs("axiom_http_request_ms",
+                           "Request ke backend sampai body jawaban terbaca",
+                           API_BUCKETS_MS);
+
+// ================== BODY STREAM ==================
+// Body jawaban HTTP/1.1 langsung dari socket: sepanjang Content-Length,
+// atau chunked kalau panjangnya tidak dikirim (koneksi keep-alive selalu
+// memakai salah satunya). Header chunk dibuang, jadi pembaca hanya melihat
+// isi body.
+class ApiBody : public Stream {
+public:
+  ApiBody(WiFiClient &client, int size)
+      : client_(client), chunked_(size < 0), left_(size < 0 ? 0 : size) {
+    // Menunggu data sudah dilakukan fill(); timedRead() cukup sekali coba
+    setTimeout(0);
+  }
+
+  int available() override { return len_ - pos_; }
+  int read() override { return fill() ? buf_[pos_++] : -1; }
+  int peek() override { return fill() ? buf_[pos_] : -1; }
+  size_t write(uint8_t) override { return 0; }
+
+  // Buang sisa body; false kalau body putus sebelum selesai
+  bool drain() {
+    while (fill())
+      pos_ = len_;
+    return done_;
+  }
+
+private:
+  // Satu byte dari socket, menunggu sampai API_TIMEOUT_MS
+  int rawRead() {
+    unsigned long start = millis();
+    for (;;) {
+      int c = client_.read();
+      if (c >= 0)
+        return c;
+      if (!client_.connected() || millis() - start > API_TIMEOUT_MS)
+        return -1;
+      delay(1);
+    }
+  }
+
+  static int hexDigit(int c) {
+    if (c >= '0' && c <= '9')
+      return c - '0';
+    c |= 0x20;
+    return c >= 'a' && c <= 'f' ? c - 'a' + 10 : -1;
+  }
+
+  // Baris ukuran chunk berikutnya. Chunk 0 diikuti trailer sampai baris
+  // kosong, lalu body selesai.
+  bool nextChunk() {
+    int c;
+    // CRLF penutup chunk sebelumnya
+    while ((c = rawRead()) == '\r' || c == '\n') {
+    }
+    uint32_t size = 0;
+    uint8_t digits = 0;
+    for (int d; (d = hexDigit(c)) >= 0 && digits < 8; c = rawRead()) {
+      size = size << 4 | d;
+      digits++;
+    }
+    // Ekstensi chunk diabaikan
+    while (c >= 0 && c != '\n')
+      c = rawRead();
+    if (c < 0 || !digits)
+      return false;
+    if (size) {
+      left_ = size;
+      return true;
+    }
+    uint16_t line = 0;
+    while ((c = rawRead()) >= 0) {
+      if (c == '\n') {
+        if (!line) {
+          done_ = true;
+          return false;
+        }
+        line = 0;
+      } else if (c != '\r') {
+        line++;
+      }
+    }
+    return false;
+  }
+
+  bool fill() {
+    if (pos_ < len_)
+      return true;
+    if (done_ || broken_)
+      return false;
+    if (!left_) {
+      if (!chunked_) {
+        done_ = true;
+        return false;
+      }
+      if (!nextChunk()) {
+        broken_ = !done_;
+        return false;
+      }
+    }
+    size_t want = left_ < sizeof(buf_) ? left_ : sizeof(buf_);
+    unsigned long start = millis();
+    int n;
+    while ((n = client_.read(buf_, want)) <= 0) {
+      if (!client_.connected() || millis() - start > API_TIMEOUT_MS) {
+        broken_ = true;
+        return false;
+      }
+      delay(1);
+    }
+    left_ -= n;
+    pos_ = 0;
+    len_ = n;
+    return true;
+  }
+
+  WiFiClient &client_;
+  bool chunked_;
+  bool done_ = false;
+  bool broken_ = false;
+  uint32_t left_; // byte tersisa di body (atau di chunk ini)
+  uint8_t buf_[API_BODY_BUF];
+  uint16_t pos_ = 0;
+  uint16_t len_ = 0;
+};
+
+void apiBegin(const char *baseUrl, const char *key) {
+  apiBase = baseUrl;
+  apiKey = key;
+  apiMutex = xSemaphoreCreateMutex();
+  client.setInsecure();
+  https.setReuse(true);
+  https.setTimeout(API_TIMEOUT_MS);
+  https.setConnectTimeout(API_TIMEOUT_MS);
+}
+
+static int request(const char *method, const char *path, const uint8_t *body,
+                   size_t len, String *response, ApiBodyReader reader,
+                   void *ctx, const ApiHeader *extra) {
+  if (WiFi.status() != WL_CONNECTED)
+    return HTTPC_ERROR_NOT_CONNECTED;
+
+  xSemaphoreTake(apiMutex, portMAX_DELAY);
+
+  bool alive = client.connected();
+  if (alive && millis() - lastUse > API_IDLE_TIMEOUT_MS) {
+    client.stop();
+    alive = false;
+  }
+  // Reconnect yang baru gagal: jangan handshake lagi sebelum jedanya habis
+  if (!alive && (long)(millis() - nextConnectAt) < 0) {
+    xSemaphoreGive(apiMutex);
+    return HTTPC_ERROR_CONNECTION_REFUSED;
+  }
+
+  // URL dirakit di buffer tetap (dijaga apiMutex), bukan String + path
+  static char url[160];
+  snprintf(url, sizeof(url), "%s%s", apiBase, path);
+  unsigned long start = millis();
+  int httpCode = HTTPC_ERROR_CONNECTION_REFUSED;
+  if (https.begin(client, url)) {
+    https.addHeader("Content-Type", "application/json");
+    https.addHeader("x-api-key", apiKey);
+    for (const ApiHeader *h = extra; h && h->name; h++)
+      https.addHeader(h->name, h->value);
+    // Koneksi baru: span termasuk handshake TLS
+    const char *span = alive ? "sendRequest" : "sendRequest+tls";
+    traceBegin(span);
+    httpCode = https.sendRequest(method, (uint8_t *)body, len);
+    traceEnd(span);
+    if (httpCode > 0)
+      ttfbMs.observe(millis() - start);
+    if (response)
+      *response = httpCode > 0 ? https.getString() : String();
+    if (reader && httpCode > 0) {
+      ApiBody stream(https.getStream(), https.getSize());
+      if (httpCode >= 200 && httpCode < 300)
+        reader(stream, ctx);
+      if (!stream.drain())
+        httpCode = HTTPC_ERROR_CONNECTION_LOST;
+    }
+    https.end();
+  }
+  uint32_t elapsed = millis() - start;
+  lastUse = millis();
+
+  stats.requests++;
+  if (alive)
+    stats.reused++;
+  else
+    stats.connects++;
+
+  if (httpCode > 0) {
+    requestMs.observe(elapsed);
+    backoff = API_BACKOFF_MIN_MS;
+    stats.lastMs = elapsed;
+    if (stats.avgMs)
+      stats.avgMs += ((int32_t)elapsed - (int32_t)stats.avgMs) / 8;
+    else
+      stats.avgMs = elapsed;
+    if (elapsed > stats.maxMs)
+      stats.maxMs = elapsed;
+    if (!alive)
+      stats.connectMs = elapsed;
+  } else {
+    stats.failures++;
+    client.stop();
+    if (httpCode == HTTPC_ERROR_CONNECTION_REFUSED) {
+      nextConnectAt = millis() + backoff;
+      backoff *= 2;
+      if (backoff > API_BACKOFF_MAX_MS)
+        backoff = API_BACKOFF_MAX_MS;
+    }
+  }
+
+  xSemaphoreGive(apiMutex);
+  return httpCode;
+}
+
+int apiRequest(const char *method, const char *path, const uint8_t *body,
+               size_t len, String *response, const ApiHeader *extra) {
+  return request(method, path, body, len, response, nullptr, nullptr, extra);
+}
+
+int apiGetStream(const char *path, ApiBodyReader reader, void *ctx) {
+  return request("GET", path, nullptr, 0, nullptr, reader, ctx, nullptr);
+}
+
+ApiStats apiStats() {
+  xSemaphoreTake(apiMutex, portMAX_DELAY);
+  ApiStats s = stats;
+  xSemaphoreGive(apiMutex);
+  return s;
+}
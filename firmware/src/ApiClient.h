@@ -0,0 +1,63 @@
+#pragma once
+
+#include <Arduino.h>
+
+// ================== API CLIENT ==================
+// Satu koneksi HTTPS keep-alive ke backend, dipakai bergantian oleh semua
+// task. Handshake TLS hanya terjadi kalau socket sudah putus; koneksi
+// idle ditutup sendiri sebelum server memutusnya, dan reconnect yang
+// gagal diberi jeda backoff.
+
+struct ApiStats {
+  uint32_t requests;
+  uint32_t failures;
+  uint32_t connects;  // handshake TLS baru
+  uint32_t reused;    // request lewat koneksi yang sudah terbuka
+  uint32_t lastMs;    // latency request terakhir
+  uint32_t avgMs;     // rata-rata bergerak (EWMA 1/8)
+  uint32_t maxMs;
+  uint32_t connectMs; // latency request terakhir yang butuh handshake
+};
+
+// Header tambahan opsional untuk satu request: array yang diakhiri elemen
+// dengan name nullptr
+struct ApiHeader {
+  const char *name;
+  const char *value;
+};
+
+void apiBegin(const char *baseUrl, const char *apiKey);
+
+// Return HTTP status, atau kode HTTPC_ERROR_* (negatif). Body jawaban
+// disalin ke response kalau tidak null. Body dikirim langsung dari buffer
+// pemanggil, tanpa salinan String.
+int apiRequest(const char *method, const char *path, const uint8_t *body,
+               size_t len, String *response = nullptr,
+               const ApiHeader *extra = nullptr);
+
+inline int apiPost(const char *path, const char *body, size_t len,
+                   String *response = nullptr,
+                   const ApiHeader *extra = nullptr) {
+  return apiRequest("POST", path, (const uint8_t *)body, len, response, extra);
+}
+
+inline int apiPost(const char *path, const String &body,
+                   String *response = nullptr) {
+  return apiPost(path, body.c_str(), body.length(), response);
+}
+
+inline int apiGet(const char *path, String *response) {
+  return apiRequest("GET", path, nullptr, 0, response);
+}
+
+// Pembaca body jawaban langsung dari socket, untuk body yang tidak perlu
+// (atau tidak muat) disalin ke String. Dipanggil di bawah apiMutex: tidak
+// boleh memanggil apiRequest lagi.
+typedef void (*ApiBodyReader)(Stream &body, void *ctx);
+
+// GET yang body jawaban 2xx-nya dibaca reader. Sisa body yang tidak dibaca
+// dibuang supaya koneksi keep-alive tetap bisa dipakai; kalau body putus
+// di tengah, return HTTPC_ERROR_CONNECTION_LOST.
+int apiGetStream(const char *path, ApiBodyReader reader, void *ctx);
+
+ApiStats apiStats();
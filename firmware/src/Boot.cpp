@@ -0,0 +1,88 @@
+#include "Boot.h"
+
+#include <RTClib.h>
+
+#include "Connectivity.h"
+#include "Events.h"
+#include "time.h"
+
+#define BOOT_TASK_CORE 0
+#define BOOT_TASK_STACK 4096
+#define BOOT_TASK_PRIO 1
+#define BOOT_POLL_MS 100
+#define NTP_WAIT_MS 5000
+#define NTP_TRIES 3
+
+static portMUX_TYPE bootMux = portMUX_INITIALIZER_UNLOCKED;
+static BootStage stages[BOOT_STAGE_MAX];
+static uint8_t stageCount = 0;
+
+static BootNetConfig netCfg;
+static volatile bool ntpReady = false;
+static uint32_t ntpUnix = 0;
+
+void bootStage(const char *name) {
+  uint32_t now = millis();
+  portENTER_CRITICAL(&bootMux);
+  if (stageCount < BOOT_STAGE_MAX)
+    stages[stageCount++] = {name, now};
+  portEXIT_CRITICAL(&bootMux);
+  Serial.printf("Boot: %-8s %6lu ms\n", name, (unsigned long)now);
+}
+
+uint8_t bootStages(BootStage *out, uint8_t max) {
+  portENTER_CRITICAL(&bootMux);
+  uint8_t n = stageCount < max ? stageCount : max;
+  for (uint8_t i = 0; i < n; i++)
+    out[i] = stages[i];
+  portEXIT_CRITICAL(&bootMux);
+  return n;
+}
+
+// Task sekali jalan: selesai setelah NTP (atau menyerah). Tidak ada
+// timeout menunggu WiFi karena scan tidak menunggu task ini
+static void bootTask(void *) {
+  // WiFi tersambung di task-nya sendiri sementara ini jalan
+  if (netCfg.background)
+    netCfg.background();
+
+  while (!netConnected())
+    vTaskDelay(pdMS_TO_TICKS(BOOT_POLL_MS));
+  bootStage("wifi");
+
+  if (netCfg.onConnected) {
+    netCfg.onConnected();
+    bootStage("ota");
+  }
+
+  configTime(netCfg.gmtOffsetSec, 0, "id.pool.ntp.org", "pool.ntp.org");
+  struct tm t;
+  for (uint8_t i = 0; i < NTP_TRIES; i++) {
+    if (getLocalTime(&t, NTP_WAIT_MS)) {
+      ntpUnix = DateTime(t.tm_year + 1900, t.tm_mon + 1, t.tm_mday, t.tm_hour,
+                         t.tm_min, t.tm_sec)
+                    .unixtime();
+      ntpReady = true;
+      eventsWake();
+      bootStage("ntp");
+      break;
+    }
+  }
+  if (!ntpReady)
+    Serial.println("Boot: NTP gagal, pakai waktu RTC");
+  vTaskDelete(nullptr);
+}
+
+void bootNetBegin(const BootNetConfig &cfg) {
+  netCfg = cfg;
+  xTaskCreatePinnedToCore(bootTask, "boot", BOOT_TASK_STACK, nullptr,
+                          BOOT_TASK_PRIO, nullptr, BOOT_TASK_CORE);
+}
+
+bool bootNtpPoll(uint32_t *unixtime) {
+  if (!ntpReady)
+    return false;
+  *unixtime = ntpUnix;
+  ntpReady = false;
+  return true;
+}
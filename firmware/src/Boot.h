@@ -0,0 +1,38 @@
+#pragma once
+
+#include <Arduino.h>
+
+// ================== BOOT ==================
+// Boot bertahap: layar, flash, RTC dan sensor siap lebih dulu dan scan
+// langsung aktif. WiFi (Connectivity.h), OTA dan NTP naik di background;
+// absen sebelum online tetap masuk outbox dan diupload begitu tersambung.
+// Setiap tahap dicatat (millis() sejak power-on) dan dicetak ke serial.
+
+#define BOOT_STAGE_MAX 12
+
+struct BootStage {
+  const char *name; // string literal
+  uint32_t atMs;
+};
+
+// Catat satu tahap; aman dipanggil dari task mana pun
+void bootStage(const char *name);
+// Salin tahap yang tercatat, urut waktu; mengembalikan jumlahnya
+uint8_t bootStages(BootStage *out, uint8_t max);
+
+struct BootNetConfig {
+  long gmtOffsetSec;
+  // Dipanggil dari task boot setelah WiFi tersambung (mis. ArduinoOTA)
+  void (*onConnected)();
+  // Dipanggil dari task boot sebelum menunggu WiFi: pekerjaan boot yang
+  // tidak butuh jaringan tetapi terlalu lama untuk setup()
+  void (*background)();
+};
+
+// Task background: jalankan background, lalu tunggu WiFi tersambung
+// pertama kali (netBegin() sudah dipanggil), lalu onConnected -> NTP
+void bootNetBegin(const BootNetConfig &cfg);
+
+// Waktu NTP (unix) yang belum diterapkan ke RTC. Dipanggil dari loop()
+// supaya bus I2C RTC hanya dipakai satu task.
+bool bootNtpPoll(uint32_t *unixtime);
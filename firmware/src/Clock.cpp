@@ -0,0 +1,182 @@
+#include "Clock.h"
+
+#include "Events.h"
+
+// Jarak minimal antar pengukuran periode: jitter edge dibagi sepanjang ini
+#define CLOCK_PERIOD_SPAN 64
+// Batas periode yang masuk akal (±1000 ppm)
+#define CLOCK_PERIOD_MIN 999000
+#define CLOCK_PERIOD_MAX 1001000
+// Edge boleh terlambat sampai periode / CLOCK_EDGE_SLACK sebelum jam
+// dianggap lepas dan kembali ekstrapolasi
+#define CLOCK_EDGE_SLACK 20
+
+static RTC_DS3231 *rtcDev = nullptr;
+static portMUX_TYPE clockMux = portMUX_INITIALIZER_UNLOCKED;
+
+// Semua di bawah dijaga clockMux (ditulis ISR dan task)
+static uint32_t baseSec = 0;        // detik unix tepat pada baseUs
+static uint32_t baseUs = 0;         // micros() edge terakhir / saat seed
+static uint32_t periodUs = 1000000; // micros() per detik RTC
+static bool edgeSeen = false;       // baseUs berasal dari edge SQW
+static uint32_t anchorSec = 0;      // awal pengukuran periode (0 = belum)
+static uint32_t anchorUs = 0;
+static uint64_t lastOut = 0;
+static ClockStats stats = {};
+
+// Di luar ISR
+static uint32_t verifiedAt = 0; // baseSec saat cek I2C terakhir (0 = perlu)
+
+static void IRAM_ATTR onSqw() {
+  uint32_t now = micros();
+  portENTER_CRITICAL_ISR(&clockMux);
+  uint32_t el = now - baseUs;
+  uint32_t n;
+  if (!edgeSeen) {
+    // Seed dibaca di tengah detik baseSec: edge berikutnya baseSec + 1
+    n = el / periodUs + 1;
+  } else if (el < periodUs / 2) {
+    stats.spurious++;
+    portEXIT_CRITICAL_ISR(&clockMux);
+    return;
+  } else {
+    n = (el + periodUs / 2) / periodUs;
+    int32_t corr = (int32_t)(el - n * periodUs);
+    stats.lastCorrUs = corr;
+    uint32_t mag = corr < 0 ? -corr : corr;
+    if (mag > stats.maxCorrUs)
+      stats.maxCorrUs = mag;
+    stats.missed += n - 1;
+  }
+  baseSec += n;
+  baseUs = now;
+  edgeSeen = true;
+  stats.edges++;
+
+  // Periode diukur dari edge yang berjauhan, bukan per detik
+  if (!anchorSec) {
+    anchorSec = baseSec;
+    anchorUs = now;
+  } else if (baseSec - anchorSec >= CLOCK_PERIOD_SPAN) {
+    uint32_t p = (now - anchorUs) / (baseSec - anchorSec);
+    if (p >= CLOCK_PERIOD_MIN && p <= CLOCK_PERIOD_MAX)
+      periodUs = p;
+    anchorSec = baseSec;
+    anchorUs = now;
+  }
+  portEXIT_CRITICAL_ISR(&clockMux);
+}
+
+// Dipanggil dengan clockMux terkunci
+static bool lockedAt(uint32_t now) {
+  return edgeSeen && now - baseUs < periodUs + periodUs / CLOCK_EDGE_SLACK;
+}
+
+// Set basis dari detik yang diketahui tepat pada saat ini
+static void reseed(uint32_t sec, bool onEdge) {
+  portENTER_CRITICAL(&clockMux);
+  baseSec = sec;
+  baseUs = micros();
+  edgeSeen = onEdge;
+  anchorSec = 0;
+  portEXIT_CRITICAL(&clockMux);
+}
+
+static uint32_t readRtc() {
+  uint32_t sec = rtcDev->now().unixtime();
+  portENTER_CRITICAL(&clockMux);
+  stats.i2cReads++;
+  portEXIT_CRITICAL(&clockMux);
+  return sec;
+}
+
+// Timer CLOCK_CHECK_MS: fallback I2C bila SQW diam, dan cocokkan detik
+// sesekali. Pembacaan dilakukan di tengah detik supaya tidak bisa
+// bertabrakan dengan edge.
+static void clockCheck(void *) {
+  portENTER_CRITICAL(&clockMux);
+  uint32_t now = micros();
+  bool locked = lockedAt(now);
+  uint32_t el = now - baseUs;
+  uint32_t sec = baseSec;
+  uint32_t period = periodUs;
+  portEXIT_CRITICAL(&clockMux);
+
+  if (!locked) {
+    reseed(readRtc(), false);
+    verifiedAt = 0;
+    return;
+  }
+  if (verifiedAt && sec - verifiedAt < CLOCK_VERIFY_S)
+    return;
+  if (el < period / 5 || el > period * 4 / 5)
+    return;
+  int32_t diff = (int32_t)(readRtc() - sec);
+  portENTER_CRITICAL(&clockMux);
+  if (baseSec == sec)
+    baseSec += diff;
+  portEXIT_CRITICAL(&clockMux);
+  if (diff)
+    Serial.printf("Clock: detik dikoreksi %ld\n", (long)diff);
+  verifiedAt = sec + diff;
+}
+
+void clockBegin(RTC_DS3231 &rtc) {
+  rtcDev = &rtc;
+  rtc.writeSqwPinMode(DS3231_SquareWave1Hz);
+  reseed(readRtc(), false);
+  pinMode(CLOCK_SQW_PIN, INPUT_PULLUP); // SQW open-drain
+  attachInterrupt(digitalPinToInterrupt(CLOCK_SQW_PIN), onSqw, FALLING);
+  timerEvery(CLOCK_CHECK_MS, clockCheck);
+}
+
+uint64_t clockNowUs() {
+  portENTER_CRITICAL(&clockMux);
+  uint32_t now = micros();
+  uint32_t el = now - baseUs;
+  uint64_t frac;
+  if (lockedAt(now))
+    // Edge berikutnya belum masuk: tahan di akhir detik, jangan melompat
+    frac = el < periodUs ? (uint64_t)el * 1000000 / periodUs : 999999;
+  else
+    frac = (uint64_t)el * 1000000 / periodUs;
+  uint64_t t = (uint64_t)baseSec * 1000000 + frac;
+  if (t < lastOut) {
+    t = lastOut;
+    stats.held++;
+  } else {
+    lastOut = t;
+  }
+  portEXIT_CRITICAL(&clockMux);
+  return t;
+}
+
+uint32_t clockNow() { return clockNowUs() / 1000000; }
+
+DateTime clockDateTime() { return DateTime(clockNow()); }
+
+void clockAdjust(const DateTime &t) {
+  // Menulis detik me-reset rantai pembagi DS3231: edge SQW berikutnya
+  // tepat satu detik setelah ini, jadi saat ini diperlakukan sebagai edge
+  rtcDev->adjust(t);
+  reseed(t.unixtime(), true);
+  portENTER_CRITICAL(&clockMux);
+  lastOut = 0;
+  portEXIT_CRITICAL(&clockMux);
+  verifiedAt = 0;
+}
+
+bool clockLocked() {
+  portENTER_CRITICAL(&clockMux);
+  bool locked = lockedAt(micros());
+  portEXIT_CRITICAL(&clockMux);
+  return locked;
+}
+
+ClockStats clockStats() {
+  portENTER_CRITICAL(&clockMux);
+  ClockStats s = stats;
+  s.periodUs = periodUs;
+  portEXIT_CRITICAL(&clockMux);
+  return s;
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <Arduino.h>
+#include <RTClib.h>
+
+// ================== CLOCK ==================
+// Jam software yang didisiplinkan oleh output SQW 1 Hz DS3231. RTC dibaca
+// sekali lewat I2C saat clockBegin(); setelah itu detik berjalan dari edge
+// turun SQW (interrupt) dan pecahan detiknya diinterpolasi dengan micros().
+// Membaca jam tidak menyentuh bus I2C sama sekali.
+//
+// Edge turun SQW terjadi tepat saat register detik DS3231 naik, jadi tiap
+// edge mengoreksi hasil interpolasi. Periode micros() per detik RTC diukur
+// dari jarak antar edge, sehingga selisih kristal ESP32 vs DS3231 ikut
+// terkompensasi. Bila edge tidak datang (kabel SQW lepas), jam kembali
+// membaca RTC lewat I2C tiap CLOCK_CHECK_MS.
+
+#define CLOCK_SQW_PIN 14
+#define CLOCK_CHECK_MS 1000
+// Detik RTC dicocokkan ulang lewat I2C sekali per interval ini
+#define CLOCK_VERIFY_S 3600
+
+struct ClockStats {
+  uint32_t edges;      // edge SQW yang dipakai
+  uint32_t missed;     // edge yang terlewat (celah > 1 detik)
+  uint32_t spurious;   // edge terlalu rapat, diabaikan
+  int32_t lastCorrUs;  // edge terakhir dikurangi prediksi interpolasi
+  uint32_t maxCorrUs;  // |koreksi| terbesar
+  uint32_t periodUs;   // micros() per detik RTC hasil ukur
+  uint32_t i2cReads;   // pembacaan RTC lewat I2C sejak boot
+  uint32_t held;       // pembacaan yang ditahan agar tidak mundur
+};
+
+// Panggil setelah rtc.begin(); mengaktifkan SQW 1 Hz dan interrupt-nya
+void clockBegin(RTC_DS3231 &rtc);
+
+// Detik unix, tanpa akses I2C
+uint32_t clockNow();
+// Mikrodetik unix, monoton (tidak pernah mundur kecuali clockAdjust)
+uint64_t clockNowUs();
+DateTime clockDateTime();
+
+// Set RTC (mis. dari NTP) dan sinkronkan ulang jam software
+void clockAdjust(const DateTime &t);
+
+// true selama edge SQW datang teratur
+bool clockLocked();
+ClockStats clockStats();
@@ -0,0 +1,265 @@
+#include "Connectivity.h"
+
+#include <LittleFS.h>
+#include <WiFi.h>
+#include <esp32/rom/crc.h>
+#include <esp_netif.h>
+#include <esp_netif_net_stack.h>
+#include <lwip/dhcp.h>
+
+#include "Clock.h"
+
+#define NET_TASK_CORE 0
+#define NET_TASK_STACK 4096
+#define NET_TASK_PRIO 1
+#define NET_POLL_MS 50       // selama percobaan connect
+#define NET_LINK_POLL_MS 250 // selama tersambung
+// Connect ke BSSID/channel yang diketahui cukup association (+ DHCP);
+// connect biasa termasuk scan semua channel
+#define NET_FAST_TIMEOUT_MS 2500
+#define NET_CONNECT_TIMEOUT_MS 12000
+
+#define NET_CACHE "/wifi.bin"
+#define NET_CACHE_MAGIC 0x4E455432 // "NET2"
+
+struct NetCache {
+  uint32_t magic;
+  uint8_t bssid[6];
+  uint8_t channel;
+  uint8_t reserved;
+  uint32_t ip, gateway, subnet, dns;
+  // Lease DHCP terakhir: clockNow() saat didapat dan waktu perpanjangannya
+  // (T1, detik). Sampai T1 IP-nya boleh dipakai ulang sebagai IP statis.
+  uint32_t leaseAt;
+  uint32_t renewS; // 0 = tidak ada / tidak diketahui
+  uint32_t crc;
+};
+
+static NetConfig cfg;
+static NetCallback onChange = nullptr;
+static SemaphoreHandle_t kickSem = nullptr;
+static portMUX_TYPE netMux = portMUX_INITIALIZER_UNLOCKED;
+static NetStats stats = {};
+static NetCache cache;
+static bool cacheValid = false;
+// Tersambung dengan IP dari cache, bukan dari DHCP
+static bool onCachedLease = false;
+
+static uint32_t cacheCrc(const NetCache &c) {
+  return crc32_le(0, (const uint8_t *)&c, offsetof(NetCache, crc));
+}
+
+// Waktu perpanjangan (T1) lease yang baru didapat, dalam detik. lwIP
+// memakai separuh lama lease kalau server tidak mengirim T1. 0 kalau tidak
+// diketahui: IP-nya lalu tidak dipakai ulang.
+static uint32_t dhcpRenewSeconds() {
+  esp_netif_t *sta = esp_netif_get_handle_from_ifkey("WIFI_STA_DEF");
+  struct netif *nif =
+      sta ? (struct netif *)esp_netif_get_netif_impl(sta) : nullptr;
+  struct dhcp *d = nif ? netif_dhcp_data(nif) : nullptr;
+  return d ? d->offered_t1_renew : 0;
+}
+
+static void loadCache() {
+  fs::File f = LittleFS.open(NET_CACHE, FILE_READ);
+  if (!f)
+    return;
+  bool ok = f.read((uint8_t *)&cache, sizeof(cache)) == sizeof(cache);
+  f.close();
+  cacheValid = ok && cache.magic == NET_CACHE_MAGIC && cache.channel &&
+               cache.crc == cacheCrc(cache);
+}
+
+// Tulis hanya kalau ada yang berubah, supaya reconnect tidak mengikis flash
+static void saveCache(bool dhcp) {
+  NetCache c = cacheValid ? cache : NetCache();
+  c.magic = NET_CACHE_MAGIC;
+  const uint8_t *bssid = WiFi.BSSID();
+  if (!bssid)
+    return;
+  memcpy(c.bssid, bssid, 6);
+  c.channel = WiFi.channel();
+  if (dhcp) {
+    c.ip = WiFi.localIP();
+    c.gateway = WiFi.gatewayIP();
+    c.subnet = WiFi.subnetMask();
+    c.dns = WiFi.dnsIP();
+    c.leaseAt = clockNow();
+    c.renewS = dhcpRenewSeconds();
+  }
+  c.crc = cacheCrc(c);
+  if (cacheValid && !memcmp(&c, &cache, sizeof(c)))
+    return;
+
+  fs::File f = LittleFS.open(NET_CACHE, FILE_WRITE);
+  if (!f)
+    return;
+  bool ok = f.write((const uint8_t *)&c, sizeof(c)) == sizeof(c);
+  f.close();
+  if (ok) {
+    cache = c;
+    cacheValid = true;
+  }
+}
+
+static void setState(NetState s) {
+  portENTER_CRITICAL(&netMux);
+  stats.state = s;
+  portEXIT_CRITICAL(&netMux);
+  if (onChange)
+    onChange(s);
+}
+
+// Jam yang diset mundur (RTC lebih cepat, lalu NTP) juga membuat lease
+// dianggap habis: lebih baik satu DHCP ekstra daripada memakai IP basi
+static bool leaseFresh() {
+  uint32_t now = clockNow();
+  return cache.renewS && now >= cache.leaseAt &&
+         now - cache.leaseAt < cache.renewS;
+}
+
+// Satu percobaan connect; true kalau tersambung sebelum timeout
+static bool attempt(bool fast, bool *dhcp) {
+  *dhcp = false;
+  onCachedLease = false;
+  if ((uint32_t)cfg.staticIp) {
+    WiFi.config(cfg.staticIp, cfg.gateway, cfg.subnet, cfg.gateway);
+  } else if (fast && leaseFresh()) {
+    WiFi.config(IPAddress(cache.ip), IPAddress(cache.gateway),
+                IPAddress(cache.subnet), IPAddress(cache.dns));
+    onCachedLease = true;
+  } else {
+    WiFi.config(INADDR_NONE, INADDR_NONE, INADDR_NONE);
+    *dhcp = true;
+  }
+  WiFi.begin(cfg.ssid, cfg.password, fast ? cache.channel : 0,
+             fast ? cache.bssid : nullptr);
+
+  uint32_t start = millis();
+  uint32_t timeout = fast ? NET_FAST_TIMEOUT_MS : NET_CONNECT_TIMEOUT_MS;
+  while (millis() - start < timeout) {
+    wl_status_t st = WiFi.status();
+    if (st == WL_CONNECTED)
+      return true;
+    if (st == WL_NO_SSID_AVAIL || st == WL_CONNECT_FAILED)
+      break;
+    vTaskDelay(pdMS_TO_TICKS(NET_POLL_MS));
+  }
+  WiFi.disconnect();
+  return false;
+}
+
+static void netTask(void *) {
+  WiFi.mode(WIFI_STA);
+  // Reconnect diatur di sini, bukan oleh driver
+  WiFi.persistent(false);
+  WiFi.setAutoReconnect(false);
+  loadCache();
+
+  uint32_t backoff = NET_BACKOFF_MIN_MS;
+  uint32_t downSince = millis();
+  bool tryFast = cacheValid;
+
+  for (;;) {
+    setState(NET_CONNECTING);
+    uint32_t start = millis();
+    bool dhcp;
+    bool fast = tryFast && cacheValid;
+    bool ok = attempt(fast, &dhcp);
+    uint32_t now = millis();
+
+    portENTER_CRITICAL(&netMux);
+    stats.attempts++;
+    if (ok) {
+      stats.connects++;
+      if (fast)
+        stats.fastConnects++;
+      stats.lastConnectMs = now - start;
+      if (stats.lastConnectMs > stats.maxConnectMs)
+        stats.maxConnectMs = stats.lastConnectMs;
+      stats.lastOutageMs = now - downSince;
+      if (stats.lastOutageMs > stats.maxOutageMs)
+        stats.maxOutageMs = stats.lastOutageMs;
+    }
+    portEXIT_CRITICAL(&netMux);
+
+    if (!ok) {
+      if (fast) {
+        // AP pindah channel / diganti: langsung coba connect biasa
+        Serial.println("WiFi: AP cache tidak ditemukan, scan ulang");
+        tryFast = false;
+        continue;
+      }
+      // Equal jitter: separuh tetap, separuh acak, supaya reader yang
+      // kehilangan AP bersamaan tidak mencoba serentak
+      uint32_t wait = backoff / 2 + random(backoff / 2 + 1);
+      Serial.printf("WiFi: gagal, coba lagi %lu ms\n", (unsigned long)wait);
+      setState(NET_BACKOFF);
+      xSemaphoreTake(kickSem, pdMS_TO_TICKS(wait));
+      backoff *= 2;
+      if (backoff > NET_BACKOFF_MAX_MS)
+        backoff = NET_BACKOFF_MAX_MS;
+      tryFast = cacheValid;
+      continue;
+    }
+
+    Serial.printf("WiFi: tersambung %lu ms%s, %s\n",
+                  (unsigned long)(now - start), fast ? " (cache)" : "",
+                  WiFi.localIP().toString().c_str());
+    saveCache(dhcp);
+    backoff = NET_BACKOFF_MIN_MS;
+    setState(NET_CONNECTED);
+
+    // IP dari cache tidak pernah diperpanjang ke server DHCP: saat T1-nya
+    // lewat, sambung ulang (ke AP yang sama) supaya dapat lease baru
+    bool renew = false;
+    while (WiFi.status() == WL_CONNECTED && !renew) {
+      xSemaphoreTake(kickSem, pdMS_TO_TICKS(NET_LINK_POLL_MS));
+      renew = onCachedLease && !leaseFresh();
+    }
+
+    if (renew) {
+      Serial.println("WiFi: lease cache habis, sambung ulang dengan DHCP");
+      portENTER_CRITICAL(&netMux);
+      stats.leaseRenews++;
+      portEXIT_CRITICAL(&netMux);
+    } else {
+      Serial.println("WiFi: putus, reconnect");
+      portENTER_CRITICAL(&netMux);
+      stats.drops++;
+      portEXIT_CRITICAL(&netMux);
+    }
+    WiFi.disconnect();
+    downSince = millis();
+    tryFast = true;
+  }
+}
+
+void netBegin(const NetConfig &config, NetCallback cb) {
+  cfg = config;
+  onChange = cb;
+  kickSem = xSemaphoreCreateBinary();
+  xTaskCreatePinnedToCore(netTask, "wifi", NET_TASK_STACK, nullptr,
+                          NET_TASK_PRIO, nullptr, NET_TASK_CORE);
+}
+
+NetState netState() {
+  portENTER_CRITICAL(&netMux);
+  NetState s = stats.state;
+  portEXIT_CRITICAL(&netMux);
+  return s;
+}
+
+bool netConnected() { return netState() == NET_CONNECTED; }
+
+NetStats netStats() {
+  portENTER_CRITICAL(&netMux);
+  NetStats s = stats;
+  portEXIT_CRITICAL(&netMux);
+  return s;
+}
+
+void netKick() {
+  if (kickSem)
+    xSemaphoreGive(kickSem);
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <Arduino.h>
+#include <IPAddress.h>
+
+// ================== CONNECTIVITY ==================
+// Manajer WiFi di task sendiri. BSSID, channel dan lease DHCP terakhir
+// disimpan di LittleFS; reconnect berikutnya langsung ke AP itu tanpa scan
+// semua channel (dan tanpa DHCP selama lease itu belum perlu diperpanjang).
+// Kalau gagal, kembali ke connect biasa, lalu backoff eksponensial dengan
+// jitter. Link yang putus (AP restart) langsung dicoba lagi tanpa reboot.
+
+enum NetState : uint8_t {
+  NET_IDLE,       // belum netBegin()
+  NET_CONNECTING, // percobaan sedang jalan
+  NET_CONNECTED,
+  NET_BACKOFF     // menunggu percobaan berikutnya
+};
+
+struct NetConfig {
+  const char *ssid;
+  const char *password;
+  // IP statis opsional; 0.0.0.0 = DHCP
+  IPAddress staticIp;
+  IPAddress gateway;
+  IPAddress subnet;
+};
+
+struct NetStats {
+  NetState state;
+  uint32_t attempts;
+  uint32_t connects;
+  uint32_t fastConnects;  // lewat BSSID/channel dari cache
+  uint32_t drops;         // link putus setelah tersambung
+  uint32_t leaseRenews;   // sambung ulang karena T1 lease cache lewat
+  uint32_t lastConnectMs; // lama percobaan sukses terakhir
+  uint32_t maxConnectMs;
+  uint32_t lastOutageMs;  // putus (atau boot) sampai tersambung lagi
+  uint32_t maxOutageMs;
+};
+
+#define NET_BACKOFF_MIN_MS 1000
+#define NET_BACKOFF_MAX_MS 60000
+
+// Dipanggil dari task net setiap state berubah
+typedef void (*NetCallback)(NetState state);
+
+// Setelah LittleFS.begin()
+void netBegin(const NetConfig &cfg, NetCallback onChange = nullptr);
+NetState netState();
+bool netConnected();
+NetStats netStats();
+// Lewati sisa backoff dan coba sekarang (mis. sync manual)
+void netKick();
@@ -0,0 +1,224 @@
+#include "Events.h"
+
+struct Button {
+  uint8_t pin;
+  volatile uint32_t edgeAt; // millis() edge terakhir dari ISR
+  volatile bool edge;
+  bool down;                // level stabil setelah debounce
+  bool longSent;
+  uint32_t downAt;
+  uint32_t nextRepeat;
+};
+
+struct Timer {
+  TimerCallback cb;
+  void *arg;
+  uint32_t due;
+  uint32_t period; // 0 = one-shot
+  uint16_t gen;
+};
+
+#define BUTTON_QUEUE 8
+
+static Button buttons[BTN_COUNT];
+static ButtonEvent queue[BUTTON_QUEUE];
+static uint8_t qHead = 0, qLen = 0;
+static Timer timers[TIMER_MAX];
+static uint16_t timerGen = 0;
+static SemaphoreHandle_t wakeSem = nullptr;
+static LoopStats stats = {};
+static uint32_t loopStart = 0;
+
+// ---- Tombol ----
+
+static void IRAM_ATTR onEdge(Button &b) {
+  b.edgeAt = millis();
+  b.edge = true;
+  BaseType_t woken = pdFALSE;
+  if (wakeSem)
+    xSemaphoreGiveFromISR(wakeSem, &woken);
+}
+
+static void IRAM_ATTR isrUp() { onEdge(buttons[BTN_UP]); }
+static void IRAM_ATTR isrDown() { onEdge(buttons[BTN_DOWN]); }
+static void IRAM_ATTR isrOk() { onEdge(buttons[BTN_OK]); }
+
+static void push(ButtonId b, ButtonAction a, uint32_t at) {
+  // Antrian penuh: event terlama dibuang, yang terbaru lebih relevan
+  if (qLen == BUTTON_QUEUE) {
+    qHead = (qHead + 1) % BUTTON_QUEUE;
+    qLen--;
+  }
+  ButtonEvent &e = queue[(qHead + qLen) % BUTTON_QUEUE];
+  e.button = b;
+  e.action = a;
+  e.at = at;
+  qLen++;
+}
+
+void buttonsBegin(const uint8_t pins[BTN_COUNT]) {
+  static void (*const isr[BTN_COUNT])() = {isrUp, isrDown, isrOk};
+  for (uint8_t i = 0; i < BTN_COUNT; i++) {
+    Button &b = buttons[i];
+    b.pin = pins[i];
+    pinMode(b.pin, INPUT_PULLUP);
+    b.down = !digitalRead(b.pin);
+    b.edge = false;
+    attachInterrupt(digitalPinToInterrupt(b.pin), isr[i], CHANGE);
+  }
+}
+
+// Level dibaca ulang hanya setelah edge terakhir diam BUTTON_DEBOUNCE_MS,
+// jadi pantulan kontak tidak pernah terlihat sebagai tekan-lepas.
+static void scanButtons(uint32_t now) {
+  for (uint8_t i = 0; i < BTN_COUNT; i++) {
+    Button &b = buttons[i];
+    if (b.edge && now - b.edgeAt >= BUTTON_DEBOUNCE_MS) {
+      b.edge = false;
+      bool down = !digitalRead(b.pin);
+      if (down != b.down) {
+        b.down = down;
+        if (down) {
+          b.downAt = b.edgeAt;
+          b.longSent = false;
+          b.nextRepeat = b.downAt + BUTTON_REPEAT_DELAY_MS;
+          push((ButtonId)i, BTN_PRESS, b.downAt);
+        } else {
+          if (!b.longSent)
+            push((ButtonId)i, BTN_CLICK, b.edgeAt);
+          push((ButtonId)i, BTN_RELEASE, b.edgeAt);
+        }
+      }
+    }
+    if (!b.down)
+      continue;
+    if ((int32_t)(now - b.nextRepeat) >= 0) {
+      b.nextRepeat += BUTTON_REPEAT_MS;
+      push((ButtonId)i, BTN_REPEAT, now);
+    }
+    if (!b.longSent && now - b.downAt >= BUTTON_LONG_MS) {
+      b.longSent = true;
+      push((ButtonId)i, BTN_LONG, now);
+    }
+  }
+}
+
+bool buttonPoll(ButtonEvent *evt) {
+  if (qLen == 0)
+    scanButtons(millis());
+  if (qLen == 0)
+    return false;
+  *evt = queue[qHead];
+  qHead = (qHead + 1) % BUTTON_QUEUE;
+  qLen--;
+  return true;
+}
+
+bool buttonHeld(ButtonId b) { return buttons[b].down; }
+
+// ---- Timer ----
+
+static TimerId addTimer(uint32_t ms, uint32_t period, TimerCallback cb,
+                        void *arg) {
+  for (uint8_t i = 0; i < TIMER_MAX; i++) {
+    Timer &t = timers[i];
+    if (t.cb)
+      continue;
+    if (++timerGen >= 0x1000)
+      timerGen = 1;
+    t.cb = cb;
+    t.arg = arg;
+    t.due = millis() + ms;
+    t.period = period;
+    t.gen = timerGen;
+    // id = generasi (12 bit, >= 1) + slot (4 bit), tidak pernah TIMER_NONE
+    return (TimerId)((t.gen << 4) | i);
+  }
+  Serial.println("Events: slot timer habis");
+  return TIMER_NONE;
+}
+
+TimerId timerAfter(uint32_t ms, TimerCallback cb, void *arg) {
+  return addTimer(ms, 0, cb, arg);
+}
+
+TimerId timerEvery(uint32_t ms, TimerCallback cb, void *arg) {
+  return addTimer(ms, ms, cb, arg);
+}
+
+void timerCancel(TimerId &id) {
+  uint8_t slot = id & 0x0F;
+  if (id != TIMER_NONE && slot < TIMER_MAX && timers[slot].cb &&
+      timers[slot].gen == (id >> 4))
+    timers[slot].cb = nullptr;
+  id = TIMER_NONE;
+}
+
+void timersRun() {
+  uint32_t now = millis();
+  for (uint8_t i = 0; i < TIMER_MAX; i++) {
+    Timer &t = timers[i];
+    if (!t.cb || (int32_t)(now - t.due) < 0)
+      continue;
+    TimerCallback cb = t.cb;
+    void *arg = t.arg;
+    if (t.period) {
+      // Tertinggal beberapa periode: jalankan sekali, jangan menumpuk
+      t.due += t.period;
+      if ((int32_t)(now - t.due) >= 0)
+        t.due = now + t.period;
+    } else {
+      t.cb = nullptr; // slot bebas sebelum callback, boleh dipakai lagi
+    }
+    cb(arg);
+  }
+}
+
+// ---- Loop ----
+
+void eventsBegin() { wakeSem = xSemaphoreCreateBinary(); }
+
+void loopBegin() { loopStart = micros(); }
+
+void loopEnd() {
+  uint32_t us = micros() - loopStart;
+  stats.iterations++;
+  stats.lastUs = us;
+  if (stats.avgUs)
+    stats.avgUs += ((int32_t)us - (int32_t)stats.avgUs) / 8;
+  else
+    stats.avgUs = us;
+  if (us > stats.maxUs)
+    stats.maxUs = us;
+  if (us > LOOP_SLOW_US)
+    stats.slow++;
+}
+
+uint32_t loopElapsedUs() { return micros() - loopStart; }
+
+LoopStats loopStats() { return stats; }
+
+void eventsWait(uint32_t maxMs) {
+  uint32_t now = millis();
+  uint32_t wait = maxMs;
+  for (uint8_t i = 0; i < TIMER_MAX; i++) {
+    if (!timers[i].cb)
+      continue;
+    int32_t left = (int32_t)(timers[i].due - now);
+    if (left <= 0)
+      return;
+    if ((uint32_t)left < wait)
+      wait = left;
+  }
+  // Tombol masih ditahan / menunggu debounce: cek lagi sebentar lagi
+  for (uint8_t i = 0; i < BTN_COUNT; i++)
+    if (buttons[i].down || buttons[i].edge)
+      wait = min(wait, (uint32_t)BUTTON_DEBOUNCE_MS);
+  if (wakeSem && wait > 0)
+    xSemaphoreTake(wakeSem, pdMS_TO_TICKS(wait));
+}
+
+void eventsWake() {
+  if (wakeSem)
+    xSemaphoreGive(wakeSem);
+}
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <Arduino.h>
+
+// ================== EVENTS ==================
+// Scheduler kooperatif untuk loop(): tombol lewat interrupt GPIO dengan
+// debounce bertimestamp, timer one-shot / periodik, dan pengukuran lama
+// tiap iterasi loop. Tidak ada yang memanggil delay(); loop tidur di
+// eventsWait() sampai ada tombol, timer jatuh tempo, atau eventsWake().
+
+// ---- Tombol ----
+
+enum ButtonId : uint8_t { BTN_UP, BTN_DOWN, BTN_OK, BTN_COUNT };
+
+enum ButtonAction : uint8_t {
+  BTN_PRESS,   // baru ditekan (sudah stabil BUTTON_DEBOUNCE_MS)
+  BTN_REPEAT,  // masih ditahan: berulang tiap BUTTON_REPEAT_MS
+  BTN_LONG,    // ditahan BUTTON_LONG_MS, sekali per tekan
+  BTN_CLICK,   // dilepas sebelum BTN_LONG
+  BTN_RELEASE  // dilepas (selalu dikirim)
+};
+
+struct ButtonEvent {
+  ButtonId button;
+  ButtonAction action;
+  uint32_t at; // millis() saat kejadian
+};
+
+#define BUTTON_DEBOUNCE_MS 30
+#define BUTTON_REPEAT_DELAY_MS 600
+#define BUTTON_REPEAT_MS 200
+#define BUTTON_LONG_MS 3000
+
+// Tombol aktif LOW (INPUT_PULLUP), urutan pin sesuai ButtonId
+void buttonsBegin(const uint8_t pins[BTN_COUNT]);
+bool buttonPoll(ButtonEvent *evt);
+bool buttonHeld(ButtonId b);
+
+// ---- Timer ----
+
+typedef void (*TimerCallback)(void *arg);
+typedef uint16_t TimerId;
+#define TIMER_NONE 0
+#define TIMER_MAX 12
+
+// Callback dipanggil dari timersRun() di loop(), bukan dari ISR
+TimerId timerAfter(uint32_t ms, TimerCallback cb, void *arg = nullptr);
+TimerId timerEvery(uint32_t ms, TimerCallback cb, void *arg = nullptr);
+// Aman untuk id yang sudah jatuh tempo / TIMER_NONE; id di-reset
+void timerCancel(TimerId &id);
+void timersRun();
+
+// ---- Loop ----
+
+struct LoopStats {
+  uint32_t iterations;
+  uint32_t lastUs; // lama kerja iterasi terakhir (tanpa waktu tidur)
+  uint32_t avgUs;  // rata-rata bergerak (EWMA 1/8)
+  uint32_t maxUs;
+  uint32_t slow;   // iterasi lebih lama dari LOOP_SLOW_US
+};
+
+#define LOOP_SLOW_US 5000
+
+void eventsBegin();
+void loopBegin();
+void loopEnd();
+// Lama kerja iterasi ini sejauh ini (sejak loopBegin())
+uint32_t loopElapsedUs();
+LoopStats loopStats();
+
+// Tidur sampai ada event, timer berikutnya, atau maxMs
+void eventsWait(uint32_t maxMs);
+// Bangunkan loop dari task lain (mis. scan task mengirim hasil)
+void eventsWake();
@@ -0,0 +1,450 @@
+#include "History.h"
+
+#include <FS.h>
+#include <LittleFS.h>
+#include <esp32/rom/crc.h>
+
+#define HISTORY_DIR "/log"
+#define HISTORY_INDEX "/log/index.dat"
+#define HISTORY_INDEX_TMP "/log/index.tmp"
+#define HISTORY_MAGIC 0x474C5841UL // "AXLG"
+#define INDEX_MAGIC 0x49485841UL   // "AXHI"
+
+// Segmen tertua dibuang lebih awal kalau sisa flash kurang dari ini,
+// supaya outbox dan template store tidak kehabisan tempat
+#define HISTORY_MIN_FREE 65536
+#define HISTORY_CHUNK 32 // record per read()
+#define HISTORY_SCAN_MAX 64
+
+#define SEG_SORTED 0x01  // unixtime tidak pernah mundur di dalam segmen
+#define SEG_BIG_UID 0x02 // ada uid >= HISTORY_UID_BITS
+#define SEG_TORN 0x04    // ekor setengah tertulis, jangan di-append lagi
+
+// File segmen: [header][record][record]...
+// Index    : [IndexHeader][Segment * count][crc32], hanya segmen tertutup.
+// Segmen terbuka dibangun ulang dari filenya saat boot, jadi index cukup
+// ditulis (tmp + rename) saat segmen ditutup atau dibuang.
+struct SegmentHeader {
+  uint32_t magic;
+  uint32_t seq;
+};
+
+struct Segment {
+  uint32_t seq;
+  uint32_t day;   // unixtime / 86400 record pertama
+  uint32_t first; // unixtime terkecil, 0 = belum ada record valid
+  uint32_t last;  // unixtime terbesar
+  uint16_t count; // jumlah slot, termasuk yang CRC-nya rusak
+  uint8_t flags;
+  uint8_t reserved;
+  uint8_t uids[HISTORY_UID_BITS / 8];
+};
+
+struct IndexHeader {
+  uint32_t magic;
+  uint32_t count;
+};
+
+static SemaphoreHandle_t historyMutex = nullptr;
+static Segment segs[HISTORY_SEGMENTS]; // segmen tertutup, lama -> baru
+static uint8_t segCount = 0;
+static Segment cur; // segmen yang sedang di-append
+static bool haveCur = false;
+static uint32_t nextSeq = 1;
+
+static uint32_t recordCrc(const HistoryRecord &r) {
+  return crc32_le(0, (const uint8_t *)&r, offsetof(HistoryRecord, crc));
+}
+
+static void segPath(uint32_t seq, char *buf) {
+  snprintf(buf, 24, HISTORY_DIR "/%08lu.seg", (unsigned long)seq);
+}
+
+static void segReset(Segment &s, uint32_t seq) {
+  memset(&s, 0, sizeof(s));
+  s.seq = seq;
+  s.flags = SEG_SORTED;
+}
+
+static void segAdd(Segment &s, const HistoryRecord &r) {
+  if (!s.first) {
+    s.day = r.unixtime / 86400;
+    s.first = s.last = r.unixtime;
+  } else {
+    if (r.unixtime < s.last)
+      s.flags &= ~SEG_SORTED;
+    if (r.unixtime < s.first)
+      s.first = r.unixtime;
+    if (r.unixtime > s.last)
+      s.last = r.unixtime;
+  }
+  if (r.uid < HISTORY_UID_BITS)
+    s.uids[r.uid >> 3] |= 1 << (r.uid & 7);
+  else
+    s.flags |= SEG_BIG_UID;
+}
+
+static bool mayContain(const Segment &s, uint16_t uid) {
+  if (uid >= HISTORY_UID_BITS)
+    return s.flags & SEG_BIG_UID;
+  return s.uids[uid >> 3] & (1 << (uid & 7));
+}
+
+static size_t readSlots(fs::File &f, uint32_t slot, HistoryRecord *buf,
+                        size_t n) {
+  if (!f.seek(sizeof(SegmentHeader) + slot * sizeof(HistoryRecord)))
+    return 0;
+  return f.read((uint8_t *)buf, n * sizeof(HistoryRecord)) /
+         sizeof(HistoryRecord);
+}
+
+static uint32_t indexCrc(const IndexHeader &h) {
+  uint32_t crc = crc32_le(0, (const uint8_t *)&h, sizeof(h));
+  return crc32_le(crc, (const uint8_t *)segs, h.count * sizeof(Segment));
+}
+
+static bool writeIndex() {
+  IndexHeader h = {INDEX_MAGIC, segCount};
+  uint32_t crc = indexCrc(h);
+
+  fs::File f = LittleFS.open(HISTORY_INDEX_TMP, FILE_WRITE);
+  if (!f)
+    return false;
+  size_t len = segCount * sizeof(Segment);
+  bool ok = f.write((const uint8_t *)&h, sizeof(h)) == sizeof(h) &&
+            f.write((const uint8_t *)segs, len) == len &&
+            f.write((const uint8_t *)&crc, sizeof(crc)) == sizeof(crc);
+  f.close();
+  return ok && LittleFS.rename(HISTORY_INDEX_TMP, HISTORY_INDEX);
+}
+
+static bool readIndex() {
+  segCount = 0;
+  fs::File f = LittleFS.open(HISTORY_INDEX, FILE_READ);
+  if (!f)
+    return false;
+  IndexHeader h;
+  uint32_t crc = 0;
+  bool ok = f.read((uint8_t *)&h, sizeof(h)) == sizeof(h) &&
+            h.magic == INDEX_MAGIC && h.count <= HISTORY_SEGMENTS &&
+            f.read((uint8_t *)segs, h.count * sizeof(Segment)) ==
+                h.count * sizeof(Segment) &&
+            f.read((uint8_t *)&crc, sizeof(crc)) == sizeof(crc);
+  f.close();
+  if (!ok || crc != indexCrc(h))
+    return false;
+  segCount = h.count;
+  return true;
+}
+
+// Bangun entry index dari isi file segmen
+static bool scanSegment(uint32_t seq, Segment &s) {
+  char path[24];
+  segPath(seq, path);
+  fs::File f = LittleFS.open(path, FILE_READ);
+  if (!f)
+    return false;
+  SegmentHeader h;
+  if (f.read((uint8_t *)&h, sizeof(h)) != sizeof(h) ||
+      h.magic != HISTORY_MAGIC || h.seq != seq) {
+    f.close();
+    return false;
+  }
+
+  segReset(s, seq);
+  size_t body = f.size() - sizeof(h);
+  uint32_t slots = body / sizeof(HistoryRecord);
+  if (body % sizeof(HistoryRecord))
+    s.flags |= SEG_TORN;
+  if (slots > HISTORY_SEGMENT_RECORDS)
+    slots = HISTORY_SEGMENT_RECORDS;
+
+  HistoryRecord buf[HISTORY_CHUNK];
+  while (s.count < slots) {
+    size_t want = slots - s.count;
+    if (want > HISTORY_CHUNK)
+      want = HISTORY_CHUNK;
+    size_t n = f.read((uint8_t *)buf, want * sizeof(HistoryRecord)) /
+               sizeof(HistoryRecord);
+    if (!n)
+      break;
+    for (size_t i = 0; i < n; i++)
+      if (buf[i].crc == recordCrc(buf[i]))
+        segAdd(s, buf[i]);
+    s.count += n;
+  }
+  f.close();
+  return true;
+}
+
+static void dropOldest() {
+  char path[24];
+  segPath(segs[0].seq, path);
+  LittleFS.remove(path);
+  segCount--;
+  memmove(&segs[0], &segs[1], segCount * sizeof(Segment));
+}
+
+static size_t freeBytes() {
+  return LittleFS.totalBytes() - LittleFS.usedBytes();
+}
+
+// Pindahkan s ke daftar segmen tertutup, buang yang tertua kalau perlu
+static void pushClosed(const Segment &s) {
+  while (segCount &&
+         (segCount >= HISTORY_SEGMENTS || freeBytes() < HISTORY_MIN_FREE))
+    dropOldest();
+  segs[segCount++] = s;
+  writeIndex();
+}
+
+static void closeCur() {
+  if (!haveCur)
+    return;
+  haveCur = false;
+  if (cur.count)
+    pushClosed(cur);
+}
+
+static bool indexed(uint32_t seq) {
+  for (uint8_t i = 0; i < segCount; i++)
+    if (segs[i].seq == seq)
+      return true;
+  return false;
+}
+
+bool historyBegin() {
+  if (!historyMutex)
+    historyMutex = xSemaphoreCreateMutex();
+  LittleFS.mkdir(HISTORY_DIR);
+
+  bool dirty = !readIndex();
+  char path[24];
+  for (int i = segCount - 1; i >= 0; i--) {
+    segPath(segs[i].seq, path);
+    if (!LittleFS.exists(path)) {
+      memmove(&segs[i], &segs[i + 1], (segCount - i - 1) * sizeof(Segment));
+      segCount--;
+      dirty = true;
+    }
+  }
+  uint32_t maxSeq = segCount ? segs[segCount - 1].seq : 0;
+
+  // Segmen yang belum masuk index: yang lebih baru dari index adalah
+  // segmen terbuka (atau index gagal ditulis), sisanya sisa pruning
+  uint32_t found[HISTORY_SCAN_MAX];
+  uint8_t nFound = 0;
+  fs::File dir = LittleFS.open(HISTORY_DIR);
+  if (dir && dir.isDirectory()) {
+    for (fs::File f = dir.openNextFile(); f; f = dir.openNextFile()) {
+      const char *name = strrchr(f.name(), '/');
+      name = name ? name + 1 : f.name();
+      char *end;
+      uint32_t seq = strtoul(name, &end, 10);
+      f.close();
+      if (end == name || strcmp(end, ".seg") != 0 || indexed(seq))
+        continue;
+      if (nFound < HISTORY_SCAN_MAX)
+        found[nFound++] = seq;
+    }
+  }
+  if (dir)
+    dir.close();
+
+  // Urutkan naik (biasanya cuma 0-1 file)
+  for (uint8_t i = 1; i < nFound; i++)
+    for (uint8_t j = i; j > 0 && found[j - 1] > found[j]; j--) {
+      uint32_t t = found[j];
+      found[j] = found[j - 1];
+      found[j - 1] = t;
+    }
+
+  haveCur = false;
+  for (uint8_t i = 0; i < nFound; i++) {
+    segPath(found[i], path);
+    if (found[i] <= maxSeq) {
+      LittleFS.remove(path);
+      continue;
+    }
+    Segment s;
+    if (!scanSegment(found[i], s)) {
+      LittleFS.remove(path);
+      continue;
+    }
+    closeCur();
+    cur = s;
+    haveCur = true;
+    maxSeq = found[i];
+  }
+  nextSeq = maxSeq + 1;
+  if (dirty)
+    writeIndex();
+
+  Serial.printf("History: %u record, %u segmen\n", (unsigned)historyCount(),
+                (unsigned)(segCount + haveCur));
+  return true;
+}
+
+bool historyAppend(uint16_t uid, uint8_t status, uint32_t unixtime) {
+  HistoryRecord r;
+  r.uid = uid;
+  r.status = status;
+  r.flags = 0;
+  r.unixtime = unixtime;
+  r.crc = recordCrc(r);
+
+  xSemaphoreTake(historyMutex, portMAX_DELAY);
+  // Segmen baru tiap hari, kalau penuh, atau kalau ekornya rusak
+  if (haveCur && (cur.count >= HISTORY_SEGMENT_RECORDS ||
+                  (cur.flags & SEG_TORN) ||
+                  (cur.first && unixtime / 86400 != cur.day)))
+    closeCur();
+
+  bool fresh = !haveCur;
+  if (fresh) {
+    segReset(cur, nextSeq++);
+    haveCur = true;
+  }
+
+  char path[24];
+  segPath(cur.seq, path);
+  bool ok = false;
+  fs::File f = LittleFS.open(path, FILE_APPEND);
+  if (f) {
+    ok = true;
+    if (fresh) {
+      SegmentHeader h = {HISTORY_MAGIC, cur.seq};
+      ok = f.write((const uint8_t *)&h, sizeof(h)) == sizeof(h);
+    }
+    ok = ok && f.write((const uint8_t *)&r, sizeof(r)) == sizeof(r);
+    f.close();
+  }
+
+  if (ok) {
+    segAdd(cur, r);
+    cur.count++;
+  } else if (fresh) {
+    LittleFS.remove(path);
+    haveCur = false;
+  } else {
+    cur.flags |= SEG_TORN;
+  }
+  xSemaphoreGive(historyMutex);
+  return ok;
+}
+
+// Record terbaru milik uid di satu segmen. Segmen urut dibaca dari
+// belakang dan berhenti di match pertama; yang tidak urut dibaca semua.
+static bool lastInSegment(const Segment &s, uint16_t uid, HistoryRecord *out) {
+  char path[24];
+  segPath(s.seq, path);
+  fs::File f = LittleFS.open(path, FILE_READ);
+  if (!f)
+    return false;
+
+  bool found = false;
+  HistoryRecord buf[HISTORY_CHUNK];
+  uint32_t end = s.count;
+  while (end > 0) {
+    uint32_t start = end > HISTORY_CHUNK ? end - HISTORY_CHUNK : 0;
+    size_t n = readSlots(f, start, buf, end - start);
+    for (int i = n - 1; i >= 0; i--) {
+      const HistoryRecord &r = buf[i];
+      if (r.uid != uid || r.crc != recordCrc(r))
+        continue;
+      if (!found || r.unixtime > out->unixtime) {
+        *out = r;
+        found = true;
+      }
+      if (s.flags & SEG_SORTED)
+        break;
+    }
+    if (found && (s.flags & SEG_SORTED))
+      break;
+    end = start;
+  }
+  f.close();
+  return found;
+}
+
+bool historyLastScan(uint16_t uid, HistoryRecord *out) {
+  xSemaphoreTake(historyMutex, portMAX_DELAY);
+  bool found = false;
+  if (haveCur && mayContain(cur, uid))
+    found = lastInSegment(cur, uid, out);
+  for (int i = segCount - 1; !found && i >= 0; i--)
+    if (mayContain(segs[i], uid))
+      found = lastInSegment(segs[i], uid, out);
+  xSemaphoreGive(historyMutex);
+  return found;
+}
+
+// Slot pertama dengan unixtime >= since di segmen urut (binary search).
+// Kalau ketemu record rusak, mulai dari 0 dan biarkan filter yang bekerja.
+static uint32_t lowerBound(fs::File &f, const Segment &s, uint32_t since) {
+  uint32_t lo = 0, hi = s.count;
+  while (lo < hi) {
+    uint32_t mid = (lo + hi) / 2;
+    HistoryRecord r;
+    if (readSlots(f, mid, &r, 1) != 1 || r.crc != recordCrc(r))
+      return 0;
+    if (r.unixtime < since)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+  return lo;
+}
+
+static bool visitSegment(const Segment &s, uint32_t since,
+                         HistoryVisitor visit, void *arg, size_t *visited) {
+  char path[24];
+  segPath(s.seq, path);
+  fs::File f = LittleFS.open(path, FILE_READ);
+  if (!f)
+    return true;
+
+  uint32_t slot = 0;
+  if ((s.flags & SEG_SORTED) && s.first < since)
+    slot = lowerBound(f, s, since);
+
+  bool more = true;
+  HistoryRecord buf[HISTORY_CHUNK];
+  while (more && slot < s.count) {
+    size_t want = s.count - slot;
+    if (want > HISTORY_CHUNK)
+      want = HISTORY_CHUNK;
+    size_t n = readSlots(f, slot, buf, want);
+    if (!n)
+      break;
+    for (size_t i = 0; more && i < n; i++) {
+      if (buf[i].unixtime < since || buf[i].crc != recordCrc(buf[i]))
+        continue;
+      (*visited)++;
+      more = visit(buf[i], arg);
+    }
+    slot += n;
+  }
+  f.close();
+  return more;
+}
+
+size_t historySince(uint32_t since, HistoryVisitor visit, void *arg) {
+  xSemaphoreTake(historyMutex, portMAX_DELAY);
+  size_t visited = 0;
+  bool more = true;
+  for (uint8_t i = 0; more && i < segCount; i++)
+    if (segs[i].first && segs[i].last >= since)
+      more = visitSegment(segs[i], since, visit, arg, &visited);
+  if (more && haveCur && cur.first && cur.last >= since)
+    visitSegment(cur, since, visit, arg, &visited);
+  xSemaphoreGive(historyMutex);
+  return visited;
+}
+
+uint32_t historyCount() {
+  uint32_t n = haveCur ? cur.count : 0;
+  for (uint8_t i = 0; i < segCount; i++)
+    n += segs[i].count;
+  return n;
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <Arduino.h>
+
+// ================== HISTORY ==================
+// Riwayat absensi di LittleFS, terpisah dari outbox: outbox dibuang
+// setelah server ack, history disimpan beberapa minggu untuk dicari di
+// device. Record biner ukuran tetap di file segmen /log/<seq>.seg; segmen
+// ganti tiap hari (atau kalau penuh). Index kecil per segmen (rentang
+// waktu + bitmap uid) ada di RAM dan /log/index.dat, jadi pencarian cukup
+// membuka segmen yang relevan.
+
+#define HISTORY_SEGMENTS 42 // segmen tertutup yang disimpan, ~6 minggu
+#define HISTORY_SEGMENT_RECORDS 4096
+#define HISTORY_UID_BITS 1024 // uid >= ini tetap dicatat, tapi tanpa bitmap
+
+struct HistoryRecord {
+  uint16_t uid;
+  uint8_t status; // index statusAbsen[]
+  uint8_t flags;
+  uint32_t unixtime;
+  uint32_t crc; // CRC32 dari 8 byte di atas
+};
+
+// Return false untuk berhenti
+typedef bool (*HistoryVisitor)(const HistoryRecord &r, void *arg);
+
+// Wajib setelah LittleFS.begin(). Memuat index dan membangun ulang entry
+// segmen terakhir (yang mungkin terpotong karena listrik mati).
+bool historyBegin();
+
+bool historyAppend(uint16_t uid, uint8_t status, uint32_t unixtime);
+
+// Scan terakhir milik uid (segmen terbaru yang memuatnya)
+bool historyLastScan(uint16_t uid, HistoryRecord *out);
+
+// Kunjungi record dengan unixtime >= since, urut segmen. Return jumlah
+// record yang dikunjungi. Jangan panggil historyAppend() dari visitor.
+size_t historySince(uint32_t since, HistoryVisitor visit, void *arg);
+
+uint32_t historyCount();
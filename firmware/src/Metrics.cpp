@@ -0,0 +1,260 @@
+#include "Metrics.h"
+
+#include <WebServer.h>
+
+// Potongan respons /metrics dikirim per buffer ini (chunked), bukan satu
+// String besar berisi semua metrik
+#define METRICS_CHUNK 512
+
+// Zero-initialized sebelum konstruktor statis mana pun jalan, jadi urutan
+// inisialisasi antar file tidak masalah
+static Metric *head = nullptr;
+static Metric *tail = nullptr;
+
+static WebServer *server = nullptr;
+
+Metric::Metric(const char *name, const char *help, const char *key)
+    : name(name), help(help), key(key), next(nullptr) {
+  // Urut pendaftaran supaya output stabil antar scrape
+  if (tail)
+    tail->next = this;
+  else
+    head = this;
+  tail = this;
+}
+
+static void writeHeader(Print &out, const Metric &m, const char *type) {
+  out.printf("# HELP %s %s\n# TYPE %s %s\n", m.name, m.help, m.name, type);
+}
+
+// ================== COUNTER ==================
+Counter::Counter(const char *name, const char *help, const char *key)
+    : Metric(name, help, key), value_(0), read_(nullptr) {}
+
+Counter::Counter(const char *name, const char *help, MetricSampler read,
+                 const char *key)
+    : Metric(name, help, key), value_(0), read_(read) {}
+
+uint32_t Counter::value() const {
+  return read_ ? (uint32_t)read_() : value_.load(std::memory_order_relaxed);
+}
+
+void Counter::write(Print &out) const {
+  writeHeader(out, *this, "counter");
+  out.printf("%s %lu\n", name, (unsigned long)value());
+}
+
+bool Counter::writeCompact(Print &out) const {
+  if (!key)
+    return false;
+  out.printf("%s=%lu", key, (unsigned long)value());
+  return true;
+}
+
+// ================== GAUGE ==================
+Gauge::Gauge(const char *name, const char *help, const char *key)
+    : Metric(name, help, key), value_(0), read_(nullptr) {}
+
+Gauge::Gauge(const char *name, const char *help, MetricSampler read,
+             const char *key)
+    : Metric(name, help, key), value_(0), read_(read) {}
+
+int32_t Gauge::value() const {
+  return read_ ? read_() : value_.load(std::memory_order_relaxed);
+}
+
+void Gauge::write(Print &out) const {
+  writeHeader(out, *this, "gauge");
+  out.printf("%s %ld\n", name, (long)value());
+}
+
+bool Gauge::writeCompact(Print &out) const {
+  if (!key)
+    return false;
+  out.printf("%s=%ld", key, (long)value());
+  return true;
+}
+
+// ================== HISTOGRAM ==================
+Histogram::Histogram(const char *name, const char *help,
+                     const uint32_t *bounds, uint8_t count, const char *key)
+    : Metric(name, help, key), bounds_(bounds),
+      count_(count < METRIC_BUCKETS_MAX ? count : METRIC_BUCKETS_MAX),
+      sum_(0) {
+  for (uint8_t i = 0; i <= METRIC_BUCKETS_MAX; i++)
+    buckets_[i].store(0, std::memory_order_relaxed);
+}
+
+void Histogram::observe(uint32_t v) {
+  // Bucket sedikit: linear lebih murah daripada binary search
+  uint8_t i = 0;
+  while (i < count_ && v > bounds_[i])
+    i++;
+  buckets_[i].fetch_add(1, std::memory_order_relaxed);
+  sum_.fetch_add(v, std::memory_order_relaxed);
+}
+
+uint32_t Histogram::count() const {
+  uint32_t n = 0;
+  for (uint8_t i = 0; i <= count_; i++)
+    n += buckets_[i].load(std::memory_order_relaxed);
+  return n;
+}
+
+uint32_t Histogram::quantile(float q) const {
+  uint32_t snap[METRIC_BUCKETS_MAX + 1];
+  uint32_t n = 0;
+  for (uint8_t i = 0; i <= count_; i++)
+    n += snap[i] = buckets_[i].load(std::memory_order_relaxed);
+  if (!n)
+    return 0;
+  uint32_t rank = (uint32_t)(q * n + 0.5f);
+  if (rank < 1)
+    rank = 1;
+  uint32_t acc = 0;
+  for (uint8_t i = 0; i < count_; i++) {
+    acc += snap[i];
+    if (acc >= rank)
+      return bounds_[i];
+  }
+  // Di atas bucket terakhir: batas terakhir sebagai batas bawah
+  return count_ ? bounds_[count_ - 1] : 0;
+}
+
+void Histogram::write(Print &out) const {
+  writeHeader(out, *this, "histogram");
+  // Bucket Prometheus kumulatif; _count sama dengan bucket +Inf walau ada
+  // observe() yang masuk di tengah scrape
+  uint32_t acc = 0;
+  for (uint8_t i = 0; i < count_; i++) {
+    acc += buckets_[i].load(std::memory_order_relaxed);
+    out.printf("%s_bucket{le=\"%lu\"} %lu\n", name, (unsigned long)bounds_[i],
+               (unsigned long)acc);
+  }
+  acc += buckets_[count_].load(std::memory_order_relaxed);
+  out.printf("%s_bucket{le=\"+Inf\"} %lu\n", name, (unsigned long)acc);
+  out.printf("%s_sum %lu\n%s_count %lu\n", name,
+             (unsigned long)sum_.load(std::memory_order_relaxed), name,
+             (unsigned long)acc);
+}
+
+bool Histogram::writeCompact(Print &out) const {
+  if (!key)
+    return false;
+  out.printf("%s=%lu/%lu", key, (unsigned long)quantile(0.5f),
+             (unsigned long)count());
+  return true;
+}
+
+// ================== OUTPUT ==================
+void metricsWrite(Print &out) {
+  for (const Metric *m = head; m; m = m->next)
+    m->write(out);
+}
+
+// Print ke buffer tetap; write yang tidak muat ditolak utuh
+class BufPrint : public Print {
+public:
+  BufPrint(char *buf, size_t size) : buf_(buf), size_(size), len_(0) {}
+  size_t write(uint8_t c) override { return write(&c, 1); }
+  size_t write(const uint8_t *data, size_t n) override {
+    if (full_ || len_ + n >= size_) {
+      full_ = true;
+      return 0;
+    }
+    memcpy(buf_ + len_, data, n);
+    len_ += n;
+    buf_[len_] = '\0';
+    return n;
+  }
+  size_t length() const { return len_; }
+  bool full() const { return full_; }
+  void truncate(size_t len) {
+    len_ = len;
+    buf_[len_] = '\0';
+    full_ = false;
+  }
+
+private:
+  char *buf_;
+  size_t size_;
+  size_t len_;
+  bool full_ = false;
+};
+
+size_t metricsCompact(char *buf, size_t size) {
+  if (!size)
+    return 0;
+  buf[0] = '\0';
+  BufPrint out(buf, size);
+  for (const Metric *m = head; m; m = m->next) {
+    size_t mark = out.length();
+    if (mark)
+      out.write((const uint8_t *)",", 1);
+    if (!m->writeCompact(out)) {
+      out.truncate(mark);
+      continue;
+    }
+    if (out.full()) {
+      out.truncate(mark);
+      break;
+    }
+  }
+  return out.length();
+}
+
+// ================== HTTP ==================
+// Print yang meneruskan ke respons HTTP per METRICS_CHUNK byte
+class ChunkPrint : public Print {
+public:
+  size_t write(uint8_t c) override { return write(&c, 1); }
+  size_t write(const uint8_t *data, size_t n) override {
+    for (size_t i = 0; i < n; i++) {
+      if (len_ == sizeof(buf_))
+        flush();
+      buf_[len_++] = data[i];
+    }
+    return n;
+  }
+  void flush() override {
+    if (len_)
+      server->sendContent(buf_, len_);
+    len_ = 0;
+  }
+
+private:
+  char buf_[METRICS_CHUNK];
+  size_t len_ = 0;
+};
+
+static void serveText(const char *type, void (*write)(Print &out)) {
+  server->setContentLength(CONTENT_LENGTH_UNKNOWN);
+  server->send(200, type, "");
+  ChunkPrint out;
+  write(out);
+  out.flush();
+  server->sendContent("");
+}
+
+void metricsServerOn(const char *uri, void (*write)(Print &out)) {
+  if (server)
+    server->on(uri, HTTP_GET, [write] { serveText("text/plain", write); });
+}
+
+void metricsServerBegin() {
+  if (server)
+    return;
+  server = new WebServer(METRICS_PORT);
+  // Default-nya delay(1) setiap handleClient() tanpa client: loop() jadi
+  // tidur 1 ms tiap iterasi
+  server->enableDelay(false);
+  server->on("/metrics", HTTP_GET,
+             [] { serveText("text/plain; version=0.0.4", metricsWrite); });
+  server->onNotFound([] { server->send(404, "text/plain", "not found\n"); });
+  server->begin();
+}
+
+void metricsServerHandle() {
+  if (server)
+    server->handleClient();
+}
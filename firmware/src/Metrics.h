@@ -0,0 +1,116 @@
+#pragma once
+
+#include <Arduino.h>
+
+#include <atomic>
+
+// ================== METRICS ==================
+// Registry counter, gauge dan histogram latency. Setiap metrik adalah
+// objek statis di modul pemiliknya dan mendaftar sendiri saat konstruksi.
+// Update dari task mana pun cukup satu operasi atomik, tanpa lock; hasil
+// scrape boleh sedikit tidak konsisten antar metrik.
+//
+// Nilai yang sudah dihitung modul lain (heap, outbox, loopStats, ...)
+// dibaca lewat fungsi sampler saat scrape, bukan disalin terus-menerus.
+//
+//   static const uint32_t BUCKETS[] = {50, 100, 250, 500, 1000};
+//   static Histogram captureMs("axiom_scan_capture_ms", "getImage()",
+//                              BUCKETS, "cap");
+//   captureMs.observe(millis() - start);
+
+#define METRIC_BUCKETS_MAX 12
+#define METRICS_PORT 80
+
+typedef int32_t (*MetricSampler)();
+
+class Metric {
+public:
+  // Format teks Prometheus (HELP, TYPE, nilai)
+  virtual void write(Print &out) const = 0;
+  // "key=nilai" untuk snapshot ringkas; false kalau metrik tanpa key
+  virtual bool writeCompact(Print &out) const = 0;
+
+  const char *name;
+  const char *help;
+  const char *key; // nama pendek untuk snapshot ringkas, boleh nullptr
+  Metric *next;
+
+protected:
+  Metric(const char *name, const char *help, const char *key);
+};
+
+class Counter : public Metric {
+public:
+  Counter(const char *name, const char *help, const char *key = nullptr);
+  // Nilai diambil dari sampler saat scrape (mis. stats modul lain)
+  Counter(const char *name, const char *help, MetricSampler read,
+          const char *key = nullptr);
+
+  void inc(uint32_t n = 1) { value_.fetch_add(n, std::memory_order_relaxed); }
+  uint32_t value() const;
+
+  void write(Print &out) const override;
+  bool writeCompact(Print &out) const override;
+
+private:
+  std::atomic<uint32_t> value_;
+  MetricSampler read_;
+};
+
+class Gauge : public Metric {
+public:
+  Gauge(const char *name, const char *help, const char *key = nullptr);
+  Gauge(const char *name, const char *help, MetricSampler read,
+        const char *key = nullptr);
+
+  void set(int32_t v) { value_.store(v, std::memory_order_relaxed); }
+  void add(int32_t d) { value_.fetch_add(d, std::memory_order_relaxed); }
+  int32_t value() const;
+
+  void write(Print &out) const override;
+  bool writeCompact(Print &out) const override;
+
+private:
+  std::atomic<int32_t> value_;
+  MetricSampler read_;
+};
+
+// Bucket batas atas inklusif, naik; nilai di atas batas terakhir masuk
+// bucket +Inf. Snapshot ringkas memakai perkiraan p50 dari bucket.
+class Histogram : public Metric {
+public:
+  Histogram(const char *name, const char *help, const uint32_t *bounds,
+            uint8_t count, const char *key = nullptr);
+  template <size_t N>
+  Histogram(const char *name, const char *help, const uint32_t (&bounds)[N],
+            const char *key = nullptr)
+      : Histogram(name, help, bounds, N, key) {}
+
+  void observe(uint32_t v);
+  uint32_t count() const;
+  // Batas atas bucket yang memuat kuantil q (0..1); 0 kalau kosong
+  uint32_t quantile(float q) const;
+
+  void write(Print &out) const override;
+  bool writeCompact(Print &out) const override;
+
+private:
+  const uint32_t *bounds_;
+  uint8_t count_;
+  std::atomic<uint32_t> buckets_[METRIC_BUCKETS_MAX + 1];
+  std::atomic<uint32_t> sum_;
+};
+
+// Semua metrik dalam format teks Prometheus 0.0.4
+void metricsWrite(Print &out);
+// Snapshot ringkas "key=nilai,key=nilai" untuk metrik yang punya key.
+// Return panjang; dipotong di batas item kalau buffer tidak cukup.
+size_t metricsCompact(char *buf, size_t size);
+
+// Endpoint GET /metrics di METRICS_PORT. Begin setelah WiFi tersambung,
+// handle dari loop().
+void metricsServerBegin();
+void metricsServerHandle();
+// Endpoint teks lain di server yang sama (mis. /trace), dikirim chunked
+// seperti /metrics. Setelah metricsServerBegin().
+void metricsServerOn(const char *uri, void (*write)(Print &out));
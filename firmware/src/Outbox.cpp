@@ -0,0 +1,338 @@
+#include "Outbox.h"
+
+#include <FS.h>
+#include <LittleFS.h>
+#include <esp32/rom/crc.h>
+
+#define OUTBOX_DATA "/outbox.dat"
+#define OUTBOX_TMP "/outbox.tmp"
+#define OUTBOX_CURSOR "/outbox.cur"
+#define OUTBOX_CURSOR_TMP "/outbox.cur.tmp"
+#define OUTBOX_MAGIC 0x324F5841UL    // "AXO2"
+#define OUTBOX_MAGIC_V1 0x424F5841UL // "AXOB", record 12 byte tanpa seq
+#define CURSOR_MAGIC 0x434F5841UL    // "AXOC"
+
+// Compact kalau record yang sudah di-ack memakan lebih dari ini
+#define OUTBOX_COMPACT_BYTES 4096
+
+// File data: [header][record][record]...
+// Cursor   : posisi head di file data generasi yang sama.
+// Compaction menulis file data generasi baru (tmp + rename) lalu cursor
+// baru. Kalau mati di antaranya, generasi data = cursor + 1 dan head
+// otomatis kembali ke awal file baru.
+struct OutboxHeader {
+  uint32_t magic;
+  uint32_t gen;
+  uint32_t epoch;
+  uint32_t nextSeq; // seq record berikutnya saat file ini ditulis
+};
+
+struct OutboxHeaderV1 {
+  uint32_t magic;
+  uint32_t gen;
+};
+
+struct OutboxRecordV1 {
+  uint16_t uid;
+  uint8_t status;
+  uint8_t flags;
+  uint32_t unixtime;
+  uint32_t crc;
+};
+
+struct OutboxCursor {
+  uint32_t magic;
+  uint32_t gen;
+  uint32_t head;
+  uint32_t crc;
+};
+
+static SemaphoreHandle_t outboxMutex = nullptr;
+static uint32_t curGen = 0;
+static uint32_t headOff = sizeof(OutboxHeader);
+static uint32_t tailOff = sizeof(OutboxHeader);
+static uint32_t curEpoch = 0;
+static uint32_t nextSeq = 1;
+
+static uint32_t recordCrc(const OutboxRecord &r) {
+  return crc32_le(0, (const uint8_t *)&r, offsetof(OutboxRecord, crc));
+}
+
+static uint32_t recordCrcV1(const OutboxRecordV1 &r) {
+  return crc32_le(0, (const uint8_t *)&r, offsetof(OutboxRecordV1, crc));
+}
+
+static uint32_t newEpoch() {
+  uint32_t e = esp_random();
+  return e ? e : 1;
+}
+
+static uint32_t cursorCrc(const OutboxCursor &c) {
+  return crc32_le(0, (const uint8_t *)&c, offsetof(OutboxCursor, crc));
+}
+
+static bool writeCursor(uint32_t gen, uint32_t head) {
+  OutboxCursor c;
+  c.magic = CURSOR_MAGIC;
+  c.gen = gen;
+  c.head = head;
+  c.crc = cursorCrc(c);
+
+  fs::File f = LittleFS.open(OUTBOX_CURSOR_TMP, FILE_WRITE);
+  if (!f)
+    return false;
+  bool ok = f.write((const uint8_t *)&c, sizeof(c)) == sizeof(c);
+  f.close();
+  return ok && LittleFS.rename(OUTBOX_CURSOR_TMP, OUTBOX_CURSOR);
+}
+
+static bool readCursor(OutboxCursor *c) {
+  fs::File f = LittleFS.open(OUTBOX_CURSOR, FILE_READ);
+  if (!f)
+    return false;
+  bool ok = f.read((uint8_t *)c, sizeof(*c)) == sizeof(*c);
+  f.close();
+  return ok && c->magic == CURSOR_MAGIC && c->crc == cursorCrc(*c);
+}
+
+// Ganti file data dengan dst (sudah berisi header generasi curGen + 1
+// dan kept record), lalu cursor ke awalnya
+static bool install(fs::File &dst, bool ok, uint32_t kept) {
+  dst.close();
+  if (!ok || !LittleFS.rename(OUTBOX_TMP, OUTBOX_DATA))
+    return false;
+
+  curGen++;
+  headOff = sizeof(OutboxHeader);
+  tailOff = headOff + kept * sizeof(OutboxRecord);
+  // Gagal di sini tetap aman: begin() berikutnya mendeteksi gen + 1
+  writeCursor(curGen, headOff);
+  return true;
+}
+
+// Tulis ulang record valid di [from, to) ke file data generasi baru
+static bool compact(uint32_t from, uint32_t to) {
+  fs::File src = LittleFS.open(OUTBOX_DATA, FILE_READ);
+  fs::File dst = LittleFS.open(OUTBOX_TMP, FILE_WRITE);
+  if (!dst) {
+    if (src)
+      src.close();
+    return false;
+  }
+
+  OutboxHeader h = {OUTBOX_MAGIC, curGen + 1, curEpoch, nextSeq};
+  bool ok = dst.write((const uint8_t *)&h, sizeof(h)) == sizeof(h);
+  uint32_t kept = 0;
+  if (src && src.seek(from)) {
+    OutboxRecord r;
+    for (uint32_t off = from; ok && off + sizeof(r) <= to; off += sizeof(r)) {
+      if (src.read((uint8_t *)&r, sizeof(r)) != sizeof(r))
+        break;
+      if (r.crc != recordCrc(r))
+        continue;
+      ok = dst.write((const uint8_t *)&r, sizeof(r)) == sizeof(r);
+      kept++;
+    }
+  }
+  if (src)
+    src.close();
+  return install(dst, ok, kept);
+}
+
+// Outbox format lama (record tanpa seq): record pending disalin ke format
+// baru dengan epoch baru dan seq mulai dari 1
+static bool migrateV1(uint32_t gen, uint32_t head, size_t size) {
+  fs::File src = LittleFS.open(OUTBOX_DATA, FILE_READ);
+  fs::File dst = LittleFS.open(OUTBOX_TMP, FILE_WRITE);
+  if (!dst) {
+    if (src)
+      src.close();
+    return false;
+  }
+  curGen = gen;
+  curEpoch = newEpoch();
+  nextSeq = 1;
+
+  OutboxHeader h = {OUTBOX_MAGIC, curGen + 1, curEpoch, nextSeq};
+  bool ok = dst.write((const uint8_t *)&h, sizeof(h)) == sizeof(h);
+  uint32_t kept = 0;
+  if (src && src.seek(head)) {
+    OutboxRecordV1 old;
+    for (uint32_t off = head; ok && off + sizeof(old) <= size;
+         off += sizeof(old)) {
+      if (src.read((uint8_t *)&old, sizeof(old)) != sizeof(old))
+        break;
+      if (old.crc != recordCrcV1(old))
+        continue;
+      OutboxRecord r;
+      r.uid = old.uid;
+      r.status = old.status;
+      r.flags = old.flags;
+      r.unixtime = old.unixtime;
+      r.seq = nextSeq++;
+      r.crc = recordCrc(r);
+      ok = dst.write((const uint8_t *)&r, sizeof(r)) == sizeof(r);
+      kept++;
+    }
+  }
+  if (src)
+    src.close();
+  Serial.printf("Outbox: %u record dipindah ke format baru\n",
+                (unsigned)kept);
+  return install(dst, ok, kept);
+}
+
+// seq record valid terakhir di file + 1; record sebelum head (sudah di-ack)
+// ikut dihitung, jadi seq tidak terpakai ulang walau compaction belum jalan
+static uint32_t scanNextSeq(fs::File &f) {
+  OutboxRecord r;
+  for (uint32_t off = tailOff; off > sizeof(OutboxHeader);) {
+    off -= sizeof(r);
+    if (f.seek(off) && f.read((uint8_t *)&r, sizeof(r)) == sizeof(r) &&
+        r.crc == recordCrc(r))
+      return r.seq + 1;
+  }
+  return 0;
+}
+
+bool outboxBegin() {
+  if (!outboxMutex)
+    outboxMutex = xSemaphoreCreateMutex();
+
+  OutboxCursor c;
+  bool haveCursor = readCursor(&c);
+
+  OutboxHeader h = {0, 0, 0, 0};
+  size_t size = 0;
+  fs::File f = LittleFS.open(OUTBOX_DATA, FILE_READ);
+  if (f) {
+    size = f.size();
+    if (f.read((uint8_t *)&h, sizeof(h)) != sizeof(h))
+      h.magic = 0;
+    f.close();
+  }
+
+  if (h.magic == OUTBOX_MAGIC_V1) {
+    uint32_t head = sizeof(OutboxHeaderV1);
+    if (haveCursor && c.gen == h.gen && c.head >= head && c.head <= size)
+      head = c.head;
+    head -= (head - sizeof(OutboxHeaderV1)) % sizeof(OutboxRecordV1);
+    return migrateV1(h.gen, head, size);
+  }
+  if (h.magic != OUTBOX_MAGIC) {
+    // Belum ada outbox (atau header rusak): mulai generasi dan epoch baru
+    curGen = haveCursor ? c.gen : 0;
+    curEpoch = newEpoch();
+    nextSeq = 1;
+    return compact(0, 0);
+  }
+
+  curGen = h.gen;
+  curEpoch = h.epoch;
+  headOff = sizeof(OutboxHeader);
+  if (haveCursor && c.gen == h.gen && c.head >= headOff && c.head <= size)
+    headOff = c.head;
+  headOff -= (headOff - sizeof(OutboxHeader)) % sizeof(OutboxRecord);
+
+  // Record terakhir bisa setengah tertulis
+  tailOff = size - (size - sizeof(OutboxHeader)) % sizeof(OutboxRecord);
+
+  // Cek CRC semua record pending; kalau ada yang rusak, compact
+  bool clean = tailOff == size;
+  nextSeq = h.nextSeq;
+  f = LittleFS.open(OUTBOX_DATA, FILE_READ);
+  if (f && f.seek(headOff)) {
+    OutboxRecord r;
+    for (uint32_t off = headOff; clean && off < tailOff; off += sizeof(r))
+      clean = f.read((uint8_t *)&r, sizeof(r)) == sizeof(r) &&
+              r.crc == recordCrc(r);
+  }
+  if (f) {
+    uint32_t seq = scanNextSeq(f);
+    if (seq > nextSeq)
+      nextSeq = seq;
+    f.close();
+  }
+
+  if (!clean || headOff - sizeof(OutboxHeader) >= OUTBOX_COMPACT_BYTES)
+    return compact(headOff, tailOff);
+  if (!haveCursor || c.gen != curGen || c.head != headOff)
+    writeCursor(curGen, headOff);
+
+  Serial.printf("Outbox: %u pending (gen %u, seq %u)\n",
+                (unsigned)outboxPending(), (unsigned)curGen,
+                (unsigned)nextSeq);
+  return true;
+}
+
+bool outboxPush(uint16_t uid, uint8_t status, uint32_t unixtime) {
+  OutboxRecord r;
+  r.uid = uid;
+  r.status = status;
+  r.flags = 0;
+  r.unixtime = unixtime;
+
+  xSemaphoreTake(outboxMutex, portMAX_DELAY);
+  r.seq = nextSeq;
+  r.crc = recordCrc(r);
+  bool ok = false;
+  if (outboxPending() < OUTBOX_MAX_RECORDS) {
+    fs::File f = LittleFS.open(OUTBOX_DATA, FILE_APPEND);
+    if (f) {
+      ok = f.write((const uint8_t *)&r, sizeof(r)) == sizeof(r);
+      f.close();
+    }
+    if (ok) {
+      tailOff += sizeof(r);
+      nextSeq++;
+    }
+  }
+  xSemaphoreGive(outboxMutex);
+  return ok;
+}
+
+uint32_t outboxPending() {
+  return (tailOff - headOff) / sizeof(OutboxRecord);
+}
+
+size_t outboxPeek(OutboxRecord *out, size_t max) {
+  xSemaphoreTake(outboxMutex, portMAX_DELAY);
+  size_t n = 0;
+  fs::File f = LittleFS.open(OUTBOX_DATA, FILE_READ);
+  if (f && f.seek(headOff)) {
+    size_t avail = outboxPending();
+    if (max > avail)
+      max = avail;
+    n = f.read((uint8_t *)out, max * sizeof(OutboxRecord)) /
+        sizeof(OutboxRecord);
+  }
+  if (f)
+    f.close();
+  xSemaphoreGive(outboxMutex);
+  return n;
+}
+
+bool outboxCommit(size_t n) {
+  if (!n)
+    return true;
+  xSemaphoreTake(outboxMutex, portMAX_DELAY);
+  uint32_t next = headOff + n * sizeof(OutboxRecord);
+  if (next > tailOff)
+    next = tailOff;
+
+  // compact() memindahkan head sendiri kalau berhasil. Kalau gagal (flash
+  // penuh, rename gagal) file data lama masih utuh: cukup majukan cursor,
+  // compaction dicoba lagi di commit berikutnya.
+  bool ok = false;
+  if (next == tailOff || next - sizeof(OutboxHeader) >= OUTBOX_COMPACT_BYTES)
+    ok = compact(next, tailOff);
+  if (!ok) {
+    ok = writeCursor(curGen, next);
+    if (ok)
+      headOff = next;
+  }
+  xSemaphoreGive(outboxMutex);
+  return ok;
+}
+
+uint32_t outboxEpoch() { return curEpoch; }
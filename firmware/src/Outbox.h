@@ -0,0 +1,40 @@
+#pragma once
+
+#include <Arduino.h>
+
+// ================== OUTBOX ==================
+// Antrian absensi di LittleFS: append-only, record biner ukuran tetap,
+// CRC per record. Cursor head disimpan terpisah dan hanya maju setelah
+// server mengkonfirmasi, jadi data aman walau listrik mati kapan saja.
+
+#define OUTBOX_MAX_RECORDS 20000
+
+struct OutboxRecord {
+  uint16_t uid;
+  uint8_t status; // index statusAbsen[]
+  uint8_t flags;
+  uint32_t unixtime;
+  uint32_t seq; // nomor urut per epoch, tidak pernah dipakai ulang
+  uint32_t crc; // CRC32 dari 12 byte di atas
+};
+
+// Wajib dipanggil setelah LittleFS.begin(). Memulihkan cursor dan
+// membuang record rusak / setengah tertulis.
+bool outboxBegin();
+
+// false jika outbox penuh atau gagal tulis
+bool outboxPush(uint16_t uid, uint8_t status, uint32_t unixtime);
+
+uint32_t outboxPending();
+
+// Salin max record mulai dari head tanpa memajukan cursor
+size_t outboxPeek(OutboxRecord *out, size_t max);
+
+// Majukan head sebanyak n record (setelah server ack)
+bool outboxCommit(size_t n);
+
+// Acak, dipilih saat outbox dibuat (flash baru / diformat). Bersama seq
+// jadi kunci idempotensi di server: record yang terkirim ulang karena ack
+// hilang dikenali sebagai duplikat, dan seq yang mulai lagi dari 1 setelah
+// format tidak bentrok dengan record lama.
+uint32_t outboxEpoch();
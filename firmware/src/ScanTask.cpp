@@ -0,0 +1,178 @@
+#include "ScanTask.h"
+
+#include "Events.h"
+#include "Metrics.h"
+#include "TemplateStore.h"
+#include "Trace.h"
+
+#define SCAN_TASK_CORE 0
+#define SCAN_TASK_STACK 4096
+#define SCAN_TASK_PRIO 2
+#define SCAN_QUEUE_LEN 4
+#define SCAN_INTERVAL_MS 50
+#define SCAN_LIFT_TIMEOUT_MS 3000
+#define SCAN_POLL_MS 2
+
+static Adafruit_Fingerprint *fp = nullptr;
+static QueueHandle_t scanQueue = nullptr;
+static SemaphoreHandle_t sensorMutex = nullptr;
+static volatile bool scanEnabled = false;
+
+// ================== METRICS ==================
+// Batas bucket dalam ms; AS608 di 57600 baud: capture ~200-400 ms,
+// image2Tz ~300 ms, fast search < 100 ms untuk library kecil
+static const uint32_t SCAN_BUCKETS_MS[] = {25,  50,  100,  200,  300,
+                                           400, 600, 1000, 2000, 4000};
+static Histogram captureMs("axiom_scan_capture_ms",
+                           "getImage() yang berhasil (jari di sensor)",
+                           SCAN_BUCKETS_MS, "cap");
+static Histogram templateMs("axiom_scan_template_ms",
+                            "Image2Tz: ekstraksi fitur di sensor",
+                            SCAN_BUCKETS_MS, "tz");
+static Histogram searchMs("axiom_scan_search_ms",
+                          "FastSearch di library sensor", SCAN_BUCKETS_MS,
+                          "search");
+static Histogram fallbackMs("axiom_scan_fallback_ms",
+                            "Pencocokan template flash setelah NOTFOUND",
+                            SCAN_BUCKETS_MS);
+static Histogram resultMs("axiom_scan_result_ms",
+                          "Jari terbaca sampai hasil scan dikirim ke UI",
+                          SCAN_BUCKETS_MS, "scan");
+static Counter scanMatch("axiom_scan_match_total", "Scan yang cocok", "match");
+static Counter scanNoMatch("axiom_scan_nomatch_total",
+                           "Scan tanpa template yang cocok", "nomatch");
+static Counter scanError("axiom_scan_error_total",
+                         "Scan gagal (kualitas gambar, komunikasi sensor)");
+
+static void postEvent(ScanResult result, uint32_t touchedAt, uint16_t id = 0,
+                      uint16_t confidence = 0) {
+  ScanEvent evt;
+  evt.result = result;
+  evt.fingerID = id;
+  evt.confidence = confidence;
+  evt.touchedAt = touchedAt;
+  evt.postedAt = millis();
+  // UI tertinggal jauh: buang event, jangan blok pipeline
+  xQueueSend(scanQueue, &evt, 0);
+  eventsWake();
+}
+
+// Tunggu balasan command async; task tidur di antara poll, tidak spin
+static uint8_t waitReply() {
+  uint8_t r;
+  while ((r = fp->poll()) == FINGERPRINT_BUSY)
+    vTaskDelay(pdMS_TO_TICKS(SCAN_POLL_MS));
+  return r;
+}
+
+// Tunggu jari diangkat supaya satu tempelan = satu event
+static void waitLift() {
+  uint32_t start = millis();
+  while (millis() - start < SCAN_LIFT_TIMEOUT_MS) {
+    sensorLock(portMAX_DELAY);
+    uint8_t r = fp->getImage();
+    sensorUnlock();
+    if (r == FINGERPRINT_NOFINGER)
+      return;
+    vTaskDelay(pdMS_TO_TICKS(SCAN_INTERVAL_MS));
+  }
+}
+
+static void scanTask(void *) {
+  for (;;) {
+    if (!scanEnabled) {
+      vTaskDelay(pdMS_TO_TICKS(SCAN_INTERVAL_MS));
+      continue;
+    }
+
+    sensorLock(portMAX_DELAY);
+    uint32_t start = millis();
+    TraceMark mark = traceMark();
+    if (fp->getImage() != FINGERPRINT_OK) {
+      sensorUnlock();
+      vTaskDelay(pdMS_TO_TICKS(SCAN_INTERVAL_MS));
+      continue;
+    }
+
+    uint32_t touchedAt = millis();
+    captureMs.observe(touchedAt - start);
+    traceSpanSince("getImage", mark);
+    // Sensor sudah mulai ekstraksi fitur selagi UI diberi tahu
+    traceBegin("image2Tz");
+    fp->beginImage2Tz();
+    postEvent(SCAN_TOUCH, touchedAt);
+
+    ScanResult result = SCAN_ERROR;
+    uint16_t id = 0, confidence = 0;
+    uint8_t tz = waitReply();
+    traceEnd("image2Tz");
+    start = millis();
+    templateMs.observe(start - touchedAt);
+    if (tz == FINGERPRINT_OK) {
+      traceBegin("fingerFastSearch");
+      fp->beginFingerFastSearch();
+      uint8_t r = waitReply();
+      traceEnd("fingerFastSearch");
+      searchMs.observe(millis() - start);
+      if (r == FINGERPRINT_OK) {
+        result = SCAN_MATCH;
+        id = templateUidForPage(fp->fingerID);
+        confidence = fp->confidence;
+        templateTouch(id);
+      } else if (r == FINGERPRINT_NOTFOUND) {
+        // Tidak ada di library sensor: coba template di flash
+        start = millis();
+        traceBegin("templateFallback");
+        result = templateFallbackMatch(&id, &confidence) ? SCAN_MATCH
+                                                          : SCAN_NOMATCH;
+        traceEnd("templateFallback");
+        fallbackMs.observe(millis() - start);
+      }
+    }
+    sensorUnlock();
+
+    resultMs.observe(millis() - touchedAt);
+    if (result == SCAN_MATCH)
+      scanMatch.inc();
+    else if (result == SCAN_NOMATCH)
+      scanNoMatch.inc();
+    else
+      scanError.inc();
+    postEvent(result, touchedAt, id, confidence);
+    waitLift();
+  }
+}
+
+void scanTaskBegin(Adafruit_Fingerprint *sensor) {
+  fp = sensor;
+  scanQueue = xQueueCreate(SCAN_QUEUE_LEN, sizeof(ScanEvent));
+  sensorMutex = xSemaphoreCreateMutex();
+  xTaskCreatePinnedToCore(scanTask, "scan", SCAN_TASK_STACK, nullptr,
+                          SCAN_TASK_PRIO, nullptr, SCAN_TASK_CORE);
+}
+
+void scanTaskEnable(bool on) {
+  scanEnabled = on;
+  // Event dari state sebelumnya sudah basi
+  if (scanQueue)
+    xQueueReset(scanQueue);
+}
+
+bool scanTaskPoll(ScanEvent *evt) {
+  if (!scanQueue)
+    return false;
+  return xQueueReceive(scanQueue, evt, 0) == pdTRUE;
+}
+
+bool sensorLock(uint32_t timeoutMs) {
+  if (!sensorMutex)
+    return true;
+  TickType_t ticks =
+      (timeoutMs == portMAX_DELAY) ? portMAX_DELAY : pdMS_TO_TICKS(timeoutMs);
+  return xSemaphoreTake(sensorMutex, ticks) == pdTRUE;
+}
+
+void sensorUnlock() {
+  if (sensorMutex)
+    xSemaphoreGive(sensorMutex);
+}
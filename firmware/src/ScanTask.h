@@ -0,0 +1,31 @@
+#pragma once
+
+#include <Adafruit_Fingerprint.h>
+#include <Arduino.h>
+
+// ================== SCAN TASK ==================
+// Pipeline getImage -> image2Tz -> fingerFastSearch berjalan di task
+// FreeRTOS sendiri (core 0), hasilnya dikirim ke loop() lewat queue.
+
+enum ScanResult : uint8_t {
+  SCAN_TOUCH,   // Jari terdeteksi, template sedang diproses
+  SCAN_MATCH,   // Ditemukan di library sensor atau template store
+  SCAN_NOMATCH, // Template valid, tidak ada di mana pun
+  SCAN_ERROR    // Gambar jelek / error komunikasi
+};
+
+struct ScanEvent {
+  ScanResult result;
+  uint16_t fingerID; // uid karyawan (bukan page sensor)
+  uint16_t confidence;
+  uint32_t touchedAt; // millis() saat getImage() berhasil
+  uint32_t postedAt;  // millis() saat event dikirim ke queue
+};
+
+void scanTaskBegin(Adafruit_Fingerprint *sensor);
+void scanTaskEnable(bool on);
+bool scanTaskPoll(ScanEvent *evt);
+
+// Akses sensor dari luar scan task (enroll, delete) wajib lewat lock ini.
+bool sensorLock(uint32_t timeoutMs = 5000);
+void sensorUnlock();
@@ -0,0 +1,106 @@
+#include "Screen.h"
+
+#include "Trace.h"
+
+Widget::Widget(int16_t x, int16_t y, int16_t w, int16_t h)
+    : x(x), y(y), w(w), h(h) {}
+
+void Widget::invalidate(int16_t rx, int16_t ry, int16_t rw, int16_t rh) {
+  // Clip ke widget
+  if (rx < 0) {
+    rw += rx;
+    rx = 0;
+  }
+  if (ry < 0) {
+    rh += ry;
+    ry = 0;
+  }
+  if (rx + rw > w)
+    rw = w - rx;
+  if (ry + rh > h)
+    rh = h - ry;
+  if (rw <= 0 || rh <= 0)
+    return;
+
+  if (dw <= 0) {
+    dx = rx;
+    dy = ry;
+    dw = rw;
+    dh = rh;
+    return;
+  }
+  // Gabung dengan dirty rect yang sudah ada
+  int16_t x2 = max(dx + dw, rx + rw);
+  int16_t y2 = max(dy + dh, ry + rh);
+  dx = min(dx, rx);
+  dy = min(dy, ry);
+  dw = x2 - dx;
+  dh = y2 - dy;
+}
+
+Screen::Screen(TFT_eSPI *tft) : tft(tft), strip(tft) {}
+
+bool Screen::begin() { return strip.begin(tft->width(), SCREEN_STRIP_H); }
+
+void Screen::setPage(Widget *const *widgets, uint8_t count) {
+  pageCount = min<uint8_t>(count, SCREEN_MAX_WIDGETS);
+  for (uint8_t i = 0; i < pageCount; i++) {
+    page[i] = widgets[i];
+    page[i]->invalidate();
+  }
+}
+
+void Screen::renderWidget(TFT_eSprite &spr, int32_t oy, void *arg) {
+  ((Widget *)arg)->render(spr, oy);
+}
+
+bool Screen::pending() const {
+  for (uint8_t i = 0; i < pageCount; i++)
+    if (page[i]->isDirty())
+      return true;
+  return false;
+}
+
+uint32_t Screen::update(uint32_t maxBytes) {
+  // Satu span per frame yang benar-benar mengirim (bukan per widget), di
+  // ring terpisah: redraw jam tiap detik tidak menimpa event scan
+  TraceMark mark = traceMark();
+  bool started = false;
+  uint32_t bytes = 0;
+  for (uint8_t i = 0; i < pageCount; i++) {
+    Widget *wg = page[i];
+    if (!wg->isDirty())
+      continue;
+    if (maxBytes && bytes >= maxBytes)
+      break;
+
+    // Baris yang muat di sisa budget, dibulatkan ke kelipatan strip
+    int16_t rows = wg->dh;
+    if (maxBytes) {
+      uint32_t rowBytes = (uint32_t)wg->dw * 2;
+      int16_t fit = (maxBytes - bytes) / rowBytes;
+      fit -= fit % SCREEN_STRIP_H;
+      if (fit < SCREEN_STRIP_H)
+        fit = SCREEN_STRIP_H;
+      if (fit < rows)
+        rows = fit;
+    }
+
+    if (!started) {
+      // CS tetap low selama frame supaya DMA tidak ditunggu endWrite()
+      strip.beginFrame();
+      started = true;
+    }
+    bytes += strip.pushRect(wg->x + wg->dx, wg->y + wg->dy, wg->dw, rows,
+                            renderWidget, wg, wg->dx, wg->dy);
+    wg->dy += rows;
+    wg->dh -= rows;
+    if (wg->dh <= 0)
+      wg->dw = wg->dh = 0;
+  }
+  if (started) {
+    strip.endFrame();
+    traceFrequentSince("tftFrame", mark);
+  }
+  return bytes;
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <Arduino.h>
+#include <TFT_eSPI.h>
+
+// ================== SCREEN ==================
+// Layer retained-mode di atas TFT_eStrip. Tiap widget menyimpan area
+// yang berubah (dirty rect); Screen hanya me-render area itu lewat
+// renderer strip double-buffer (CPU menggambar strip berikutnya selagi
+// DMA mengirim strip sebelumnya).
+
+#ifndef SCREEN_STRIP_H
+#define SCREEN_STRIP_H 10
+#endif
+#define SCREEN_MAX_WIDGETS 8
+
+class Widget {
+public:
+  Widget(int16_t x, int16_t y, int16_t w, int16_t h);
+  virtual ~Widget() {}
+
+  // Gambar isi widget ke spr dengan koordinat lokal widget digeser -oy
+  // (baris oy jatuh di baris 0 sprite). Wajib mengisi setiap piksel
+  // [0, w) karena strip dipakai ulang tanpa dibersihkan.
+  virtual void render(TFT_eSprite &spr, int16_t oy) = 0;
+
+  void invalidate() { invalidate(0, 0, w, h); }
+  void invalidate(int16_t rx, int16_t ry, int16_t rw, int16_t rh);
+  bool isDirty() const { return dw > 0; }
+
+  const int16_t x, y, w, h;
+
+private:
+  friend class Screen;
+  int16_t dx = 0, dy = 0, dw = 0, dh = 0; // dirty rect, lokal
+};
+
+class Screen {
+public:
+  explicit Screen(TFT_eSPI *tft);
+
+  // Alokasi strip + initDMA. false kalau heap tidak cukup.
+  bool begin();
+
+  // Ganti halaman: semua widget halaman baru di-invalidate penuh.
+  // Widget sebaiknya menutup layar penuh supaya tidak perlu fillScreen.
+  void setPage(Widget *const *widgets, uint8_t count);
+
+  // Kirim dirty rect. maxBytes > 0 membatasi kiriman per panggilan (per
+  // strip): sisa baris tetap dirty dan dikirim di panggilan berikutnya,
+  // supaya gambar ulang satu layar tidak menahan loop puluhan ms.
+  // Return jumlah byte piksel yang dikirim.
+  uint32_t update(uint32_t maxBytes = 0);
+  bool pending() const;
+
+  // Tinggi strip bisa diubah saat jalan (RAM vs jumlah transaksi DMA)
+  bool setStripHeight(uint16_t h) { return strip.setStripHeight(h); }
+  const StripStats &stats() { return strip.stats(); }
+
+private:
+  static void renderWidget(TFT_eSprite &spr, int32_t oy, void *arg);
+
+  TFT_eSPI *tft;
+  TFT_eStrip strip;
+  Widget *page[SCREEN_MAX_WIDGETS];
+  uint8_t pageCount = 0;
+};
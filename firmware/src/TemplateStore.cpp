@@ -0,0 +1,456 @@
+#include "TemplateStore.h"
+
+#include <FS.h>
+#include <LittleFS.h>
+#include <esp32/rom/crc.h>
+
+#include "ScanTask.h"
+
+#define TEMPLATE_INDEX "/tpl.idx"
+#define TEMPLATE_INDEX_TMP "/tpl.idx.tmp"
+#define TEMPLATE_DATA "/tpl.dat"
+#define TEMPLATE_MAGIC 0x50545841UL // "AXTP"
+
+// Batas waktu fallback per scan: satu kandidat ~185 ms (DownChar 512 byte
+// di 57600 baud + PS_Match). Dengan store dibatasi templateCapacity(),
+// paling banyak TEMPLATE_FALLBACK_WINDOW kandidat, jadi batas ini hanya
+// pengaman kalau sensor lebih lambat dari biasanya.
+#define TEMPLATE_FALLBACK_MS 4000
+
+// File index: [header][entry]... urut uid, ditulis ulang utuh (tmp +
+// rename) setiap ada perubahan. File data: blob template per slot, CRC
+// blob ada di entry, jadi blob setengah tertulis ketahuan saat dibaca.
+struct TemplateIndexHeader {
+  uint32_t magic;
+  uint32_t count;
+  uint32_t syncVersion; // versi server terakhir yang sudah diterapkan
+  uint32_t crc;         // CRC32 semua entry
+};
+
+static Adafruit_Fingerprint *fp = nullptr;
+static bool storeReady = false;
+static TemplateEntry entries[TEMPLATE_MAX]; // urut uid
+static uint16_t entryCount = 0;
+static uint32_t seenClock = 0;
+static uint32_t syncVersion = 0;
+static uint8_t tplBuf[TEMPLATE_BYTES];
+static TemplateFallbackStats fallbackStats = {};
+static uint32_t refused = 0;
+
+static int findUid(uint16_t uid) {
+  int lo = 0, hi = entryCount;
+  while (lo < hi) {
+    int mid = (lo + hi) / 2;
+    if (entries[mid].uid < uid)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+  return (lo < entryCount && entries[lo].uid == uid) ? lo : -1;
+}
+
+static bool writeIndex() {
+  TemplateIndexHeader h;
+  h.magic = TEMPLATE_MAGIC;
+  h.count = entryCount;
+  h.syncVersion = syncVersion;
+  h.crc = crc32_le(0, (const uint8_t *)entries,
+                   entryCount * sizeof(TemplateEntry));
+
+  fs::File f = LittleFS.open(TEMPLATE_INDEX_TMP, FILE_WRITE);
+  if (!f)
+    return false;
+  size_t n = entryCount * sizeof(TemplateEntry);
+  bool ok = f.write((const uint8_t *)&h, sizeof(h)) == sizeof(h) &&
+            f.write((const uint8_t *)entries, n) == n;
+  f.close();
+  return ok && LittleFS.rename(TEMPLATE_INDEX_TMP, TEMPLATE_INDEX);
+}
+
+static bool readIndex() {
+  fs::File f = LittleFS.open(TEMPLATE_INDEX, FILE_READ);
+  if (!f)
+    return false;
+  TemplateIndexHeader h;
+  bool ok = f.read((uint8_t *)&h, sizeof(h)) == sizeof(h) &&
+            h.magic == TEMPLATE_MAGIC && h.count <= TEMPLATE_MAX;
+  if (ok) {
+    size_t n = h.count * sizeof(TemplateEntry);
+    ok = f.read((uint8_t *)entries, n) == n &&
+         crc32_le(0, (const uint8_t *)entries, n) == h.crc;
+  }
+  f.close();
+  entryCount = ok ? h.count : 0;
+  syncVersion = ok ? h.syncVersion : 0;
+  return ok;
+}
+
+static bool writeBlob(uint16_t slot, const uint8_t *buf) {
+  const char *mode = LittleFS.exists(TEMPLATE_DATA) ? "r+" : FILE_WRITE;
+  fs::File f = LittleFS.open(TEMPLATE_DATA, mode);
+  if (!f)
+    return false;
+  bool ok = f.seek((uint32_t)slot * TEMPLATE_BYTES, fs::SeekSet) &&
+            f.write(buf, TEMPLATE_BYTES) == TEMPLATE_BYTES;
+  f.close();
+  return ok;
+}
+
+static bool readBlob(const TemplateEntry &e, uint8_t *buf) {
+  fs::File f = LittleFS.open(TEMPLATE_DATA, FILE_READ);
+  if (!f)
+    return false;
+  bool ok = f.seek((uint32_t)e.slot * TEMPLATE_BYTES, fs::SeekSet) &&
+            f.read(buf, TEMPLATE_BYTES) == TEMPLATE_BYTES;
+  f.close();
+  return ok && crc32_le(0, buf, TEMPLATE_BYTES) == e.crc;
+}
+
+// Slot blob terkecil yang belum dipakai
+static uint16_t freeSlot() {
+  static uint8_t used[(TEMPLATE_MAX + 7) / 8];
+  memset(used, 0, sizeof(used));
+  for (uint16_t i = 0; i < entryCount; i++)
+    used[entries[i].slot / 8] |= 1 << (entries[i].slot % 8);
+  for (uint16_t s = 0; s < TEMPLATE_MAX; s++)
+    if (!(used[s / 8] & (1 << (s % 8))))
+      return s;
+  return TEMPLATE_MAX;
+}
+
+static bool pageUsed(uint16_t page) {
+  for (uint16_t i = 0; i < entryCount; i++)
+    if (entries[i].page == page)
+      return true;
+  return false;
+}
+
+static uint16_t freePage(uint16_t preferred) {
+  if (preferred < fp->capacity && !pageUsed(preferred))
+    return preferred;
+  for (uint16_t p = 0; p < fp->capacity; p++)
+    if (!pageUsed(p))
+      return p;
+  return TEMPLATE_NO_PAGE;
+}
+
+// Page kosong di library sensor; kalau penuh, keluarkan template resident
+// yang paling lama tidak dipakai (tetap ada di store).
+static uint16_t allocPage(uint16_t preferred) {
+  uint16_t page = freePage(preferred);
+  if (page != TEMPLATE_NO_PAGE)
+    return page;
+
+  int lru = -1;
+  for (uint16_t i = 0; i < entryCount; i++) {
+    if (entries[i].page == TEMPLATE_NO_PAGE)
+      continue;
+    if (lru < 0 || entries[i].lastSeen < entries[lru].lastSeen)
+      lru = i;
+  }
+  if (lru < 0)
+    return TEMPLATE_NO_PAGE;
+  page = entries[lru].page;
+  if (fp->deleteModel(page) != FINGERPRINT_OK)
+    return TEMPLATE_NO_PAGE;
+  entries[lru].page = TEMPLATE_NO_PAGE;
+  return page;
+}
+
+// Masukkan / ganti entry uid, blob diambil dari tplBuf
+static bool putEntry(uint16_t uid, uint16_t page, uint16_t flags) {
+  int i = findUid(uid);
+  if (i < 0) {
+    if (entryCount >= TEMPLATE_MAX)
+      return false;
+    uint16_t slot = freeSlot();
+    if (slot >= TEMPLATE_MAX)
+      return false;
+    // Sisipkan sambil menjaga urutan uid
+    i = entryCount;
+    while (i > 0 && entries[i - 1].uid > uid) {
+      entries[i] = entries[i - 1];
+      i--;
+    }
+    entries[i].uid = uid;
+    entries[i].slot = slot;
+    entryCount++;
+  }
+  entries[i].page = page;
+  entries[i].flags = flags;
+  entries[i].lastSeen = ++seenClock;
+  entries[i].crc = crc32_le(0, tplBuf, TEMPLATE_BYTES);
+  return writeBlob(entries[i].slot, tplBuf);
+}
+
+// Satu page per sensorLock(): scan task bisa menyela di antaranya. Page
+// yang di-enroll selama impor (tanpa store: page = uid) ikut terimpor
+// kalau letaknya belum dilewati, kalau tidak tetap dikenali lewat page.
+static void importSensorLibrary() {
+  sensorLock(portMAX_DELAY);
+  bool ok = fp->getTemplateCount() == FINGERPRINT_OK;
+  uint16_t total = fp->templateCount;
+  sensorUnlock();
+  if (!ok || total == 0)
+    return;
+  uint16_t found = 0;
+  for (uint16_t page = 0; page < fp->capacity && found < total; page++) {
+    sensorLock(portMAX_DELAY);
+    if (fp->loadModel(page) == FINGERPRINT_OK) {
+      found++;
+      if (fp->readModel(tplBuf, TEMPLATE_BYTES) == FINGERPRINT_OK)
+        putEntry(page, page, TEMPLATE_FLAG_DIRTY);
+    }
+    sensorUnlock();
+    vTaskDelay(1); // scan task yang menunggu lock dapat giliran
+  }
+  sensorLock(portMAX_DELAY);
+  writeIndex();
+  sensorUnlock();
+  Serial.printf("Template: %u diimpor dari sensor\n", entryCount);
+}
+
+// Sensor diganti / library dikosongkan: page yang hilang tidak lagi
+// dianggap resident, supaya template-nya ikut dicek di fallback.
+static void checkResident() {
+  uint16_t resident = 0;
+  for (uint16_t i = 0; i < entryCount; i++)
+    if (entries[i].page != TEMPLATE_NO_PAGE)
+      resident++;
+  if (fp->getTemplateCount() != FINGERPRINT_OK ||
+      fp->templateCount >= resident)
+    return;
+
+  uint16_t lost = 0;
+  for (uint16_t i = 0; i < entryCount; i++) {
+    if (entries[i].page == TEMPLATE_NO_PAGE ||
+        fp->loadModel(entries[i].page) == FINGERPRINT_OK)
+      continue;
+    entries[i].page = TEMPLATE_NO_PAGE;
+    lost++;
+  }
+  writeIndex();
+  Serial.printf("Template: %u tidak ada lagi di sensor\n", lost);
+}
+
+bool templateStoreBegin(Adafruit_Fingerprint *sensor) {
+  fp = sensor;
+  fp->getParameters(); // capacity + packet_len untuk DownChar
+  readIndex();
+  for (uint16_t i = 0; i < entryCount; i++)
+    if (entries[i].lastSeen > seenClock)
+      seenClock = entries[i].lastSeen;
+  Serial.printf("Template: %u di store\n", entryCount);
+  return true;
+}
+
+void templateStoreImport() {
+  if (entryCount == 0) {
+    importSensorLibrary();
+    sensorLock(portMAX_DELAY);
+  } else {
+    sensorLock(portMAX_DELAY);
+    checkResident();
+  }
+  storeReady = true;
+  sensorUnlock();
+}
+
+uint16_t templateCount() { return entryCount; }
+
+uint16_t templateCapacity() {
+  uint32_t cap = (uint32_t)fp->capacity + TEMPLATE_FALLBACK_WINDOW;
+  return cap < TEMPLATE_MAX ? cap : TEMPLATE_MAX;
+}
+
+bool templateHasRoom(uint16_t uid) {
+  if (findUid(uid) >= 0 || entryCount < templateCapacity())
+    return true;
+  refused++;
+  return false;
+}
+
+uint32_t templateRefused() { return refused; }
+
+uint16_t templateUidForPage(uint16_t page) {
+  for (uint16_t i = 0; i < entryCount; i++)
+    if (entries[i].page == page)
+      return entries[i].uid;
+  return page; // enroll lama tanpa store: page = uid
+}
+
+void templateTouch(uint16_t uid) {
+  int i = findUid(uid);
+  if (i >= 0)
+    entries[i].lastSeen = ++seenClock;
+}
+
+uint8_t templateEnroll(uint16_t uid) {
+  if (!storeReady)
+    return fp->storeModel(uid);
+  if (!templateHasRoom(uid))
+    return TEMPLATE_STORE_FULL;
+
+  int i = findUid(uid);
+  uint16_t page = (i >= 0 && entries[i].page != TEMPLATE_NO_PAGE)
+                      ? entries[i].page
+                      : allocPage(uid);
+  if (page == TEMPLATE_NO_PAGE)
+    return FINGERPRINT_BADLOCATION;
+
+  uint8_t r = fp->storeModel(page);
+  if (r != FINGERPRINT_OK)
+    return r;
+  r = fp->readModel(tplBuf, TEMPLATE_BYTES);
+  if (r == FINGERPRINT_OK &&
+      !(putEntry(uid, page, TEMPLATE_FLAG_DIRTY) && writeIndex()))
+    r = FINGERPRINT_FLASHERR;
+  if (r != FINGERPRINT_OK) {
+    // Jangan tinggalkan page sensor yang isinya tidak sama dengan store
+    fp->deleteModel(page);
+    i = findUid(uid);
+    if (i >= 0 && entries[i].page == page)
+      entries[i].page = TEMPLATE_NO_PAGE;
+    writeIndex();
+  }
+  return r;
+}
+
+uint8_t templateDelete(uint16_t uid) {
+  int i = findUid(uid);
+  if (!storeReady || i < 0)
+    return fp->deleteModel(uid);
+
+  if (entries[i].page != TEMPLATE_NO_PAGE) {
+    uint8_t r = fp->deleteModel(entries[i].page);
+    if (r != FINGERPRINT_OK)
+      return r;
+  }
+  for (uint16_t j = i; j + 1 < entryCount; j++)
+    entries[j] = entries[j + 1];
+  entryCount--;
+  return writeIndex() ? FINGERPRINT_OK : FINGERPRINT_FLASHERR;
+}
+
+uint8_t templateInstall(uint16_t uid, const uint8_t *buf) {
+  if (!storeReady)
+    return FINGERPRINT_PACKETRECIEVEERR;
+  if (!templateHasRoom(uid))
+    return TEMPLATE_STORE_FULL;
+
+  memcpy(tplBuf, buf, TEMPLATE_BYTES);
+  int i = findUid(uid);
+  uint16_t page = (i >= 0) ? entries[i].page : TEMPLATE_NO_PAGE;
+  // Tidak mengusir template lain: kalau library penuh, template baru cukup
+  // ada di store dan masuk sensor lewat fallback saat pertama dipakai
+  if (page == TEMPLATE_NO_PAGE)
+    page = freePage(uid);
+  if (page != TEMPLATE_NO_PAGE &&
+      (fp->writeModel(tplBuf, TEMPLATE_BYTES, 1) != FINGERPRINT_OK ||
+       fp->storeModel(page, 1) != FINGERPRINT_OK)) {
+    // Isi page lama sudah tidak bisa dipercaya
+    if (i >= 0 && entries[i].page == page)
+      fp->deleteModel(page);
+    page = TEMPLATE_NO_PAGE;
+  }
+  return putEntry(uid, page, 0) && writeIndex() ? FINGERPRINT_OK
+                                                : FINGERPRINT_FLASHERR;
+}
+
+bool templateInfo(uint16_t uid, uint32_t *crc, uint16_t *flags) {
+  int i = findUid(uid);
+  if (i < 0)
+    return false;
+  *crc = entries[i].crc;
+  *flags = entries[i].flags;
+  return true;
+}
+
+bool templateRead(uint16_t uid, uint8_t *buf, uint32_t *crc) {
+  int i = findUid(uid);
+  if (i < 0 || !readBlob(entries[i], buf))
+    return false;
+  *crc = entries[i].crc;
+  return true;
+}
+
+bool templateNextDirty(uint32_t from, uint16_t *uid) {
+  for (uint16_t i = 0; i < entryCount; i++) {
+    if (entries[i].uid >= from && (entries[i].flags & TEMPLATE_FLAG_DIRTY)) {
+      *uid = entries[i].uid;
+      return true;
+    }
+  }
+  return false;
+}
+
+void templateMarkSynced(uint16_t uid, uint32_t crc) {
+  int i = findUid(uid);
+  // Di-enroll ulang selama upload: blob baru tetap harus diupload
+  if (i < 0 || entries[i].crc != crc)
+    return;
+  entries[i].flags &= ~TEMPLATE_FLAG_DIRTY;
+  writeIndex();
+}
+
+uint32_t templateSyncVersion() { return syncVersion; }
+
+bool templateSetSyncVersion(uint32_t version) {
+  if (!storeReady)
+    return false;
+  syncVersion = version;
+  return writeIndex();
+}
+
+static int byLastSeenDesc(const void *a, const void *b) {
+  uint32_t sa = entries[*(const uint16_t *)a].lastSeen;
+  uint32_t sb = entries[*(const uint16_t *)b].lastSeen;
+  return (sa < sb) - (sa > sb);
+}
+
+bool templateFallbackMatch(uint16_t *uid, uint16_t *confidence) {
+  if (!storeReady)
+    return false;
+
+  static uint16_t order[TEMPLATE_MAX];
+  uint16_t n = 0;
+  for (uint16_t i = 0; i < entryCount; i++)
+    if (entries[i].page == TEMPLATE_NO_PAGE)
+      order[n++] = i;
+  if (n == 0)
+    return false;
+  qsort(order, n, sizeof(order[0]), byLastSeenDesc);
+
+  uint32_t start = millis();
+  uint16_t k = 0;
+  bool hit = false;
+  for (; k < n && millis() - start < TEMPLATE_FALLBACK_MS; k++) {
+    TemplateEntry &e = entries[order[k]];
+    if (!readBlob(e, tplBuf))
+      continue;
+    fallbackStats.candidates++;
+    if (fp->writeModel(tplBuf, TEMPLATE_BYTES, 2) != FINGERPRINT_OK)
+      break;
+    if (fp->matchModels() != FINGERPRINT_OK)
+      continue;
+
+    *uid = e.uid;
+    *confidence = fp->confidence;
+    e.lastSeen = ++seenClock;
+
+    // Promosi: template tersimpan (char buffer 2) masuk library sensor
+    uint16_t page = allocPage(e.uid);
+    if (page != TEMPLATE_NO_PAGE && fp->storeModel(page, 2) == FINGERPRINT_OK)
+      e.page = page;
+    writeIndex();
+    hit = true;
+    break;
+  }
+  fallbackStats.scans++;
+  fallbackStats.hits += hit;
+  fallbackStats.cutoffs += !hit && k < n;
+  fallbackStats.busyMs += millis() - start;
+  return hit;
+}
+
+TemplateFallbackStats templateFallbackStats() { return fallbackStats; }
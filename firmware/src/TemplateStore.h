@@ -0,0 +1,101 @@
+#pragma once
+
+#include <Adafruit_Fingerprint.h>
+#include <Arduino.h>
+
+// ================== TEMPLATE STORE ==================
+// Salinan semua template sidik jari di LittleFS. Library AS608 hanya muat
+// ~160 template, jadi library sensor diperlakukan sebagai cache: template
+// yang terakhir dipakai tinggal di sensor (fingerFastSearch), sisanya
+// dicoba satu per satu lewat fallback lalu dipromosikan ke sensor.
+//
+// Format template AS608 tertutup, jadi perbandingan tetap dikerjakan
+// sensor (PS_Match antara char buffer 1 dan 2) dan ESP32 tidak bisa
+// menyaring kandidat; ESP32 hanya menyimpan template, mengurutkan
+// kandidat (terbaru dulu), dan mengatur page mana yang resident. Satu
+// kandidat ~185 ms, jadi fallback per scan hanya menjangkau
+// TEMPLATE_FALLBACK_WINDOW template non-resident. Karena itu store dibatasi
+// templateCapacity() = page sensor + TEMPLATE_FALLBACK_WINDOW: semua
+// template di store selalu bisa dicocokkan dalam satu scan, dan enroll /
+// template sync di atas batas itu ditolak (TEMPLATE_STORE_FULL), bukan
+// disimpan lalu tidak pernah dikenali.
+//
+// Semua fungsi di bawah memakai UART sensor: panggil sambil memegang
+// sensorLock() (kecuali templateStoreBegin() sebelum scan task jalan dan
+// templateStoreImport() yang mengambil lock sendiri).
+
+#define TEMPLATE_BYTES 512
+#define TEMPLATE_MAX 1000           // batas array; library sensor terbesar
+#define TEMPLATE_FALLBACK_WINDOW 18 // x ~185 ms < TEMPLATE_FALLBACK_MS
+#define TEMPLATE_STORE_FULL 0x1F    // kode AS608 "library penuh"
+#define TEMPLATE_NO_PAGE 0xFFFF
+#define TEMPLATE_FLAG_DIRTY 0x0001  // belum diupload ke server
+
+struct TemplateEntry {
+  uint16_t uid;
+  uint16_t slot;     // posisi blob di file data (slot * TEMPLATE_BYTES)
+  uint16_t page;     // page library sensor, TEMPLATE_NO_PAGE kalau tidak ada
+  uint16_t flags;
+  uint32_t lastSeen; // jam logis match terakhir, makin besar makin baru
+  uint32_t crc;      // CRC32 blob template
+};
+
+// Wajib setelah LittleFS.begin(). Hanya membaca index dari flash; sampai
+// templateStoreImport() selesai, fallback belum aktif dan page sensor
+// yang belum ada di store dianggap page = uid (fingerFastSearch saja).
+bool templateStoreBegin(Adafruit_Fingerprint *sensor);
+// Dari task background setelah scan task jalan. Store kosong (boot
+// pertama): template di library sensor diimpor, ~150 ms per page, lock
+// sensor dilepas di antara page supaya scan tetap jalan. Store berisi:
+// page yang hilang dari sensor ditandai non-resident.
+void templateStoreImport();
+uint16_t templateCount();
+// Jumlah template yang masih bisa dikenali: page sensor +
+// TEMPLATE_FALLBACK_WINDOW (maks. TEMPLATE_MAX)
+uint16_t templateCapacity();
+// Masih ada tempat untuk uid (sudah ada di store, atau store belum
+// penuh). false dihitung sebagai penolakan di templateRefused().
+bool templateHasRoom(uint16_t uid);
+uint32_t templateRefused();
+
+// uid pemilik page sensor hasil fingerFastSearch()
+uint16_t templateUidForPage(uint16_t page);
+
+// Tandai uid baru saja cocok (urutan kandidat fallback + eviction)
+void templateTouch(uint16_t uid);
+
+// Template hasil createModel() ada di char buffer 1: simpan ke sensor
+// dan ke store. Return kode FINGERPRINT_*, atau TEMPLATE_STORE_FULL.
+uint8_t templateEnroll(uint16_t uid);
+uint8_t templateDelete(uint16_t uid);
+
+// Char buffer 1 berisi hasil scan yang tidak ditemukan di library sensor.
+// Cocokkan dengan template non-resident, yang terbaru dipakai duluan,
+// sampai TEMPLATE_FALLBACK_MS habis. Kalau cocok, template dipromosikan
+// ke library sensor supaya scan berikutnya cukup lewat fingerFastSearch.
+bool templateFallbackMatch(uint16_t *uid, uint16_t *confidence);
+
+struct TemplateFallbackStats {
+  uint32_t scans;      // scan yang masuk fallback (ada kandidat)
+  uint32_t hits;
+  uint32_t candidates; // template yang dicocokkan di sensor
+  uint32_t busyMs;     // total waktu fallback; candidates / busyMs = laju
+  uint32_t cutoffs;    // scan yang kehabisan TEMPLATE_FALLBACK_MS
+};
+TemplateFallbackStats templateFallbackStats();
+
+// ---- Sinkronisasi dengan server (TemplateSync) ----
+
+// Template dari server: simpan ke store, lalu ke library sensor kalau
+// masih ada page kosong (DownChar + PS_StoreChar). TEMPLATE_STORE_FULL
+// kalau store sudah templateCapacity().
+uint8_t templateInstall(uint16_t uid, const uint8_t *buf);
+bool templateInfo(uint16_t uid, uint32_t *crc, uint16_t *flags);
+// Salin blob uid (TEMPLATE_BYTES) dari flash, tanpa menyentuh sensor
+bool templateRead(uint16_t uid, uint8_t *buf, uint32_t *crc);
+// uid terkecil >= from yang masih TEMPLATE_FLAG_DIRTY
+bool templateNextDirty(uint32_t from, uint16_t *uid);
+// Upload blob dengan crc tersebut selesai
+void templateMarkSynced(uint16_t uid, uint32_t crc);
+uint32_t templateSyncVersion();
+bool templateSetSyncVersion(uint32_t version);
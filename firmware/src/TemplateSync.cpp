@@ -0,0 +1,399 @@
+#include "TemplateSync.h"
+
+#include <ArduinoJson.h>
+#include <WiFi.h>
+#include <esp32/rom/crc.h>
+
+#include "ApiClient.h"
+#include "ScanTask.h"
+#include "TemplateStore.h"
+
+#define SYNC_TASK_CORE 0
+#define SYNC_TASK_STACK 8192
+#define SYNC_TASK_PRIO 1
+#define SYNC_INTERVAL_MS 120000
+#define SYNC_BACKOFF_MIN_MS 5000
+#define SYNC_BACKOFF_MAX_MS 300000
+#define SYNC_PAGE 20
+// Batas putaran koreksi offset (409) per template
+#define SYNC_MAX_RESYNC 4
+// Semua JsonDocument di task ini memakai arena, bukan heap. Paling banyak
+// dua dokumen hidup bersamaan (chunk + jawabannya), masing-masing satu pool
+// ArduinoJson plus string hex: 4 KB di ESP32, lebih besar di build native
+// (slot 64-bit).
+#define SYNC_JSON_ARENA (4 * ARDUINOJSON_POOL_CAPACITY * 2 * sizeof(void *))
+
+static SemaphoreHandle_t kickSem = nullptr;
+
+// Posisi transfer yang terputus, dilanjutkan kalau template-nya masih sama
+struct Transfer {
+  uint16_t uid;
+  uint32_t crc;
+  uint16_t offset;
+};
+static Transfer upload = {};
+static Transfer download = {};
+static uint8_t upBuf[TEMPLATE_BYTES];
+static uint8_t downBuf[TEMPLATE_BYTES];
+static char arenaBuf[SYNC_JSON_ARENA];
+static ArenaAllocator arena(arenaBuf, sizeof(arenaBuf));
+
+// Satu entry daftar perubahan. Koneksi ke server hanya satu, jadi satu
+// halaman disalin ke sini dulu; download template baru bisa jalan setelah
+// body daftarnya selesai dibaca.
+struct Change {
+  uint32_t version;
+  uint32_t crc;
+  uint16_t uid;
+  uint16_t size;
+  bool deleted;
+};
+
+struct ChangePage {
+  Change changes[SYNC_PAGE];
+  uint8_t count;
+  bool more;
+  bool ok; // body terbaca utuh sebagai JSON
+};
+static ChangePage page;
+
+enum SyncResult {
+  SYNC_OK,
+  SYNC_SKIP,  // ditolak permanen untuk template ini, lanjut ke berikutnya
+  SYNC_RETRY  // jaringan / server bermasalah, ulangi nanti
+};
+
+static SyncResult classify(int httpCode) {
+  if (httpCode >= 200 && httpCode < 300)
+    return SYNC_OK;
+  // 401 dan 5xx bukan salah template-nya
+  if (httpCode >= 400 && httpCode < 500 && httpCode != 401)
+    return SYNC_SKIP;
+  return SYNC_RETRY;
+}
+
+static void toHex(const uint8_t *buf, size_t len, char *out) {
+  static const char digits[] = "0123456789abcdef";
+  for (size_t i = 0; i < len; i++) {
+    *out++ = digits[buf[i] >> 4];
+    *out++ = digits[buf[i] & 0x0F];
+  }
+  *out = '\0';
+}
+
+static int hexNibble(char c) {
+  if (c >= '0' && c <= '9')
+    return c - '0';
+  if (c >= 'a' && c <= 'f')
+    return c - 'a' + 10;
+  if (c >= 'A' && c <= 'F')
+    return c - 'A' + 10;
+  return -1;
+}
+
+// Return jumlah byte, -1 kalau bukan hex
+static int fromHex(const char *hex, uint8_t *out, size_t max) {
+  size_t n = 0;
+  while (hex[0] && hex[1]) {
+    int hi = hexNibble(hex[0]), lo = hexNibble(hex[1]);
+    if (hi < 0 || lo < 0 || n >= max)
+      return -1;
+    out[n++] = (hi << 4) | lo;
+    hex += 2;
+  }
+  return hex[0] ? -1 : (int)n;
+}
+
+// ---- Upload: enroll lokal -> server ----
+
+static SyncResult uploadTemplate(uint16_t uid, uint32_t crc) {
+  char path[32];
+  sprintf(path, "/api/templates/%u", uid);
+
+  uint16_t offset = 0;
+  if (upload.uid == uid && upload.crc == crc)
+    offset = upload.offset;
+
+  static char hex[TEMPLATE_SYNC_CHUNK * 2 + 1];
+  // {"crc":..,"size":..,"offset":..,"data":"<hex>"} diserialisasi ke
+  // buffer tetap, bukan ke String yang dialokasi ulang tiap chunk
+  static char payload[sizeof(hex) + 64];
+  uint8_t resyncs = 0;
+  while (offset < TEMPLATE_BYTES) {
+    size_t len = TEMPLATE_BYTES - offset;
+    if (len > TEMPLATE_SYNC_CHUNK)
+      len = TEMPLATE_SYNC_CHUNK;
+    toHex(upBuf + offset, len, hex);
+
+    JsonDocument doc(&arena);
+    doc["crc"] = crc;
+    doc["size"] = TEMPLATE_BYTES;
+    doc["offset"] = offset;
+    doc["data"] = (const char *)hex;
+    size_t n = serializeJson(doc, payload, sizeof(payload));
+    if (n >= sizeof(payload) - 1)
+      return SYNC_SKIP; // tidak mungkin selama ukuran chunk tetap
+
+    String response;
+    int httpCode = apiPost(path, payload, n, &response);
+    JsonDocument reply(&arena);
+    bool parsed = httpCode > 0 && !deserializeJson(reply, response);
+
+    // 409: server punya posisi lain (chunk sebelumnya sudah / belum sampai),
+    // 422: CRC gabungan salah dan staging dibuang. Lanjut dari posisi server.
+    if ((httpCode == 409 || httpCode == 422) && parsed &&
+        ++resyncs <= SYNC_MAX_RESYNC) {
+      offset = reply["received"] | 0;
+      continue;
+    }
+    SyncResult r = classify(httpCode);
+    if (r != SYNC_OK || !parsed)
+      return r == SYNC_OK ? SYNC_RETRY : r;
+
+    offset = reply["received"] | (uint16_t)(offset + len);
+    upload.uid = uid;
+    upload.crc = crc;
+    upload.offset = offset;
+  }
+  upload = {};
+  return SYNC_OK;
+}
+
+static bool pushDirty() {
+  uint32_t from = 0;
+  uint16_t uid;
+  uint32_t crc;
+  for (;;) {
+    sensorLock(portMAX_DELAY);
+    bool more = templateNextDirty(from, &uid);
+    bool read = more && templateRead(uid, upBuf, &crc);
+    sensorUnlock();
+    if (!more)
+      return true;
+    // Blob rusak / hilang di flash: jangan hentikan upload uid sesudahnya
+    if (!read) {
+      Serial.printf("TemplateSync: uid %u gagal dibaca dari flash\n", uid);
+      from = (uint32_t)uid + 1;
+      continue;
+    }
+
+    SyncResult r = uploadTemplate(uid, crc);
+    if (r == SYNC_RETRY)
+      return false;
+    if (r == SYNC_OK) {
+      sensorLock(portMAX_DELAY);
+      templateMarkSynced(uid, crc);
+      sensorUnlock();
+      Serial.printf("TemplateSync: uid %u diupload\n", uid);
+    } else {
+      // Biasanya uid belum terdaftar sebagai Employee; dicoba lagi nanti
+      Serial.printf("TemplateSync: uid %u ditolak server\n", uid);
+    }
+    from = (uint32_t)uid + 1;
+  }
+}
+
+// ---- Download: server -> store + sensor ----
+
+static SyncResult downloadTemplate(uint16_t uid, uint32_t crc) {
+  char path[64];
+  uint16_t offset = 0;
+  if (download.uid == uid && download.crc == crc)
+    offset = download.offset;
+
+  while (offset < TEMPLATE_BYTES) {
+    sprintf(path, "/api/templates/%u?offset=%u&length=%u", uid, offset,
+            TEMPLATE_SYNC_CHUNK);
+    String response;
+    int httpCode = apiGet(path, &response);
+    SyncResult r = classify(httpCode);
+    if (r != SYNC_OK)
+      return r;
+
+    JsonDocument reply(&arena);
+    if (deserializeJson(reply, response))
+      return SYNC_RETRY;
+    // Template diganti lagi sejak daftar perubahan diambil
+    if ((reply["crc"] | 0UL) != crc)
+      return SYNC_RETRY;
+    int n = fromHex(reply["data"] | "", downBuf + offset,
+                    TEMPLATE_BYTES - offset);
+    if (n <= 0)
+      return SYNC_SKIP;
+
+    offset += n;
+    download.uid = uid;
+    download.crc = crc;
+    download.offset = offset;
+  }
+  download = {};
+  return crc32_le(0, downBuf, TEMPLATE_BYTES) == crc ? SYNC_OK : SYNC_SKIP;
+}
+
+// Terapkan satu perubahan dari server; false kalau harus diulang nanti
+static bool applyChange(const Change &c) {
+  uint16_t uid = c.uid;
+  uint32_t crc = c.crc;
+  uint32_t localCrc;
+  uint16_t flags;
+
+  sensorLock(portMAX_DELAY);
+  bool found = templateInfo(uid, &localCrc, &flags);
+  if (c.deleted) {
+    if (found && templateDelete(uid) == FINGERPRINT_OK)
+      Serial.printf("TemplateSync: uid %u dihapus\n", uid);
+    sensorUnlock();
+    return true;
+  }
+  // Store penuh: template di atas templateCapacity() tidak akan pernah
+  // dikenali, jadi dilewati (bukan diulang terus sampai sync macet)
+  bool room = c.size != TEMPLATE_BYTES || templateHasRoom(uid);
+  sensorUnlock();
+  if (!room) {
+    Serial.printf("TemplateSync: template store penuh (%u), uid %u "
+                  "dilewati\n",
+                  templateCapacity(), uid);
+    return true;
+  }
+
+  // Sudah sama (biasanya upload reader ini sendiri), atau enroll lokal
+  // yang belum terupload menang sampai uploadnya selesai
+  if (found && (localCrc == crc || (flags & TEMPLATE_FLAG_DIRTY)))
+    return true;
+  if (c.size != TEMPLATE_BYTES)
+    return true;
+
+  SyncResult r = downloadTemplate(uid, crc);
+  if (r == SYNC_RETRY)
+    return false;
+  if (r == SYNC_SKIP) {
+    Serial.printf("TemplateSync: template uid %u rusak, dilewati\n", uid);
+    return true;
+  }
+
+  sensorLock(portMAX_DELAY);
+  uint8_t res = templateInstall(uid, downBuf);
+  sensorUnlock();
+  Serial.printf("TemplateSync: uid %u dipasang (%d)\n", uid, res);
+  return res == FINGERPRINT_OK;
+}
+
+// Body /api/templates?since=N dibaca langsung dari socket dengan pull
+// parser: hanya satu entry yang dijadikan JsonDocument pada satu waktu, dan
+// ukuran body tidak mempengaruhi RAM
+static void readPage(Stream &body, void *ctx) {
+  ChangePage *p = (ChangePage *)ctx;
+  auto parser = makeJsonPullParser(body);
+  if (parser.next() != JsonToken::ObjectStart)
+    return;
+
+  while (parser.next() == JsonToken::Key) {
+    bool isTemplates = parser.str() == "templates";
+    bool isMore = parser.str() == "more";
+    parser.next();
+    if (isTemplates && parser.token() == JsonToken::ArrayStart) {
+      while (parser.next() == JsonToken::ObjectStart) {
+        // Lebih dari limit: sisanya diambil di halaman berikut
+        if (p->count == SYNC_PAGE) {
+          p->more = true;
+          parser.skip();
+          continue;
+        }
+        JsonDocument t(&arena);
+        if (parser.read(t))
+          return;
+        Change &c = p->changes[p->count++];
+        c.version = t["version"] | 0UL;
+        c.crc = t["crc"] | 0UL;
+        c.uid = t["uid"] | 0;
+        c.size = t["size"] | 0;
+        c.deleted = t["deleted"] | false;
+      }
+    } else if (isMore) {
+      p->more |= parser.as<bool>();
+    } else {
+      parser.skip();
+    }
+  }
+  p->ok = parser.token() == JsonToken::ObjectEnd;
+}
+
+static bool pullChanges() {
+  for (;;) {
+    uint32_t since = templateSyncVersion();
+    char path[64];
+    sprintf(path, "/api/templates?since=%lu&limit=%u", (unsigned long)since,
+            SYNC_PAGE);
+    page = {};
+    if (classify(apiGetStream(path, readPage, &page)) != SYNC_OK || !page.ok)
+      return false;
+
+    uint32_t applied = since;
+    bool ok = true;
+    for (uint8_t i = 0; ok && i < page.count; i++) {
+      ok = applyChange(page.changes[i]);
+      if (ok && page.changes[i].version)
+        applied = page.changes[i].version;
+    }
+
+    // Versi disimpan per halaman, bukan per template, supaya index tidak
+    // ditulis ulang untuk setiap perubahan
+    if (applied != since) {
+      sensorLock(portMAX_DELAY);
+      templateSetSyncVersion(applied);
+      sensorUnlock();
+    }
+    if (!ok)
+      return false;
+    if (!page.more)
+      return true;
+  }
+}
+
+static void syncTask(void *) {
+  size_t arenaFailures = 0;
+  uint32_t backoff = SYNC_BACKOFF_MIN_MS;
+  uint32_t wait = 0;
+
+  for (;;) {
+    xSemaphoreTake(kickSem, pdMS_TO_TICKS(wait));
+
+    if (WiFi.status() != WL_CONNECTED) {
+      wait = SYNC_INTERVAL_MS;
+      continue;
+    }
+
+    // Upload dulu supaya enroll lokal tidak tertimpa versi lama dari server
+    bool ok = pushDirty() && pullChanges();
+    // Semua dokumen sudah keluar scope; reset juga membuang blok yang
+    // tertahan karena urutan free yang tidak LIFO
+    arena.reset();
+    if (arena.failures() != arenaFailures) {
+      arenaFailures = arena.failures();
+      Serial.printf("TemplateSync: arena JSON penuh (puncak %u/%u byte)\n",
+                    (unsigned)arena.highWaterMark(),
+                    (unsigned)arena.capacity());
+    }
+
+    if (ok) {
+      backoff = SYNC_BACKOFF_MIN_MS;
+      wait = SYNC_INTERVAL_MS;
+    } else {
+      wait = backoff;
+      backoff *= 2;
+      if (backoff > SYNC_BACKOFF_MAX_MS)
+        backoff = SYNC_BACKOFF_MAX_MS;
+    }
+  }
+}
+
+void templateSyncBegin() {
+  kickSem = xSemaphoreCreateBinary();
+  xTaskCreatePinnedToCore(syncTask, "tplsync", SYNC_TASK_STACK, nullptr,
+                          SYNC_TASK_PRIO, nullptr, SYNC_TASK_CORE);
+}
+
+void templateSyncKick() {
+  if (kickSem)
+    xSemaphoreGive(kickSem);
+}
@@ -0,0 +1,18 @@
+#pragma once
+
+#include <Arduino.h>
+
+// ================== TEMPLATE SYNC ==================
+// Menyamakan template store antar reader lewat server. Template hasil
+// enroll diupload ke /api/templates/<uid>; perubahan dari reader lain
+// ditarik per versi (/api/templates?since=N) lalu dipasang ke store dan
+// sensor. Blob dikirim per chunk, dan chunk yang sudah sampai tidak
+// dikirim ulang kalau transfer terputus.
+
+#define TEMPLATE_SYNC_CHUNK 256
+
+// apiBegin() dan templateStoreBegin() harus sudah dipanggil
+void templateSyncBegin();
+
+// Sync sekarang (baru enroll / sync manual)
+void templateSyncKick();
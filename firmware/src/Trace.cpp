@@ -0,0 +1,141 @@
+#include "Trace.h"
+
+#include <atomic>
+
+#define TRACE_NAME_LEN 16
+#define TRACE_CALIBRATE_SPANS 64
+
+struct TraceEvent {
+  const char *name;
+  uint32_t cycles; // CCOUNT core tempat task jalan
+  uint32_t tick;   // xTaskGetTickCount(), 1 ms
+  uint8_t task;    // indeks ke tasks[]
+  char phase;      // 'B' / 'E'
+};
+
+struct TraceTask {
+  TaskHandle_t handle;
+  uint8_t core;
+  char name[TRACE_NAME_LEN];
+};
+
+struct TraceRing {
+  TraceRing(TraceEvent *events, uint32_t size)
+      : events(events), mask(size - 1), head(0) {}
+  TraceEvent *events;
+  uint32_t mask;
+  std::atomic<uint32_t> head;
+};
+
+static TraceEvent mainEvents[TRACE_RING];
+static TraceEvent frequentEvents[TRACE_RING_FREQUENT];
+static TraceRing mainRing(mainEvents, TRACE_RING);
+static TraceRing frequentRing(frequentEvents, TRACE_RING_FREQUENT);
+static volatile bool paused = false;
+
+static TraceTask tasks[TRACE_TASKS];
+static std::atomic<uint8_t> taskCount(0);
+static portMUX_TYPE taskMux = portMUX_INITIALIZER_UNLOCKED;
+
+static uint32_t spanCycles = 0;
+
+// Indeks task pemanggil. Task baru didaftarkan sekali (nama disalin,
+// karena task bisa dihapus sebelum dump); setelah itu hanya beberapa
+// perbandingan pointer.
+static uint8_t taskIndex() {
+  TaskHandle_t self = xTaskGetCurrentTaskHandle();
+  uint8_t n = taskCount.load(std::memory_order_acquire);
+  for (uint8_t i = 0; i < n; i++)
+    if (tasks[i].handle == self)
+      return i;
+
+  portENTER_CRITICAL(&taskMux);
+  n = taskCount.load(std::memory_order_relaxed);
+  uint8_t i = 0;
+  while (i < n && tasks[i].handle != self)
+    i++;
+  if (i == n && n < TRACE_TASKS) {
+    tasks[i].handle = self;
+    tasks[i].core = xPortGetCoreID();
+    strncpy(tasks[i].name, pcTaskGetName(self), TRACE_NAME_LEN - 1);
+    tasks[i].name[TRACE_NAME_LEN - 1] = '\0';
+    taskCount.store(n + 1, std::memory_order_release);
+  }
+  portEXIT_CRITICAL(&taskMux);
+  // Tabel penuh: digabung ke task terakhir
+  return i < TRACE_TASKS ? i : TRACE_TASKS - 1;
+}
+
+static void record(TraceRing &ring, const char *name, char phase,
+                   uint32_t cycles, uint32_t tick) {
+  if (paused)
+    return;
+  TraceEvent &e =
+      ring.events[ring.head.fetch_add(1, std::memory_order_relaxed) &
+                  ring.mask];
+  e.name = name;
+  e.cycles = cycles;
+  e.tick = tick;
+  e.task = taskIndex();
+  e.phase = phase;
+}
+
+static inline void record(const char *name, char phase) {
+  record(mainRing, name, phase, ESP.getCycleCount(), xTaskGetTickCount());
+}
+
+#if TRACE_ENABLED
+void traceBegin(const char *name) { record(name, 'B'); }
+void traceEnd(const char *name) { record(name, 'E'); }
+
+TraceMark traceMark() { return {ESP.getCycleCount(), xTaskGetTickCount()}; }
+
+// Event B masuk ring sesudah event lain yang terjadi selama span;
+// trace2json mengurutkan ulang berdasarkan waktu
+void traceSpanSince(const char *name, const TraceMark &since) {
+  record(mainRing, name, 'B', since.cycles, since.tick);
+  record(name, 'E');
+}
+
+void traceFrequentSince(const char *name, const TraceMark &since) {
+  record(frequentRing, name, 'B', since.cycles, since.tick);
+  record(frequentRing, name, 'E', ESP.getCycleCount(), xTaskGetTickCount());
+}
+#endif
+
+void traceInit() {
+  uint32_t start = ESP.getCycleCount();
+  for (uint8_t i = 0; i < TRACE_CALIBRATE_SPANS; i++) {
+    record("calibrate", 'B');
+    record("calibrate", 'E');
+  }
+  spanCycles = (ESP.getCycleCount() - start) / TRACE_CALIBRATE_SPANS;
+  mainRing.head.store(0, std::memory_order_relaxed);
+}
+
+// Return jumlah event yang sudah tertimpa
+static uint32_t dumpRing(Print &out, const TraceRing &ring) {
+  uint32_t end = ring.head.load(std::memory_order_relaxed);
+  uint32_t start = end > ring.mask + 1 ? end - ring.mask - 1 : 0;
+  for (uint32_t i = start; i < end; i++) {
+    const TraceEvent &e = ring.events[i & ring.mask];
+    out.printf("%c %u %lu %lu %s\n", e.phase, e.task, (unsigned long)e.cycles,
+               (unsigned long)e.tick, e.name);
+  }
+  return start;
+}
+
+// Ring kedua ditulis sesudah ring utama; trace2json mengurutkan ulang
+// berdasarkan waktu
+void traceDump(Print &out) {
+  paused = true;
+  out.printf("# axiom trace 1\ncpu_mhz %lu\nspan_cycles %lu\n",
+             (unsigned long)ESP.getCpuFreqMHz(), (unsigned long)spanCycles);
+  uint8_t n = taskCount.load(std::memory_order_acquire);
+  for (uint8_t i = 0; i < n; i++)
+    out.printf("task %u %u %s\n", i, tasks[i].core, tasks[i].name);
+  uint32_t dropped = dumpRing(out, mainRing);
+  dropped += dumpRing(out, frequentRing);
+  out.printf("dropped %lu\n", (unsigned long)dropped);
+  paused = false;
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <Arduino.h>
+
+// ================== TRACE ==================
+// Span begin/end dicatat dengan cycle counter CPU ke ring buffer tetap,
+// untuk melihat ke mana waktu sebuah scan pergi (sensor, TLS, layar,
+// flash). Satu event: baca CCOUNT + tick FreeRTOS, satu fetch_add atomik,
+// simpan 16 byte. Target < 1 us per span (begin + end); biaya nyata
+// diukur di traceInit() dan ikut di dump ("span_cycles"). Event tertua
+// ditimpa kalau ring penuh.
+//
+// CCOUNT per core dan wrap tiap ~17.9 s; tick 1 ms ikut dicatat supaya
+// tools/trace2json bisa menyambung wrap dan menyelaraskan kedua core.
+//
+//   TRACE_SPAN("saveAttendance");       // sampai akhir scope
+//   traceBegin("image2Tz"); ...; traceEnd("image2Tz");
+//
+// Dump lewat serial (kirim 't') atau GET /trace, lalu di host:
+//   trace2json dump.txt > trace.json    // buka di ui.perfetto.dev
+
+#ifndef TRACE_ENABLED
+#define TRACE_ENABLED 1
+#endif
+#define TRACE_RING 1024 // event, pangkat dua
+// Ring terpisah untuk span periodik yang sangat sering (frame TFT), supaya
+// tidak menggeser event scan keluar dari ring utama
+#define TRACE_RING_FREQUENT 256
+#define TRACE_TASKS 8   // task berbeda yang bisa muncul di trace
+
+struct TraceMark {
+  uint32_t cycles;
+  uint32_t tick;
+};
+
+#if TRACE_ENABLED
+
+// name harus string literal (yang disimpan hanya pointernya)
+void traceBegin(const char *name);
+void traceEnd(const char *name);
+
+// Untuk operasi yang baru ketahuan layak dicatat setelah selesai (mis.
+// getImage yang ternyata menemukan jari): ambil mark sebelum, lalu catat
+// span [mark, sekarang]. Poll yang tidak dicatat tidak mengisi ring.
+TraceMark traceMark();
+void traceSpanSince(const char *name, const TraceMark &since);
+// Sama, ke ring TRACE_RING_FREQUENT
+void traceFrequentSince(const char *name, const TraceMark &since);
+
+class TraceSpan {
+public:
+  explicit TraceSpan(const char *name) : name_(name) { traceBegin(name); }
+  ~TraceSpan() { traceEnd(name_); }
+
+private:
+  const char *name_;
+};
+
+#define TRACE_CAT_(a, b) a##b
+#define TRACE_CAT(a, b) TRACE_CAT_(a, b)
+#define TRACE_SPAN(name) TraceSpan TRACE_CAT(traceSpan_, __LINE__)(name)
+
+#else
+
+inline void traceBegin(const char *) {}
+inline void traceEnd(const char *) {}
+inline TraceMark traceMark() { return TraceMark(); }
+inline void traceSpanSince(const char *, const TraceMark &) {}
+inline void traceFrequentSince(const char *, const TraceMark &) {}
+#define TRACE_SPAN(name) ((void)0)
+
+#endif
+
+// Ukur overhead span; dipanggil sekali di setup()
+void traceInit();
+// Isi ring, tertua dulu, dalam format teks yang dibaca tools/trace2json.
+// Perekaman berhenti selama dump.
+void traceDump(Print &out);
@@ -0,0 +1,169 @@
+#include "Uploader.h"
+
+#include <RTClib.h>
+#include <WiFi.h>
+
+#include "ApiClient.h"
+#include "Metrics.h"
+#include "Outbox.h"
+#include "Trace.h"
+
+#define UPLOAD_TASK_CORE 0
+#define UPLOAD_TASK_STACK 8192
+#define UPLOAD_TASK_PRIO 1
+#define UPLOAD_IDLE_MS 10000
+#define UPLOAD_BACKOFF_MIN_MS 2000
+#define UPLOAD_BACKOFF_MAX_MS 60000
+// Snapshot metrik ringkas (metricsCompact) ikut di header x-device-metrics
+// setiap upload; server hanya mencatatnya ke log. 0 = tidak dikirim.
+#define UPLOAD_METRICS 1
+
+// Panjang maksimum satu record di payload, termasuk koma:
+// ,{"uid":65535,"timestamp":"2026-01-01T00:00:00.000Z","seq":4294967295}
+#define UPLOAD_RECORD_JSON 73
+
+static SemaphoreHandle_t kickSem = nullptr;
+
+// Payload ditulis langsung ke buffer statis ini (hanya dipakai upload
+// task). Bentuknya tetap dan semua nilainya angka, jadi tidak perlu
+// JsonDocument maupun String yang ukurannya beda-beda tiap batch dan lama
+// kelamaan memecah heap.
+static char payload[UPLOAD_BATCH * UPLOAD_RECORD_JSON + 3];
+#if UPLOAD_METRICS
+static char metrics[192];
+#endif
+// MAC + epoch outbox, lihat outboxEpoch()
+static char deviceId[24];
+
+// Batch dibagi dua setiap kali ditolak permanen, sampai record yang
+// ditolak tinggal sendiri dan dibuang; kembali penuh setelah batch lolos
+static size_t batchLimit = UPLOAD_BATCH;
+
+enum UploadResult {
+  UPLOAD_OK,       // seluruh batch final (tersimpan, duplikat, atau ditolak
+                   // per record di dalam jawaban 2xx)
+  UPLOAD_REJECTED, // batch ditolak permanen (4xx selain retryable4xx())
+  UPLOAD_RETRY,    // jaringan, 5xx, atau 4xx yang bisa sembuh sendiri
+};
+
+static size_t buildPayload(const OutboxRecord *recs, size_t n) {
+  size_t len = 0;
+  payload[len++] = '[';
+  for (size_t i = 0; i < n; i++) {
+    DateTime t(recs[i].unixtime);
+    len += snprintf(payload + len, sizeof(payload) - len,
+                    "%s{\"uid\":%u,\"timestamp\":\"%04d-%02d-%02dT%02d:%02d:"
+                    "%02d.000Z\",\"seq\":%lu}",
+                    i ? "," : "", (unsigned)recs[i].uid, t.year(), t.month(),
+                    t.day(), t.hour(), t.minute(), t.second(),
+                    (unsigned long)recs[i].seq);
+  }
+  payload[len++] = ']';
+  payload[len] = '\0';
+  return len;
+}
+
+// 4xx yang bukan salah isi batch: kunci API / route salah konfigurasi
+// (401, 403, 404), timeout, atau rate limit. Dicoba lagi nanti.
+static bool retryable4xx(int httpCode) {
+  return httpCode == 401 || httpCode == 403 || httpCode == 404 ||
+         httpCode == 408 || httpCode == 425 || httpCode == 429;
+}
+
+// Satu POST berisi array JSON [{uid, timestamp, seq}, ...] dengan header
+// x-device-id. Server melewati record yang (device, seq)-nya sudah
+// tersimpan, jadi batch yang terkirim ulang karena ack hilang tidak
+// tercatat dua kali. Server menjawab hasil per record; 2xx berarti seluruh
+// batch sudah final. 4xx lain (400, 413, 422, ...) berarti batch-nya tidak
+// akan pernah diterima apa adanya.
+static UploadResult uploadBatch(const OutboxRecord *recs, size_t n) {
+  TRACE_SPAN("uploadBatch");
+  size_t len = buildPayload(recs, n);
+
+  if (!deviceId[0]) {
+    String mac = WiFi.macAddress();
+    size_t at = 0;
+    for (const char *p = mac.c_str(); *p && at < 12; p++)
+      if (*p != ':')
+        deviceId[at++] = *p;
+    snprintf(deviceId + at, sizeof(deviceId) - at, "-%08lx",
+             (unsigned long)outboxEpoch());
+  }
+#if UPLOAD_METRICS
+  metricsCompact(metrics, sizeof(metrics));
+  ApiHeader extra[] = {{"x-device-id", deviceId},
+                       {"x-device-metrics", metrics},
+                       {nullptr, nullptr}};
+#else
+  ApiHeader extra[] = {{"x-device-id", deviceId}, {nullptr, nullptr}};
+#endif
+  int httpCode = apiPost("/api/ingest", payload, len, nullptr, extra);
+  ApiStats st = apiStats();
+  Serial.printf("HTTP Response: %d (%u record, %u ms, avg %u ms, %u/%u "
+                "handshake)\n",
+                httpCode, (unsigned)n, (unsigned)st.lastMs, (unsigned)st.avgMs,
+                (unsigned)st.connects, (unsigned)st.requests);
+
+  if (httpCode >= 200 && httpCode < 300)
+    return UPLOAD_OK;
+  if (httpCode >= 400 && httpCode < 500 && !retryable4xx(httpCode))
+    return UPLOAD_REJECTED;
+  return UPLOAD_RETRY;
+}
+
+static void uploadTask(void *) {
+  OutboxRecord batch[UPLOAD_BATCH];
+  uint32_t backoff = UPLOAD_BACKOFF_MIN_MS;
+  uint32_t wait = 0;
+
+  for (;;) {
+    xSemaphoreTake(kickSem, pdMS_TO_TICKS(wait));
+
+    if (outboxPending() == 0 || WiFi.status() != WL_CONNECTED) {
+      wait = UPLOAD_IDLE_MS;
+      continue;
+    }
+
+    size_t n = outboxPeek(batch, batchLimit);
+    UploadResult res = uploadBatch(batch, n);
+    size_t done = 0;
+    if (res == UPLOAD_OK) {
+      done = n;
+      batchLimit = UPLOAD_BATCH;
+    } else if (res == UPLOAD_REJECTED && n > 1) {
+      // Cari record penyebabnya tanpa membuang record lain yang valid
+      batchLimit = n / 2;
+      Serial.printf("Outbox: batch %u record ditolak, dicoba %u\n",
+                    (unsigned)n, (unsigned)batchLimit);
+    } else if (res == UPLOAD_REJECTED) {
+      done = 1;
+      Serial.printf("Outbox: record uid %u seq %lu ditolak server, dibuang\n",
+                    (unsigned)batch[0].uid, (unsigned long)batch[0].seq);
+    }
+    traceBegin("outboxCommit");
+    outboxCommit(done);
+    traceEnd("outboxCommit");
+
+    if (res == UPLOAD_RETRY) {
+      // Server / jaringan bermasalah: mundur eksponensial
+      wait = backoff;
+      backoff *= 2;
+      if (backoff > UPLOAD_BACKOFF_MAX_MS)
+        backoff = UPLOAD_BACKOFF_MAX_MS;
+    } else {
+      backoff = UPLOAD_BACKOFF_MIN_MS;
+      wait = outboxPending() ? 0 : UPLOAD_IDLE_MS;
+    }
+  }
+}
+
+void uploaderBegin() {
+  kickSem = xSemaphoreCreateBinary();
+  xTaskCreatePinnedToCore(uploadTask, "upload", UPLOAD_TASK_STACK, nullptr,
+                          UPLOAD_TASK_PRIO, nullptr, UPLOAD_TASK_CORE);
+}
+
+void uploaderKick() {
+  if (kickSem)
+    xSemaphoreGive(kickSem);
+}
@@ -0,0 +1,15 @@
+#pragma once
+
+#include <Arduino.h>
+
+// ================== UPLOADER ==================
+// Task background yang menguras outbox ke API per batch. Cursor outbox
+// hanya maju untuk record yang sudah dijawab server.
+
+#define UPLOAD_BATCH 32
+
+// apiBegin() harus sudah dipanggil
+void uploaderBegin();
+
+// Bangunkan uploader sekarang (ada record baru / sync manual)
+void uploaderKick();
@@ -0,0 +1,187 @@
+#include "Widgets.h"
+
+// ================== HEADER ==================
+void HeaderWidget::render(TFT_eSprite &spr, int16_t oy) {
+  spr.fillSprite(0x2104);
+  spr.fillRoundRect(5, 5 - oy, 40, 40, 8, TFT_CYAN);
+  spr.setTextColor(TFT_WHITE);
+  spr.setCursor(12, 18 - oy);
+  spr.setTextSize(2);
+  spr.print("AX");
+  spr.setTextSize(1);
+  spr.setTextDatum(MC_DATUM);
+  spr.drawString("AXIOM ID", 140, 25 - oy, 2);
+}
+
+// ================== JAM ==================
+void ClockWidget::set(const DateTime &now) {
+  if (now.hour() == hour && now.minute() == minute)
+    return;
+  hour = now.hour();
+  minute = now.minute();
+  invalidate(5, 0, 200, h); // area digit HH:MM
+}
+
+void ClockWidget::render(TFT_eSprite &spr, int16_t oy) {
+  spr.fillSprite(TFT_BLACK);
+  if (hour < 0)
+    return;
+  char hmBuf[12];
+  sprintf(hmBuf, "%02d:%02d", hour, minute);
+  spr.setTextColor(0x07FF, TFT_BLACK);
+  spr.setTextDatum(MC_DATUM);
+  spr.setTextSize(3); // Font 4 with size 3
+  spr.drawString(hmBuf, 105, 48 - oy, 4);
+  spr.setTextSize(1);
+}
+
+void SecondsWidget::set(const DateTime &now) {
+  if (now.second() == second)
+    return;
+  second = now.second();
+  invalidate(100, 0, 40, h); // ":SS" saja
+}
+
+void SecondsWidget::render(TFT_eSprite &spr, int16_t oy) {
+  spr.fillSprite(TFT_BLACK);
+  if (second < 0)
+    return;
+  char secBuf[12];
+  sprintf(secBuf, ":%02d", second);
+  spr.setTextColor(TFT_CYAN, TFT_BLACK);
+  spr.setTextDatum(MC_DATUM);
+  spr.drawString(secBuf, 120, 9 - oy, 2);
+}
+
+// ================== STATUS BOX ==================
+void StatusWidget::set(const String &t, uint16_t b, uint16_t f) {
+  if (t == text && b == bg && f == fg)
+    return;
+  text = t;
+  bg = b;
+  fg = f;
+  invalidate(0, 0, w, 56);
+}
+
+void StatusWidget::setSensorError(bool err) {
+  if (err == sensorError)
+    return;
+  sensorError = err;
+  invalidate(0, 56, w, 12);
+}
+
+void StatusWidget::render(TFT_eSprite &spr, int16_t oy) {
+  spr.fillSprite(TFT_BLACK);
+  spr.fillRoundRect(5, 4 - oy, 230, 50, 10, bg);
+  spr.setTextColor(fg, bg);
+  spr.setTextDatum(MC_DATUM);
+  spr.drawString(text, 120, 29 - oy, 4);
+  if (sensorError) {
+    spr.setTextColor(TFT_RED, TFT_BLACK);
+    spr.drawString("-- SENSOR ERROR --", 120, 62 - oy, 1);
+  }
+}
+
+// ================== WIFI ==================
+void WifiWidget::set(bool on, const String &addr) {
+  if (on == online && addr == ip)
+    return;
+  online = on;
+  ip = addr;
+  invalidate();
+}
+
+void WifiWidget::render(TFT_eSprite &spr, int16_t oy) {
+  spr.fillSprite(TFT_BLACK);
+  if (online < 0)
+    return;
+  spr.setTextDatum(BL_DATUM);
+  if (online) {
+    spr.setTextColor(TFT_YELLOW, TFT_BLACK);
+    spr.drawString(ip, 5, 21 - oy, 2);
+  } else {
+    spr.setTextColor(TFT_DARKGREY, TFT_BLACK);
+    spr.drawString("no-ip", 5, 21 - oy, 2);
+  }
+  spr.setTextDatum(BR_DATUM);
+  spr.setTextColor(online ? TFT_GREEN : TFT_RED, TFT_BLACK);
+  spr.drawString(online ? "ONLINE" : "OFFLINE", 235, 21 - oy, 2);
+}
+
+// ================== PESAN LAYAR PENUH ==================
+void MessageWidget::set(uint16_t b, const String &m, int i) {
+  bg = b;
+  msg = m;
+  id = i;
+  invalidate();
+}
+
+void MessageWidget::render(TFT_eSprite &spr, int16_t oy) {
+  spr.fillSprite(bg);
+  spr.setTextColor(TFT_BLACK);
+  spr.setTextDatum(MC_DATUM);
+  spr.drawString(msg, 120, 100 - oy, 4);
+  if (id > 0)
+    spr.drawString("ID " + String(id), 120, 145 - oy, 2);
+}
+
+// ================== HALAMAN ADMIN ==================
+void TextPageWidget::clear() {
+  for (Line &l : lines)
+    l = Line();
+  invalidate();
+}
+
+void TextPageWidget::invalidateLine(const Line &l) {
+  if (l.text.length())
+    invalidate(0, l.y - 16, w, 32); // font 4 setinggi 26 piksel
+}
+
+void TextPageWidget::setLine(uint8_t i, const String &text, int16_t y,
+                             uint8_t font) {
+  if (i >= TEXT_PAGE_LINES)
+    return;
+  Line &l = lines[i];
+  if (l.text == text && l.y == y && l.font == font)
+    return;
+  invalidateLine(l);
+  l.text = text;
+  l.y = y;
+  l.font = font;
+  invalidateLine(l);
+}
+
+void TextPageWidget::render(TFT_eSprite &spr, int16_t oy) {
+  spr.fillSprite(TFT_BLACK);
+  spr.setTextColor(TFT_WHITE, TFT_BLACK);
+  spr.setTextDatum(MC_DATUM);
+  for (const Line &l : lines)
+    if (l.text.length())
+      spr.drawString(l.text, 120, l.y - oy, l.font);
+}
+
+void MenuWidget::set(const char *const *it, uint8_t n, uint8_t sel) {
+  if (it != items || n != count) {
+    items = it;
+    count = n;
+    selected = sel;
+    invalidate();
+    return;
+  }
+  if (sel == selected)
+    return;
+  invalidateItem(selected);
+  selected = sel;
+  invalidateItem(selected);
+}
+
+void MenuWidget::render(TFT_eSprite &spr, int16_t oy) {
+  spr.fillSprite(TFT_BLACK);
+  spr.setTextDatum(MC_DATUM);
+  for (uint8_t i = 0; i < count; i++) {
+    uint16_t bg = i == selected ? 0x5DFF : 0x2104;
+    spr.fillRoundRect(15, 70 + i * 50 - oy, 210, 40, 8, bg);
+    spr.setTextColor(TFT_WHITE, bg);
+    spr.drawString(items[i], 120, 90 + i * 50 - oy, 2);
+  }
+}
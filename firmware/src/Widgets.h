@@ -0,0 +1,110 @@
+#pragma once
+
+#include <RTClib.h>
+
+#include "Screen.h"
+
+// ================== WIDGET STANDBY ==================
+// Tata letak standby menutup layar penuh (240x240) tanpa celah:
+//   header 0-49, jam 50-125, detik 126-145, status 146-213, wifi 214-239
+
+class HeaderWidget : public Widget {
+public:
+  HeaderWidget() : Widget(0, 0, 240, 50) {}
+  void render(TFT_eSprite &spr, int16_t oy) override;
+};
+
+class ClockWidget : public Widget {
+public:
+  ClockWidget() : Widget(0, 50, 240, 76) {}
+  void set(const DateTime &now);
+  void render(TFT_eSprite &spr, int16_t oy) override;
+
+private:
+  int8_t hour = -1, minute = -1;
+};
+
+class SecondsWidget : public Widget {
+public:
+  SecondsWidget() : Widget(0, 126, 240, 20) {}
+  void set(const DateTime &now);
+  void render(TFT_eSprite &spr, int16_t oy) override;
+
+private:
+  int8_t second = -1;
+};
+
+class StatusWidget : public Widget {
+public:
+  StatusWidget() : Widget(0, 146, 240, 68) {}
+  void set(const String &text, uint16_t bg, uint16_t fg);
+  void setSensorError(bool err);
+  void render(TFT_eSprite &spr, int16_t oy) override;
+
+private:
+  String text;
+  uint16_t bg = 0, fg = 0;
+  bool sensorError = false;
+};
+
+class WifiWidget : public Widget {
+public:
+  WifiWidget() : Widget(0, 214, 240, 26) {}
+  void set(bool online, const String &ip);
+  void render(TFT_eSprite &spr, int16_t oy) override;
+
+private:
+  int8_t online = -1;
+  String ip;
+};
+
+// Layar penuh untuk flashScreen()
+class MessageWidget : public Widget {
+public:
+  MessageWidget() : Widget(0, 0, 240, 240) {}
+  void set(uint16_t bg, const String &msg, int id);
+  void render(TFT_eSprite &spr, int16_t oy) override;
+
+private:
+  uint16_t bg = 0;
+  String msg;
+  int id = 0;
+};
+
+// ================== WIDGET ADMIN ==================
+// Halaman PIN, enroll, hapus dan sync: layar hitam penuh dengan beberapa
+// baris teks di tengah. Hanya baris yang berubah yang digambar ulang.
+#define TEXT_PAGE_LINES 3
+
+class TextPageWidget : public Widget {
+public:
+  TextPageWidget() : Widget(0, 0, 240, 240) {}
+  // Kosongkan semua baris sebelum halaman baru dipasang
+  void clear();
+  // Baris i, rata tengah di y
+  void setLine(uint8_t i, const String &text, int16_t y, uint8_t font);
+  void render(TFT_eSprite &spr, int16_t oy) override;
+
+private:
+  struct Line {
+    String text;
+    int16_t y = 0;
+    uint8_t font = 2;
+  };
+  void invalidateLine(const Line &l);
+  Line lines[TEXT_PAGE_LINES];
+};
+
+// Menu admin: tombol bulat bertumpuk, yang terpilih berwarna
+class MenuWidget : public Widget {
+public:
+  MenuWidget() : Widget(0, 0, 240, 240) {}
+  void set(const char *const *items, uint8_t count, uint8_t selected);
+  void render(TFT_eSprite &spr, int16_t oy) override;
+
+private:
+  void invalidateItem(int8_t i) { invalidate(15, 70 + i * 50, 210, 40); }
+  const char *const *items = nullptr;
+  uint8_t count = 0;
+  int8_t selected = -1;
+};
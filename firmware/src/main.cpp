@@ -14,12 +14,32 @@
 #include <WiFiUdp.h>
 #include <Wire.h>
 
+#include "ApiClient.h"
+#include "Boot.h"
+#include "Clock.h"
+#include "Connectivity.h"
+#include "Events.h"
+#include "History.h"
+#include "Metrics.h"
+#include "Outbox.h"
+#include "ScanTask.h"
+#include "TemplateStore.h"
+#include "TemplateSync.h"
+#include "Trace.h"
+#include "Uploader.h"
+#include "Widgets.h"
+
 // ================== KONFIGURASI ==================
 const char *WIFI_SSID = "realme GT Neo2 5G";
 const char *WIFI_PASSWORD = "Nyorean9";
-const char *API_URL = "https://axiom-pearl-six.vercel.app/api/ingest";
+// IP statis opsional (0.0.0.0 = DHCP)
+const IPAddress WIFI_STATIC_IP(0, 0, 0, 0);
+const IPAddress WIFI_GATEWAY(0, 0, 0, 0);
+const IPAddress WIFI_SUBNET(255, 255, 255, 0);
+const char *API_BASE = "https://axiom-pearl-six.vercel.app";
 const char *API_KEY = "AxiomSecure_2026_Key";
 #define PIN_ADMIN "1212"
+#define GMT_OFFSET_SEC 25200 // WIB
 
 // ================== PIN MAPPING ==================
 #define PIN_UP 33
@@ -36,46 +56,129 @@ TFT_eSPI tft = TFT_eSPI();
 RTC_DS3231 rtc;
 HardwareSerial mySerial(2);
 Adafruit_Fingerprint finger = Adafruit_Fingerprint(&mySerial);
-WiFiClientSecure client;
-
-enum AppState { STANDBY, INPUT_PIN, MENU, ENROLL, DELETE };
+Screen screen(&tft);
+HeaderWidget headerWidget;
+ClockWidget clockWidget;
+SecondsWidget secondsWidget;
+StatusWidget statusWidget;
+WifiWidget wifiWidget;
+MessageWidget messageWidget;
+TextPageWidget textPage;
+MenuWidget menuWidget;
+Widget *standbyPage[] = {&headerWidget, &clockWidget, &secondsWidget,
+                         &statusWidget, &wifiWidget};
+
+// MESSAGE: layar hasil (flashScreen) sampai timer-nya habis
+// SYNC: menunggu outbox terkirim setelah long press UP
+enum AppState { STANDBY, INPUT_PIN, MENU, ENROLL, DELETE, MESSAGE, SYNC };
 AppState state = STANDBY;
+AppState afterMessage = STANDBY;
 bool isFirstEntry = true;
 bool sensorDetected = false;
+bool isScanning = false;
 
 String statusAbsen[] = {"Check-In", "Check-Out", "Lembur"};
 int currentStatusIdx = 0;
 int menuIdx = 0;
-unsigned long lastActivity = 0;
-unsigned long lastScanTime = 0;
 bool isLcdOn = true;
+bool clockDue = true;
+volatile bool netServicesReady = false; // OTA + /metrics, ditulis task boot
+TimerId backlightTimer = TIMER_NONE;
+TimerId messageTimer = TIMER_NONE;
+TimerId buzzerTimer = TIMER_NONE;
+
+#define BACKLIGHT_TIMEOUT_MS 300000
+#define MESSAGE_MS 1500
+#define CLOCK_REFRESH_MS 250
+#define LOOP_IDLE_MS 10
+// Dua strip lebar penuh (240 x 10 x 2 masing-masing), ~3 ms SPI di
+// 27 MHz; strip kedua dirender selagi DMA mengirim yang pertama
+#define SCREEN_UPDATE_BYTES 9600
+// Iterasi yang sudah sesibuk ini (mis. scan menulis ke flash) menunda
+// strip ke iterasi berikutnya, supaya tidak lewat LOOP_SLOW_US
+#define SCREEN_DEFER_AFTER_US 1000
+#define SYNC_TIMEOUT_MS 15000
+#define ENROLL_TIMEOUT_MS 10000
+#define ENROLL_RETRY_MS 50
+#define ENROLL_PAUSE_MS 1000
 int lastFingerID = -1;
 unsigned long lastFingerTime = 0;
 
+// ================== METRICS ==================
+// Nilai yang sudah dihitung modul lain, dibaca saat scrape /metrics.
+// Latency scan dan HTTP dicatat di ScanTask.cpp dan ApiClient.cpp.
+Gauge heapFree("axiom_heap_free_bytes", "Heap bebas",
+               [] { return (int32_t)ESP.getFreeHeap(); }, "heap");
+Gauge heapMinFree("axiom_heap_min_free_bytes", "Heap bebas terendah sejak boot",
+                  [] { return (int32_t)ESP.getMinFreeHeap(); });
+Gauge heapMaxBlock("axiom_heap_max_block_bytes", "Blok heap bebas terbesar",
+                   [] { return (int32_t)ESP.getMaxAllocHeap(); }, "blk");
+Gauge outboxDepth("axiom_outbox_pending", "Absen di outbox belum terupload",
+                  [] { return (int32_t)outboxPending(); }, "outbox");
+Gauge uptime("axiom_uptime_seconds", "Detik sejak boot",
+             [] { return (int32_t)(millis() / 1000); }, "up");
+Gauge loopBusyMax("axiom_loop_busy_max_us", "Iterasi loop() terlama",
+                  [] { return (int32_t)loopStats().maxUs; }, "loop");
+Counter loopSlow("axiom_loop_slow_total", "Iterasi loop() > LOOP_SLOW_US",
+                 [] { return (int32_t)loopStats().slow; });
+Gauge wifiRssi("axiom_wifi_rssi_dbm", "RSSI AP",
+               [] { return (int32_t)WiFi.RSSI(); }, "rssi");
+Counter wifiDrops("axiom_wifi_drops_total", "Link WiFi putus",
+                  [] { return (int32_t)netStats().drops; }, "drops");
+Counter tlsHandshakes("axiom_tls_handshakes_total", "Handshake TLS baru",
+                      [] { return (int32_t)apiStats().connects; }, "tls");
+Counter httpFailures("axiom_http_failures_total",
+                     "Request backend tanpa jawaban HTTP",
+                     [] { return (int32_t)apiStats().failures; });
+Counter fallbackCandidates(
+    "axiom_template_fallback_candidates_total",
+    "Template dicocokkan 1:1 lewat fallback",
+    [] { return (int32_t)templateFallbackStats().candidates; });
+Counter fallbackCutoffs("axiom_template_fallback_cutoff_total",
+                        "Fallback berhenti di TEMPLATE_FALLBACK_MS",
+                        [] { return (int32_t)templateFallbackStats().cutoffs; });
+Counter templateRefusedCounter(
+    "axiom_template_refused_total",
+    "Enroll/sync ditolak karena template store penuh",
+    [] { return (int32_t)templateRefused(); });
+Gauge templatesGauge("axiom_templates", "Template di store",
+                     [] { return (int32_t)templateCount(); });
+Gauge clockLockedGauge("axiom_clock_locked", "1 = jam terkunci ke SQW DS3231",
+                       [] { return (int32_t)clockLocked(); });
+
 // ================== PROTOTYPE ==================
 void runStandby();
 void runInputPin();
 void runMenu();
 void runEnroll();
 void runDelete();
+void runSync();
 void changeState(AppState newState);
-void flashScreen(uint16_t warna, String msg, int id);
+void flashScreen(uint16_t warna, String msg, int id, AppState next);
 void playBuzzer(int p);
 void wakeUpLcd();
-void updateRTCfromNTP();
-void sendDataToAPI(int id, String status);
+void handleButton(const ButtonEvent &evt);
+void onNetworkUp();
+void onBootBackground();
+void onNetState(NetState s);
+bool saveAttendance(int id, int statusIdx);
+void importLegacyOffline();
 void syncOfflineData();
-bool waitFinger(uint8_t target, uint32_t timeout = 10000);
+void handleScanEvent(const ScanEvent &evt);
 
 // ================== SETUP ==================
+// setup() hanya menunggu yang dibutuhkan untuk scan. WiFi, OTA dan NTP naik
+// di background (Connectivity.h, Boot.h); absen sebelum online masuk outbox
+// seperti biasa.
 void setup() {
   Serial.begin(115200);
   mySerial.begin(57600, SERIAL_8N1, FP_RX, FP_TX);
   Wire.begin(I2C_SDA, I2C_SCL);
 
-  pinMode(PIN_UP, INPUT_PULLUP);
-  pinMode(PIN_DOWN, INPUT_PULLUP);
-  pinMode(PIN_OK, INPUT_PULLUP);
+  eventsBegin();
+  traceInit();
+  const uint8_t buttonPins[BTN_COUNT] = {PIN_UP, PIN_DOWN, PIN_OK};
+  buttonsBegin(buttonPins);
   pinMode(PIN_BUZZER, OUTPUT);
   pinMode(LED_HIJAU, OUTPUT);
   digitalWrite(LED_HIJAU, HIGH);
@@ -87,116 +190,127 @@ void setup() {
   tft.setTextDatum(MC_DATUM);
   tft.drawString("AXIOM BOOTING", 120, 80, 4);
 
+  if (!screen.begin())
+    Serial.println("Screen: heap tidak cukup untuk strip sprite");
+  bootStage("display");
+
   LittleFS.begin(true);
+  outboxBegin();
+  historyBegin();
+  importLegacyOffline();
+  bootStage("storage");
   rtc.begin();
+  clockBegin(rtc);
+  bootStage("rtc");
 
   // Cek Sensor
-  if (finger.verifyPassword()) {
-    sensorDetected = true;
-    tft.setTextColor(TFT_GREEN);
-    tft.drawString("SENSOR OK!", 120, 120, 2);
-  } else {
-    sensorDetected = false;
-    tft.setTextColor(TFT_RED);
-    tft.drawString("SENSOR ERROR!", 120, 120, 2);
+  sensorDetected = finger.verifyPassword();
+  if (!sensorDetected)
     playBuzzer(2);
+  bootStage("sensor");
+
+  apiBegin(API_BASE, API_KEY);
+  uploaderBegin();
+  if (sensorDetected) {
+    // Index dari flash saja; impor library sensor di task boot
+    templateStoreBegin(&finger);
+    scanTaskBegin(&finger);
   }
-  delay(1000);
-
-  // WiFi
-  tft.fillRect(0, 150, 240, 50, TFT_BLACK);
-  tft.setTextColor(TFT_WHITE);
-  tft.drawString("WiFi: CONNECTING...", 120, 170, 2);
-
-  WiFi.mode(WIFI_STA);
-  WiFi.begin(WIFI_SSID, WIFI_PASSWORD);
-  unsigned long startWiFi = millis();
-  while (WiFi.status() != WL_CONNECTED && millis() - startWiFi < 8000) {
-    delay(500);
-    Serial.print(".");
+  timerEvery(CLOCK_REFRESH_MS, [](void *) { clockDue = true; });
+  wakeUpLcd();
+  changeState(STANDBY);
+  bootStage("scan");
+
+  netBegin({WIFI_SSID, WIFI_PASSWORD, WIFI_STATIC_IP, WIFI_GATEWAY, WIFI_SUBNET},
+           onNetState);
+  bootNetBegin({GMT_OFFSET_SEC, onNetworkUp, onBootBackground});
+}
+
+// Dari task boot, scan sudah aktif. Boot pertama mengimpor library sensor
+// ke template store (~25 s untuk 160 template); sampai selesai scan hanya
+// memakai fingerFastSearch, dan template sync menunggu supaya tidak
+// memasang template ke page yang belum terimpor.
+void onBootBackground() {
+  if (!sensorDetected)
+    return;
+  templateStoreImport();
+  bootStage("template");
+  templateSyncBegin();
+}
+
+// ================== NETWORK ==================
+// Dari task wifi setiap kali tersambung (boot atau reconnect): uploader dan
+// template sync dibangunkan, tidak menunggu interval berikutnya.
+void onNetState(NetState s) {
+  if (s == NET_CONNECTED) {
+    uploaderKick();
+    templateSyncKick();
   }
+}
 
-  if (WiFi.status() == WL_CONNECTED) {
-    tft.fillRect(0, 150, 240, 50, TFT_BLACK);
-    tft.setTextColor(TFT_GREEN);
-    tft.drawString("CONNECTED!", 120, 170, 2);
-
-    // Setup OTA
-    ArduinoOTA.setHostname("axiom-esp32");
-    ArduinoOTA.setPassword("admin"); // Password untuk upload OTA
-
-    ArduinoOTA.onStart([]() {
-      String type =
-          (ArduinoOTA.getCommand() == U_FLASH) ? "sketch" : "filesystem";
-      tft.fillScreen(TFT_BLACK);
-      tft.setTextColor(TFT_YELLOW);
-      tft.drawString("UPDATING...", 120, 120, 4);
-    });
-
-    ArduinoOTA.onEnd([]() {
-      tft.fillScreen(TFT_BLACK);
-      tft.setTextColor(TFT_GREEN);
-      tft.drawString("UPDATE SUKSES", 120, 120, 4);
-      delay(1000);
-    });
-
-    ArduinoOTA.onProgress([](unsigned int progress, unsigned int total) {
-      tft.fillRect(20, 140, 200, 20, TFT_BLACK);
-      int barWidth = (progress / (total / 100)) * 2;
-      tft.drawRect(20, 140, 200, 20, TFT_WHITE);
-      tft.fillRect(20, 140, barWidth, 20, TFT_GREEN);
-    });
-
-    ArduinoOTA.onError([](ota_error_t error) {
-      tft.fillScreen(TFT_BLACK);
-      tft.setTextColor(TFT_RED);
-      tft.drawString("UPDATE GAGAL", 120, 120, 4);
-      delay(2000);
-    });
-
-    ArduinoOTA.begin();
+// Dari task boot setelah tersambung pertama kali. handle() di loop() baru
+// jalan setelah netServicesReady.
+void onNetworkUp() {
+  ArduinoOTA.setHostname("axiom-esp32");
+  ArduinoOTA.setPassword("admin"); // Password untuk upload OTA
 
+  ArduinoOTA.onStart([]() {
+    String type =
+        (ArduinoOTA.getCommand() == U_FLASH) ? "sketch" : "filesystem";
+    tft.fillScreen(TFT_BLACK);
     tft.setTextColor(TFT_YELLOW);
-    tft.drawString("Syncing Time...", 120, 195, 2);
-    updateRTCfromNTP();
+    tft.drawString("UPDATING...", 120, 120, 4);
+  });
+
+  ArduinoOTA.onEnd([]() {
+    tft.fillScreen(TFT_BLACK);
+    tft.setTextColor(TFT_GREEN);
+    tft.drawString("UPDATE SUKSES", 120, 120, 4);
     delay(1000);
-  } else {
-    tft.fillRect(0, 150, 240, 50, TFT_BLACK);
-    tft.setTextColor(TFT_RED);
-    tft.drawString("OFFLINE MODE", 120, 170, 2);
-    delay(1500);
-  }
+  });
 
-  client.setInsecure();
-  changeState(STANDBY);
+  ArduinoOTA.onProgress([](unsigned int progress, unsigned int total) {
+    tft.fillRect(20, 140, 200, 20, TFT_BLACK);
+    int barWidth = (progress / (total / 100)) * 2;
+    tft.drawRect(20, 140, 200, 20, TFT_WHITE);
+    tft.fillRect(20, 140, barWidth, 20, TFT_GREEN);
+  });
+
+  ArduinoOTA.onError([](ota_error_t error) {
+    Serial.printf("OTA gagal: error %u\n", (unsigned)error);
+    tft.fillScreen(TFT_BLACK);
+    tft.setTextColor(TFT_RED);
+    tft.drawString("UPDATE GAGAL", 120, 120, 4);
+    delay(2000);
+  });
+
+  ArduinoOTA.begin();
+  metricsServerBegin();
+  metricsServerOn("/trace", traceDump);
+  netServicesReady = true;
 }
 
 // ================== LOOP ==================
+// Tidak ada delay() di sini: tombol datang sebagai event, tampilan yang
+// perlu menunggu memakai timer, lalu loop tidur di eventsWait().
 void loop() {
-  if (WiFi.status() == WL_CONNECTED) {
+  loopBegin();
+  if (netServicesReady && WiFi.status() == WL_CONNECTED) {
     ArduinoOTA.handle();
+    metricsServerHandle();
   }
+  // 't' di serial monitor: dump trace untuk tools/trace2json
+  if (Serial.available() && Serial.read() == 't')
+    traceDump(Serial);
+  // RTC hanya disentuh dari loop(); task net cukup menitipkan waktu NTP
+  uint32_t ntp;
+  if (bootNtpPoll(&ntp))
+    clockAdjust(DateTime(ntp));
 
-  // Backlight timeout 5 menit
-  if (millis() - lastActivity > 300000 && isLcdOn) {
-    digitalWrite(LED_HIJAU, LOW);
-    isLcdOn = false;
-  }
-
-  if (!digitalRead(PIN_UP) || !digitalRead(PIN_DOWN) || !digitalRead(PIN_OK)) {
-    if (!isLcdOn)
-      wakeUpLcd();
-    lastActivity = millis();
-  }
-
-  // Long press UP = sync offline
-  if (state == STANDBY && !digitalRead(PIN_UP)) {
-    uint32_t t = millis();
-    while (!digitalRead(PIN_UP))
-      ;
-    if (millis() - t > 3000)
-      syncOfflineData();
-  }
+  ButtonEvent btn;
+  while (buttonPoll(&btn))
+    handleButton(btn);
+  timersRun();
 
   switch (state) {
   case STANDBY:
@@ -214,315 +328,353 @@ void loop() {
   case DELETE:
     runDelete();
     break;
+  case SYNC:
+    runSync();
+    break;
+  case MESSAGE:
+    break;
   }
-  yield();
+
+  // Semua halaman digambar bertahap lewat widget; selama masih ada sisa,
+  // loop tidak tidur
+  if (loopElapsedUs() < SCREEN_DEFER_AFTER_US)
+    screen.update(SCREEN_UPDATE_BYTES);
+  bool drawing = screen.pending();
+  loopEnd();
+  eventsWait(drawing ? 0 : LOOP_IDLE_MS);
 }
 
 // ================== STANDBY MODE ==================
 void runStandby() {
-  DateTime now = rtc.now();
-  static int lastSec = -1, lastMin = -1, lastStatus = -1, lastWifi = -1;
-
   if (isFirstEntry) {
-    tft.fillScreen(TFT_BLACK);
-    tft.fillRect(0, 0, 240, 50, 0x2104);
-    tft.fillRoundRect(5, 5, 40, 40, 8, TFT_CYAN);
-    tft.setTextColor(TFT_WHITE);
-    tft.setCursor(12, 18);
-    tft.setTextSize(2);
-    tft.print("AX");
-    tft.setTextSize(1);
-    tft.setTextDatum(MC_DATUM);
-    tft.drawString("AXIOM ID", 140, 25, 2);
+    screen.setPage(standbyPage, 5);
     isFirstEntry = false;
-    lastSec = -1;
-    lastMin = -1;
-    lastStatus = -1;
-    lastWifi = -1;
-  }
-
-  // Jam Besar & Detik
-  if (now.minute() != lastMin) {
-    tft.fillRect(5, 55, 200, 90, TFT_BLACK);
-    char hmBuf[6];
-    sprintf(hmBuf, "%02d:%02d", now.hour(), now.minute());
-    tft.setTextColor(0x07FF, TFT_BLACK);
-    tft.setTextDatum(MC_DATUM);
-    tft.setTextSize(3);                 // Manual size scaling
-    tft.drawString(hmBuf, 105, 100, 4); // Font 4 with size 3
-    tft.setTextSize(1);                 // Reset
-    lastMin = now.minute();
-  }
-  if (now.second() != lastSec) {
-    tft.fillRect(5, 120, 200, 25, TFT_BLACK);
-    char secBuf[4];
-    sprintf(secBuf, ":%02d", now.second());
-    tft.setTextColor(TFT_CYAN, TFT_BLACK);
-    tft.setTextDatum(MC_DATUM);
-    tft.drawString(secBuf, 120, 132, 2); // Smaller font for seconds
-    lastSec = now.second();
-  }
+    clockDue = true;
+  }
+
+  // Widget jam dicek per CLOCK_REFRESH_MS; jam software, tanpa I2C
+  if (clockDue) {
+    clockDue = false;
+    DateTime now = clockDateTime();
+    clockWidget.set(now);
+    secondsWidget.set(now);
+  }
+  if (!isScanning)
+    statusWidget.set(statusAbsen[currentStatusIdx], 0x5DFF, TFT_WHITE);
+  statusWidget.setSensorError(!sensorDetected);
+  bool online = WiFi.status() == WL_CONNECTED;
+  wifiWidget.set(online, online ? WiFi.localIP().toString() : String());
+
+  // Hasil scan dari scan task
+  ScanEvent evt;
+  while (state == STANDBY && scanTaskPoll(&evt))
+    handleScanEvent(evt);
+}
 
-  // Status Box
-  if (currentStatusIdx != lastStatus) {
-    tft.fillRoundRect(5, 150, 230, 50, 10, 0x5DFF);
-    tft.setTextColor(TFT_WHITE, 0x5DFF);
-    tft.setTextDatum(MC_DATUM);
-    tft.drawString(statusAbsen[currentStatusIdx], 120, 175, 4);
-
-    tft.fillRect(0, 202, 240, 12, TFT_BLACK);
-    if (!sensorDetected) {
-      tft.setTextColor(TFT_RED, TFT_BLACK);
-      tft.drawString("-- SENSOR ERROR --", 120, 208, 1);
-    }
-    lastStatus = currentStatusIdx;
-  }
+void standbyButton(const ButtonEvent &evt) {
+  // UP: klik = status sebelumnya, tahan 3 detik = sync manual
+  if (evt.button == BTN_UP && evt.action == BTN_CLICK)
+    currentStatusIdx = (currentStatusIdx + 2) % 3;
+  else if (evt.button == BTN_UP && evt.action == BTN_LONG)
+    syncOfflineData();
+  else if (evt.button == BTN_DOWN && evt.action == BTN_PRESS)
+    currentStatusIdx = (currentStatusIdx + 1) % 3;
+  else if (evt.button == BTN_OK && evt.action == BTN_PRESS)
+    changeState(INPUT_PIN);
+}
 
-  // WiFi Status
-  int currentWifi = (WiFi.status() == WL_CONNECTED) ? 1 : 0;
-  if (currentWifi != lastWifi) {
-    tft.fillRect(0, 215, 240, 25, TFT_BLACK);
-    tft.setTextDatum(BL_DATUM);
-    if (currentWifi) {
-      tft.setTextColor(TFT_YELLOW, TFT_BLACK);
-      tft.drawString(WiFi.localIP().toString(), 5, 235, 2);
+void handleScanEvent(const ScanEvent &evt) {
+  if (evt.result != SCAN_TOUCH)
+    isScanning = false;
+  switch (evt.result) {
+  case SCAN_TOUCH:
+    isScanning = true;
+    statusWidget.set("MEMINDAI...", TFT_YELLOW, TFT_BLACK);
+    playBuzzer(1);
+    return;
+  case SCAN_MATCH:
+    Serial.printf("Scan ID %d: %lu ms\n", evt.fingerID,
+                  (unsigned long)(evt.postedAt - evt.touchedAt));
+    if (evt.fingerID == lastFingerID && millis() - lastFingerTime < 60000) {
+      flashScreen(TFT_YELLOW, "SUDAH ABSEN", evt.fingerID, STANDBY);
     } else {
-      tft.setTextColor(TFT_DARKGREY, TFT_BLACK);
-      tft.drawString("no-ip", 5, 235, 2);
-    }
-    tft.setTextDatum(BR_DATUM);
-    tft.setTextColor(currentWifi ? TFT_GREEN : TFT_RED, TFT_BLACK);
-    tft.drawString(currentWifi ? "ONLINE" : "OFFLINE", 235, 235, 2);
-    lastWifi = currentWifi;
-  }
-
-  // Scan Fingerprint
-  if (sensorDetected && (millis() - lastScanTime > 200)) {
-    lastScanTime = millis();
-    if (finger.getImage() == FINGERPRINT_OK) {
-      playBuzzer(1);
-      tft.fillRoundRect(5, 150, 230, 50, 10, TFT_YELLOW);
-      tft.setTextColor(TFT_BLACK, TFT_YELLOW);
-      tft.setTextDatum(MC_DATUM);
-      tft.drawString("MEMINDAI...", 120, 175, 4);
-
-      if (finger.image2Tz() == FINGERPRINT_OK) {
-        if (finger.fingerFastSearch() == FINGERPRINT_OK) {
-          if (finger.fingerID == lastFingerID &&
-              millis() - lastFingerTime < 60000) {
-            flashScreen(TFT_YELLOW, "SUDAH ABSEN", finger.fingerID);
-          } else {
-            lastFingerID = finger.fingerID;
-            lastFingerTime = millis();
-            flashScreen(TFT_GREEN, "BERHASIL", finger.fingerID);
-            sendDataToAPI(finger.fingerID, statusAbsen[currentStatusIdx]);
-          }
-        } else {
-          playBuzzer(2);
-          flashScreen(TFT_RED, "JARI ASING", 0);
-        }
+      lastFingerID = evt.fingerID;
+      lastFingerTime = millis();
+      // Simpan dulu ke flash, baru tampilkan hasil
+      if (saveAttendance(evt.fingerID, currentStatusIdx)) {
+        flashScreen(TFT_GREEN, "BERHASIL", evt.fingerID, STANDBY);
+      } else {
+        playBuzzer(2);
+        flashScreen(TFT_RED, "MEMORI PENUH", evt.fingerID, STANDBY);
       }
-      changeState(STANDBY);
     }
-  }
-
-  // Navigation
-  if (!digitalRead(PIN_UP)) {
-    currentStatusIdx = (currentStatusIdx + 2) % 3;
-    delay(200);
-  }
-  if (!digitalRead(PIN_DOWN)) {
-    currentStatusIdx = (currentStatusIdx + 1) % 3;
-    delay(200);
-  }
-  if (!digitalRead(PIN_OK)) {
-    changeState(INPUT_PIN);
-    delay(200);
+    break;
+  case SCAN_NOMATCH:
+    playBuzzer(2);
+    flashScreen(TFT_RED, "JARI ASING", 0, STANDBY);
+    break;
+  case SCAN_ERROR:
+    changeState(STANDBY);
+    break;
   }
 }
 
-// ================== SEND TO VERCEL API ==================
-void sendDataToAPI(int id, String status) {
-  // Get timestamp from RTC
-  DateTime now = rtc.now();
-  char timestamp[25];
-  sprintf(timestamp, "%04d-%02d-%02dT%02d:%02d:%02d.000Z", now.year(),
-          now.month(), now.day(), now.hour(), now.minute(), now.second());
-
-  String dataKirim = String(id) + "," + String(timestamp) + "," + status;
-
-  if (WiFi.status() == WL_CONNECTED) {
-    HTTPClient https;
-    https.begin(client, API_URL);
-    https.addHeader("Content-Type", "application/json");
-    https.addHeader("x-api-key", API_KEY);
-
-    JsonDocument doc;
-    doc["uid"] = id;
-    doc["timestamp"] = String(timestamp);
-
-    String jsonPayload;
-    serializeJson(doc, jsonPayload);
+// ================== SIMPAN KE OUTBOX ==================
+bool saveAttendance(int id, int statusIdx) {
+  TRACE_SPAN("saveAttendance");
+  // Upload dikerjakan uploader task, di sini cukup simpan ke flash
+  uint32_t now = clockNow();
+  if (!outboxPush(id, statusIdx, now))
+    return false;
+  historyAppend(id, statusIdx, now);
+  uploaderKick();
+  return true;
+}
 
-    int httpCode = https.POST(jsonPayload);
-    Serial.printf("HTTP Response: %d\n", httpCode);
-    https.end();
-  } else {
-    // Offline mode - save to LittleFS
-    fs::File f = LittleFS.open("/offline.txt", FILE_APPEND);
-    if (f) {
-      f.println(dataKirim);
-      f.close();
+// Pindahkan /offline.txt (format CSV lama) ke outbox
+void importLegacyOffline() {
+  fs::File f = LittleFS.open("/offline.txt", FILE_READ);
+  if (!f)
+    return;
+  // Berhenti di baris pertama yang gagal masuk outbox (penuh / flash
+  // error): baris itu dan sesudahnya tetap di /offline.txt untuk boot
+  // berikutnya, yang sudah masuk tidak diimpor dua kali
+  bool failed = false;
+  size_t lineStart = 0;
+  while (f.available()) {
+    lineStart = f.position();
+    String line = f.readStringUntil('\n');
+    int idx1 = line.indexOf(',');
+    int idx2 = line.indexOf(',', idx1 + 1);
+    if (idx1 > 0 && idx2 > 0) {
+      int uid = line.substring(0, idx1).toInt();
+      DateTime t(line.substring(idx1 + 1, idx2).c_str());
+      String status = line.substring(idx2 + 1);
+      status.trim();
+      int statusIdx = 0;
+      for (int i = 0; i < 3; i++)
+        if (status == statusAbsen[i])
+          statusIdx = i;
+      if (!outboxPush(uid, statusIdx, t.unixtime())) {
+        failed = true;
+        break;
+      }
+      historyAppend(uid, statusIdx, t.unixtime());
     }
   }
+  if (!failed) {
+    f.close();
+    LittleFS.remove("/offline.txt");
+    return;
+  }
+
+  fs::File rest = LittleFS.open("/offline.tmp", FILE_WRITE);
+  bool ok = rest && f.seek(lineStart);
+  uint8_t buf[128];
+  while (ok && f.available()) {
+    size_t n = f.read(buf, sizeof(buf));
+    ok = n && rest.write(buf, n) == n;
+  }
+  f.close();
+  if (rest)
+    rest.close();
+  if (ok)
+    LittleFS.rename("/offline.tmp", "/offline.txt");
+  else
+    LittleFS.remove("/offline.tmp");
+  Serial.println("Outbox: import /offline.txt belum selesai, sisanya disimpan");
 }
 
 // ================== HELPER FUNCTIONS ==================
-void updateRTCfromNTP() {
-  configTime(25200, 0, "id.pool.ntp.org", "pool.ntp.org");
-  struct tm t;
-  if (getLocalTime(&t, 5000)) {
-    rtc.adjust(DateTime(t.tm_year + 1900, t.tm_mon + 1, t.tm_mday, t.tm_hour,
-                        t.tm_min, t.tm_sec));
-  }
+void flashScreen(uint16_t warna, String msg, int id, AppState next) {
+  changeState(MESSAGE);
+  // Satu kali push per piksel, tanpa fillScreen + gambar ulang
+  Widget *page[] = {&messageWidget};
+  messageWidget.set(warna, msg, id);
+  screen.setPage(page, 1);
+  // Tidak menunggu di sini: state berikutnya dipasang oleh timer
+  afterMessage = next;
+  messageTimer = timerAfter(MESSAGE_MS, [](void *) {
+    messageTimer = TIMER_NONE;
+    changeState(afterMessage);
+  });
 }
 
-void flashScreen(uint16_t warna, String msg, int id) {
-  tft.fillScreen(warna);
-  tft.setTextColor(TFT_BLACK);
-  tft.setTextDatum(MC_DATUM);
-  tft.drawString(msg, 120, 100, 4);
-  if (id > 0)
-    tft.drawString("ID " + String(id), 120, 145, 2);
-  delay(1500);
+// Halaman teks admin, kosong; baris diisi lewat textPage.setLine()
+static void showTextPage() {
+  Widget *page[] = {&textPage};
+  textPage.clear();
+  screen.setPage(page, 1);
 }
 
+static uint32_t syncStart = 0;
+
 void syncOfflineData() {
   if (WiFi.status() != WL_CONNECTED) {
-    flashScreen(TFT_RED, "OFFLINE", 0);
-    changeState(STANDBY);
+    netKick(); // lewati sisa backoff reconnect
+    flashScreen(TFT_RED, "OFFLINE", 0, STANDBY);
     return;
   }
-  tft.fillScreen(TFT_BLACK);
-  tft.drawString("SINKRONISASI...", 120, 120, 2);
+  changeState(SYNC);
+  showTextPage();
+  textPage.setLine(0, "SINKRONISASI...", 120, 2);
 
-  fs::File f = LittleFS.open("/offline.txt", FILE_READ);
-  if (f) {
-    HTTPClient https;
-    https.begin(client, API_URL);
-    https.addHeader("Content-Type", "application/json");
-    https.addHeader("x-api-key", API_KEY);
-
-    while (f.available()) {
-      String line = f.readStringUntil('\n');
-      int idx1 = line.indexOf(',');
-      int idx2 = line.indexOf(',', idx1 + 1);
-
-      if (idx1 > 0 && idx2 > 0) {
-        int uid = line.substring(0, idx1).toInt();
-        String timestamp = line.substring(idx1 + 1, idx2);
-
-        JsonDocument doc;
-        doc["uid"] = uid;
-        doc["timestamp"] = timestamp;
-
-        String payload;
-        serializeJson(doc, payload);
-        https.POST(payload);
-        delay(100);
-      }
-      yield();
-    }
-    https.end();
-    f.close();
-    LittleFS.remove("/offline.txt");
-    flashScreen(TFT_GREEN, "SYNC OK", 0);
-  }
-  changeState(STANDBY);
+  // Uploader yang mengirim; runSync() hanya memantau antrian
+  uploaderKick();
+  syncStart = millis();
+}
+
+void runSync() {
+  uint32_t sisa = outboxPending();
+  if (sisa == 0)
+    flashScreen(TFT_GREEN, "SYNC OK", 0, STANDBY);
+  else if (millis() - syncStart >= SYNC_TIMEOUT_MS)
+    flashScreen(TFT_YELLOW, "SISA " + String(sisa), 0, STANDBY);
 }
 
 void playBuzzer(int p) {
   digitalWrite(PIN_BUZZER, HIGH);
-  delay(p == 1 ? 150 : 300);
-  digitalWrite(PIN_BUZZER, LOW);
+  timerCancel(buzzerTimer);
+  buzzerTimer = timerAfter(p == 1 ? 150 : 300, [](void *) {
+    buzzerTimer = TIMER_NONE;
+    digitalWrite(PIN_BUZZER, LOW);
+  });
 }
 
+// Backlight mati setelah BACKLIGHT_TIMEOUT_MS tanpa tombol ditekan
 void wakeUpLcd() {
-  lastActivity = millis();
   digitalWrite(LED_HIJAU, HIGH);
   isLcdOn = true;
-  delay(200);
+  timerCancel(backlightTimer);
+  backlightTimer = timerAfter(BACKLIGHT_TIMEOUT_MS, [](void *) {
+    backlightTimer = TIMER_NONE;
+    digitalWrite(LED_HIJAU, LOW);
+    isLcdOn = false;
+  });
 }
 
 void changeState(AppState newState) {
+  timerCancel(messageTimer);
   state = newState;
   isFirstEntry = true;
+  isScanning = false;
+  scanTaskEnable(newState == STANDBY && sensorDetected);
 }
 
+void inputPinButton(const ButtonEvent &evt);
+void menuButton(const ButtonEvent &evt);
+void enrollButton(const ButtonEvent &evt);
+void deleteButton(const ButtonEvent &evt);
+void standbyButton(const ButtonEvent &evt);
+
+void handleButton(const ButtonEvent &evt) {
+  // Tekanan yang menyalakan backlight tidak diteruskan ke state
+  static bool swallow[BTN_COUNT] = {};
+  if (evt.action == BTN_PRESS && !isLcdOn)
+    swallow[evt.button] = true;
+  if (evt.action == BTN_PRESS)
+    wakeUpLcd();
+  if (swallow[evt.button]) {
+    if (evt.action == BTN_RELEASE)
+      swallow[evt.button] = false;
+    return;
+  }
+
+  switch (state) {
+  case STANDBY:
+    standbyButton(evt);
+    break;
+  case INPUT_PIN:
+    inputPinButton(evt);
+    break;
+  case MENU:
+    menuButton(evt);
+    break;
+  case ENROLL:
+    enrollButton(evt);
+    break;
+  case DELETE:
+    deleteButton(evt);
+    break;
+  case MESSAGE:
+  case SYNC:
+    break;
+  }
+}
+
+// Naik / turun: sekali saat ditekan, lalu berulang selama ditahan
+static bool isStep(const ButtonEvent &evt, ButtonId b) {
+  return evt.button == b &&
+         (evt.action == BTN_PRESS || evt.action == BTN_REPEAT);
+}
+
+static String enteredPin = "";
+static int curDigit = 0;
+static bool pinDirty = true;
+
 void runInputPin() {
-  static String enteredPin = "";
-  static int curDigit = 0;
   if (isFirstEntry) {
-    tft.fillScreen(TFT_BLACK);
-    tft.setTextColor(TFT_WHITE);
-    tft.setTextDatum(MC_DATUM);
-    tft.drawString("PIN ADMIN", 120, 40, 2);
+    showTextPage();
+    textPage.setLine(0, "PIN ADMIN", 40, 2);
     isFirstEntry = false;
+    pinDirty = true;
   }
-  tft.fillRect(60, 100, 120, 40, TFT_BLACK);
+  if (!pinDirty)
+    return;
+  pinDirty = false;
   String disp = "";
   for (int i = 0; i < 4; i++)
     disp += (i < (int)enteredPin.length()) ? "*" : "-";
-  tft.drawString(disp, 120, 115, 4);
-  tft.fillRect(80, 170, 80, 30, TFT_BLACK);
-  tft.drawString("Digit: " + String(curDigit), 120, 185, 2);
+  textPage.setLine(1, disp, 115, 4);
+  textPage.setLine(2, "Digit: " + String(curDigit), 185, 2);
+}
 
-  if (!digitalRead(PIN_UP)) {
+void inputPinButton(const ButtonEvent &evt) {
+  if (isStep(evt, BTN_UP))
     curDigit = (curDigit + 1) % 10;
-    delay(200);
-  }
-  if (!digitalRead(PIN_DOWN)) {
+  else if (isStep(evt, BTN_DOWN))
     curDigit = (curDigit + 9) % 10;
-    delay(200);
-  }
-  if (!digitalRead(PIN_OK)) {
+  else if (evt.button == BTN_OK && evt.action == BTN_PRESS) {
     enteredPin += String(curDigit);
     curDigit = 0;
-    delay(250);
     if (enteredPin.length() == 4) {
       if (enteredPin == PIN_ADMIN)
         changeState(MENU);
-      else {
-        flashScreen(TFT_RED, "SALAH", 0);
-        changeState(STANDBY);
-      }
+      else
+        flashScreen(TFT_RED, "SALAH", 0, STANDBY);
       enteredPin = "";
     }
+  } else {
+    return;
   }
+  pinDirty = true;
 }
 
+static bool menuDirty = true;
+static const char *const menuItems[] = {"DAFTAR JARI", "HAPUS JARI",
+                                        "KEMBALI"};
+
 void runMenu() {
   if (isFirstEntry) {
-    tft.fillScreen(TFT_BLACK);
+    Widget *page[] = {&menuWidget};
+    screen.setPage(page, 1);
     isFirstEntry = false;
+    menuDirty = true;
   }
-  String items[] = {"DAFTAR JARI", "HAPUS JARI", "KEMBALI"};
-  for (int i = 0; i < 3; i++) {
-    tft.fillRoundRect(15, 70 + (i * 50), 210, 40, 8,
-                      (i == menuIdx) ? 0x5DFF : 0x2104);
-    tft.setTextColor(TFT_WHITE);
-    tft.drawString(items[i], 120, 90 + (i * 50), 2);
-  }
-  if (!digitalRead(PIN_UP)) {
+  if (!menuDirty)
+    return;
+  menuDirty = false;
+  menuWidget.set(menuItems, 3, menuIdx);
+}
+
+void menuButton(const ButtonEvent &evt) {
+  if (isStep(evt, BTN_UP)) {
     menuIdx = (menuIdx + 2) % 3;
-    delay(200);
-  }
-  if (!digitalRead(PIN_DOWN)) {
+    menuDirty = true;
+  } else if (isStep(evt, BTN_DOWN)) {
     menuIdx = (menuIdx + 1) % 3;
-    delay(200);
-  }
-  if (!digitalRead(PIN_OK)) {
-    delay(250);
+    menuDirty = true;
+  } else if (evt.button == BTN_OK && evt.action == BTN_PRESS) {
     if (menuIdx == 0)
       changeState(ENROLL);
     else if (menuIdx == 1)
@@ -532,89 +684,183 @@ void runMenu() {
   }
 }
 
+// ================== ENROLL ==================
+// Dua kali getImage + image2Tz lewat API async sensor, dijalankan sedikit
+// demi sedikit dari loop. Lock sensor dipegang dari tempelan pertama
+// sampai template tersimpan supaya char buffer tidak ditimpa task lain.
+enum EnrollStep {
+  ENROLL_ID,     // pilih ID
+  ENROLL_FIRST,  // menunggu tempelan pertama
+  ENROLL_PAUSE,  // jeda sebelum "Tempel Lagi"
+  ENROLL_SECOND  // menunggu tempelan kedua
+};
+static EnrollStep enrollStep = ENROLL_ID;
+static int enrollId = 1;
+static bool enrollLocked = false;
+static bool enrollConverting = false; // image2Tz sedang jalan
+static uint32_t enrollDeadline = 0;
+static uint32_t enrollNextTry = 0;
+
+static void drawEnrollId() {
+  textPage.setLine(0, "SET ID: " + String(enrollId), 80, 2);
+}
+
+static void enrollPrompt(const char *msg) {
+  textPage.clear();
+  textPage.setLine(0, msg, 120, 2);
+}
+
+static void enrollFinish(bool ok) {
+  if (finger.busy())
+    finger.abortCommand();
+  if (enrollLocked) {
+    sensorUnlock();
+    enrollLocked = false;
+  }
+  enrollStep = ENROLL_ID;
+  if (ok) {
+    templateSyncKick();
+    flashScreen(TFT_GREEN, "SUKSES", enrollId, MENU);
+  } else {
+    flashScreen(TFT_RED, "GAGAL", 0, MENU);
+  }
+}
+
+// Satu langkah tempelan: return true kalau image2Tz(slot) sudah selesai
+static bool enrollCapture(uint8_t slot) {
+  if (!finger.busy()) {
+    if ((int32_t)(millis() - enrollNextTry) < 0)
+      return false;
+    finger.beginGetImage();
+    enrollConverting = false;
+    return false;
+  }
+  uint8_t r = finger.poll();
+  if (r == FINGERPRINT_BUSY)
+    return false;
+  if (enrollConverting) {
+    enrollConverting = false;
+    if (r == FINGERPRINT_OK)
+      return true;
+    enrollNextTry = millis() + ENROLL_RETRY_MS; // gambar jelek, ulangi
+    return false;
+  }
+  if (r == FINGERPRINT_OK) {
+    finger.beginImage2Tz(slot);
+    enrollConverting = true;
+  } else {
+    enrollNextTry = millis() + ENROLL_RETRY_MS;
+  }
+  return false;
+}
+
 void runEnroll() {
   if (!sensorDetected) {
-    flashScreen(TFT_RED, "NO SENSOR", 0);
-    changeState(MENU);
+    flashScreen(TFT_RED, "NO SENSOR", 0, MENU);
     return;
   }
-  static int id = 1;
   if (isFirstEntry) {
-    tft.fillScreen(TFT_BLACK);
-    tft.drawString("SET ID: " + String(id), 120, 80, 2);
+    showTextPage();
+    drawEnrollId();
     isFirstEntry = false;
+    enrollStep = ENROLL_ID;
   }
-  if (!digitalRead(PIN_UP)) {
-    id++;
-    tft.fillRect(110, 70, 60, 30, TFT_BLACK);
-    tft.drawString(String(id), 130, 80, 2);
-    delay(200);
+  if (enrollStep == ENROLL_ID)
+    return;
+
+  if (enrollStep != ENROLL_PAUSE &&
+      (int32_t)(millis() - enrollDeadline) >= 0) {
+    enrollFinish(false);
+    return;
   }
-  if (!digitalRead(PIN_DOWN) && id > 1) {
-    id--;
-    tft.fillRect(110, 70, 60, 30, TFT_BLACK);
-    tft.drawString(String(id), 130, 80, 2);
-    delay(200);
+
+  switch (enrollStep) {
+  case ENROLL_FIRST:
+    if (enrollCapture(1)) {
+      enrollStep = ENROLL_PAUSE;
+      enrollDeadline = millis() + ENROLL_PAUSE_MS;
+    }
+    break;
+  case ENROLL_PAUSE:
+    if ((int32_t)(millis() - enrollDeadline) >= 0) {
+      enrollPrompt("Tempel Lagi");
+      enrollStep = ENROLL_SECOND;
+      enrollDeadline = millis() + ENROLL_TIMEOUT_MS;
+    }
+    break;
+  case ENROLL_SECOND:
+    if (enrollCapture(2))
+      enrollFinish(finger.createModel() == FINGERPRINT_OK &&
+                   templateEnroll(enrollId) == FINGERPRINT_OK);
+    break;
+  case ENROLL_ID:
+    break;
   }
-  if (!digitalRead(PIN_OK)) {
-    tft.fillScreen(TFT_BLACK);
-    tft.drawString("Tempel Jari", 120, 120, 2);
-    if (waitFinger(FINGERPRINT_OK)) {
-      finger.image2Tz(1);
-      delay(1000);
-      tft.fillScreen(TFT_BLACK);
-      tft.drawString("Tempel Lagi", 120, 120, 2);
-      if (waitFinger(FINGERPRINT_OK)) {
-        finger.image2Tz(2);
-        if (finger.createModel() == FINGERPRINT_OK &&
-            finger.storeModel(id) == FINGERPRINT_OK)
-          flashScreen(TFT_GREEN, "SUKSES", id);
-        else
-          flashScreen(TFT_RED, "GAGAL", 0);
-      }
+}
+
+void enrollButton(const ButtonEvent &evt) {
+  if (enrollStep != ENROLL_ID)
+    return;
+  if (isStep(evt, BTN_UP)) {
+    enrollId++;
+    drawEnrollId();
+  } else if (isStep(evt, BTN_DOWN) && enrollId > 1) {
+    enrollId--;
+    drawEnrollId();
+  } else if (evt.button == BTN_OK && evt.action == BTN_PRESS) {
+    // Task sync bisa sedang memasang template (< 0.5 detik)
+    if (!sensorLock(500)) {
+      flashScreen(TFT_RED, "SENSOR SIBUK", 0, MENU);
+      return;
+    }
+    // Di atas templateCapacity() template baru tidak akan pernah dikenali
+    if (!templateHasRoom(enrollId)) {
+      sensorUnlock();
+      flashScreen(TFT_RED, "MEMORI PENUH", 0, MENU);
+      return;
     }
-    changeState(MENU);
+    enrollLocked = true;
+    enrollPrompt("Tempel Jari");
+    enrollStep = ENROLL_FIRST;
+    enrollNextTry = millis();
+    enrollDeadline = millis() + ENROLL_TIMEOUT_MS;
   }
 }
 
+// ================== DELETE ==================
+static int deleteId = 1;
+
+static void drawDeleteId() {
+  textPage.setLine(0, "HAPUS ID: " + String(deleteId), 100, 2);
+}
+
 void runDelete() {
   if (!sensorDetected) {
-    flashScreen(TFT_RED, "NO SENSOR", 0);
-    changeState(MENU);
+    flashScreen(TFT_RED, "NO SENSOR", 0, MENU);
     return;
   }
-  static int id = 1;
   if (isFirstEntry) {
-    tft.fillScreen(TFT_BLACK);
-    tft.drawString("HAPUS ID: " + String(id), 120, 100, 2);
+    showTextPage();
+    drawDeleteId();
     isFirstEntry = false;
   }
-  if (!digitalRead(PIN_UP)) {
-    id++;
-    tft.fillRect(110, 90, 60, 30, TFT_BLACK);
-    tft.drawString(String(id), 130, 100, 2);
-    delay(200);
-  }
-  if (!digitalRead(PIN_DOWN) && id > 1) {
-    id--;
-    tft.fillRect(110, 90, 60, 30, TFT_BLACK);
-    tft.drawString(String(id), 130, 100, 2);
-    delay(200);
-  }
-  if (!digitalRead(PIN_OK)) {
-    if (finger.deleteModel(id) == FINGERPRINT_OK)
-      flashScreen(TFT_RED, "TERHAPUS", id);
-    changeState(MENU);
-  }
 }
 
-bool waitFinger(uint8_t target, uint32_t timeout) {
-  uint32_t start = millis();
-  while (millis() - start < timeout) {
-    if (finger.getImage() == target)
-      return true;
-    delay(50);
-    yield();
+void deleteButton(const ButtonEvent &evt) {
+  if (isStep(evt, BTN_UP) || (isStep(evt, BTN_DOWN) && deleteId > 1)) {
+    deleteId += evt.button == BTN_UP ? 1 : -1;
+    drawDeleteId();
+  } else if (evt.button == BTN_OK && evt.action == BTN_PRESS) {
+    // Sama seperti enroll: jangan hapus tanpa memegang sensor
+    if (!sensorLock(500)) {
+      flashScreen(TFT_RED, "SENSOR SIBUK", 0, MENU);
+      return;
+    }
+    uint8_t r = templateDelete(deleteId);
+    sensorUnlock();
+    if (r == FINGERPRINT_OK)
+      flashScreen(TFT_RED, "TERHAPUS", deleteId, MENU);
+    else
+      changeState(MENU);
   }
-  return false;
 }
@@ -0,0 +1,291 @@
+// ArenaAllocator (lib/ArduinoJson/Memory/ArenaAllocator.hpp) dibandingkan
+// dengan allocator bawaan (malloc) pada payload yang benar-benar lewat:
+// batch ingest penuh, jawaban ingest, dan satu halaman daftar template.
+// Dicek: hasil parse dan serialize sama persis, arena tidak tumbuh pada
+// parse bersarang yang berulang, dan NoMemory kalau arena terlalu kecil.
+// Throughput parse/serialize dan puncak memori dicetak.
+//
+//   pio test -e native -f test_arena_allocator
+
+#include <ArduinoJson.h>
+#include <unity.h>
+
+#include <chrono>
+#include <string>
+
+#include "Uploader.h"
+
+#define BATCH_EVENTS UPLOAD_BATCH
+#define PAGE_TEMPLATES 20 // SYNC_PAGE di TemplateSync.cpp
+#define BENCH_REPS 2000
+#define NESTED_REPS 1000
+
+static char arenaBuf[32 * 1024];
+
+// Allocator bawaan (malloc) yang mencatat byte hidup dan puncaknya
+class CountingAllocator : public Allocator {
+public:
+  void *allocate(size_t size) override {
+    size_t *p = (size_t *)malloc(size + sizeof(size_t) * 2);
+    if (!p)
+      return nullptr;
+    *p = size;
+    grow(size);
+    return p + 2;
+  }
+
+  void deallocate(void *ptr) override {
+    if (!ptr)
+      return;
+    size_t *p = (size_t *)ptr - 2;
+    live -= *p;
+    free(p);
+  }
+
+  void *reallocate(void *ptr, size_t size) override {
+    if (!ptr)
+      return allocate(size);
+    size_t *p = (size_t *)ptr - 2;
+    size_t was = *p;
+    p = (size_t *)realloc(p, size + sizeof(size_t) * 2);
+    if (!p)
+      return nullptr;
+    live -= was;
+    *p = size;
+    grow(size);
+    return p + 2;
+  }
+
+  size_t live = 0;
+  size_t peak = 0;
+  uint32_t calls = 0;
+
+private:
+  void grow(size_t size) {
+    live += size;
+    calls++;
+    if (live > peak)
+      peak = live;
+  }
+};
+
+// Body POST /api/ingest seperti yang dikirim Uploader
+static std::string ingestBatch() {
+  std::string s = "[";
+  char ev[96];
+  for (int i = 0; i < BATCH_EVENTS; i++) {
+    snprintf(ev, sizeof(ev),
+             "%s{\"uid\":%d,\"timestamp\":\"2026-01-05T07:%02d:%02d.000Z\","
+             "\"seq\":%d}",
+             i ? "," : "", 1 + i * 37 % 500, i, i * 7 % 60, 40001 + i);
+    s += ev;
+  }
+  return s + "]";
+}
+
+// Jawaban server untuk batch itu: satu result per event
+static std::string ingestReply() {
+  std::string s = "{\"message\":\"Success\",\"stored\":31,\"results\":[";
+  for (int i = 0; i < BATCH_EVENTS; i++) {
+    if (i)
+      s += ",";
+    s += i == 9 ? "{\"uid\":" + std::to_string(1 + i * 37 % 500) +
+                      ",\"duplicate\":true}"
+        : i % 2 ? "{\"message\":\"Success\",\"status\":\"Out\"}"
+                : "{\"message\":\"Success\",\"status\":\"In\"}";
+  }
+  return s + "]}";
+}
+
+// GET /api/templates?since=N, satu halaman penuh
+static std::string templatePage() {
+  std::string s = "{\"templates\":[";
+  char t[112];
+  for (int i = 0; i < PAGE_TEMPLATES; i++) {
+    snprintf(t, sizeof(t),
+             "%s{\"uid\":%d,\"version\":%d,\"crc\":%lu,\"size\":512,"
+             "\"deleted\":%s}",
+             i ? "," : "", 1 + i * 13 % 300, 1200 + i,
+             (unsigned long)((i + 1) * 2654435761UL), i % 7 ? "false" : "true");
+    s += t;
+  }
+  return s + "],\"version\":1219,\"more\":true}";
+}
+
+struct Payload {
+  const char *name;
+  std::string json;
+};
+
+static Payload payloads[3];
+
+void setUp() {}
+void tearDown() {}
+
+static std::string roundTrip(const std::string &json, Allocator *alloc) {
+  JsonDocument doc(alloc);
+  TEST_ASSERT_TRUE(deserializeJson(doc, json) == DeserializationError::Ok);
+  std::string out;
+  serializeJson(doc, out);
+  return out;
+}
+
+static void test_output_matches_default_allocator() {
+  for (const Payload &p : payloads) {
+    ArenaAllocator arena(arenaBuf, sizeof(arenaBuf));
+    std::string viaArena = roundTrip(p.json, &arena);
+    std::string viaHeap =
+        roundTrip(p.json, detail::DefaultAllocator::instance());
+    TEST_ASSERT_TRUE_MESSAGE(viaArena == viaHeap, p.name);
+    TEST_ASSERT_TRUE_MESSAGE(viaArena == p.json, p.name);
+    TEST_ASSERT_EQUAL(0, arena.used());
+    TEST_ASSERT_EQUAL(0, arena.failures());
+  }
+
+  // Dokumen yang dibangun lewat API (pool + string yang disalin) juga sama
+  ArenaAllocator arena(arenaBuf, sizeof(arenaBuf));
+  JsonDocument built(&arena), ref;
+  for (JsonDocument *d : {&built, &ref}) {
+    for (int i = 0; i < BATCH_EVENTS; i++) {
+      JsonObject ev = d->add<JsonObject>();
+      ev["uid"] = 1 + i * 37 % 500;
+      ev["timestamp"] = std::string("2026-01-05T07:00:00.000Z");
+      ev["seq"] = 40001 + i;
+    }
+    d->shrinkToFit();
+  }
+  std::string a, b;
+  serializeJson(built, a);
+  serializeJson(ref, b);
+  TEST_ASSERT_TRUE(a == b);
+  TEST_ASSERT_FALSE(built.overflowed());
+}
+
+// Pola TemplateSync: satu dokumen luar, dokumen dalam per entry yang hidup
+// dan mati di dalam scope. Tanpa reset(), arena harus kembali kosong dan
+// puncaknya tidak boleh naik setelah putaran pertama.
+static void test_nested_parses_do_not_grow() {
+  ArenaAllocator arena(arenaBuf, sizeof(arenaBuf));
+  const std::string &page = payloads[2].json;
+  const std::string &reply = payloads[1].json;
+  size_t firstPeak = 0;
+  for (int rep = 0; rep < NESTED_REPS; rep++) {
+    {
+      JsonDocument outer(&arena);
+      TEST_ASSERT_TRUE(deserializeJson(outer, page) ==
+                       DeserializationError::Ok);
+      for (JsonObjectConst t : outer["templates"].as<JsonArrayConst>()) {
+        JsonDocument inner(&arena);
+        inner["uid"] = t["uid"];
+        inner["crc"] = t["crc"];
+        JsonDocument ack(&arena);
+        TEST_ASSERT_TRUE(deserializeJson(ack, reply) ==
+                         DeserializationError::Ok);
+        TEST_ASSERT_EQUAL(BATCH_EVENTS, ack["results"].size());
+      }
+    }
+    TEST_ASSERT_EQUAL(0, arena.used());
+    if (rep == 0)
+      firstPeak = arena.highWaterMark();
+  }
+  TEST_ASSERT_EQUAL(firstPeak, arena.highWaterMark());
+  TEST_ASSERT_EQUAL(0, arena.failures());
+}
+
+static void test_small_arena_reports_no_memory() {
+  const std::string &page = payloads[2].json;
+  size_t need;
+  {
+    ArenaAllocator arena(arenaBuf, sizeof(arenaBuf));
+    JsonDocument doc(&arena);
+    TEST_ASSERT_TRUE(deserializeJson(doc, page) == DeserializationError::Ok);
+    need = arena.highWaterMark();
+  }
+
+  ArenaAllocator small(arenaBuf, need / 2);
+  {
+    JsonDocument doc(&small);
+    TEST_ASSERT_TRUE(deserializeJson(doc, page) ==
+                     DeserializationError::NoMemory);
+  }
+  TEST_ASSERT_TRUE(small.failures() > 0);
+  TEST_ASSERT_EQUAL(0, small.used());
+
+  // Membangun dokumen: overflowed(), bukan crash
+  {
+    JsonDocument doc(&small);
+    for (int i = 0; i < 1000; i++)
+      doc.add(std::string("template-") + std::to_string(i));
+    TEST_ASSERT_TRUE(doc.overflowed());
+  }
+
+  // Arena yang pas persis cukup
+  ArenaAllocator exact(arenaBuf, need);
+  JsonDocument doc(&exact);
+  TEST_ASSERT_TRUE(deserializeJson(doc, page) == DeserializationError::Ok);
+  TEST_ASSERT_EQUAL(0, exact.failures());
+}
+
+struct Bench {
+  double parseUs;
+  double serializeUs;
+  size_t peak;
+};
+
+static Bench bench(const std::string &json, Allocator *alloc) {
+  Bench b = {0, 0, 0};
+  std::string out;
+  out.reserve(json.size());
+  for (int rep = 0; rep < BENCH_REPS; rep++) {
+    JsonDocument doc(alloc);
+    auto t0 = std::chrono::steady_clock::now();
+    DeserializationError err = deserializeJson(doc, json);
+    auto t1 = std::chrono::steady_clock::now();
+    out.clear();
+    serializeJson(doc, out);
+    auto t2 = std::chrono::steady_clock::now();
+    TEST_ASSERT_TRUE(err == DeserializationError::Ok);
+    b.parseUs += std::chrono::duration<double, std::micro>(t1 - t0).count();
+    b.serializeUs +=
+        std::chrono::duration<double, std::micro>(t2 - t1).count();
+  }
+  b.parseUs /= BENCH_REPS;
+  b.serializeUs /= BENCH_REPS;
+  return b;
+}
+
+static void test_throughput_and_peak_memory() {
+  for (const Payload &p : payloads) {
+    CountingAllocator heap;
+    Bench h = bench(p.json, &heap);
+    h.peak = heap.peak;
+    TEST_ASSERT_EQUAL(0, heap.live);
+
+    ArenaAllocator arena(arenaBuf, sizeof(arenaBuf));
+    Bench a = bench(p.json, &arena);
+    a.peak = arena.highWaterMark();
+    TEST_ASSERT_EQUAL(0, arena.used());
+    TEST_ASSERT_EQUAL(0, arena.failures());
+
+    char msg[200];
+    snprintf(msg, sizeof(msg),
+             "%-14s %5u B: parse %.1f / %.1f us, serialize %.1f / %.1f us "
+             "(heap / arena); puncak %u B heap (%u alokasi), %u B arena",
+             p.name, (unsigned)p.json.size(), h.parseUs, a.parseUs,
+             h.serializeUs, a.serializeUs, (unsigned)h.peak,
+             (unsigned)(heap.calls / BENCH_REPS), (unsigned)a.peak);
+    TEST_MESSAGE(msg);
+  }
+}
+
+int main(int, char **) {
+  payloads[0] = {"ingest batch", ingestBatch()};
+  payloads[1] = {"ingest reply", ingestReply()};
+  payloads[2] = {"template page", templatePage()};
+  UNITY_BEGIN();
+  RUN_TEST(test_output_matches_default_allocator);
+  RUN_TEST(test_nested_parses_do_not_grow);
+  RUN_TEST(test_small_arena_reports_no_memory);
+  RUN_TEST(test_throughput_and_peak_memory);
+  return UNITY_END();
+}
@@ -0,0 +1,195 @@
+// Adafruit_Fingerprint poll(): balasan sensor diputar ulang dari Stream
+// yang disisipi sampah, frame terpotong, length dan checksum rusak. Frame
+// rusak harus dilewati sampai start code 0xEF01 berikutnya; command baru
+// gagal kalau sampai timeout tidak ada balasan valid.
+//
+//   pio test -e native -f test_fingerprint_replay
+
+#include <Adafruit_Fingerprint.h>
+#include <unity.h>
+
+#include <random>
+#include <vector>
+
+#include "SimKernel.h"
+
+typedef std::vector<uint8_t> Bytes;
+
+// Stream yang membaca naskah byte; yang ditulis (command) dibuang
+class ReplayStream : public Stream {
+public:
+  Bytes rx;
+  size_t pos = 0;
+
+  void push(const Bytes &b) { rx.insert(rx.end(), b.begin(), b.end()); }
+  int available() override { return (int)(rx.size() - pos); }
+  int read() override { return pos < rx.size() ? rx[pos++] : -1; }
+  int peek() override { return pos < rx.size() ? rx[pos] : -1; }
+  size_t write(uint8_t) override { return 1; }
+};
+
+static Bytes frame(uint8_t type, const Bytes &payload) {
+  uint16_t len = payload.size() + 2;
+  Bytes b = {0xEF, 0x01, 0xFF, 0xFF, 0xFF, 0xFF, type, (uint8_t)(len >> 8),
+             (uint8_t)len};
+  uint16_t sum = type + (len >> 8) + (len & 0xFF);
+  for (uint8_t c : payload) {
+    b.push_back(c);
+    sum += c;
+  }
+  b.push_back(sum >> 8);
+  b.push_back(sum & 0xFF);
+  return b;
+}
+
+// Balasan fingerFastSearch: cocok di slot 42, confidence 150
+static Bytes searchReply() {
+  return frame(FINGERPRINT_ACKPACKET, {FINGERPRINT_OK, 0, 42, 0, 150});
+}
+
+static Bytes badChecksum() {
+  Bytes b = searchReply();
+  b.back() ^= 0x55;
+  return b;
+}
+
+static Bytes badLength() {
+  Bytes b = searchReply();
+  b[7] = 0x7F; // 32 KB, lebih dari FINGERPRINT_MAX_PAYLOAD
+  return b;
+}
+
+static ReplayStream uart;
+static Adafruit_Fingerprint finger(&uart);
+
+void setUp() {
+  uart.rx.clear();
+  uart.pos = 0;
+  finger.beginFingerFastSearch();
+}
+void tearDown() {}
+
+// Naskah dibaca dalam potongan kecil, seperti byte yang datang dari UART
+// selama beberapa poll()
+static uint8_t pollUntilDone(size_t step = 3) {
+  ReplayStream &s = uart;
+  Bytes all = s.rx;
+  s.rx.clear();
+  s.pos = 0;
+  size_t fed = 0;
+  uint8_t r;
+  while ((r = finger.poll()) == FINGERPRINT_BUSY) {
+    size_t n = std::min(step, all.size() - fed);
+    s.push(Bytes(all.begin() + fed, all.begin() + fed + n));
+    fed += n;
+    sim::charge(1000);
+  }
+  return r;
+}
+
+static void assertMatch(uint8_t r) {
+  TEST_ASSERT_EQUAL(FINGERPRINT_OK, r);
+  TEST_ASSERT_EQUAL(42, finger.fingerID);
+  TEST_ASSERT_EQUAL(150, finger.confidence);
+}
+
+static void test_clean_reply() {
+  uart.push(searchReply());
+  assertMatch(pollUntilDone());
+}
+
+static void test_garbage_before_reply() {
+  uart.push({0x00, 0xFF, 0x13, 0xEF, 0xEF, 0x37});
+  uart.push(searchReply());
+  assertMatch(pollUntilDone());
+}
+
+static void test_bad_checksum_then_reply() {
+  uart.push(badChecksum());
+  uart.push(searchReply());
+  assertMatch(pollUntilDone());
+}
+
+static void test_bad_length_then_reply() {
+  uart.push(badLength());
+  uart.push(searchReply());
+  assertMatch(pollUntilDone());
+}
+
+// Noise yang kebetulan berbunyi 0xEF01 menelan header balasan asli: byte
+// yang sudah terbaca harus dipindai ulang
+static void test_false_start_code_swallows_reply() {
+  uart.push({0xEF, 0x01, 0x00});
+  uart.push(searchReply());
+  assertMatch(pollUntilDone());
+}
+
+// Frame terpotong (byte hilang di tengah) langsung disusul balasan
+static void test_truncated_frame_then_reply() {
+  Bytes cut = searchReply();
+  cut.resize(11);
+  uart.push(cut);
+  uart.push(searchReply());
+  assertMatch(pollUntilDone());
+}
+
+// Hanya frame rusak: tetap menunggu sampai timeout, tidak gagal lebih awal
+static void test_only_corrupt_frames_time_out() {
+  unsigned long start = millis();
+  for (int i = 0; i < 4; i++) {
+    uart.push(badChecksum());
+    uart.push(badLength());
+  }
+  TEST_ASSERT_EQUAL(FINGERPRINT_PACKETRECIEVEERR, pollUntilDone());
+  TEST_ASSERT_GREATER_OR_EQUAL(DEFAULTTIMEOUT, millis() - start);
+}
+
+// Acak: sampah (termasuk potongan start code dan frame rusak) di depan
+// balasan valid, dengan ukuran potongan baca yang berbeda-beda
+static void test_fuzz_garbage_and_framing_errors() {
+  std::mt19937 rng(87);
+  for (int round = 0; round < 2000; round++) {
+    setUp();
+    int parts = rng() % 6;
+    for (int p = 0; p < parts; p++) {
+      switch (rng() % 5) {
+      case 0:
+        uart.push({0xEF});
+        break;
+      case 1:
+        uart.push({0xEF, 0x01});
+        break;
+      case 2:
+        uart.push(badChecksum());
+        break;
+      case 3:
+        uart.push(badLength());
+        break;
+      default:
+        for (int n = rng() % 12; n > 0; n--)
+          uart.push({(uint8_t)rng()});
+        break;
+      }
+    }
+    uart.push(searchReply());
+    uint8_t r = pollUntilDone(1 + rng() % 16);
+    if (r != FINGERPRINT_OK || finger.fingerID != 42) {
+      char msg[48];
+      snprintf(msg, sizeof(msg), "round %d: result 0x%02X", round, r);
+      TEST_FAIL_MESSAGE(msg);
+    }
+  }
+}
+
+int main(int, char **) {
+  UNITY_BEGIN();
+  RUN_TEST(test_clean_reply);
+  RUN_TEST(test_garbage_before_reply);
+  RUN_TEST(test_bad_checksum_then_reply);
+  RUN_TEST(test_bad_length_then_reply);
+  RUN_TEST(test_false_start_code_swallows_reply);
+  RUN_TEST(test_truncated_frame_then_reply);
+  RUN_TEST(test_only_corrupt_frames_time_out);
+  RUN_TEST(test_fuzz_garbage_and_framing_errors);
+  return UNITY_END();
+}
@@ -0,0 +1,177 @@
+// History (src/History.cpp) setelah 50 hari x 300 scan di flash simulasi:
+// retensi HISTORY_SEGMENTS, historyLastScan() dan historySince() harus
+// sama dengan model di RAM, dan waktu flash virtual per append dan per
+// lookup diukur. Lookup lewat index dibandingkan dengan membaca semua
+// record (historySince(0)), yaitu biaya pencarian tanpa index.
+//
+//   pio test -e native -f test_history
+
+#include <Arduino.h>
+#include <LittleFS.h>
+#include <unity.h>
+
+#include <map>
+#include <random>
+#include <vector>
+
+#include "History.h"
+#include "SimKernel.h"
+
+#define FS_DIR ".sim_fs_history_test"
+#define WORKLOAD_SEED 13
+#define DAYS 50
+#define SCANS_PER_DAY 300
+#define UIDS 400
+#define DAY0 1767571200UL // 2026-01-05 00:00 UTC
+#define BIG_UID 1500      // >= HISTORY_UID_BITS, tanpa bitmap
+
+struct Scan {
+  uint16_t uid;
+  uint8_t status;
+  uint32_t unixtime;
+};
+
+static std::vector<Scan> scans; // semua yang di-append, urut waktu
+static uint64_t appendUs = 0, appendMaxUs = 0;
+
+void setUp() {}
+void tearDown() {}
+
+// Record yang masih disimpan: hari terakhir sebanyak segmen yang ada
+static uint32_t firstKept() {
+  uint32_t days = historyCount() / SCANS_PER_DAY;
+  return DAY0 + (DAYS - days) * 86400UL;
+}
+
+static void test_append_fifty_days() {
+  std::mt19937 rng(WORKLOAD_SEED);
+  for (uint32_t day = 0; day < DAYS; day++) {
+    uint32_t t = DAY0 + day * 86400UL + 7 * 3600;
+    for (uint32_t i = 0; i < SCANS_PER_DAY; i++) {
+      t += 1 + rng() % 90;
+      Scan s = {(uint16_t)(1 + rng() % UIDS), (uint8_t)(rng() % 4), t};
+      if (i == 100 && (day == 3 || day == 45))
+        s.uid = BIG_UID;
+      uint64_t v0 = sim::nowUs();
+      TEST_ASSERT_TRUE(historyAppend(s.uid, s.status, s.unixtime));
+      uint64_t us = sim::nowUs() - v0;
+      appendUs += us;
+      if (us > appendMaxUs)
+        appendMaxUs = us;
+      scans.push_back(s);
+    }
+  }
+  // HISTORY_SEGMENTS segmen tertutup + segmen hari ini
+  TEST_ASSERT_EQUAL((HISTORY_SEGMENTS + 1) * SCANS_PER_DAY, historyCount());
+
+  char msg[96];
+  snprintf(msg, sizeof(msg), "append: %.2f ms rata-rata, maks %.1f ms",
+           appendUs / 1000.0 / scans.size(), appendMaxUs / 1000.0);
+  TEST_MESSAGE(msg);
+}
+
+static bool collect(const HistoryRecord &r, void *arg) {
+  ((std::vector<HistoryRecord> *)arg)->push_back(r);
+  return true;
+}
+
+static bool same(const Scan &s, const HistoryRecord &r) {
+  return s.uid == r.uid && s.status == r.status && s.unixtime == r.unixtime;
+}
+
+static void assertSince(uint32_t since) {
+  std::vector<HistoryRecord> got;
+  size_t n = historySince(since, collect, &got);
+  TEST_ASSERT_EQUAL(got.size(), n);
+  uint32_t kept = firstKept();
+  size_t j = 0;
+  for (const Scan &s : scans) {
+    if (s.unixtime < since || s.unixtime < kept)
+      continue;
+    TEST_ASSERT_TRUE(j < got.size());
+    TEST_ASSERT_TRUE(same(s, got[j]));
+    j++;
+  }
+  TEST_ASSERT_EQUAL(j, got.size());
+}
+
+static void test_since_matches_model() {
+  uint64_t v0 = sim::nowUs();
+  assertSince(0);
+  uint64_t fullUs = sim::nowUs() - v0;
+  assertSince(firstKept());
+  // Di tengah hari: binary search di dalam segmen
+  assertSince(DAY0 + 45 * 86400UL + 12 * 3600);
+  v0 = sim::nowUs();
+  assertSince(DAY0 + 49 * 86400UL);
+  uint64_t todayUs = sim::nowUs() - v0;
+
+  char msg[96];
+  snprintf(msg, sizeof(msg), "since: semua %.1f ms, hari ini %.1f ms",
+           fullUs / 1000.0, todayUs / 1000.0);
+  TEST_MESSAGE(msg);
+  TEST_ASSERT_TRUE(todayUs * 10 < fullUs);
+}
+
+// Model: scan terakhir per uid di antara record yang masih disimpan
+static void assertLastScans(uint64_t *totalUs) {
+  std::map<uint16_t, Scan> last;
+  uint32_t kept = firstKept();
+  for (const Scan &s : scans)
+    if (s.unixtime >= kept)
+      last[s.uid] = s;
+
+  // UIDS + 1 tidak pernah scan
+  std::vector<uint16_t> uids;
+  for (uint16_t uid = 1; uid <= UIDS + 1; uid++)
+    uids.push_back(uid);
+  uids.push_back(BIG_UID);
+
+  for (uint16_t uid : uids) {
+    HistoryRecord r;
+    uint64_t v0 = sim::nowUs();
+    bool found = historyLastScan(uid, &r);
+    *totalUs += sim::nowUs() - v0;
+    auto it = last.find(uid);
+    TEST_ASSERT_EQUAL(it != last.end(), found);
+    if (found)
+      TEST_ASSERT_TRUE(same(it->second, r));
+  }
+}
+
+static void test_last_scan_matches_model() {
+  uint64_t total = 0;
+  assertLastScans(&total);
+  double lookupMs = total / 1000.0 / (UIDS + 2);
+
+  uint64_t v0 = sim::nowUs();
+  std::vector<HistoryRecord> all;
+  historySince(0, collect, &all);
+  double scanAllMs = (sim::nowUs() - v0) / 1000.0;
+
+  char msg[96];
+  snprintf(msg, sizeof(msg), "lastScan: %.2f ms per uid, baca semua %.1f ms",
+           lookupMs, scanAllMs);
+  TEST_MESSAGE(msg);
+  TEST_ASSERT_TRUE(lookupMs * 10 < scanAllMs);
+}
+
+// Boot ulang: index dari /log/index.dat, segmen hari ini dibangun ulang
+static void test_reboot_keeps_history() {
+  TEST_ASSERT_TRUE(historyBegin());
+  TEST_ASSERT_EQUAL((HISTORY_SEGMENTS + 1) * SCANS_PER_DAY, historyCount());
+  uint64_t total = 0;
+  assertLastScans(&total);
+  assertSince(DAY0 + 45 * 86400UL + 12 * 3600);
+}
+
+int main(int, char **) {
+  sim::fsSetRoot(FS_DIR, true);
+  historyBegin();
+  UNITY_BEGIN();
+  RUN_TEST(test_append_fifty_days);
+  RUN_TEST(test_since_matches_model);
+  RUN_TEST(test_last_scan_matches_model);
+  RUN_TEST(test_reboot_keeps_history);
+  return UNITY_END();
+}
@@ -0,0 +1,220 @@
+// Outbox (src/Outbox.cpp) di bawah listrik padam: beban push/commit yang
+// sama diulang, dan listrik diputus di setiap operasi flash secara
+// bergantian. Setelah boot ulang (outboxBegin) tidak boleh ada record yang
+// hilang, dan yang terkirim ulang hanya batch yang commit-nya terpotong.
+//
+//   pio test -e native -f test_outbox_power_cut
+
+#include <Arduino.h>
+#include <FS.h>
+#include <LittleFS.h>
+#include <esp32/rom/crc.h>
+#include <unity.h>
+
+#include <random>
+#include <vector>
+
+#include "Outbox.h"
+
+#define FS_DIR ".sim_fs_outbox_test"
+#define WORKLOAD_SEED 87
+// Lebih dari OUTBOX_COMPACT_BYTES, supaya compaction ikut terpotong
+#define WORKLOAD_RECORDS 450
+
+void setUp() { sim::fsSetRoot(FS_DIR, true); }
+void tearDown() { sim::fsPowerRestore(); }
+
+// Yang diketahui pemanggil sebelum listrik padam. uid = nomor urut push.
+struct Model {
+  uint32_t pushed = 0;    // uid 1..pushed sudah dikonfirmasi outboxPush
+  uint32_t committed = 0; // uid 1..committed sudah dikonfirmasi outboxCommit
+  // Operasi yang sedang jalan saat listrik padam: hasilnya tidak pasti
+  bool doubtPush = false;
+  uint32_t doubtCommit = 0;
+};
+
+struct Totals {
+  uint32_t cuts = 0;
+  uint32_t replayed = 0; // record dari commit yang terpotong, terkirim ulang
+  uint32_t lost = 0;
+};
+
+static bool powerGone(uint32_t cutAt) {
+  return cutAt && sim::fsOps() >= cutAt;
+}
+
+// Push bergelombang, upload per UPLOAD_BATCH-an seperti uploader task.
+// Jalan sampai selesai atau sampai listrik padam di cutAt.
+static void workload(uint32_t cutAt, Model &m) {
+  std::mt19937 rng(WORKLOAD_SEED);
+  while (m.pushed < WORKLOAD_RECORDS || m.committed < m.pushed) {
+    uint32_t burst = 1 + rng() % 24;
+    for (; burst > 0 && m.pushed < WORKLOAD_RECORDS; burst--) {
+      bool ok = outboxPush(m.pushed + 1, 0, 1767600000 + m.pushed);
+      if (powerGone(cutAt)) {
+        m.doubtPush = true;
+        return;
+      }
+      TEST_ASSERT_TRUE(ok);
+      m.pushed++;
+    }
+    // Kadang server tidak terjangkau dan antrian menumpuk
+    if (m.pushed < WORKLOAD_RECORDS && rng() % 3 == 0)
+      continue;
+    while (m.committed < m.pushed) {
+      OutboxRecord batch[32];
+      size_t n = outboxPeek(batch, 1 + rng() % 32);
+      TEST_ASSERT_TRUE(n > 0);
+      TEST_ASSERT_EQUAL(m.committed + 1, batch[0].uid);
+      bool ok = outboxCommit(n);
+      if (powerGone(cutAt)) {
+        m.doubtCommit = n;
+        return;
+      }
+      TEST_ASSERT_TRUE(ok);
+      m.committed += n;
+    }
+  }
+}
+
+// Boot ulang dari isi flash saja, lalu bandingkan dengan model
+static void checkRecovery(const Model &m, Totals &t) {
+  sim::fsPowerRestore();
+  TEST_ASSERT_TRUE(outboxBegin());
+  std::vector<OutboxRecord> recs(outboxPending() + 1);
+  recs.resize(outboxPeek(recs.data(), recs.size()));
+
+  // Record yang masih ada selalu satu rentang uid berurutan, dan seq
+  // (kunci idempotensi di server) tetap milik record yang sama
+  for (size_t i = 0; i < recs.size(); i++) {
+    TEST_ASSERT_EQUAL(recs[i].uid, recs[i].seq);
+    if (i > 0)
+      TEST_ASSERT_EQUAL(recs[i - 1].uid + 1, recs[i].uid);
+  }
+  uint32_t first = recs.empty() ? m.pushed + 1 : recs[0].uid;
+  uint32_t last = recs.empty() ? m.pushed : recs.back().uid;
+
+  // Head: tepat setelah commit terakhir yang dikonfirmasi, atau setelah
+  // commit yang terpotong (cursor pindah utuh, tidak setengah batch)
+  bool replayedDoubt = first == m.committed + 1;
+  TEST_ASSERT_TRUE(replayedDoubt || first == m.committed + m.doubtCommit + 1);
+  if (m.doubtCommit && replayedDoubt)
+    t.replayed += m.doubtCommit;
+  // Tail: push terakhir yang dikonfirmasi, +1 kalau push terpotong sempat
+  // tersimpan
+  TEST_ASSERT_TRUE(last == m.pushed || (m.doubtPush && last == m.pushed + 1));
+  if (last < m.pushed)
+    t.lost += m.pushed - last;
+
+  // Push sesudah boot tidak boleh memakai ulang seq yang mungkin sudah
+  // sampai di server
+  TEST_ASSERT_TRUE(outboxPush(1, 0, 1767600000));
+  std::vector<OutboxRecord> all(outboxPending());
+  all.resize(outboxPeek(all.data(), all.size()));
+  TEST_ASSERT_TRUE(all.back().seq > last);
+  t.cuts++;
+}
+
+static void test_power_cut_at_every_flash_operation() {
+  Model dry;
+  uint32_t base = sim::fsOps();
+  outboxBegin();
+  workload(0, dry);
+  uint32_t ops = sim::fsOps() - base;
+  TEST_ASSERT_EQUAL(WORKLOAD_RECORDS, dry.committed);
+
+  Totals t;
+  for (uint32_t k = 1; k <= ops; k++) {
+    setUp();
+    Model m;
+    uint32_t cutAt = sim::fsOps() + k;
+    sim::fsPowerCutAt(cutAt);
+    outboxBegin();
+    if (!powerGone(cutAt))
+      workload(cutAt, m);
+    checkRecovery(m, t);
+  }
+  TEST_ASSERT_EQUAL(0, t.lost);
+
+  char msg[96];
+  snprintf(msg, sizeof(msg), "%u cuts over %u flash ops: %u replayed, %u lost",
+           (unsigned)t.cuts, (unsigned)ops, (unsigned)t.replayed,
+           (unsigned)t.lost);
+  TEST_MESSAGE(msg);
+}
+
+// Compaction gagal (rename ke file data ditolak): commit tetap maju lewat
+// cursor, dan record yang sudah di-ack tidak terkirim ulang setelah boot
+static void test_failed_compaction_keeps_cursor() {
+  outboxBegin();
+  for (uint16_t uid = 1; uid <= 10; uid++)
+    TEST_ASSERT_TRUE(outboxPush(uid, 0, 1767600000 + uid));
+
+  sim::fsFailNext("/outbox.dat");
+  TEST_ASSERT_TRUE(outboxCommit(10)); // antrian habis: mencoba compact
+  TEST_ASSERT_EQUAL(0, outboxPending());
+  TEST_ASSERT_TRUE(outboxPush(11, 0, 1767600011));
+
+  outboxBegin();
+  OutboxRecord r;
+  TEST_ASSERT_EQUAL(1, outboxPending());
+  TEST_ASSERT_EQUAL(1, outboxPeek(&r, 1));
+  TEST_ASSERT_EQUAL(11, r.uid);
+}
+
+// Outbox format lama (record 12 byte tanpa seq, magic "AXOB") dari
+// firmware sebelumnya: record yang belum di-ack dipindah dengan seq baru
+static void test_migrates_v1_outbox() {
+  struct {
+    uint32_t magic, gen;
+  } h = {0x424F5841UL, 3};
+  struct {
+    uint16_t uid;
+    uint8_t status, flags;
+    uint32_t unixtime, crc;
+  } r;
+  fs::File f = LittleFS.open("/outbox.dat", FILE_WRITE);
+  f.write((const uint8_t *)&h, sizeof(h));
+  for (uint16_t uid = 1; uid <= 5; uid++) {
+    r = {uid, 1, 0, 1767600000U + uid, 0};
+    r.crc = crc32_le(0, (const uint8_t *)&r, 8);
+    f.write((const uint8_t *)&r, sizeof(r));
+  }
+  f.close();
+  // Cursor generasi 3: dua record pertama sudah di-ack
+  struct {
+    uint32_t magic, gen, head, crc;
+  } c = {0x434F5841UL, 3, (uint32_t)(sizeof(h) + 2 * sizeof(r)), 0};
+  c.crc = crc32_le(0, (const uint8_t *)&c, 12);
+  f = LittleFS.open("/outbox.cur", FILE_WRITE);
+  f.write((const uint8_t *)&c, sizeof(c));
+  f.close();
+
+  TEST_ASSERT_TRUE(outboxBegin());
+  OutboxRecord recs[4];
+  TEST_ASSERT_EQUAL(3, outboxPending());
+  TEST_ASSERT_EQUAL(3, outboxPeek(recs, 4));
+  for (uint32_t i = 0; i < 3; i++) {
+    TEST_ASSERT_EQUAL(3 + i, recs[i].uid);
+    TEST_ASSERT_EQUAL(1, recs[i].status);
+    TEST_ASSERT_EQUAL(1767600003U + i, recs[i].unixtime);
+    TEST_ASSERT_EQUAL(1 + i, recs[i].seq);
+  }
+  TEST_ASSERT_TRUE(outboxEpoch() != 0);
+
+  // Boot berikutnya membaca format baru apa adanya
+  uint32_t epoch = outboxEpoch();
+  TEST_ASSERT_TRUE(outboxPush(6, 0, 1767600006));
+  TEST_ASSERT_TRUE(outboxBegin());
+  TEST_ASSERT_EQUAL(epoch, outboxEpoch());
+  TEST_ASSERT_EQUAL(4, outboxPeek(recs, 4));
+  TEST_ASSERT_EQUAL(4, recs[3].seq);
+}
+
+int main(int, char **) {
+  UNITY_BEGIN();
+  RUN_TEST(test_power_cut_at_every_flash_operation);
+  RUN_TEST(test_failed_compaction_keeps_cursor);
+  RUN_TEST(test_migrates_v1_outbox);
+  return UNITY_END();
+}
@@ -0,0 +1,189 @@
+// JsonPullParser (lib/ArduinoJson): batas buffer token, dan benchmark
+// membaca daftar template 5 MB dari Stream seperti TemplateSync.
+//
+//   pio test -e native -f test_pull_parser
+
+#include <ArduinoJson.h>
+#include <unity.h>
+
+#include <chrono>
+#include <string>
+
+#include "SimDevices.h"
+
+#define BENCH_BYTES (5UL * 1024 * 1024)
+
+static std::string member(const std::string &key, size_t valueLen) {
+  return "{\"" + key + "\":\"" + std::string(valueLen, 'a') + "\"}";
+}
+
+void setUp() {}
+void tearDown() {}
+
+// Token buffer 64 byte: 63 karakter masih muat
+static void test_string_that_fits_is_read() {
+  std::string json = member("k", 63);
+  auto parser = makeJsonPullParser(json.c_str());
+  JsonDocument doc;
+  TEST_ASSERT_TRUE(parser.next() == JsonToken::ObjectStart);
+  TEST_ASSERT_TRUE(parser.read(doc) == DeserializationError::Ok);
+  TEST_ASSERT_EQUAL(63, doc["k"].as<JsonString>().size());
+  TEST_ASSERT_TRUE(parser.next() == JsonToken::End);
+}
+
+static void test_long_string_is_not_truncated_silently() {
+  std::string json = member("k", 70);
+  auto parser = makeJsonPullParser(json.c_str());
+  JsonDocument doc;
+  TEST_ASSERT_TRUE(parser.next() == JsonToken::ObjectStart);
+  TEST_ASSERT_TRUE(parser.read(doc) == DeserializationError::NoMemory);
+  TEST_ASSERT_TRUE(parser.token() == JsonToken::Error);
+  TEST_ASSERT_TRUE(parser.error() == DeserializationError::NoMemory);
+  TEST_ASSERT_TRUE(parser.next() == JsonToken::Error);
+}
+
+// Token per token: string tetap dipotong, tapi ditandai
+static void test_long_string_token_reports_truncated() {
+  std::string json = member("k", 70);
+  auto parser = makeJsonPullParser(json.c_str());
+  TEST_ASSERT_TRUE(parser.next() == JsonToken::ObjectStart);
+  TEST_ASSERT_TRUE(parser.next() == JsonToken::Key);
+  TEST_ASSERT_FALSE(parser.truncated());
+  TEST_ASSERT_TRUE(parser.next() == JsonToken::String);
+  TEST_ASSERT_TRUE(parser.truncated());
+  TEST_ASSERT_EQUAL(63, parser.str().size());
+  TEST_ASSERT_TRUE(parser.next() == JsonToken::ObjectEnd);
+  TEST_ASSERT_TRUE(parser.next() == JsonToken::End);
+}
+
+static void test_long_key_fails_read() {
+  std::string json = "{\"" + std::string(70, 'k') + "\":1}";
+  auto parser = makeJsonPullParser(json.c_str());
+  JsonDocument doc;
+  TEST_ASSERT_TRUE(parser.next() == JsonToken::ObjectStart);
+  TEST_ASSERT_TRUE(parser.read(doc) == DeserializationError::NoMemory);
+}
+
+static void test_long_string_at_top_level_fails_read() {
+  std::string json = "[\"" + std::string(70, 'a') + "\"]";
+  auto parser = makeJsonPullParser(json.c_str());
+  JsonDocument doc;
+  TEST_ASSERT_TRUE(parser.next() == JsonToken::ArrayStart);
+  TEST_ASSERT_TRUE(parser.next() == JsonToken::String);
+  TEST_ASSERT_TRUE(parser.read(doc) == DeserializationError::NoMemory);
+}
+
+static void test_larger_buffer_reads_long_string() {
+  std::string json = member("k", 70);
+  auto parser = makeJsonPullParser<128>(json.c_str());
+  JsonDocument doc;
+  TEST_ASSERT_TRUE(parser.next() == JsonToken::ObjectStart);
+  TEST_ASSERT_TRUE(parser.read(doc) == DeserializationError::Ok);
+  TEST_ASSERT_TRUE(doc["k"].as<std::string>() == std::string(70, 'a'));
+}
+
+// Body /api/templates?since=N sebesar BENCH_BYTES, dibuat sambil dibaca
+// (tidak pernah ada utuh di RAM)
+class TemplateListStream : public Stream {
+public:
+  int available() override { return len_ - pos_ || !done_; }
+  int read() override { return fill() ? line_[pos_++] : -1; }
+  int peek() override { return fill() ? line_[pos_] : -1; }
+  size_t write(uint8_t) override { return 0; }
+
+  size_t sent = 0;
+  uint32_t entries = 0;
+
+private:
+  bool fill() {
+    if (pos_ < len_)
+      return true;
+    if (done_)
+      return false;
+    if (sent == 0) {
+      len_ = snprintf(line_, sizeof(line_), "{\"templates\":[");
+    } else if (sent < BENCH_BYTES) {
+      entries++;
+      len_ = snprintf(line_, sizeof(line_),
+                      "%s{\"uid\":%lu,\"version\":%lu,\"crc\":%lu,"
+                      "\"size\":512,\"deleted\":%s}",
+                      entries > 1 ? "," : "", (unsigned long)(entries % 1000),
+                      (unsigned long)entries,
+                      (unsigned long)(entries * 2654435761UL),
+                      entries % 7 ? "false" : "true");
+    } else {
+      len_ = snprintf(line_, sizeof(line_), "],\"more\":false}");
+      done_ = true;
+    }
+    sent += len_;
+    pos_ = 0;
+    return true;
+  }
+
+  char line_[128];
+  int len_ = 0;
+  int pos_ = 0;
+  bool done_ = false;
+};
+
+static void test_stream_5mb_constant_memory() {
+  static char arenaBuf[4 * ARDUINOJSON_POOL_CAPACITY * 2 * sizeof(void *)];
+  ArenaAllocator arena(arenaBuf, sizeof(arenaBuf));
+  TemplateListStream body;
+  size_t heapBefore = sim::heapUsed();
+  size_t heapMax = 0;
+  size_t arenaEarly = 0;
+  uint32_t versions = 0;
+
+  auto start = std::chrono::steady_clock::now();
+  auto parser = makeJsonPullParser(body);
+  TEST_ASSERT_TRUE(parser.next() == JsonToken::ObjectStart);
+  TEST_ASSERT_TRUE(parser.next() == JsonToken::Key);
+  TEST_ASSERT_TRUE(parser.next() == JsonToken::ArrayStart);
+  while (parser.next() == JsonToken::ObjectStart) {
+    JsonDocument t(&arena);
+    TEST_ASSERT_TRUE(parser.read(t) == DeserializationError::Ok);
+    versions = t["version"] | 0UL;
+    if (versions == 1000)
+      arenaEarly = arena.highWaterMark();
+    size_t heap = sim::heapUsed() - heapBefore;
+    if (heap > heapMax)
+      heapMax = heap;
+  }
+  TEST_ASSERT_TRUE(parser.token() == JsonToken::ArrayEnd);
+  TEST_ASSERT_TRUE(parser.next() == JsonToken::Key);
+  TEST_ASSERT_TRUE(parser.next() == JsonToken::Boolean);
+  TEST_ASSERT_TRUE(parser.next() == JsonToken::ObjectEnd);
+  TEST_ASSERT_TRUE(parser.next() == JsonToken::End);
+  double secs = std::chrono::duration<double>(
+                    std::chrono::steady_clock::now() - start)
+                    .count();
+
+  TEST_ASSERT_GREATER_OR_EQUAL(BENCH_BYTES, body.sent);
+  TEST_ASSERT_EQUAL(body.entries, versions);
+  // Memori tetap: tidak ada heap, arena tidak tumbuh setelah 1000 entry
+  TEST_ASSERT_EQUAL(0, heapMax);
+  TEST_ASSERT_EQUAL(0, arena.failures());
+  TEST_ASSERT_EQUAL(arenaEarly, arena.highWaterMark());
+
+  char msg[160];
+  snprintf(msg, sizeof(msg),
+           "%.1f MB, %lu entries in %.2f s host (%.1f MB/s); parser %u B, "
+           "arena peak %u B",
+           body.sent / 1048576.0, (unsigned long)body.entries, secs,
+           body.sent / 1048576.0 / secs, (unsigned)sizeof(parser),
+           (unsigned)arena.highWaterMark());
+  TEST_MESSAGE(msg);
+}
+
+int main(int, char **) {
+  UNITY_BEGIN();
+  RUN_TEST(test_string_that_fits_is_read);
+  RUN_TEST(test_long_string_is_not_truncated_silently);
+  RUN_TEST(test_long_string_token_reports_truncated);
+  RUN_TEST(test_long_key_fails_read);
+  RUN_TEST(test_long_string_at_top_level_fails_read);
+  RUN_TEST(test_larger_buffer_reads_long_string);
+  RUN_TEST(test_stream_5mb_constant_memory);
+  return UNITY_END();
+}
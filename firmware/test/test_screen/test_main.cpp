@@ -0,0 +1,159 @@
+// Screen + widget standby (src/Screen.cpp, src/Widgets.cpp) di atas TFT
+// simulasi: isi panel harus sama piksel per piksel dengan halaman yang
+// digambar utuh, sementara yang lewat SPI hanya dirty rect. Byte per
+// frame dihitung dari TFT_eSPI::spiBytes (piksel + perintah window).
+//
+//   pio test -e native -f test_screen
+
+#include <TFT_eSPI.h>
+#include <unity.h>
+
+#include <vector>
+
+#include "Widgets.h"
+
+// Satu window ST7789: CASET + RASET + RAMWR beserta argumennya
+#define WINDOW_BYTES 11
+#define FULL_SCREEN_BYTES (240UL * 240 * 2)
+// Satu window per strip SCREEN_STRIP_H baris
+#define WINDOWS(rows) (((rows) + SCREEN_STRIP_H - 1) / SCREEN_STRIP_H)
+
+static TFT_eSPI panel;
+static Screen *screen;
+static HeaderWidget header;
+static ClockWidget clockW;
+static SecondsWidget seconds;
+static StatusWidget status;
+static WifiWidget wifi;
+static Widget *page[] = {&header, &clockW, &seconds, &status, &wifi};
+
+void setUp() {}
+void tearDown() {}
+
+// Halaman yang sama digambar utuh per widget (tanpa strip, tanpa dirty
+// rect), sebagai acuan
+static std::vector<uint16_t> reference() {
+  std::vector<uint16_t> fb(240 * 240);
+  for (Widget *w : page) {
+    TFT_eSprite spr(&panel);
+    spr.createSprite(w->w, w->h);
+    w->render(spr, 0);
+    const uint16_t *px = (const uint16_t *)spr.getPointer();
+    for (int16_t y = 0; y < w->h; y++)
+      for (int16_t x = 0; x < w->w; x++)
+        fb[(w->y + y) * 240 + w->x + x] = px[y * w->w + x];
+  }
+  return fb;
+}
+
+static void assertPanelMatches() {
+  std::vector<uint16_t> ref = reference();
+  const uint16_t *fb = panel.frame();
+  for (size_t i = 0; i < ref.size(); i++) {
+    if (fb[i] != ref[i]) {
+      char msg[64];
+      snprintf(msg, sizeof(msg), "piksel (%u,%u): 0x%04X, harusnya 0x%04X",
+               (unsigned)(i % 240), (unsigned)(i / 240), fb[i], ref[i]);
+      TEST_FAIL_MESSAGE(msg);
+    }
+  }
+}
+
+// Satu frame: update() sampai tidak ada yang dirty. Return byte SPI
+// frame itu.
+static uint64_t frame(uint32_t maxBytes = 0) {
+  uint64_t before = TFT_eSPI::spiBytes;
+  do
+    screen->update(maxBytes);
+  while (screen->pending());
+  return TFT_eSPI::spiBytes - before;
+}
+
+static void report(const char *what, uint64_t bytes) {
+  char msg[96];
+  snprintf(msg, sizeof(msg), "%-14s %6llu byte (%.1f%% layar penuh)", what,
+           (unsigned long long)bytes, 100.0 * bytes / FULL_SCREEN_BYTES);
+  TEST_MESSAGE(msg);
+}
+
+static void test_full_page_then_dirty_rects_only() {
+  clockW.set(DateTime(2026, 1, 5, 8, 0, 0));
+  seconds.set(DateTime(2026, 1, 5, 8, 0, 0));
+  status.set("CHECK IN", 0x5DFF, TFT_WHITE);
+  wifi.set(true, "192.168.1.50");
+  screen->setPage(page, 5);
+  uint64_t full = frame();
+  assertPanelMatches();
+  report("halaman baru", full);
+  // Halaman baru: layar penuh, satu window per strip tiap widget
+  TEST_ASSERT_EQUAL(FULL_SCREEN_BYTES +
+                        (WINDOWS(50) + WINDOWS(76) + WINDOWS(20) +
+                         WINDOWS(68) + WINDOWS(26)) *
+                            WINDOW_BYTES,
+                    full);
+
+  // Detik: hanya area ":SS" 40x20
+  seconds.set(DateTime(2026, 1, 5, 8, 0, 1));
+  uint64_t tick = frame();
+  assertPanelMatches();
+  report("detik", tick);
+  TEST_ASSERT_EQUAL(40 * 20 * 2 + WINDOWS(20) * WINDOW_BYTES, tick);
+
+  // Menit: digit HH:MM 200x76 + detik
+  clockW.set(DateTime(2026, 1, 5, 8, 1, 0));
+  seconds.set(DateTime(2026, 1, 5, 8, 1, 0));
+  uint64_t minute = frame();
+  assertPanelMatches();
+  report("menit", minute);
+  TEST_ASSERT_EQUAL(200 * 76 * 2 + 40 * 20 * 2 +
+                        (WINDOWS(76) + WINDOWS(20)) * WINDOW_BYTES,
+                    minute);
+
+  // Status dan wifi
+  status.set("MEMINDAI...", TFT_YELLOW, TFT_BLACK);
+  uint64_t box = frame();
+  assertPanelMatches();
+  report("status", box);
+  TEST_ASSERT_EQUAL(240 * 56 * 2 + WINDOWS(56) * WINDOW_BYTES, box);
+
+  wifi.set(false, "");
+  uint64_t link = frame();
+  assertPanelMatches();
+  report("wifi", link);
+  TEST_ASSERT_EQUAL(240 * 26 * 2 + WINDOWS(26) * WINDOW_BYTES, link);
+
+  // Tidak ada yang berubah: tidak ada byte
+  clockW.set(DateTime(2026, 1, 5, 8, 1, 0));
+  TEST_ASSERT_EQUAL(0, frame());
+}
+
+// update() dengan budget seperti loop() (SCREEN_UPDATE_BYTES): hasil
+// akhirnya sama, hanya dikirim dalam beberapa panggilan
+static void test_budgeted_update_is_pixel_exact() {
+  status.set("BERHASIL", TFT_GREEN, TFT_BLACK);
+  status.setSensorError(true);
+  clockW.set(DateTime(2026, 1, 5, 9, 30, 0));
+  seconds.set(DateTime(2026, 1, 5, 9, 30, 15));
+  uint32_t calls = 0;
+  uint64_t before = TFT_eSPI::spiBytes;
+  do {
+    uint32_t sent = screen->update(9600);
+    TEST_ASSERT_TRUE(sent <= 9600 + 240 * SCREEN_STRIP_H * 2);
+    calls++;
+  } while (screen->pending());
+  assertPanelMatches();
+  TEST_ASSERT_TRUE(calls > 1);
+  char msg[64];
+  snprintf(msg, sizeof(msg), "%u panggilan, %llu byte", (unsigned)calls,
+           (unsigned long long)(TFT_eSPI::spiBytes - before));
+  TEST_MESSAGE(msg);
+}
+
+int main(int, char **) {
+  screen = new Screen(&panel);
+  screen->begin();
+  UNITY_BEGIN();
+  RUN_TEST(test_full_page_then_dirty_rects_only);
+  RUN_TEST(test_budgeted_update_is_pixel_exact);
+  return UNITY_END();
+}
@@ -0,0 +1,253 @@
+// Smooth font TFT_eSPI (lib/TFT_eSPI/Extensions/Smooth_font) dengan font
+// vlw 200 glyph di flash simulasi: index unicode terurut harus sama dengan
+// pencarian linear, glyph dari cache sama piksel per piksel dengan yang
+// dibaca dari file, dan throughput drawString diukur untuk teks yang muat
+// di cache (hit) dan teks 200 glyph yang selalu miss (jalur baca file,
+// seperti sebelum ada cache).
+//
+//   pio test -e native -f test_smooth_font
+
+#include <Arduino.h>
+#include <LittleFS.h>
+#include <TFT_eSPI.h>
+#include <unity.h>
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include "SimKernel.h"
+
+#define FS_DIR ".sim_fs_font_test"
+#define FONT_NAME "bench"
+#define GLYPHS 200
+#define GLYPH_W 12
+#define GLYPH_H 16
+#define GLYPH_ADVANCE 14
+#define GLYPH_DY 14 // atas bitmap di atas baseline
+#define GLYPH_DX 1
+#define FONT_ASCENT 14
+#define FONT_DESCENT 4
+#define DRAWS 200
+#define LOOKUP_REPS 200
+
+static TFT_eSPI panel;
+static TFT_eSprite spr(&panel);
+
+// 0x21..0x7E lalu 0x100.., total GLYPHS
+static uint16_t glyphCode(uint16_t i) {
+  return i < 94 ? 0x21 + i : 0x100 + i - 94;
+}
+
+// Alpha per piksel: campuran kosong, penuh dan setengah supaya semua
+// cabang drawGlyph (hline, drawPixel + alphaBlend) terpakai
+static uint8_t alpha(uint16_t code, int x, int y) {
+  static const uint8_t levels[] = {0x00, 0xFF, 0x80, 0x40, 0xFF};
+  return levels[(code + x * 3 + y * 5) % 5];
+}
+
+static void put32(std::vector<uint8_t> &v, uint32_t x) {
+  v.push_back(x >> 24);
+  v.push_back(x >> 16);
+  v.push_back(x >> 8);
+  v.push_back(x);
+}
+
+static void writeFont() {
+  std::vector<uint8_t> vlw;
+  put32(vlw, GLYPHS);
+  put32(vlw, 11); // versi encoder vlw
+  put32(vlw, 18);
+  put32(vlw, 0);
+  put32(vlw, FONT_ASCENT);
+  put32(vlw, FONT_DESCENT);
+  for (uint16_t i = 0; i < GLYPHS; i++) {
+    put32(vlw, glyphCode(i));
+    put32(vlw, GLYPH_H);
+    put32(vlw, GLYPH_W);
+    put32(vlw, GLYPH_ADVANCE);
+    put32(vlw, GLYPH_DY);
+    put32(vlw, GLYPH_DX);
+    put32(vlw, 0);
+  }
+  for (uint16_t i = 0; i < GLYPHS; i++)
+    for (int y = 0; y < GLYPH_H; y++)
+      for (int x = 0; x < GLYPH_W; x++)
+        vlw.push_back(alpha(glyphCode(i), x, y));
+  vlw.push_back(5);
+  for (const char *p = FONT_NAME; *p; p++)
+    vlw.push_back(*p);
+  vlw.push_back(0);
+  vlw.push_back(1);
+  File f = LittleFS.open("/" FONT_NAME ".vlw", "w");
+  f.write(vlw.data(), vlw.size());
+  f.close();
+}
+
+static void utf8(std::string &s, uint16_t c) {
+  if (c < 0x80) {
+    s += (char)c;
+  } else {
+    s += (char)(0xC0 | c >> 6);
+    s += (char)(0x80 | (c & 0x3F));
+  }
+}
+
+// Glyph first..first+n-1, diulang sampai len karakter
+static std::string text(uint16_t first, uint16_t n, uint16_t len) {
+  std::string s;
+  for (uint16_t i = 0; i < len; i++)
+    utf8(s, glyphCode(first + i % n));
+  return s;
+}
+
+static double hostUs(std::chrono::steady_clock::time_point t0) {
+  return std::chrono::duration<double, std::micro>(
+             std::chrono::steady_clock::now() - t0)
+      .count();
+}
+
+void setUp() {
+  spr.loadFont(FONT_NAME);
+  spr.glyphCacheHits = 0;
+  spr.glyphCacheMisses = 0;
+}
+void tearDown() { spr.unloadFont(); }
+
+// Waktu host LOOKUP_REPS putaran atas codes; out = nomor glyph atau -1
+static double lookups(const std::vector<uint16_t> &codes,
+                      std::vector<int> &out) {
+  out.clear();
+  for (uint16_t c : codes) {
+    uint16_t g = 0;
+    out.push_back(spr.getUnicodeIndex(c, &g) ? g : -1);
+  }
+  volatile uint32_t sink = 0;
+  auto t0 = std::chrono::steady_clock::now();
+  for (int rep = 0; rep < LOOKUP_REPS; rep++)
+    for (uint16_t c : codes) {
+      uint16_t g = 0;
+      sink = sink + spr.getUnicodeIndex(c, &g) + g;
+    }
+  return hostUs(t0);
+}
+
+static void test_index_matches_linear_search() {
+  TEST_ASSERT_TRUE(spr.fontLoaded);
+  TEST_ASSERT_EQUAL(GLYPHS, spr.gFont.gCount);
+
+  std::vector<uint16_t> codes;
+  for (uint32_t c = 0; c < 0x200; c++)
+    codes.push_back(c);
+
+  // gSorted == NULL: getUnicodeIndex() jatuh ke pencarian linear lama
+  uint16_t *sorted = spr.gSorted;
+  std::vector<int> linear, indexed;
+  spr.gSorted = nullptr;
+  double linearUs = lookups(codes, linear);
+  spr.gSorted = sorted;
+  double sortedUs = lookups(codes, indexed);
+
+  TEST_ASSERT_TRUE(linear == indexed);
+  uint32_t found = 0;
+  for (int g : indexed)
+    found += g >= 0;
+  TEST_ASSERT_EQUAL(GLYPHS, found);
+
+  char msg[96];
+  snprintf(msg, sizeof(msg), "lookup: linear %.1f ns, index %.1f ns",
+           linearUs * 1000 / (LOOKUP_REPS * codes.size()),
+           sortedUs * 1000 / (LOOKUP_REPS * codes.size()));
+  TEST_MESSAGE(msg);
+}
+
+// Satu glyph di (10, 5), tanpa isi latar: piksel = alphaBlend dari bitmap
+static void test_glyph_pixels_from_cache_and_file() {
+  spr.createSprite(240, 40);
+  spr.setTextColor(TFT_YELLOW, TFT_NAVY);
+  uint16_t code = glyphCode(120);
+  std::string s;
+  utf8(s, code);
+  for (int pass = 0; pass < 2; pass++) { // miss, lalu hit
+    spr.fillSprite(TFT_NAVY);
+    spr.drawString(s.c_str(), 10, 5);
+    for (int y = 0; y < GLYPH_H; y++)
+      for (int x = 0; x < GLYPH_W; x++) {
+        uint8_t a = alpha(code, x, y);
+        uint16_t want = a == 0      ? TFT_NAVY
+                        : a == 0xFF ? TFT_YELLOW
+                                    : spr.alphaBlend(a, TFT_YELLOW, TFT_NAVY);
+        TEST_ASSERT_EQUAL_UINT16(
+            want, spr.readPixel(10 + GLYPH_DX + x,
+                                5 + FONT_ASCENT - GLYPH_DY + y));
+      }
+  }
+  TEST_ASSERT_EQUAL(1, spr.glyphCacheMisses);
+  TEST_ASSERT_EQUAL(1, spr.glyphCacheHits);
+}
+
+struct Run {
+  double hostUsPerString;
+  uint64_t flashUs; // waktu virtual baca file font
+};
+
+static Run drawMany(const std::string &s, std::vector<uint16_t> *pixels) {
+  auto t0 = std::chrono::steady_clock::now();
+  uint64_t v0 = sim::nowUs();
+  for (int i = 0; i < DRAWS; i++)
+    spr.drawString(s.c_str(), 2, 2);
+  Run r = {hostUs(t0) / DRAWS, sim::nowUs() - v0};
+  if (pixels) {
+    const uint16_t *px = (const uint16_t *)spr.getPointer();
+    pixels->assign(px, px + spr.width() * spr.height());
+  }
+  return r;
+}
+
+static void test_draw_string_throughput() {
+  spr.createSprite(240, 80);
+  spr.setTextColor(TFT_WHITE, TFT_BLACK, true);
+  // 16 karakter dari 12 glyph: muat di cache (SMOOTH_FONT_CACHE_GLYPHS)
+  std::string hot = text(30, 12, 16);
+  // Semua 200 glyph berurutan: LRU selalu membuang glyph berikutnya
+  std::string all = text(0, GLYPHS, GLYPHS);
+
+  std::vector<uint16_t> cold, warm;
+  spr.fillSprite(TFT_BLACK);
+  spr.drawString(hot.c_str(), 2, 2);
+  const uint16_t *px = (const uint16_t *)spr.getPointer();
+  cold.assign(px, px + spr.width() * spr.height());
+  TEST_ASSERT_EQUAL(12, spr.glyphCacheMisses);
+
+  Run hit = drawMany(hot, &warm);
+  TEST_ASSERT_TRUE(cold == warm);
+  TEST_ASSERT_EQUAL(12, spr.glyphCacheMisses);
+  TEST_ASSERT_EQUAL(4 + DRAWS * 16, spr.glyphCacheHits);
+  TEST_ASSERT_EQUAL(0, hit.flashUs); // tidak ada baca flash sama sekali
+
+  uint32_t misses = spr.glyphCacheMisses;
+  Run miss = drawMany(all, nullptr);
+  // Hanya 12 glyph teks sebelumnya yang masih di cache pada putaran pertama
+  TEST_ASSERT_EQUAL(DRAWS * GLYPHS - 12, spr.glyphCacheMisses - misses);
+  TEST_ASSERT_TRUE(miss.flashUs > 0);
+
+  double hitGlyphUs = hit.hostUsPerString / 16;
+  double missGlyphUs = miss.hostUsPerString / GLYPHS;
+  char msg[160];
+  snprintf(msg, sizeof(msg),
+           "drawString: hit %.2f us/glyph (%.0f glyph/s), miss %.2f us/glyph "
+           "+ %.1f us flash virtual",
+           hitGlyphUs, 1e6 / hitGlyphUs, missGlyphUs,
+           (double)miss.flashUs / (DRAWS * GLYPHS));
+  TEST_MESSAGE(msg);
+}
+
+int main(int, char **) {
+  sim::fsSetRoot(FS_DIR, true);
+  writeFont();
+  UNITY_BEGIN();
+  RUN_TEST(test_index_matches_linear_search);
+  RUN_TEST(test_glyph_pixels_from_cache_and_file);
+  RUN_TEST(test_draw_string_throughput);
+  return UNITY_END();
+}
@@ -0,0 +1,218 @@
+// Kasus uji StringPool yang sama untuk kedua konfigurasi. Tiap .cpp
+// menentukan ARDUINOJSON_STRING_POOL_HASH sendiri lalu meng-include file
+// ini dengan POOL_CASES = nama tabel kasusnya; test_main.cpp memanggil
+// keduanya lewat tabel itu, tanpa melihat tipe ArduinoJson yang berbeda.
+
+#pragma once
+
+#include <stddef.h>
+
+#include <string>
+
+struct PoolCases {
+  const char *name;
+  void (*roundTrip)();
+  void (*dedupe)();
+  void (*remove)();
+  void (*copyMoveSwap)();
+  // Rata-rata waktu host deserializeJson() dalam us
+  double (*parseUs)(const std::string &json, int reps);
+};
+
+extern const PoolCases listPool;
+extern const PoolCases hashedPool;
+
+// Array n string berbeda: "s0000000", "s0000001", ...
+std::string distinctStrings(size_t n);
+
+#ifdef POOL_CASES
+
+#include <ArduinoJson.h>
+#include <unity.h>
+
+#include <chrono>
+
+namespace {
+
+// Allocator bawaan yang menghitung byte hidup, untuk cek bocor dan bahwa
+// string yang dihapus benar-benar dikembalikan
+class CountingAllocator : public Allocator {
+public:
+  void *allocate(size_t size) override {
+    size_t *p = (size_t *)malloc(size + sizeof(size_t) * 2);
+    if (!p)
+      return nullptr;
+    *p = size;
+    live += size;
+    return p + 2;
+  }
+
+  void deallocate(void *ptr) override {
+    if (!ptr)
+      return;
+    size_t *p = (size_t *)ptr - 2;
+    live -= *p;
+    free(p);
+  }
+
+  void *reallocate(void *ptr, size_t size) override {
+    if (!ptr)
+      return allocate(size);
+    size_t *p = (size_t *)ptr - 2;
+    size_t was = *p;
+    p = (size_t *)realloc(p, size + sizeof(size_t) * 2);
+    if (!p)
+      return nullptr;
+    live += size - was;
+    *p = size;
+    return p + 2;
+  }
+
+  size_t live = 0;
+};
+
+// Lebih dari 3 karakter: string sependek itu disimpan di dalam slot
+// (tiny string), tidak lewat pool
+std::string key(size_t i) { return "key" + std::to_string(i); }
+std::string value(size_t i) { return "value" + std::to_string(i % 5); }
+
+// Objek n key berbeda; nilainya hanya 5 string, jadi banyak yang dibagi
+std::string object(size_t n) {
+  std::string s = "{";
+  for (size_t i = 0; i < n; i++)
+    s += (i ? ",\"" : "\"") + key(i) + "\":\"" + value(i) + "\"";
+  return s + "}";
+}
+
+void assertObject(JsonDocument &doc, size_t n) {
+  TEST_ASSERT_EQUAL(n, doc.size());
+  for (size_t i = 0; i < n; i++) {
+    TEST_ASSERT_EQUAL_STRING(value(i).c_str(), doc[key(i)].as<const char *>());
+  }
+  TEST_ASSERT_TRUE(doc[key(n)].isNull());
+}
+
+// 1 string, 9 (tabel bawaan 8 bucket tumbuh), 100 (beberapa kali tumbuh)
+void caseRoundTrip() {
+  for (size_t n : {1, 9, 100}) {
+    std::string json = object(n);
+    JsonDocument doc;
+    TEST_ASSERT_TRUE(deserializeJson(doc, json) == DeserializationError::Ok);
+    assertObject(doc, n);
+    std::string out;
+    serializeJson(doc, out);
+    TEST_ASSERT_TRUE(out == json);
+
+    std::string arr = distinctStrings(n);
+    TEST_ASSERT_TRUE(deserializeJson(doc, arr) == DeserializationError::Ok);
+    out.clear();
+    serializeJson(doc, out);
+    TEST_ASSERT_TRUE(out == arr);
+  }
+}
+
+// String yang sama hanya disimpan sekali, dari parse maupun dari API
+void caseDedupe() {
+  JsonDocument doc;
+  TEST_ASSERT_TRUE(deserializeJson(doc, "[\"alpha\",\"alpha\",\"bravo\","
+                                        "{\"alpha\":\"alpha\"}]") ==
+                   DeserializationError::Ok);
+  const char *alpha = doc[0].as<const char *>();
+  TEST_ASSERT_TRUE(alpha == doc[1].as<const char *>());
+  TEST_ASSERT_TRUE(alpha != doc[2].as<const char *>());
+  TEST_ASSERT_TRUE(alpha == doc[3]["alpha"].as<const char *>());
+  doc.add(std::string("alpha"));
+  TEST_ASSERT_TRUE(alpha == doc[4].as<const char *>());
+  doc.add(std::string("alphb"));
+  TEST_ASSERT_TRUE(alpha != doc[5].as<const char *>());
+  TEST_ASSERT_EQUAL_STRING("alphb", doc[5].as<const char *>());
+}
+
+// Hapus separuh key: string-nya dilepas, sisanya masih ketemu, key yang
+// dihapus bisa ditambah lagi
+void caseRemove() {
+  CountingAllocator heap;
+  {
+    JsonDocument doc(&heap);
+    TEST_ASSERT_TRUE(deserializeJson(doc, object(200)) ==
+                     DeserializationError::Ok);
+    size_t full = heap.live;
+    for (size_t i = 0; i < 200; i += 2)
+      doc.remove(key(i));
+    TEST_ASSERT_TRUE(heap.live < full);
+    TEST_ASSERT_EQUAL(100, doc.size());
+    for (size_t i = 0; i < 200; i++) {
+      if (i % 2)
+        TEST_ASSERT_EQUAL_STRING(value(i).c_str(),
+                                 doc[key(i)].as<const char *>());
+      else
+        TEST_ASSERT_TRUE(doc[key(i)].isNull());
+    }
+    for (size_t i = 0; i < 200; i += 2)
+      doc[key(i)] = value(i);
+    assertObject(doc, 200);
+  }
+  TEST_ASSERT_EQUAL(0, heap.live);
+}
+
+// Salinan punya pool sendiri; move dan swap memindahkan tabel (juga yang
+// masih di dalam dokumen), dan dokumen tetap bisa dipakai sesudahnya
+void caseCopyMoveSwap() {
+  CountingAllocator heap;
+  {
+    JsonDocument big(&heap), small(&heap);
+    TEST_ASSERT_TRUE(deserializeJson(big, object(100)) ==
+                     DeserializationError::Ok);
+    TEST_ASSERT_TRUE(deserializeJson(small, object(3)) ==
+                     DeserializationError::Ok);
+
+    JsonDocument copy(big);
+    assertObject(copy, 100);
+    copy["extra"] = value(1);
+    TEST_ASSERT_EQUAL(101, copy.size());
+    TEST_ASSERT_TRUE(copy["extra"].as<const char *>() ==
+                     copy[key(1)].as<const char *>());
+    TEST_ASSERT_TRUE(copy[key(1)].as<const char *>() !=
+                     big[key(1)].as<const char *>());
+
+    JsonDocument moved(std::move(big));
+    assertObject(moved, 100);
+    moved[key(100)] = value(100);
+    TEST_ASSERT_EQUAL(101, moved.size());
+    TEST_ASSERT_TRUE(copy[key(100)].isNull()); // salinan tidak ikut berubah
+
+    swap(moved, small);
+    TEST_ASSERT_EQUAL(3, moved.size());
+    TEST_ASSERT_EQUAL(101, small.size());
+    for (size_t i = 3; i < 100; i++)
+      moved[key(i)] = value(i);
+    assertObject(moved, 100);
+    small.remove(key(100));
+    assertObject(small, 100);
+  }
+  TEST_ASSERT_EQUAL(0, heap.live);
+}
+
+double caseParseUs(const std::string &json, int reps) {
+  JsonDocument doc;
+  auto t0 = std::chrono::steady_clock::now();
+  for (int i = 0; i < reps; i++)
+    TEST_ASSERT_TRUE(deserializeJson(doc, json) == DeserializationError::Ok);
+  return std::chrono::duration<double, std::micro>(
+             std::chrono::steady_clock::now() - t0)
+             .count() /
+         reps;
+}
+
+} // namespace
+
+extern const PoolCases POOL_CASES = {
+    ARDUINOJSON_STRING_POOL_HASH ? "hash" : "list",
+    caseRoundTrip,
+    caseDedupe,
+    caseRemove,
+    caseCopyMoveSwap,
+    caseParseUs,
+};
+
+#endif
@@ -0,0 +1,9 @@
+// Konfigurasi hash dari StringPool. Namespace versi ArduinoJson tidak
+// memuat opsi ini, jadi diberi nama sendiri supaya StringNode/StringPool
+// dengan layout berbeda tidak bertabrakan (ODR) dengan test_main.cpp dan
+// src/ yang memakai daftar biasa.
+
+#define ARDUINOJSON_STRING_POOL_HASH 1
+#define ARDUINOJSON_VERSION_NAMESPACE V742_StringPoolHash
+#define POOL_CASES hashedPool
+#include "pool_cases.h"
@@ -0,0 +1,74 @@
+// StringPool ArduinoJson (lib/ArduinoJson/Memory/StringPool.hpp) dengan
+// ARDUINOJSON_STRING_POOL_HASH 0 (daftar, bawaan) dan 1 (index hash, di
+// string_pool_hashed.cpp). Kasus yang sama dijalankan untuk keduanya:
+// round trip, dedupe, remove, copy/move/swap. Benchmark parse array 10
+// sampai 10.000 string berbeda: daftar kuadratik, hash linear.
+//
+//   pio test -e native -f test_string_pool
+
+#define POOL_CASES listPool
+#include "pool_cases.h"
+
+#define BENCH_STRINGS_MAX 10000
+#define BENCH_WORK 20000 // string per pengukuran, dibagi ke beberapa putaran
+
+std::string distinctStrings(size_t n) {
+  std::string s = "[";
+  char one[16];
+  for (size_t i = 0; i < n; i++) {
+    snprintf(one, sizeof(one), "%s\"s%07u\"", i ? "," : "", (unsigned)i);
+    s += one;
+  }
+  return s + "]";
+}
+
+static const PoolCases *pools[] = {&listPool, &hashedPool};
+
+void setUp() {}
+void tearDown() {}
+
+static void test_round_trip() {
+  for (const PoolCases *p : pools)
+    p->roundTrip();
+}
+
+static void test_dedupe() {
+  for (const PoolCases *p : pools)
+    p->dedupe();
+}
+
+static void test_remove() {
+  for (const PoolCases *p : pools)
+    p->remove();
+}
+
+static void test_copy_move_swap() {
+  for (const PoolCases *p : pools)
+    p->copyMoveSwap();
+}
+
+static void test_parse_distinct_strings() {
+  double list = 0, hash = 0;
+  for (size_t n = 10; n <= BENCH_STRINGS_MAX; n *= 10) {
+    std::string json = distinctStrings(n);
+    int reps = n < BENCH_WORK ? BENCH_WORK / n : 1;
+    list = listPool.parseUs(json, reps);
+    hash = hashedPool.parseUs(json, reps);
+    char msg[96];
+    snprintf(msg, sizeof(msg), "%5u string: daftar %10.1f us, hash %8.1f us",
+             (unsigned)n, list, hash);
+    TEST_MESSAGE(msg);
+  }
+  // Di 10.000 string selisihnya dua orde besaran; 10x aman dari noise
+  TEST_ASSERT_TRUE(hash * 10 < list);
+}
+
+int main(int, char **) {
+  UNITY_BEGIN();
+  RUN_TEST(test_round_trip);
+  RUN_TEST(test_dedupe);
+  RUN_TEST(test_remove);
+  RUN_TEST(test_copy_move_swap);
+  RUN_TEST(test_parse_distinct_strings);
+  return UNITY_END();
+}
@@ -0,0 +1,142 @@
+// TFT_eStrip (lib/TFT_eSPI/Extensions/Strip) di atas backend SPI/DMA
+// simulasi: CPU menggambar strip N+1 selagi DMA mengirim strip N. Dicek:
+// isi panel, buffer yang sedang dikirim DMA tidak pernah digambar ulang,
+// StripStats, dan waktu frame dengan DMA vs pushImage blocking.
+//
+//   pio test -e native -f test_strip
+
+#include <TFT_eSPI.h>
+#include <unity.h>
+
+#include "SimKernel.h"
+
+#define W 240
+#define H 240
+
+static TFT_eSPI panel;
+static TFT_eStrip strip(&panel);
+
+// Konten uji: warna unik per (x, y) konten, supaya strip yang tertukar
+// atau offset sx/sy yang salah terlihat
+static uint16_t pattern(int32_t x, int32_t y) {
+  return (uint16_t)(x * 31 + y * 257 + 7);
+}
+
+struct Render {
+  uint32_t costUs = 0;           // waktu CPU per strip
+  const void *lastBuf = nullptr; // strip yang terakhir dipush
+  uint32_t clobbered = 0;
+};
+
+static void renderPattern(TFT_eSprite &spr, int32_t oy, void *arg) {
+  Render *r = (Render *)arg;
+  // Buffer yang masih dikirim DMA tidak boleh ditimpa
+  if (panel.dmaBusy() && spr.getPointer() == r->lastBuf)
+    r->clobbered++;
+  r->lastBuf = spr.getPointer();
+  uint16_t *px = (uint16_t *)spr.getPointer();
+  for (int32_t y = 0; y < spr.height(); y++)
+    for (int32_t x = 0; x < spr.width(); x++)
+      px[y * spr.width() + x] = pattern(x, oy + y);
+  sim::charge(r->costUs);
+}
+
+void setUp() {
+  if (!panel.DMA_Enabled)
+    panel.initDMA();
+  strip.begin(W, 20);
+}
+void tearDown() {}
+
+static void assertPanel(int32_t x0, int32_t y0, int32_t w, int32_t h,
+                        int32_t sx, int32_t sy) {
+  for (int32_t y = 0; y < h; y++)
+    for (int32_t x = 0; x < w; x++)
+      if (panel.readPixel(x0 + x, y0 + y) != pattern(sx + x, sy + y)) {
+        char msg[48];
+        snprintf(msg, sizeof(msg), "piksel (%d,%d) salah", (int)(x0 + x),
+                 (int)(y0 + y));
+        TEST_FAIL_MESSAGE(msg);
+      }
+}
+
+static void test_full_frame_is_exact() {
+  Render r;
+  TEST_ASSERT_EQUAL(W * H * 2, strip.pushRect(0, 0, W, H, renderPattern, &r));
+  assertPanel(0, 0, W, H, 0, 0);
+  TEST_ASSERT_EQUAL(12, strip.stats().strips);
+  TEST_ASSERT_EQUAL(W * H * 2, strip.stats().lastFrameBytes);
+  TEST_ASSERT_EQUAL(0, r.clobbered);
+}
+
+// Sub-area: kolom sx.. dari konten, tinggi bukan kelipatan strip
+static void test_sub_rect_with_offsets() {
+  Render r;
+  strip.pushRect(30, 50, 100, 47, renderPattern, &r, 60, 13);
+  assertPanel(30, 50, 100, 47, 60, 13);
+  TEST_ASSERT_EQUAL(3, strip.stats().strips);
+  TEST_ASSERT_EQUAL(100 * 47 * 2, strip.stats().lastFrameBytes);
+}
+
+// Beberapa pushRect dalam satu frame; tinggi strip diubah saat jalan
+static void test_frame_and_strip_height() {
+  Render r;
+  TEST_ASSERT_TRUE(strip.setStripHeight(8));
+  strip.beginFrame();
+  strip.pushRect(0, 0, W, 40, renderPattern, &r);
+  strip.pushRect(0, 200, W, 40, renderPattern, &r, 0, 200);
+  strip.endFrame();
+  assertPanel(0, 0, W, 40, 0, 0);
+  assertPanel(0, 200, W, 40, 0, 200);
+  TEST_ASSERT_EQUAL(10, strip.stats().strips);
+  TEST_ASSERT_EQUAL(0, r.clobbered);
+  TEST_ASSERT_FALSE(panel.dmaBusy()); // endFrame() menunggu strip terakhir
+}
+
+static uint32_t frameUs(uint32_t renderCostUs) {
+  Render r;
+  r.costUs = renderCostUs;
+  strip.pushRect(0, 0, W, H, renderPattern, &r);
+  TEST_ASSERT_EQUAL(0, r.clobbered);
+  return strip.stats().lastFrameUs;
+}
+
+// Render ~ sama lama dengan transfer (strip 240x20 = 9.6 KB, ~2.8 ms di
+// 27 MHz): dengan DMA keduanya tumpang tindih, tanpa DMA dijumlah
+static void test_dma_overlaps_render_and_transfer() {
+  uint32_t wireUs = 12 * ((9600 + 11) * 8 / 27);
+  uint32_t renderUs = 12 * 2500;
+
+  uint32_t dma = frameUs(2500);
+  uint32_t dmaWait = strip.stats().waitUs;
+  panel.deInitDMA();
+  uint32_t blocking = frameUs(2500);
+  panel.initDMA();
+
+  char msg[96];
+  snprintf(msg, sizeof(msg),
+           "frame %u us dengan DMA (tunggu %u us), %u us blocking", dma,
+           dmaWait, blocking);
+  TEST_MESSAGE(msg);
+  TEST_ASSERT_TRUE(blocking >= wireUs + renderUs);
+  TEST_ASSERT_TRUE(dma < blocking * 6 / 10);
+  // Yang lebih lambat (transfer) menentukan, ditambah satu strip render
+  TEST_ASSERT_TRUE(dma <= wireUs + 2500 + 500);
+}
+
+// Render lambat: DMA selalu selesai duluan, tidak ada waktu tunggu
+static void test_slow_render_never_waits() {
+  frameUs(5000);
+  TEST_ASSERT_EQUAL(0, strip.stats().waitUs);
+  TEST_ASSERT_TRUE(strip.stats().renderUs >= 12 * 5000);
+}
+
+int main(int, char **) {
+  UNITY_BEGIN();
+  RUN_TEST(test_full_frame_is_exact);
+  RUN_TEST(test_sub_rect_with_offsets);
+  RUN_TEST(test_frame_and_strip_height);
+  RUN_TEST(test_dma_overlaps_render_and_transfer);
+  RUN_TEST(test_slow_render_never_waits);
+  return UNITY_END();
+}
@@ -0,0 +1,111 @@
+// Soak jalur upload (src/Outbox.cpp, src/Uploader.cpp, src/ApiClient.cpp):
+// 100k scan lewat outbox dan uploader task ke backend simulasi. Setelah
+// tiap 10k scan dan outbox kosong, heap yang terpakai harus kembali ke
+// angka yang sama; kalau payload atau URL dibangun di String/heap yang
+// tumbuh, angkanya merambat naik. Satu-satunya yang boleh tumbuh adalah
+// header x-device-metrics di HTTPClient: counter di dalamnya bertambah
+// digit (9999 -> 10000), jadi selisih heap dibatasi selisih panjang header
+// itu.
+//
+// Heap sim menghitung byte hidup (operator new dan buffer String), tidak
+// memodelkan letak blok, jadi "blok bebas terbesar" di sini sama dengan
+// free heap; yang diuji adalah tidak ada alokasi yang tertinggal, dan
+// puncak heap berhenti naik setelah separuh soak.
+//
+//   pio test -e native -f test_upload_soak
+
+#include <Arduino.h>
+#include <LittleFS.h>
+#include <WiFi.h>
+#include <unity.h>
+
+#include "ApiClient.h"
+#include "Outbox.h"
+#include "SimDevices.h"
+#include "SimKernel.h"
+#include "SimNet.h"
+#include "Uploader.h"
+
+#define FS_DIR ".sim_fs_upload_soak"
+#define SOAK_SCANS 100000
+#define SOAK_BLOCK 10000
+#define WARMUP_SCANS 1000
+#define SCAN_GAP_MS 100
+#define END_US (48ULL * 3600 * 1000000) // batas aman waktu virtual
+
+extern const char *WIFI_SSID;
+extern const char *WIFI_PASSWORD;
+extern const char *API_BASE;
+extern const char *API_KEY;
+
+static uint32_t scans = 0;
+
+void setUp() {}
+void tearDown() {}
+
+static void scanMany(uint32_t n) {
+  for (uint32_t i = 0; i < n; i++, scans++) {
+    TEST_ASSERT_TRUE(outboxPush(1 + scans % 500, scans % 2,
+                                1767600000UL + scans * 3));
+    uploaderKick();
+    delay(SCAN_GAP_MS);
+  }
+  while (outboxPending())
+    delay(1000);
+}
+
+static void test_heap_flat_over_100k_scans() {
+  LittleFS.begin(true);
+  TEST_ASSERT_TRUE(outboxBegin());
+  WiFi.begin(WIFI_SSID, WIFI_PASSWORD);
+  while (WiFi.status() != WL_CONNECTED)
+    delay(100);
+  apiBegin(API_BASE, API_KEY);
+  uploaderBegin();
+
+  // Koneksi TLS, buffer HTTP dan semacamnya dialokasikan sekali di awal
+  scanMany(WARMUP_SCANS);
+  size_t base = sim::heapUsed();
+  size_t baseMetrics = sim::serverLastMetrics().length();
+  size_t peak = 0;
+
+  char msg[112];
+  for (uint32_t done = 0; done < SOAK_SCANS; done += SOAK_BLOCK) {
+    scanMany(SOAK_BLOCK);
+    snprintf(msg, sizeof(msg),
+             "%6u scan: heap %u byte (awal %u), blok terbesar %u, puncak %u",
+             (unsigned)(done + SOAK_BLOCK), (unsigned)sim::heapUsed(),
+             (unsigned)base, (unsigned)ESP.getMaxAllocHeap(),
+             (unsigned)sim::heapPeak());
+    TEST_MESSAGE(msg);
+    size_t digits = sim::serverLastMetrics().length() - baseMetrics;
+    TEST_ASSERT_TRUE(sim::heapUsed() <= base + digits);
+    if (done + SOAK_BLOCK == SOAK_SCANS / 2)
+      peak = sim::heapPeak();
+  }
+  TEST_ASSERT_EQUAL(peak, sim::heapPeak());
+  TEST_ASSERT_EQUAL(WARMUP_SCANS + SOAK_SCANS, sim::serverRecords());
+
+  ApiStats st = apiStats();
+  snprintf(msg, sizeof(msg), "%u request, %u handshake, %u gagal",
+           (unsigned)st.requests, (unsigned)st.connects,
+           (unsigned)st.failures);
+  TEST_MESSAGE(msg);
+}
+
+// Test jalan di loopTask kernel sim, karena uploader butuh task dan waktu
+// virtual
+static void runTests() {
+  UNITY_BEGIN();
+  RUN_TEST(test_heap_flat_over_100k_scans);
+  sim::setExitStatus(UNITY_END() ? 1 : 0);
+  sim::finish();
+}
+
+static void idle() { delay(1000); }
+
+int main(int, char **) {
+  sim::fsSetRoot(FS_DIR, true);
+  sim::runArduino(runTests, idle, END_US, nullptr);
+  return 0;
+}
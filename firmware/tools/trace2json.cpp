@@ -0,0 +1,181 @@
+// Converts a trace dump from the reader (Trace.h: serial 't' or GET /trace)
+// into Chrome trace event JSON, viewable in ui.perfetto.dev or
+// chrome://tracing.
+//
+//   g++ -std=c++11 -O2 -o trace2json tools/trace2json.cpp
+//   curl http://192.168.1.50/trace | ./trace2json > trace.json
+//   ./trace2json serial.log > trace.json
+//
+// Lines that are not part of the dump (serial log, prompts) are skipped.
+//
+// Each event carries the 32-bit CCOUNT of the core its task runs on and
+// the 1 ms FreeRTOS tick. CCOUNT wraps every 2^32 cycles (~17.9 s at
+// 240 MHz) and the two cores' counters have an unknown offset, so per
+// core the cycles are unwrapped using the tick as a coarse guide, then
+// shifted so that every event falls inside its own tick millisecond.
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <string>
+#include <vector>
+
+struct Event {
+  char phase;
+  unsigned task;
+  uint32_t cycles;
+  uint32_t tick;
+  std::string name;
+  double ts; // us
+};
+
+struct Task {
+  unsigned core = 0;
+  std::string name;
+};
+
+struct CoreClock {
+  bool seen = false;
+  uint32_t lastCycles = 0;
+  uint32_t lastTick = 0;
+  int64_t ext = 0; // cycles since the core's first event, may go negative
+  double lo = -INFINITY, hi = INFINITY; // bounds of the us offset
+};
+
+static std::string jsonEscape(const std::string &s) {
+  std::string out;
+  for (char c : s) {
+    if (c == '"' || c == '\\')
+      out += '\\';
+    if ((unsigned char)c >= 0x20)
+      out += c;
+  }
+  return out;
+}
+
+int main(int argc, char **argv) {
+  FILE *in = stdin;
+  if (argc > 1 && !(in = fopen(argv[1], "r"))) {
+    perror(argv[1]);
+    return 1;
+  }
+
+  unsigned mhz = 240, spanCycles = 0;
+  unsigned long dropped = 0;
+  std::map<unsigned, Task> tasks;
+  std::vector<Event> events;
+
+  char line[256];
+  bool inDump = false;
+  while (fgets(line, sizeof(line), in)) {
+    line[strcspn(line, "\r\n")] = '\0';
+    if (!strncmp(line, "# axiom trace", 13)) {
+      // A later dump in the same log replaces the earlier one
+      inDump = true;
+      tasks.clear();
+      events.clear();
+      continue;
+    }
+    if (!inDump)
+      continue;
+
+    char name[128];
+    unsigned a, b;
+    unsigned long c, d;
+    char phase;
+    if (sscanf(line, "cpu_mhz %u", &a) == 1) {
+      mhz = a ? a : 240;
+    } else if (sscanf(line, "span_cycles %u", &a) == 1) {
+      spanCycles = a;
+    } else if (sscanf(line, "task %u %u %127[^\n]", &a, &b, name) == 3) {
+      tasks[a].core = b;
+      tasks[a].name = name;
+    } else if (sscanf(line, "%c %u %lu %lu %127s", &phase, &a, &c, &d,
+                      name) == 5 &&
+               (phase == 'B' || phase == 'E')) {
+      events.push_back({phase, a, (uint32_t)c, (uint32_t)d, name, 0});
+    } else if (sscanf(line, "dropped %lu", &c) == 1) {
+      dropped = c;
+      inDump = false;
+    }
+  }
+  if (in != stdin)
+    fclose(in);
+  if (events.empty()) {
+    fprintf(stderr, "trace2json: no trace dump found\n");
+    return 1;
+  }
+
+  // Pass 1, in ring order: unwrap cycles per core. The delta between two
+  // events is the value congruent to the 32-bit difference that is
+  // closest to what the ticks say; this also handles B events written
+  // after the fact (traceSpanSince), which go back in time.
+  std::map<unsigned, CoreClock> clocks;
+  std::vector<double> rel(events.size());
+  const double wrap = 4294967296.0;
+  for (size_t i = 0; i < events.size(); i++) {
+    const Event &e = events[i];
+    CoreClock &cc = clocks[tasks[e.task].core];
+    if (cc.seen) {
+      double expected =
+          (double)(int32_t)(e.tick - cc.lastTick) * 1000.0 * mhz;
+      double dc = (double)(uint32_t)(e.cycles - cc.lastCycles);
+      double k = std::round((expected - dc) / wrap);
+      cc.ext += (int64_t)(dc + k * wrap);
+    }
+    cc.seen = true;
+    cc.lastCycles = e.cycles;
+    cc.lastTick = e.tick;
+    rel[i] = (double)cc.ext / mhz;
+    // tick * 1000 <= true time < (tick + 1) * 1000
+    cc.lo = std::max(cc.lo, e.tick * 1000.0 - rel[i]);
+    cc.hi = std::min(cc.hi, e.tick * 1000.0 + 1000.0 - rel[i]);
+  }
+  for (size_t i = 0; i < events.size(); i++) {
+    CoreClock &cc = clocks[tasks[events[i].task].core];
+    double offset = cc.hi > cc.lo ? (cc.lo + cc.hi) / 2 : cc.lo;
+    events[i].ts = rel[i] + offset;
+  }
+
+  // Pass 2: time order, and drop E events whose B was overwritten in the
+  // ring
+  std::stable_sort(events.begin(), events.end(),
+                   [](const Event &x, const Event &y) { return x.ts < y.ts; });
+  std::map<unsigned, std::vector<std::string>> open;
+  std::vector<const Event *> out;
+  for (const Event &e : events) {
+    std::vector<std::string> &stack = open[e.task];
+    if (e.phase == 'B') {
+      stack.push_back(e.name);
+    } else {
+      auto it = std::find(stack.rbegin(), stack.rend(), e.name);
+      if (it == stack.rend())
+        continue;
+      stack.erase(std::next(it).base(), stack.end());
+    }
+    out.push_back(&e);
+  }
+
+  double t0 = out.empty() ? 0 : out.front()->ts;
+  printf("{\"displayTimeUnit\":\"ms\",\"otherData\":{\"cpu_mhz\":%u,"
+         "\"span_cycles\":%u,\"dropped\":%lu},\n\"traceEvents\":[\n",
+         mhz, spanCycles, dropped);
+  printf("{\"ph\":\"M\",\"name\":\"process_name\",\"pid\":1,"
+         "\"args\":{\"name\":\"axiom\"}}");
+  for (auto &t : tasks)
+    printf(",\n{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":1,\"tid\":%u,"
+           "\"args\":{\"name\":\"%s (core %u)\"}}",
+           t.first, jsonEscape(t.second.name).c_str(), t.second.core);
+  for (const Event *e : out)
+    printf(",\n{\"ph\":\"%c\",\"name\":\"%s\",\"pid\":1,\"tid\":%u,"
+           "\"ts\":%.3f}",
+           e->phase, jsonEscape(e->name).c_str(), e->task, e->ts - t0);
+  printf("\n]}\n");
+  fprintf(stderr, "trace2json: %zu events, %zu tasks, %lu dropped\n",
+          out.size(), tasks.size(), dropped);
+  return 0;
+}
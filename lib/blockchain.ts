@@ -1,6 +1,9 @@
 import crypto from 'crypto';
+import { AnyBulkWriteOperation, Types } from 'mongoose';
 import dbConnect from './mongodb';
-import Attendance from '@/models/Attendance';
+import Attendance, { IAttendance } from '@/models/Attendance';
+import ChainCheckpoint from '@/models/ChainCheckpoint';
+import { acquireLease, releaseLease } from '@/models/Counter';
 
 /**
  * Generates a SHA-256 hash from an object
@@ -28,72 +31,465 @@ export function createBlockHash(
     return generateHash(blockData);
 }
 
+/**
+ * Gets the sequence number and hash of the last block in the chain
+ */
+export async function getChainTail(): Promise<{ seq: number; hash: string }> {
+    await dbConnect();
+    const last = await Attendance.findOne({ seq: { $exists: true } }, { seq: 1, hash: 1 })
+        .sort({ seq: -1 })
+        .lean();
+    return { seq: last?.seq ?? 0, hash: last?.hash || 'GENESIS_BLOCK' };
+}
+
 /**
  * Gets the hash of the last attendance record
  */
 export async function getLastHash(): Promise<string> {
+    return (await getChainTail()).hash;
+}
+
+function isDuplicateKey(error: unknown): boolean {
+    return (error as { code?: number }).code === 11000;
+}
+
+let sequenceReady: Promise<void> | null = null;
+
+// Lease on the backfill, renewed after every bulk write; a process that
+// dies mid-backfill loses it after this long and another one resumes
+const BACKFILL_LEASE = 'chain-backfill';
+const BACKFILL_LEASE_MS = 30000;
+const BACKFILL_POLL_MS = 500;
+const processId = crypto.randomUUID();
+
+/**
+ * Numbers records stored before the seq field existed, in the order they
+ * were chained and verified until then (timestamp, then _id). Only the
+ * process holding the backfill lease numbers; the others wait until no
+ * unnumbered record is left.
+ */
+function ensureSequence(): Promise<void> {
+    if (!sequenceReady) {
+        sequenceReady = backfillSequence().catch((error) => {
+            sequenceReady = null;
+            throw error;
+        });
+    }
+    return sequenceReady;
+}
+
+async function backfillSequence() {
     await dbConnect();
-    const lastRecord = await Attendance.findOne().sort({ timestamp: -1 });
-    return lastRecord?.hash || 'GENESIS_BLOCK';
+    while (await Attendance.exists({ seq: { $exists: false } })) {
+        if (await acquireLease(BACKFILL_LEASE, processId, BACKFILL_LEASE_MS)) {
+            try {
+                await numberRecords();
+            } finally {
+                await releaseLease(BACKFILL_LEASE, processId);
+            }
+            return;
+        }
+        await new Promise((resolve) => setTimeout(resolve, BACKFILL_POLL_MS));
+    }
+}
+
+/**
+ * Continues after the tail, which a holder that died mid-backfill left at
+ * the last record it numbered. Runs under the lease, so any record
+ * numbered by someone else or a seq already taken (error 11000) means the
+ * lease was lost: the backfill fails rather than skip or reuse a number.
+ */
+async function numberRecords() {
+    let { seq } = await getChainTail();
+    const cursor = Attendance.find({ seq: { $exists: false } }, { _id: 1 })
+        .sort({ timestamp: 1, _id: 1 })
+        .lean()
+        .cursor({ batchSize: 1000 });
+
+    const flush = async (ops: AnyBulkWriteOperation<IAttendance>[]) => {
+        const result = await Attendance.bulkWrite(ops, { ordered: true });
+        if (result.modifiedCount !== ops.length) {
+            throw new Error('Chain backfill: records numbered by another process');
+        }
+        if (!(await acquireLease(BACKFILL_LEASE, processId, BACKFILL_LEASE_MS))) {
+            throw new Error('Chain backfill: lease lost');
+        }
+    };
+    let ops: AnyBulkWriteOperation<IAttendance>[] = [];
+    try {
+        for await (const doc of cursor) {
+            ops.push({
+                updateOne: {
+                    filter: { _id: doc._id, seq: { $exists: false } },
+                    update: { $set: { seq: ++seq } },
+                },
+            });
+            if (ops.length === 1000) {
+                await flush(ops);
+                ops = [];
+            }
+        }
+    } finally {
+        await cursor.close();
+    }
+    if (ops.length > 0) await flush(ops);
+}
+
+export interface ChainEntry {
+    uid: number;
+    timestamp: Date;
+    status: 'In' | 'Out';
+    deviceAuthToken?: string;
+    device?: string;
+    deviceSeq?: number;
+}
+
+export interface ChainBlock extends ChainEntry {
+    seq: number;
+    hash: string;
+    previousHash: string;
+    duplicate?: boolean; // device and deviceSeq were already stored
+}
+
+// Entries written by one insert when requests queue up
+const APPEND_GROUP_MAX = 1000;
+// Lost races against other processes before an append gives up
+const APPEND_RETRIES = 20;
+
+interface PendingAppend {
+    entries: ChainEntry[];
+    resolve: (blocks: ChainBlock[]) => void;
+    reject: (error: unknown) => void;
+}
+
+const appendQueue: PendingAppend[] = [];
+let appending = false;
+
+/**
+ * Appends entries to the chain in the given order and returns the stored
+ * blocks. Calls in this process are queued and written together, one
+ * insert per group; other processes are kept out by the unique seq index,
+ * so every block links to exactly one predecessor.
+ */
+export function appendToChain(entries: ChainEntry[]): Promise<ChainBlock[]> {
+    if (entries.length === 0) return Promise.resolve([]);
+    return new Promise((resolve, reject) => {
+        appendQueue.push({ entries, resolve, reject });
+        if (!appending) void drainAppendQueue();
+    });
+}
+
+async function drainAppendQueue() {
+    appending = true;
+    while (appendQueue.length > 0) {
+        let count = 0;
+        let take = 0;
+        while (take < appendQueue.length && (take === 0 || count < APPEND_GROUP_MAX)) {
+            count += appendQueue[take++].entries.length;
+        }
+        const group = appendQueue.splice(0, take);
+
+        const blocks: ChainBlock[] = [];
+        try {
+            await appendBlocks(group.flatMap((p) => p.entries), blocks);
+        } catch {
+            // Settled per request below
+        }
+        let offset = 0;
+        for (const p of group) {
+            const stored = blocks.slice(offset, offset + p.entries.length);
+            offset += p.entries.length;
+            if (stored.length === p.entries.length) {
+                p.resolve(stored);
+                continue;
+            }
+            // The group failed on something other than a lost race (e.g. a
+            // document that does not validate). Retry each request on its
+            // own so one bad request does not fail the others queued with
+            // it; entries already stored stay in the chain.
+            const rest: ChainBlock[] = [];
+            try {
+                await appendBlocks(p.entries.slice(stored.length), rest);
+                p.resolve([...stored, ...rest]);
+            } catch (error) {
+                p.reject(error);
+            }
+        }
+    }
+    appending = false;
+}
+
+/**
+ * Links entries to the current tail and inserts them with consecutive seq
+ * numbers. If another process took one of those numbers the ordered insert
+ * stops there; the stored prefix is kept and the rest is relinked to the
+ * new tail. An entry whose device and deviceSeq are already stored (a
+ * resend racing the original) is not chained again: the stored record is
+ * returned for it, marked duplicate. Stored blocks are appended to `blocks`
+ * as they land, so after a throw the caller knows which entries made it.
+ */
+async function appendBlocks(entries: ChainEntry[], blocks: ChainBlock[]): Promise<void> {
+    await ensureSequence();
+
+    let rest = entries;
+    for (let attempt = 0; rest.length > 0; attempt++) {
+        if (attempt === APPEND_RETRIES) {
+            throw new Error('Chain append lost too many races');
+        }
+
+        let { seq, hash: previousHash } = await getChainTail();
+        const docs: ChainBlock[] = rest.map((entry) => {
+            const hash = createBlockHash(entry.uid, entry.timestamp, entry.status, previousHash);
+            const block = { ...entry, seq: ++seq, hash, previousHash };
+            previousHash = hash;
+            return block;
+        });
+
+        let stored = docs.length;
+        try {
+            await Attendance.insertMany(docs, { ordered: true });
+        } catch (error) {
+            if (!isDuplicateKey(error)) throw error;
+            stored = await Attendance.countDocuments({
+                seq: { $gte: docs[0].seq, $lte: docs[docs.length - 1].seq },
+                hash: { $in: docs.map((d) => d.hash) },
+            });
+            const existing = await findByDeviceSeq(rest[stored]);
+            if (existing) {
+                blocks.push(...docs.slice(0, stored), existing);
+                rest = rest.slice(stored + 1);
+                attempt--; // not a lost race
+                continue;
+            }
+            // Back off a little so racing writers spread out
+            await new Promise((r) => setTimeout(r, Math.random() * 10 * (attempt + 1)));
+        }
+        blocks.push(...docs.slice(0, stored));
+        rest = rest.slice(stored);
+    }
+}
+
+async function findByDeviceSeq(entry: ChainEntry | undefined): Promise<ChainBlock | null> {
+    if (!entry?.device || entry.deviceSeq === undefined) return null;
+    const record = await Attendance.findOne(
+        { device: entry.device, deviceSeq: entry.deviceSeq },
+        { uid: 1, timestamp: 1, status: 1, seq: 1, hash: 1, previousHash: 1 }
+    ).lean();
+    if (!record) return null;
+    return {
+        uid: record.uid,
+        timestamp: record.timestamp,
+        status: record.status,
+        device: entry.device,
+        deviceSeq: entry.deviceSeq,
+        seq: record.seq ?? 0,
+        hash: record.hash || '',
+        previousHash: record.previousHash || '',
+        duplicate: true,
+    };
+}
+
+const CHAIN_ID = 'attendance';
+// Progress is saved this often, so a long first run that times out resumes
+const CHECKPOINT_EVERY = 10000;
+
+let warnedNoSecret = false;
+
+/**
+ * HMAC key for checkpoints, or null when none is configured. Without a
+ * secret checkpoints are neither read nor written: a signature made with
+ * a key anyone can read would let a forged checkpoint skip verification.
+ */
+function checkpointSecret(): string | null {
+    const secret = process.env.CHAIN_CHECKPOINT_SECRET || process.env.NEXTAUTH_SECRET;
+    if (!secret && !warnedNoSecret) {
+        console.warn(
+            'CHAIN_CHECKPOINT_SECRET and NEXTAUTH_SECRET are not set: chain checkpoints disabled, verifying from genesis'
+        );
+        warnedNoSecret = true;
+    }
+    return secret || null;
+}
+
+function signCheckpoint(
+    secret: string,
+    index: number,
+    hash: string,
+    recordId: string,
+    seq: number
+): string {
+    return crypto
+        .createHmac('sha256', secret)
+        .update(`${CHAIN_ID}:${index}:${hash}:${recordId}:${seq}`)
+        .digest('hex');
+}
+
+interface ChainRecord {
+    _id: Types.ObjectId;
+    seq: number;
+    uid: number;
+    timestamp: Date;
+    status: string;
+    hash?: string;
+    previousHash?: string;
+}
+
+/**
+ * Loads the stored checkpoint if its signature is valid and the record it
+ * points at still carries the same hash, otherwise returns null
+ */
+async function loadCheckpoint(secret: string) {
+    const checkpoint = await ChainCheckpoint.findById(CHAIN_ID).lean();
+    if (!checkpoint) return null;
+
+    const expected = Buffer.from(
+        signCheckpoint(
+            secret,
+            checkpoint.index,
+            checkpoint.hash,
+            checkpoint.recordId.toString(),
+            checkpoint.seq
+        ),
+        'hex'
+    );
+    const signature = Buffer.from(checkpoint.signature, 'hex');
+    if (signature.length !== expected.length || !crypto.timingSafeEqual(signature, expected)) {
+        console.warn('Chain checkpoint signature mismatch, verifying from genesis');
+        return null;
+    }
+
+    const anchor = await Attendance.findById(checkpoint.recordId, { hash: 1, seq: 1 }).lean();
+    if (!anchor || anchor.hash !== checkpoint.hash || anchor.seq !== checkpoint.seq) {
+        console.warn('Chain checkpoint record changed, verifying from genesis');
+        return null;
+    }
+    return checkpoint;
+}
+
+/**
+ * Stores the checkpoint unless a concurrent run already stored a later one.
+ * `replace` overwrites regardless (after a rejected checkpoint).
+ */
+async function saveCheckpoint(
+    secret: string | null,
+    index: number,
+    record: ChainRecord,
+    replace: boolean
+) {
+    if (!secret) return;
+    const recordId = record._id.toString();
+    const doc = {
+        index,
+        hash: record.hash,
+        recordId: record._id,
+        seq: record.seq,
+        signature: signCheckpoint(secret, index, record.hash || '', recordId, record.seq),
+        verifiedAt: new Date(),
+    };
+    const filter = replace ? { _id: CHAIN_ID } : { _id: CHAIN_ID, index: { $lt: index } };
+    try {
+        await ChainCheckpoint.updateOne(filter, { $set: doc }, { upsert: true });
+    } catch (error) {
+        if ((error as { code?: number }).code !== 11000) throw error;
+    }
 }
 
 /**
- * Verifies the integrity of the entire attendance chain
+ * Records in the chain (numbered), whether or not verification reached
+ * them. Counted the same way for a valid and a broken chain.
  */
-export async function verifyChain(): Promise<{
+function chainLength(): Promise<number> {
+    return Attendance.countDocuments({ seq: { $exists: true } });
+}
+
+/**
+ * Verifies the attendance chain. Records up to the last signed checkpoint
+ * are trusted; only newer ones are streamed and re-hashed. `full` ignores
+ * the checkpoint and verifies from the genesis block, as does a server
+ * without a checkpoint secret.
+ */
+export async function verifyChain(options: { full?: boolean } = {}): Promise<{
     valid: boolean;
     totalRecords: number;
+    verifiedRecords: number;
+    checkpoint?: number;
     brokenAt?: number;
     invalidRecord?: object;
 }> {
     await dbConnect();
+    await ensureSequence();
 
-    const records = await Attendance.find().sort({ timestamp: 1 });
+    const secret = checkpointSecret();
+    const checkpoint = options.full || !secret ? null : await loadCheckpoint(secret);
+    const replace = !checkpoint;
 
-    if (records.length === 0) {
-        return { valid: true, totalRecords: 0 };
-    }
+    let index = checkpoint ? checkpoint.index : -1;
+    let expectedPreviousHash = checkpoint ? checkpoint.hash : 'GENESIS_BLOCK';
+    const filter = { seq: checkpoint ? { $gt: checkpoint.seq } : { $exists: true } };
 
-    for (let i = 0; i < records.length; i++) {
-        const record = records[i];
-        const expectedPreviousHash = i === 0 ? 'GENESIS_BLOCK' : records[i - 1].hash;
-
-        // Check if previousHash matches
-        if (record.previousHash !== expectedPreviousHash) {
-            return {
-                valid: false,
-                totalRecords: records.length,
-                brokenAt: i,
-                invalidRecord: {
-                    _id: record._id,
-                    uid: record.uid,
-                    timestamp: record.timestamp,
-                },
-            };
-        }
+    const cursor = Attendance.find(filter, {
+        seq: 1,
+        uid: 1,
+        timestamp: 1,
+        status: 1,
+        hash: 1,
+        previousHash: 1,
+    })
+        .sort({ seq: 1 })
+        .lean<ChainRecord[]>()
+        .cursor({ batchSize: 1000 });
 
-        // Recalculate and verify the hash
-        const recalculatedHash = createBlockHash(
-            record.uid,
-            record.timestamp,
-            record.status,
-            record.previousHash || ""
-        );
+    let last: ChainRecord | null = null;
+    let unsaved = 0;
+    const start = index;
+    try {
+        for await (const record of cursor) {
+            index++;
 
-        if (record.hash !== recalculatedHash) {
-            return {
-                valid: false,
-                totalRecords: records.length,
-                brokenAt: i,
-                invalidRecord: {
-                    _id: record._id,
-                    uid: record.uid,
-                    timestamp: record.timestamp,
-                    reason: 'Hash mismatch',
-                },
-            };
+            // Check if previousHash matches, then recalculate the hash
+            let reason: string | undefined;
+            if (record.previousHash !== expectedPreviousHash) {
+                reason = 'Previous hash mismatch';
+            } else if (
+                record.hash !==
+                createBlockHash(record.uid, record.timestamp, record.status, record.previousHash || '')
+            ) {
+                reason = 'Hash mismatch';
+            }
+
+            if (reason) {
+                if (last && unsaved) await saveCheckpoint(secret, index - 1, last, replace);
+                return {
+                    valid: false,
+                    totalRecords: await chainLength(),
+                    verifiedRecords: index - start - 1,
+                    checkpoint: checkpoint?.index,
+                    brokenAt: index,
+                    invalidRecord: {
+                        _id: record._id,
+                        uid: record.uid,
+                        timestamp: record.timestamp,
+                        reason,
+                    },
+                };
+            }
+
+            expectedPreviousHash = record.hash || '';
+            last = record;
+            if (++unsaved >= CHECKPOINT_EVERY) {
+                await saveCheckpoint(secret, index, last, replace);
+                unsaved = 0;
+            }
         }
+    } finally {
+        await cursor.close();
     }
 
-    return { valid: true, totalRecords: records.length };
+    if (last && unsaved) await saveCheckpoint(secret, index, last, replace);
+    return {
+        valid: true,
+        totalRecords: await chainLength(),
+        verifiedRecords: index - start,
+        checkpoint: checkpoint?.index,
+    };
 }
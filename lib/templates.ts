@@ -0,0 +1,81 @@
+import dbConnect from './mongodb';
+import Template from '@/models/Template';
+import { releaseSequence, reserveSequence, stableSequence } from '@/models/Counter';
+
+export const TEMPLATE_MAX_BYTES = 1024;
+export const TEMPLATE_CHUNK_BYTES = 256;
+// A version still in flight after this long belongs to a writer that died.
+// Each write is a single update, far shorter.
+const TEMPLATE_WRITE_LEASE_MS = 60000;
+
+let crcTable: Uint32Array | null = null;
+
+/**
+ * Standard CRC-32 (same as crc32_le() in the ESP32 ROM)
+ */
+export function crc32(buf: Buffer): number {
+    if (!crcTable) {
+        crcTable = new Uint32Array(256);
+        for (let n = 0; n < 256; n++) {
+            let c = n;
+            for (let k = 0; k < 8; k++) {
+                c = c & 1 ? 0xedb88320 ^ (c >>> 1) : c >>> 1;
+            }
+            crcTable[n] = c >>> 0;
+        }
+    }
+    let crc = 0xffffffff;
+    for (let i = 0; i < buf.length; i++) {
+        crc = crcTable[(crc ^ buf[i]) & 0xff] ^ (crc >>> 8);
+    }
+    return (crc ^ 0xffffffff) >>> 0;
+}
+
+/**
+ * Every template change takes the next version, so readers can pull
+ * everything newer than the last version they applied. The version is
+ * taken before `write` stores it, so version N + 1 can land before N;
+ * readers only see versions up to visibleTemplateVersion().
+ */
+export async function publishTemplateVersion(
+    write: (version: number) => Promise<unknown>
+): Promise<number> {
+    const version = await reserveSequence('template', TEMPLATE_WRITE_LEASE_MS);
+    try {
+        await write(version);
+    } finally {
+        await releaseSequence('template', version);
+    }
+    return version;
+}
+
+/**
+ * Highest version below every version still being written. A reader that
+ * moved past a version would otherwise never see the lower one that lands
+ * after it.
+ */
+export function visibleTemplateVersion(): Promise<number> {
+    return stableSequence('template', TEMPLATE_WRITE_LEASE_MS);
+}
+
+/**
+ * Marks the template of an employee as deleted. The tombstone keeps its
+ * own version so readers that already hold the template remove it too.
+ */
+export async function deleteTemplate(uid: number): Promise<boolean> {
+    await dbConnect();
+    const existing = await Template.findOne({ uid, deleted: false }, { _id: 1 });
+    if (!existing) {
+        return false;
+    }
+    await publishTemplateVersion((version) =>
+        Template.updateOne(
+            { _id: existing._id },
+            {
+                $set: { deleted: true, version, updatedAt: new Date() },
+                $unset: { data: 1, upload: 1 },
+            }
+        )
+    );
+    return true;
+}
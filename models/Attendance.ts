@@ -1,23 +1,46 @@
 import mongoose, { Schema, Document, Model } from 'mongoose';
 
 export interface IAttendance extends Document {
+    seq?: number; // position in the hash chain, 1-based
     uid: number;
     timestamp: Date;
     status: 'In' | 'Out';
     hash?: string;
     previousHash?: string;
     deviceAuthToken?: string;
+    device?: string; // x-device-id of the reader that sent the record
+    deviceSeq?: number; // record number on that device, see ingestBatch()
 }
 
 const AttendanceSchema: Schema = new Schema({
+    seq: { type: Number, required: false },
     uid: { type: Number, required: true, index: true },
     timestamp: { type: Date, default: Date.now },
     status: { type: String, enum: ['In', 'Out'], required: true },
     hash: { type: String, required: false },
     previousHash: { type: String, required: false },
     deviceAuthToken: { type: String, required: false }, // For extra security later
+    device: { type: String, required: false },
+    deviceSeq: { type: Number, required: false },
 });
 
+// Chain order: a seq number can only be taken once, which keeps concurrent
+// appends from linking to the same tail. Partial, so records not yet
+// numbered (stored before seq existed) do not collide on null.
+AttendanceSchema.index(
+    { seq: 1 },
+    { unique: true, partialFilterExpression: { seq: { $exists: true } } }
+);
+// Idempotency key: a device resends a batch whose reply it never got, and
+// each record may be stored only once. Partial, like seq, for records
+// without one.
+AttendanceSchema.index(
+    { device: 1, deviceSeq: 1 },
+    { unique: true, partialFilterExpression: { deviceSeq: { $exists: true } } }
+);
+// Order records were chained in before seq existed, see ensureSequence()
+AttendanceSchema.index({ timestamp: 1, _id: 1 });
+
 // Prevent model recompilation error in development
 const Attendance: Model<IAttendance> =
     mongoose.models.Attendance ||
@@ -0,0 +1,27 @@
+import mongoose, { Schema, Document, Model, Types } from 'mongoose';
+
+export interface IChainCheckpoint extends Omit<Document, '_id'> {
+    _id: string; // chain name
+    index: number; // position of the last verified record (0-based)
+    hash: string; // hash of that record
+    recordId: Types.ObjectId;
+    seq: number; // Attendance.seq of that record
+    signature: string; // HMAC-SHA256 over the fields above
+    verifiedAt: Date;
+}
+
+const ChainCheckpointSchema: Schema = new Schema({
+    _id: { type: String, required: true },
+    index: { type: Number, required: true },
+    hash: { type: String, required: true },
+    recordId: { type: Schema.Types.ObjectId, required: true },
+    seq: { type: Number, required: true },
+    signature: { type: String, required: true },
+    verifiedAt: { type: Date, default: Date.now },
+});
+
+const ChainCheckpoint: Model<IChainCheckpoint> =
+    mongoose.models.ChainCheckpoint ||
+    mongoose.model<IChainCheckpoint>('ChainCheckpoint', ChainCheckpointSchema);
+
+export default ChainCheckpoint;
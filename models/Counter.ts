@@ -0,0 +1,132 @@
+import mongoose, { Schema, Document, Model } from 'mongoose';
+
+export interface ICounter extends Omit<Document, '_id'> {
+    _id: string;
+    seq: number;
+    // Values handed out by reserveSequence() whose write has not landed yet
+    inflight?: { value: number; at: Date }[];
+    // Process holding the lease taken by acquireLease(), and until when
+    holder?: string;
+    until?: Date;
+}
+
+const CounterSchema: Schema = new Schema({
+    _id: { type: String, required: true },
+    seq: { type: Number, default: 0 },
+    inflight: { type: [{ _id: false, value: Number, at: Date }], default: undefined },
+    holder: { type: String },
+    until: { type: Date },
+});
+
+const Counter: Model<ICounter> =
+    mongoose.models.Counter || mongoose.model<ICounter>('Counter', CounterSchema);
+
+/**
+ * Atomically increments and returns the named sequence (first value is 1)
+ */
+export async function nextSequence(name: string): Promise<number> {
+    const counter = await Counter.findOneAndUpdate(
+        { _id: name },
+        { $inc: { seq: 1 } },
+        { new: true, upsert: true }
+    );
+    return counter.seq;
+}
+
+/**
+ * Like nextSequence(), but the value stays in flight until
+ * releaseSequence(). Entries older than leaseMs (writer died) are dropped.
+ */
+export async function reserveSequence(name: string, leaseMs: number): Promise<number> {
+    const counter = await Counter.findOneAndUpdate(
+        { _id: name },
+        [
+            { $set: { seq: { $add: [{ $ifNull: ['$seq', 0] }, 1] } } },
+            {
+                $set: {
+                    inflight: {
+                        $concatArrays: [
+                            {
+                                $filter: {
+                                    input: { $ifNull: ['$inflight', []] },
+                                    cond: { $gt: ['$$this.at', { $subtract: ['$$NOW', leaseMs] }] },
+                                },
+                            },
+                            [{ value: '$seq', at: '$$NOW' }],
+                        ],
+                    },
+                },
+            },
+        ],
+        { new: true, upsert: true, updatePipeline: true }
+    );
+    return counter.seq;
+}
+
+export async function releaseSequence(name: string, value: number): Promise<void> {
+    await Counter.updateOne({ _id: name }, { $pull: { inflight: { value } } });
+}
+
+/**
+ * Highest value with no lower value still in flight: everything up to it
+ * has been written, so a reader that stops there never skips a value that
+ * lands later. Uses the server clock for the lease, like reserveSequence().
+ */
+export async function stableSequence(name: string, leaseMs: number): Promise<number> {
+    const [counter] = await Counter.aggregate([
+        { $match: { _id: name } },
+        {
+            $project: {
+                seq: 1,
+                lowest: {
+                    $min: {
+                        $map: {
+                            input: {
+                                $filter: {
+                                    input: { $ifNull: ['$inflight', []] },
+                                    cond: { $gt: ['$$this.at', { $subtract: ['$$NOW', leaseMs] }] },
+                                },
+                            },
+                            in: '$$this.value',
+                        },
+                    },
+                },
+            },
+        },
+    ]);
+    if (!counter) return 0;
+    return counter.lowest != null ? counter.lowest - 1 : counter.seq;
+}
+
+/**
+ * Takes or renews the named lease for `owner` unless another owner holds
+ * it and it has not expired. Returns whether `owner` holds it now. Uses
+ * the server clock, so processes with skewed clocks agree on expiry.
+ */
+export async function acquireLease(name: string, owner: string, leaseMs: number): Promise<boolean> {
+    const free = {
+        $or: [
+            { $eq: [{ $ifNull: ['$holder', owner] }, owner] },
+            { $lte: [{ $ifNull: ['$until', new Date(0)] }, '$$NOW'] },
+        ],
+    };
+    const counter = await Counter.findOneAndUpdate(
+        { _id: name },
+        [
+            {
+                $set: {
+                    holder: { $cond: [free, owner, '$holder'] },
+                    until: { $cond: [free, { $add: ['$$NOW', leaseMs] }, '$until'] },
+                },
+            },
+        ],
+        { new: true, upsert: true, updatePipeline: true }
+    );
+    return counter.holder === owner;
+}
+
+export async function releaseLease(name: string, owner: string): Promise<void> {
+    await Counter.updateOne({ _id: name, holder: owner }, { $unset: { holder: 1, until: 1 } });
+}
+
+export default Counter;
@@ -0,0 +1,40 @@
+import mongoose, { Schema, Document, Model } from 'mongoose';
+
+export interface ITemplate extends Document {
+    uid: number; // Employee.uid
+    version: number;
+    crc: number;
+    size: number;
+    data?: Buffer;
+    deleted: boolean;
+    upload?: {
+        crc: number;
+        size: number;
+        received: Buffer;
+    };
+    updatedAt: Date;
+}
+
+const TemplateSchema: Schema = new Schema({
+    uid: { type: Number, required: true, unique: true }, // Reference to Employee.uid
+    version: { type: Number, required: true, index: true },
+    crc: { type: Number, default: 0 },
+    size: { type: Number, default: 0 },
+    data: { type: Buffer, required: false },
+    deleted: { type: Boolean, default: false },
+    // Chunked upload in progress, promoted to data once complete
+    upload: {
+        type: {
+            crc: Number,
+            size: Number,
+            received: Buffer,
+        },
+        required: false,
+    },
+    updatedAt: { type: Date, default: Date.now },
+});
+
+const Template: Model<ITemplate> =
+    mongoose.models.Template || mongoose.model<ITemplate>('Template', TemplateSchema);
+
+export default Template;
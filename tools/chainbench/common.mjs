@@ -0,0 +1,91 @@
+// Shared by the chain benchmarks: scratch database, command line options
+// and the block hash of lib/blockchain.ts (createBlockHash).
+import crypto from 'crypto';
+import mongoose from 'mongoose';
+
+export function blockHash(uid, timestamp, status, previousHash) {
+    const blockData = {
+        uid,
+        timestamp: timestamp.toISOString(),
+        status,
+        previousHash,
+    };
+    return crypto.createHash('sha256').update(JSON.stringify(blockData)).digest('hex');
+}
+
+// --name value or --name=value, numbers converted
+export function option(name, fallback) {
+    const args = process.argv.slice(2);
+    for (let i = 0; i < args.length; i++) {
+        let value;
+        if (args[i] === `--${name}`) value = args[i + 1];
+        else if (args[i].startsWith(`--${name}=`)) value = args[i].slice(name.length + 3);
+        else continue;
+        return typeof fallback === 'number' ? Number(value) : value;
+    }
+    return fallback;
+}
+
+// Every value of a repeatable option, e.g. --url a --url b
+export function options(name, fallback) {
+    const args = process.argv.slice(2);
+    const values = [];
+    args.forEach((a, i) => {
+        if (a === `--${name}`) values.push(args[i + 1]);
+        else if (a.startsWith(`--${name}=`)) values.push(a.slice(name.length + 3));
+    });
+    return values.length ? values : fallback;
+}
+
+/**
+ * Connects to CHAINBENCH_URI and empties the collections the benchmark
+ * writes. A separate variable from MONGODB_URI, so a shell that points the
+ * app at real data cannot wipe it by accident.
+ */
+export async function openScratchDb() {
+    const uri = process.env.CHAINBENCH_URI;
+    if (!uri) {
+        console.error('Set CHAINBENCH_URI to a scratch database, it is emptied first');
+        process.exit(2);
+    }
+    await mongoose.connect(uri);
+    const db = mongoose.connection.db;
+    for (const name of ['attendances', 'chaincheckpoints', 'employees']) {
+        await db.collection(name).deleteMany({});
+    }
+    // Same definition as models/Attendance.ts, so it exists before the
+    // server first loads the model
+    await db.collection('attendances').createIndex(
+        { seq: 1 },
+        { unique: true, partialFilterExpression: { seq: { $exists: true } } }
+    );
+    return db;
+}
+
+export async function closeDb() {
+    await mongoose.disconnect();
+}
+
+export async function getJson(url, init) {
+    const res = await fetch(url, init);
+    const body = await res.json().catch(() => ({}));
+    if (!res.ok) throw new Error(`${url}: HTTP ${res.status} ${JSON.stringify(body)}`);
+    return body;
+}
+
+export async function timed(fn) {
+    const t0 = performance.now();
+    const result = await fn();
+    return [result, performance.now() - t0];
+}
+
+// Collects failed checks; the script exits 1 if there are any
+export function checker() {
+    const failed = [];
+    const check = (ok, what) => {
+        console.log(`  ${ok ? 'ok  ' : 'FAIL'} ${what}`);
+        if (!ok) failed.push(what);
+    };
+    check.failed = failed;
+    return check;
+}
@@ -0,0 +1,95 @@
+// Records/s of /api/ingest with one event per POST (the old firmware path)
+// against array batches (the outbox path). The same --events events are
+// replayed both ways against the same scratch database, which is emptied
+// between the two runs; each run must leave a valid chain of every event.
+//
+//   CHAINBENCH_URI=mongodb://localhost/axiom_bench HARDWARE_API_KEY=... \
+//     node tools/chainbench/ingest-batch.mjs --events 2000 --batch 10 \
+//     --url http://localhost:3000
+import { checker, closeDb, getJson, openScratchDb, option, timed } from './common.mjs';
+
+const EVENTS = option('events', 2000);
+const BATCH = option('batch', 10); // events per request, like UPLOAD_BATCH
+const DEVICES = option('devices', 4); // readers posting at the same time
+const EMPLOYEES = option('employees', 300);
+const SERVER = option('url', 'http://localhost:3000');
+const API_KEY = process.env.HARDWARE_API_KEY || '';
+
+const db = await openScratchDb();
+await db.collection('employees').insertMany(
+    Array.from({ length: EMPLOYEES }, (_, i) => ({
+        uid: i + 1,
+        name: `Bench ${i + 1}`,
+        department: 'Bench',
+        isActive: true,
+        joinedAt: new Date(),
+    }))
+);
+
+// One scan a second per reader, spread over the employees
+const start = Date.now() - EVENTS * 1000;
+const events = Array.from({ length: EVENTS }, (_, i) => ({
+    uid: 1 + ((i * 37) % EMPLOYEES),
+    timestamp: new Date(start + i * 1000).toISOString(),
+    seq: Math.floor(i / DEVICES) + 1,
+}));
+
+function post(device, body) {
+    return getJson(`${SERVER}/api/ingest`, {
+        method: 'POST',
+        headers: {
+            'content-type': 'application/json',
+            'x-api-key': API_KEY,
+            'x-device-id': device,
+        },
+        body: JSON.stringify(body),
+    });
+}
+
+// Reader n sends events n, n + DEVICES, ... in order, `size` per request;
+// size 0 posts each one as a single object, without seq
+async function replay(size) {
+    await db.collection('attendances').deleteMany({});
+    await db.collection('chaincheckpoints').deleteMany({});
+    const [, ms] = await timed(() =>
+        Promise.all(
+            Array.from({ length: DEVICES }, async (_, n) => {
+                const mine = events.filter((_, i) => i % DEVICES === n);
+                const device = `bench-${n}`;
+                if (!size) {
+                    for (const { uid, timestamp } of mine) await post(device, { uid, timestamp });
+                    return;
+                }
+                for (let i = 0; i < mine.length; i += size) {
+                    const reply = await post(device, mine.slice(i, i + size));
+                    if (reply.duplicates) throw new Error(`${device}: unexpected duplicates`);
+                }
+            })
+        )
+    );
+    const count = await db.collection('attendances').countDocuments();
+    const verified = await getJson(`${SERVER}/api/verify-chain?full=1`);
+    return { ms, count, valid: verified.valid && verified.verifiedRecords === count };
+}
+
+const single = await replay(0);
+const batched = await replay(BATCH);
+
+const rate = (run) => (EVENTS / run.ms) * 1000;
+console.log(`${EVENTS} events from ${DEVICES} devices:`);
+console.log(`  single POST:   ${(single.ms / 1000).toFixed(1)} s, ${rate(single).toFixed(0)} records/s`);
+console.log(
+    `  batch of ${BATCH}: ${(batched.ms / 1000).toFixed(1)} s, ${rate(batched).toFixed(0)} records/s ` +
+        `(${(rate(batched) / rate(single)).toFixed(1)}x)`
+);
+
+const check = checker();
+check(single.count === EVENTS && single.valid, `single POSTs: ${single.count} records, chain valid`);
+check(batched.count === EVENTS && batched.valid, `batches: ${batched.count} records, chain valid`);
+check(rate(batched) > rate(single), 'batches store more records/s than single POSTs');
+
+await closeDb();
+if (check.failed.length) {
+    console.log(`${check.failed.length} check(s) failed`);
+    process.exit(1);
+}
@@ -0,0 +1,129 @@
+// Concurrent /api/ingest load from simulated readers. Afterwards the chain
+// must have no forks and no gaps, and every acknowledged event must be
+// stored exactly once.
+//
+//   CHAINBENCH_URI=mongodb://localhost/axiom_bench HARDWARE_API_KEY=... \
+//     node tools/chainbench/ingest-load.mjs --devices 20 --seconds 30 \
+//     --url http://localhost:3000 --url http://localhost:3001
+import { blockHash, checker, closeDb, getJson, openScratchDb, option, options, timed } from './common.mjs';
+
+const DEVICES = option('devices', 20);
+const SECONDS = option('seconds', 30);
+const BATCH = option('batch', 10); // events per request, like UPLOAD_BATCH
+const RESEND = option('resend', 0.1); // share of batches sent twice at once
+const EMPLOYEES = option('employees', 300);
+const URLS = options('url', ['http://localhost:3000']);
+const API_KEY = process.env.HARDWARE_API_KEY || '';
+
+const db = await openScratchDb();
+await db.collection('employees').insertMany(
+    Array.from({ length: EMPLOYEES }, (_, i) => ({
+        uid: i + 1,
+        name: `Bench ${i + 1}`,
+        department: 'Bench',
+        isActive: true,
+        joinedAt: new Date(),
+    }))
+);
+
+let stored = 0;
+let duplicates = 0;
+let failures = 0;
+const latencies = [];
+
+function post(url, device, events) {
+    return timed(() =>
+        getJson(`${url}/api/ingest`, {
+            method: 'POST',
+            headers: {
+                'content-type': 'application/json',
+                'x-api-key': API_KEY,
+                'x-device-id': device,
+            },
+            body: JSON.stringify(events),
+        })
+    );
+}
+
+// One reader: batches back to back until the deadline, retried until the
+// server answers, as the firmware outbox does. A resent batch goes to the
+// next server, so with several --url the copies race across processes.
+async function reader(n, deadline) {
+    const device = `bench-${n}`;
+    let seq = 0;
+    while (Date.now() < deadline) {
+        const events = Array.from({ length: BATCH }, () => ({
+            uid: 1 + Math.floor(Math.random() * EMPLOYEES),
+            timestamp: new Date().toISOString(),
+            seq: ++seq,
+        }));
+        const copies = Math.random() < RESEND ? 2 : 1;
+        for (;;) {
+            const replies = await Promise.allSettled(
+                Array.from({ length: copies }, (_, i) => post(URLS[(n + i) % URLS.length], device, events))
+            );
+            const ok = replies.filter((r) => r.status === 'fulfilled').map((r) => r.value);
+            failures += replies.length - ok.length;
+            if (!ok.length) {
+                await new Promise((resolve) => setTimeout(resolve, 200));
+                continue;
+            }
+            ok.forEach(([, ms]) => latencies.push(ms));
+            // Copies race: together they store the batch once
+            for (const [reply] of ok) {
+                stored += reply.stored;
+                duplicates += reply.duplicates;
+            }
+            break;
+        }
+    }
+    return seq;
+}
+
+const deadline = Date.now() + SECONDS * 1000;
+const [sent, wallMs] = await timed(() =>
+    Promise.all(Array.from({ length: DEVICES }, (_, n) => reader(n, deadline)))
+);
+const events = sent.reduce((a, b) => a + b, 0);
+
+latencies.sort((a, b) => a - b);
+const pct = (p) => latencies[Math.min(latencies.length - 1, Math.floor((p / 100) * latencies.length))];
+console.log(
+    `${DEVICES} devices via ${URLS.length} server(s): ${events} events in ${(wallMs / 1000).toFixed(1)} s, ` +
+        `${((stored / wallMs) * 1000).toFixed(0)} inserts/s, ${duplicates} duplicates, ${failures} failed requests`
+);
+console.log(
+    `request latency: p50 ${pct(50).toFixed(0)} ms, p99 ${pct(99).toFixed(0)} ms, max ${latencies[latencies.length - 1].toFixed(0)} ms`
+);
+
+const check = checker();
+const attendances = db.collection('attendances');
+const count = await attendances.countDocuments();
+check(stored === events && count === events, `every event stored once (${count} records, ${stored} acknowledged)`);
+
+const forks = await attendances
+    .aggregate([{ $group: { _id: '$previousHash', n: { $sum: 1 } } }, { $match: { n: { $gt: 1 } } }])
+    .toArray();
+check(forks.length === 0, `no two records link to the same previous hash (${forks.length} forks)`);
+
+let expectedSeq = 1;
+let previousHash = 'GENESIS_BLOCK';
+let badLinks = 0;
+for await (const r of attendances.find({}, { sort: { seq: 1 } })) {
+    if (r.seq !== expectedSeq || r.previousHash !== previousHash ||
+        r.hash !== blockHash(r.uid, r.timestamp, r.status, r.previousHash)) {
+        badLinks++;
+    }
+    expectedSeq = r.seq + 1;
+    previousHash = r.hash;
+}
+check(badLinks === 0 && expectedSeq === count + 1, `seq 1..${count} without gaps, every link and hash valid`);
+
+const verified = await getJson(`${URLS[0]}/api/verify-chain?full=1`);
+check(verified.valid && verified.verifiedRecords === count, '/api/verify-chain?full=1 agrees');
+
+await closeDb();
+if (check.failed.length) {
+    console.log(`${check.failed.length} check(s) failed`);
+    process.exit(1);
+}
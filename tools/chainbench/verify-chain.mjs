@@ -0,0 +1,68 @@
+// /api/verify-chain on a large chain: a full rescan from genesis, then the
+// incremental runs that start from the signed checkpoint.
+//
+//   CHAINBENCH_URI=mongodb://localhost/axiom_bench \
+//     node tools/chainbench/verify-chain.mjs --records 1000000 --url http://localhost:3000
+import { blockHash, checker, closeDb, getJson, openScratchDb, option, timed } from './common.mjs';
+
+const RECORDS = option('records', 1000000);
+const APPEND = option('append', 1000);
+const URL = option('url', 'http://localhost:3000');
+const INSERT_BATCH = 10000;
+const T0 = Date.UTC(2025, 0, 1);
+
+const db = await openScratchDb();
+const attendances = db.collection('attendances');
+
+let tail = { seq: 0, hash: 'GENESIS_BLOCK' };
+
+// Chained records seq+1..seq+n, one scan a minute over 500 employees
+async function append(n) {
+    for (let done = 0; done < n; ) {
+        const docs = [];
+        for (; docs.length < INSERT_BATCH && done < n; done++) {
+            const seq = tail.seq + 1;
+            const uid = 1 + (seq % 500);
+            const timestamp = new Date(T0 + seq * 60000);
+            const status = Math.floor(seq / 500) % 2 ? 'Out' : 'In';
+            const hash = blockHash(uid, timestamp, status, tail.hash);
+            docs.push({ seq, uid, timestamp, status, hash, previousHash: tail.hash });
+            tail = { seq, hash };
+        }
+        await attendances.insertMany(docs, { ordered: true });
+    }
+}
+
+const verify = (full) => timed(() => getJson(`${URL}/api/verify-chain${full ? '?full=1' : ''}`));
+const check = checker();
+
+const [, seedMs] = await timed(() => append(RECORDS));
+console.log(`seeded ${RECORDS} records in ${(seedMs / 1000).toFixed(1)} s`);
+
+const [full, fullMs] = await verify(true);
+console.log(`full:        ${fullMs.toFixed(0)} ms (${((RECORDS / fullMs) * 1000).toFixed(0)} records/s)`);
+check(full.valid && full.verifiedRecords === RECORDS, `full rescan verifies ${RECORDS} records`);
+
+const [idle, idleMs] = await verify(false);
+console.log(`nothing new: ${idleMs.toFixed(0)} ms`);
+check(idle.valid && idle.verifiedRecords === 0, 'resumes at the checkpoint with nothing to do');
+
+await append(APPEND);
+const [inc, incMs] = await verify(false);
+console.log(`+${APPEND}:       ${incMs.toFixed(0)} ms`);
+check(inc.valid && inc.verifiedRecords === APPEND, `verifies only the ${APPEND} new records`);
+check(inc.totalRecords === RECORDS + APPEND, 'totalRecords counts the whole chain');
+check(incMs * 10 < fullMs, 'incremental run takes under a tenth of the full rescan');
+
+// A record changed after the checkpoint is still caught
+await append(10);
+const tampered = RECORDS + APPEND + 5;
+await attendances.updateOne({ seq: tampered }, { $set: { status: 'Out', uid: 9999 } });
+const [broken] = await verify(false);
+check(!broken.valid && broken.brokenAt === tampered - 1, `reports the change at index ${tampered - 1}`);
+
+await closeDb();
+if (check.failed.length) {
+    console.log(`${check.failed.length} check(s) failed`);
+    process.exit(1);
+}
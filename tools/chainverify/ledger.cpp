@@ -0,0 +1,836 @@
+#include "ledger.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "sha256.h"
+
+namespace chain {
+
+// ================== Dates ==================
+
+// Days since 1970-01-01 for a proleptic Gregorian date (H. Hinnant)
+static int64_t daysFromCivil(int64_t y, unsigned m, unsigned d) {
+  y -= m <= 2;
+  int64_t era = (y >= 0 ? y : y - 399) / 400;
+  unsigned yoe = (unsigned)(y - era * 400);
+  unsigned doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+  unsigned doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+  return era * 146097 + (int64_t)doe - 719468;
+}
+
+static void civilFromDays(int64_t z, int64_t *y, unsigned *m, unsigned *d) {
+  z += 719468;
+  int64_t era = (z >= 0 ? z : z - 146096) / 146097;
+  unsigned doe = (unsigned)(z - era * 146097);
+  unsigned yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+  unsigned doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+  unsigned mp = (5 * doy + 2) / 153;
+  *d = doy - (153 * mp + 2) / 5 + 1;
+  *m = mp < 10 ? mp + 3 : mp - 9;
+  *y = (int64_t)yoe + era * 400 + (*m <= 2);
+}
+
+static int64_t floorDiv(int64_t a, int64_t b) {
+  return a / b - ((a % b != 0) && ((a < 0) != (b < 0)));
+}
+
+std::string isoTimestamp(int64_t ms) {
+  int64_t days = floorDiv(ms, 86400000);
+  int64_t rem = ms - days * 86400000;
+  int64_t y;
+  unsigned m, d;
+  civilFromDays(days, &y, &m, &d);
+
+  char buf[64];
+  char year[16];
+  // Years outside 0..9999 use the expanded +YYYYYY / -YYYYYY form
+  if (y >= 0 && y <= 9999)
+    snprintf(year, sizeof(year), "%04lld", (long long)y);
+  else
+    snprintf(year, sizeof(year), "%c%06lld", y < 0 ? '-' : '+',
+             (long long)(y < 0 ? -y : y));
+  snprintf(buf, sizeof(buf), "%s-%02u-%02uT%02d:%02d:%02d.%03dZ", year, m, d,
+           (int)(rem / 3600000), (int)(rem / 60000 % 60),
+           (int)(rem / 1000 % 60), (int)(rem % 1000));
+  return buf;
+}
+
+static bool digits(const char *&p, int n, int *out) {
+  int v = 0;
+  for (int i = 0; i < n; i++, p++) {
+    if (*p < '0' || *p > '9')
+      return false;
+    v = v * 10 + (*p - '0');
+  }
+  *out = v;
+  return true;
+}
+
+bool parseIsoTimestamp(const std::string &s, int64_t *ms) {
+  const char *p = s.c_str();
+  int64_t year;
+  int y, mo, d, h, mi, se = 0, frac = 0;
+  if (*p == '+' || *p == '-') {
+    bool neg = *p++ == '-';
+    if (!digits(p, 6, &y))
+      return false;
+    year = neg ? -y : y;
+  } else {
+    if (!digits(p, 4, &y))
+      return false;
+    year = y;
+  }
+  if (*p++ != '-' || !digits(p, 2, &mo) || *p++ != '-' || !digits(p, 2, &d))
+    return false;
+  if (*p != 'T' && *p != ' ')
+    return false;
+  p++;
+  if (!digits(p, 2, &h) || *p++ != ':' || !digits(p, 2, &mi))
+    return false;
+  if (*p == ':') {
+    p++;
+    if (!digits(p, 2, &se))
+      return false;
+    if (*p == '.' || *p == ',') {
+      p++;
+      // Milliseconds; further digits are truncated like Date.parse()
+      int n = 0;
+      for (; *p >= '0' && *p <= '9'; p++, n++)
+        if (n < 3)
+          frac = frac * 10 + (*p - '0');
+      if (!n)
+        return false;
+      for (; n < 3; n++)
+        frac *= 10;
+    }
+  }
+  int offset = 0;
+  if (*p == 'Z') {
+    p++;
+  } else if (*p == '+' || *p == '-') {
+    int sign = *p++ == '-' ? -1 : 1;
+    int oh, om;
+    if (!digits(p, 2, &oh))
+      return false;
+    if (*p == ':')
+      p++;
+    if (!digits(p, 2, &om))
+      return false;
+    offset = sign * (oh * 60 + om);
+  }
+  if (*p || mo < 1 || mo > 12 || d < 1 || d > 31 || h > 24 || mi > 59 ||
+      se > 59)
+    return false;
+
+  int64_t days = daysFromCivil(year, mo, d);
+  *ms = ((days * 24 + h) * 60 + mi - offset) * 60000LL + se * 1000LL + frac;
+  return true;
+}
+
+// ================== JSON text ==================
+
+std::string jsNumber(double x) {
+  if (!isfinite(x))
+    return "null"; // JSON.stringify(NaN) / Infinity
+  if (x == 0)
+    return "0";
+  if (x == floor(x) && fabs(x) < 1e21) {
+    char buf[32];
+    snprintf(buf, sizeof(buf), "%.0f", x);
+    return buf;
+  }
+
+  // Shortest digit string that reads back to x
+  char buf[40];
+  for (int prec = 1; prec <= 17; prec++) {
+    snprintf(buf, sizeof(buf), "%.*e", prec - 1, x);
+    if (strtod(buf, nullptr) == x)
+      break;
+  }
+  std::string out = x < 0 ? "-" : "";
+  const char *p = buf + (x < 0);
+  std::string dig;
+  for (; *p != 'e'; p++)
+    if (*p != '.')
+      dig += *p;
+  while (dig.size() > 1 && dig.back() == '0')
+    dig.pop_back();
+  int n = atoi(p + 1) + 1; // decimal point position
+  int k = dig.size();
+
+  if (k <= n && n <= 21) {
+    out += dig + std::string(n - k, '0');
+  } else if (0 < n && n <= 21) {
+    out += dig.substr(0, n) + "." + dig.substr(n);
+  } else if (-6 < n && n <= 0) {
+    out += "0." + std::string(-n, '0') + dig;
+  } else {
+    out += dig.substr(0, 1);
+    if (k > 1)
+      out += "." + dig.substr(1);
+    char e[16];
+    snprintf(e, sizeof(e), "e%c%d", n - 1 < 0 ? '-' : '+', abs(n - 1));
+    out += e;
+  }
+  return out;
+}
+
+void jsonQuote(const std::string &s, std::string &out) {
+  static const char hex[] = "0123456789abcdef";
+  out += '"';
+  for (size_t i = 0; i < s.size(); i++) {
+    unsigned char c = s[i];
+    switch (c) {
+    case '"':
+      out += "\\\"";
+      break;
+    case '\\':
+      out += "\\\\";
+      break;
+    case '\b':
+      out += "\\b";
+      break;
+    case '\f':
+      out += "\\f";
+      break;
+    case '\n':
+      out += "\\n";
+      break;
+    case '\r':
+      out += "\\r";
+      break;
+    case '\t':
+      out += "\\t";
+      break;
+    default:
+      if (c < 0x20) {
+        out += "\\u00";
+        out += hex[c >> 4];
+        out += hex[c & 15];
+      } else if (c == 0xED && i + 2 < s.size() &&
+                 ((unsigned char)s[i + 1] & 0xE0) == 0xA0) {
+        // Lone surrogate kept as WTF-8 by the parser: JSON.stringify
+        // writes it as \udxxx
+        unsigned cp = 0xD000 | ((s[i + 1] & 0x3F) << 6) | (s[i + 2] & 0x3F);
+        out += "\\u";
+        out += hex[(cp >> 12) & 15];
+        out += hex[(cp >> 8) & 15];
+        out += hex[(cp >> 4) & 15];
+        out += hex[cp & 15];
+        i += 2;
+      } else {
+        out += (char)c;
+      }
+    }
+  }
+  out += '"';
+}
+
+std::string canonicalBlock(const Record &r) {
+  // Keys with an undefined value are left out, like JSON.stringify does
+  std::string out = "{";
+  if (!r.uid.empty())
+    out += "\"uid\":" + r.uid + ",";
+  out += "\"timestamp\":\"" + isoTimestamp(r.timestampMs) + "\",";
+  if (r.hasStatus) {
+    out += "\"status\":";
+    jsonQuote(r.status, out);
+    out += ",";
+  }
+  out += "\"previousHash\":";
+  jsonQuote(r.hasPreviousHash ? r.previousHash : std::string(), out);
+  out += "}";
+  return out;
+}
+
+std::string blockHash(const Record &r) { return sha256Hex(canonicalBlock(r)); }
+
+// ================== Extended JSON ==================
+
+namespace {
+
+struct Scalar {
+  enum Type { None, String, Number, Bool, Null, Other } type = None;
+  std::string text; // unescaped string, number text, "true"/"false"
+  std::string tag;  // extended JSON wrapper, e.g. "$date" or "$date/$numberLong"
+};
+
+class JsonParser {
+public:
+  JsonParser(const char *p, const char *end) : p_(p), end_(end) {}
+
+  void ws() {
+    while (p_ < end_ && (*p_ == ' ' || *p_ == '\t' || *p_ == '\n' || *p_ == '\r'))
+      p_++;
+  }
+
+  bool lit(char c) {
+    ws();
+    if (p_ < end_ && *p_ == c) {
+      p_++;
+      return true;
+    }
+    return false;
+  }
+
+  bool peek(char c) {
+    ws();
+    return p_ < end_ && *p_ == c;
+  }
+
+  bool string(std::string &out) {
+    if (!lit('"'))
+      return false;
+    out.clear();
+    while (p_ < end_) {
+      char c = *p_++;
+      if (c == '"')
+        return true;
+      if (c != '\\') {
+        out += c;
+        continue;
+      }
+      if (p_ >= end_)
+        return false;
+      c = *p_++;
+      switch (c) {
+      case 'b': out += '\b'; break;
+      case 'f': out += '\f'; break;
+      case 'n': out += '\n'; break;
+      case 'r': out += '\r'; break;
+      case 't': out += '\t'; break;
+      case 'u': {
+        unsigned cp;
+        if (!hex4(&cp))
+          return false;
+        if (cp >= 0xD800 && cp < 0xDC00 && end_ - p_ >= 6 && p_[0] == '\\' &&
+            p_[1] == 'u') {
+          const char *save = p_;
+          p_ += 2;
+          unsigned lo;
+          if (hex4(&lo) && lo >= 0xDC00 && lo < 0xE000)
+            cp = 0x10000 + ((cp - 0xD800) << 10) + (lo - 0xDC00);
+          else
+            p_ = save;
+        }
+        utf8(cp, out);
+        break;
+      }
+      default:
+        out += c;
+      }
+    }
+    return false;
+  }
+
+  bool number(std::string &out) {
+    ws();
+    const char *s = p_;
+    while (p_ < end_ && (strchr("+-.eE", *p_) || (*p_ >= '0' && *p_ <= '9')))
+      p_++;
+    out.assign(s, p_);
+    return p_ > s;
+  }
+
+  bool skip() {
+    ws();
+    if (p_ >= end_)
+      return false;
+    std::string tmp;
+    if (*p_ == '"')
+      return string(tmp);
+    if (*p_ == '{' || *p_ == '[') {
+      char close = *p_ == '{' ? '}' : ']';
+      p_++;
+      if (lit(close))
+        return true;
+      do {
+        if (close == '}' && (!string(tmp) || !lit(':')))
+          return false;
+        if (!skip())
+          return false;
+      } while (lit(','));
+      return lit(close);
+    }
+    if (*p_ == 't' || *p_ == 'f' || *p_ == 'n') {
+      while (p_ < end_ && *p_ >= 'a' && *p_ <= 'z')
+        p_++;
+      return true;
+    }
+    return number(tmp);
+  }
+
+  bool scalar(Scalar &v) {
+    ws();
+    if (p_ >= end_)
+      return false;
+    char c = *p_;
+    if (c == '"') {
+      v.type = Scalar::String;
+      return string(v.text);
+    }
+    if (c == 't' || c == 'f' || c == 'n') {
+      const char *s = p_;
+      while (p_ < end_ && *p_ >= 'a' && *p_ <= 'z')
+        p_++;
+      v.text.assign(s, p_);
+      v.type = c == 'n' ? Scalar::Null : Scalar::Bool;
+      return true;
+    }
+    if (c == '[') {
+      v.type = Scalar::Other;
+      return skip();
+    }
+    if (c != '{') {
+      v.type = Scalar::Number;
+      return number(v.text);
+    }
+
+    // {"$oid": ...}, {"$date": ...}, {"$numberLong": ...}
+    p_++;
+    v.type = Scalar::Other;
+    if (lit('}'))
+      return true;
+    std::string key;
+    if (!string(key) || !lit(':'))
+      return false;
+    if (key.size() > 1 && key[0] == '$') {
+      Scalar inner;
+      if (!scalar(inner))
+        return false;
+      v = inner;
+      v.tag = inner.tag.empty() ? key : key + "/" + inner.tag;
+    } else if (!skip()) {
+      return false;
+    }
+    while (lit(',')) {
+      if (!string(key) || !lit(':') || !skip())
+        return false;
+    }
+    return lit('}');
+  }
+
+private:
+  bool hex4(unsigned *cp) {
+    if (end_ - p_ < 4)
+      return false;
+    *cp = 0;
+    for (int i = 0; i < 4; i++) {
+      char c = *p_++;
+      int d = c >= '0' && c <= '9'   ? c - '0'
+              : c >= 'a' && c <= 'f' ? c - 'a' + 10
+              : c >= 'A' && c <= 'F' ? c - 'A' + 10
+                                     : -1;
+      if (d < 0)
+        return false;
+      *cp = *cp << 4 | d;
+    }
+    return true;
+  }
+
+  // Lone surrogates are kept as 3-byte sequences (WTF-8), see jsonQuote()
+  static void utf8(unsigned cp, std::string &out) {
+    if (cp < 0x80) {
+      out += (char)cp;
+    } else if (cp < 0x800) {
+      out += (char)(0xC0 | cp >> 6);
+      out += (char)(0x80 | (cp & 0x3F));
+    } else if (cp < 0x10000) {
+      out += (char)(0xE0 | cp >> 12);
+      out += (char)(0x80 | ((cp >> 6) & 0x3F));
+      out += (char)(0x80 | (cp & 0x3F));
+    } else {
+      out += (char)(0xF0 | cp >> 18);
+      out += (char)(0x80 | ((cp >> 12) & 0x3F));
+      out += (char)(0x80 | ((cp >> 6) & 0x3F));
+      out += (char)(0x80 | (cp & 0x3F));
+    }
+  }
+
+  const char *p_;
+  const char *end_;
+};
+
+} // namespace
+
+static std::string uidText(const Scalar &v) {
+  std::string out;
+  switch (v.type) {
+  case Scalar::Number:
+    return jsNumber(strtod(v.text.c_str(), nullptr));
+  case Scalar::String:
+    // {"$numberInt": "5"} etc. are numbers, a bare string stays a string
+    if (v.tag.compare(0, 7, "$number") == 0)
+      return jsNumber(strtod(v.text.c_str(), nullptr));
+    jsonQuote(v.text, out);
+    return out;
+  case Scalar::Bool:
+  case Scalar::Null:
+    return v.text;
+  default:
+    return out;
+  }
+}
+
+static bool timestampFrom(const Scalar &v, int64_t *ms) {
+  if (v.type == Scalar::Number ||
+      (v.type == Scalar::String && v.tag == "$date/$numberLong")) {
+    *ms = strtoll(v.text.c_str(), nullptr, 10);
+    return true;
+  }
+  return v.type == Scalar::String && parseIsoTimestamp(v.text, ms);
+}
+
+static void stringFrom(const Scalar &v, std::string *out, bool *has) {
+  *has = v.type == Scalar::String;
+  if (*has)
+    *out = v.text;
+}
+
+static bool parseJsonRecord(const char *p, const char *end, Record &r,
+                            std::string &err) {
+  r = Record();
+  JsonParser js(p, end);
+  if (!js.lit('{')) {
+    err = "expected an object";
+    return false;
+  }
+  if (js.lit('}'))
+    return true;
+  std::string key;
+  do {
+    if (!js.string(key) || !js.lit(':')) {
+      err = "bad object key";
+      return false;
+    }
+    Scalar v;
+    bool ok = true;
+    if (key == "_id" || key == "uid" || key == "timestamp" || key == "status" ||
+        key == "hash" || key == "previousHash")
+      ok = js.scalar(v);
+    else
+      ok = js.skip();
+    if (!ok) {
+      err = "bad value for '" + key + "'";
+      return false;
+    }
+
+    if (key == "_id") {
+      if (v.type == Scalar::String)
+        r.id = v.text;
+    } else if (key == "uid") {
+      r.uid = uidText(v);
+    } else if (key == "timestamp") {
+      r.hasTimestamp = timestampFrom(v, &r.timestampMs);
+    } else if (key == "status") {
+      stringFrom(v, &r.status, &r.hasStatus);
+    } else if (key == "hash") {
+      stringFrom(v, &r.hash, &r.hasHash);
+    } else if (key == "previousHash") {
+      stringFrom(v, &r.previousHash, &r.hasPreviousHash);
+    }
+  } while (js.lit(','));
+  if (!js.lit('}')) {
+    err = "expected '}'";
+    return false;
+  }
+  return true;
+}
+
+// ================== BSON ==================
+
+static int32_t le32(const char *p) {
+  const uint8_t *u = (const uint8_t *)p;
+  return (int32_t)(u[0] | u[1] << 8 | u[2] << 16 | (uint32_t)u[3] << 24);
+}
+
+static int64_t le64(const char *p) {
+  return (int64_t)((uint64_t)(uint32_t)le32(p) |
+                   (uint64_t)(uint32_t)le32(p + 4) << 32);
+}
+
+static bool parseBsonRecord(const char *p, const char *end, Record &r,
+                            std::string &err) {
+  r = Record();
+  p += 4;
+  end--; // trailing 0x00
+  while (p < end) {
+    uint8_t type = *p++;
+    const char *name = p;
+    while (p < end && *p)
+      p++;
+    if (p >= end) {
+      err = "truncated element name";
+      return false;
+    }
+    std::string key(name, p++);
+    const char *v = p;
+    int64_t size;
+    switch (type) {
+    case 0x01: case 0x09: case 0x11: case 0x12: size = 8; break;
+    case 0x02: case 0x0D: case 0x0E: size = end - p >= 4 ? 4 + le32(p) : -1; break;
+    case 0x03: case 0x04: case 0x0F: size = end - p >= 4 ? le32(p) : -1; break;
+    case 0x05: size = end - p >= 4 ? 5 + le32(p) : -1; break;
+    case 0x06: case 0x0A: case 0x7F: case 0xFF: size = 0; break;
+    case 0x07: size = 12; break;
+    case 0x08: size = 1; break;
+    case 0x0C: size = end - p >= 4 ? 16 + le32(p) : -1; break;
+    case 0x10: size = 4; break;
+    case 0x13: size = 16; break;
+    case 0x0B: {
+      const char *q = p;
+      for (int n = 0; n < 2 && q < end; q++)
+        n += !*q;
+      size = q - p;
+      break;
+    }
+    default:
+      err = "unknown BSON type";
+      return false;
+    }
+    if (size < 0 || size > end - p) {
+      err = "truncated element '" + key + "'";
+      return false;
+    }
+    p += size;
+
+    bool str = type == 0x02 && size >= 5;
+    std::string text = str ? std::string(v + 4, size - 5) : std::string();
+    if (key == "_id" && type == 0x07) {
+      r.id.resize(24);
+      toHex((const uint8_t *)v, 12, &r.id[0]);
+    } else if (key == "uid") {
+      if (type == 0x10)
+        r.uid = std::to_string(le32(v));
+      else if (type == 0x12)
+        r.uid = jsNumber((double)le64(v));
+      else if (type == 0x01) {
+        double d;
+        memcpy(&d, v, 8);
+        r.uid = jsNumber(d);
+      } else if (str)
+        jsonQuote(text, r.uid);
+    } else if (key == "timestamp" && type == 0x09) {
+      r.timestampMs = le64(v);
+      r.hasTimestamp = true;
+    } else if (key == "status" && str) {
+      r.status = text;
+      r.hasStatus = true;
+    } else if (key == "hash" && str) {
+      r.hash = text;
+      r.hasHash = true;
+    } else if (key == "previousHash" && str) {
+      r.previousHash = text;
+      r.hasPreviousHash = true;
+    }
+  }
+  return true;
+}
+
+// ================== Reader ==================
+
+RecordReader::RecordReader(FILE *f, Format format)
+    : f_(f), format_(format), buf_(1 << 20) {}
+
+bool RecordReader::fill() {
+  if (eof_)
+    return false;
+  if (pos_ > 0) {
+    memmove(buf_.data(), buf_.data() + pos_, len_ - pos_);
+    len_ -= pos_;
+    pos_ = 0;
+  }
+  if (len_ == buf_.size())
+    buf_.resize(buf_.size() * 2);
+  size_t n = fread(buf_.data() + len_, 1, buf_.size() - len_, f_);
+  if (n == 0)
+    eof_ = true;
+  len_ += n;
+  return n > 0;
+}
+
+bool RecordReader::next(Record &r) {
+  if (format_ == Auto) {
+    while (len_ - pos_ < 2 && fill()) {
+    }
+    // A BSON document of 123 bytes also starts with '{', but its second
+    // length byte is 0, which never appears in JSON text
+    const char *p = buf_.data() + pos_;
+    size_t n = len_ - pos_;
+    size_t i = 0;
+    while (i < n && strchr(" \t\r\n", p[i]))
+      i++;
+    format_ = i < n && (p[i] == '[' || (p[i] == '{' && i + 1 < n && p[i + 1]))
+                  ? Json
+                  : Bson;
+  }
+  bool ok = format_ == Json ? nextJson(r) : nextBson(r);
+  if (ok)
+    count_++;
+  return ok;
+}
+
+bool RecordReader::nextJson(Record &r) {
+  // Skip separators between records: whitespace, ',', '[' and ']'
+  for (;;) {
+    while (pos_ < len_ && strchr(" \t\r\n,[]", buf_[pos_]))
+      pos_++;
+    if (pos_ < len_)
+      break;
+    if (!fill())
+      return false;
+  }
+  if (buf_[pos_] != '{') {
+    err_ = "record " + std::to_string(count_) + ": expected '{'";
+    return false;
+  }
+
+  // Find the matching brace, reading more input as needed
+  size_t i = pos_;
+  int depth = 0;
+  bool inString = false, escape = false;
+  for (;;) {
+    for (; i < len_; i++) {
+      char c = buf_[i];
+      if (inString) {
+        if (escape)
+          escape = false;
+        else if (c == '\\')
+          escape = true;
+        else if (c == '"')
+          inString = false;
+      } else if (c == '"') {
+        inString = true;
+      } else if (c == '{') {
+        depth++;
+      } else if (c == '}' && --depth == 0) {
+        break;
+      }
+    }
+    if (i < len_)
+      break;
+    size_t off = i - pos_;
+    if (!fill()) {
+      err_ = "record " + std::to_string(count_) + ": truncated";
+      return false;
+    }
+    i = pos_ + off;
+  }
+
+  std::string err;
+  bool ok = parseJsonRecord(buf_.data() + pos_, buf_.data() + i + 1, r, err);
+  pos_ = i + 1;
+  if (!ok)
+    err_ = "record " + std::to_string(count_) + ": " + err;
+  return ok;
+}
+
+bool RecordReader::nextBson(Record &r) {
+  while (len_ - pos_ < 4)
+    if (!fill()) {
+      if (len_ != pos_)
+        err_ = "record " + std::to_string(count_) + ": truncated";
+      return false;
+    }
+  int32_t size = le32(buf_.data() + pos_);
+  if (size < 5) {
+    err_ = "record " + std::to_string(count_) + ": bad document size";
+    return false;
+  }
+  while (len_ - pos_ < (size_t)size)
+    if (!fill()) {
+      err_ = "record " + std::to_string(count_) + ": truncated";
+      return false;
+    }
+
+  std::string err;
+  const char *doc = buf_.data() + pos_;
+  pos_ += size;
+  if (!parseBsonRecord(doc, doc + size, r, err)) {
+    err_ = "record " + std::to_string(count_) + ": " + err;
+    return false;
+  }
+  return true;
+}
+
+// ================== Self test ==================
+
+bool selfTest(FILE *log) {
+  struct ShaVector {
+    const char *msg;
+    const char *hex;
+  };
+  static const ShaVector sha[] = {
+      {"", "e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855"},
+      {"abc",
+       "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad"},
+      {"abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq",
+       "248d6a61d20638b8e5c026930c3e6039a33ce45964ff2167f6ecedd419db06c1"},
+  };
+
+  // Expected createBlockHash() output: JSON.stringify() text and its digest
+  struct BlockVector {
+    const char *uid;
+    const char *timestamp;
+    const char *status;
+    const char *previousHash;
+    const char *json;
+    const char *hash;
+  };
+  static const BlockVector blocks[] = {
+      {"1", "2026-01-02T14:30:45.000Z", "In", "GENESIS_BLOCK", "{\"uid\":1,\"timestamp\":\"2026-01-02T14:30:45.000Z\",\"status\":\"In\",\"previousHash\":\"GENESIS_BLOCK\"}", "4c6090821a7813a829834b5e92499f963a17a205ea20a5e9ae969a02568477e4"},
+      {"42", "2026-01-02T21:30:45.5+07:00", "Out", "4c6090821a7813a829834b5e92499f963a17a205ea20a5e9ae969a02568477e4", "{\"uid\":42,\"timestamp\":\"2026-01-02T14:30:45.500Z\",\"status\":\"Out\",\"previousHash\":\"4c6090821a7813a829834b5e92499f963a17a205ea20a5e9ae969a02568477e4\"}", "35b677e62a74f4cb391b73b2f5d4707f63e49447036e2dea4b5668e8df8d9cff"},
+      {"7.0", "1969-12-31T23:59:59.999Z", "In", "", "{\"uid\":7,\"timestamp\":\"1969-12-31T23:59:59.999Z\",\"status\":\"In\",\"previousHash\":\"\"}", "6e3e8c0487da7d5c7a0d02d642da91986afd8be4d6366ba76735b223c6b21297"},
+      {"1.5e-7", "+010000-01-01T00:00:00Z", "Out", "35b677e62a74f4cb391b73b2f5d4707f63e49447036e2dea4b5668e8df8d9cff", "{\"uid\":1.5e-7,\"timestamp\":\"+010000-01-01T00:00:00.000Z\",\"status\":\"Out\",\"previousHash\":\"35b677e62a74f4cb391b73b2f5d4707f63e49447036e2dea4b5668e8df8d9cff\"}", "19069562cd2a37051d3d9369a5633ff2cd3cec24ea6e1ed1d5f6c7ed77d172a5"},
+      {"1e21", "2024-02-29T23:59:59.123456Z", "In", "35b677e62a74f4cb391b73b2f5d4707f63e49447036e2dea4b5668e8df8d9cff", "{\"uid\":1e+21,\"timestamp\":\"2024-02-29T23:59:59.123Z\",\"status\":\"In\",\"previousHash\":\"35b677e62a74f4cb391b73b2f5d4707f63e49447036e2dea4b5668e8df8d9cff\"}", "0464a375c37a11b6258498c81cec7158260024e920601686cd3efd7c969b3c5e"},
+      {"\"7\"", "2026-01-05T08:00:00Z", "In\"\\\n\x01\xc3\xa9" "\xe2\x80\xa8" "", "4c6090821a7813a829834b5e92499f963a17a205ea20a5e9ae969a02568477e4", "{\"uid\":\"7\",\"timestamp\":\"2026-01-05T08:00:00.000Z\",\"status\":\"In\\\"\\\\\\n\\u0001\xc3\xa9" "\xe2\x80\xa8" "\",\"previousHash\":\"4c6090821a7813a829834b5e92499f963a17a205ea20a5e9ae969a02568477e4\"}", "f5f9a530c1248212041c08dae017af6d831bd0b4e029f7486337217ffe0cde6a"},
+  };
+
+  bool ok = true;
+  for (const ShaVector &v : sha) {
+    std::string got = sha256Hex(v.msg);
+    if (got != v.hex) {
+      fprintf(log, "sha256(\"%s\") = %s, expected %s\n", v.msg, got.c_str(),
+              v.hex);
+      ok = false;
+    }
+  }
+  // 0..200 byte messages cover every padding case
+  std::string msg;
+  for (int i = 0; i <= 200; i++, msg += (char)('a' + i % 26)) {
+    ShaImpl impl = sha256Active();
+    sha256Select(ShaImpl::Portable);
+    std::string ref = sha256Hex(msg);
+    sha256Select(impl);
+    if (sha256Hex(msg) != ref) {
+      fprintf(log, "%s differs from portable at %d bytes\n",
+              sha256Name(impl), i);
+      ok = false;
+    }
+  }
+
+  for (const BlockVector &v : blocks) {
+    Record r;
+    JsonParser js(v.uid, v.uid + strlen(v.uid));
+    Scalar uid;
+    js.scalar(uid);
+    r.uid = uidText(uid);
+    r.hasTimestamp = parseIsoTimestamp(v.timestamp, &r.timestampMs);
+    r.status = v.status;
+    r.hasStatus = true;
+    r.previousHash = v.previousHash;
+    r.hasPreviousHash = true;
+    std::string json = canonicalBlock(r);
+    std::string hash = blockHash(r);
+    if (!r.hasTimestamp || json != v.json || hash != v.hash) {
+      fprintf(log, "block %s %s: got %s %s\n", v.uid, v.timestamp,
+              json.c_str(), hash.c_str());
+      ok = false;
+    }
+  }
+  return ok;
+}
+
+} // namespace chain
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include <string>
+#include <vector>
+
+// Attendance records as exported from MongoDB and the canonical block JSON
+// hashed by createBlockHash() in lib/blockchain.ts.
+
+namespace chain {
+
+struct Record {
+  std::string id;  // ObjectId hex, empty when absent
+  std::string uid; // JSON text of the uid value, empty when absent
+  int64_t timestampMs = 0;
+  bool hasTimestamp = false;
+  std::string status;
+  bool hasStatus = false;
+  std::string hash;
+  bool hasHash = false;
+  std::string previousHash;
+  bool hasPreviousHash = false;
+};
+
+// JSON.stringify({ uid, timestamp: timestamp.toISOString(), status,
+// previousHash }), byte for byte
+std::string canonicalBlock(const Record &r);
+std::string blockHash(const Record &r);
+
+// Date.prototype.toISOString()
+std::string isoTimestamp(int64_t ms);
+// ISO-8601 with optional fraction and Z / +hh:mm offset
+bool parseIsoTimestamp(const std::string &s, int64_t *ms);
+// Number.prototype.toString() for a finite double
+std::string jsNumber(double x);
+// JSON.stringify() of a string (without the surrounding record)
+void jsonQuote(const std::string &s, std::string &out);
+
+// Streams records from a mongoexport file (JSON lines or --jsonArray,
+// relaxed or canonical extended JSON) or a mongodump .bson file.
+class RecordReader {
+public:
+  enum Format { Auto, Json, Bson };
+
+  RecordReader(FILE *f, Format format);
+  // false at end of input or on a parse error (see error())
+  bool next(Record &r);
+  const std::string &error() const { return err_; }
+
+private:
+  bool fill();
+  bool nextJson(Record &r);
+  bool nextBson(Record &r);
+
+  FILE *f_;
+  Format format_;
+  std::vector<char> buf_;
+  size_t pos_ = 0;
+  size_t len_ = 0;
+  bool eof_ = false;
+  uint64_t count_ = 0;
+  std::string err_;
+};
+
+// Embedded vectors cross-checked against Node's createBlockHash()
+bool selfTest(FILE *log);
+
+} // namespace chain
@@ -0,0 +1,383 @@
+// chainverify: offline audit of the attendance hash chain.
+//
+// Reads a mongoexport (JSON lines / --jsonArray) or mongodump (.bson) dump
+// of the attendance collection in chain order and checks every block the
+// same way verifyChain() in lib/blockchain.ts does: previousHash must equal
+// the hash of the record before it, and hash must equal createBlockHash().
+//
+// A block hash only depends on the record's own fields, so records are
+// hashed in parallel batches; the links between batches are checked in
+// order when the batches are collected.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "ledger.h"
+#include "sha256.h"
+
+using namespace chain;
+
+static const size_t BATCH_RECORDS = 4096;
+static const char *GENESIS = "GENESIS_BLOCK";
+
+struct Batch {
+  uint64_t firstIndex = 0;
+  std::vector<Record> records;
+  // Filled by a worker
+  bool done = false;
+  long failAt = -1; // offset of the first bad record in this batch
+  const char *reason = nullptr;
+};
+
+struct Options {
+  std::vector<const char *> files;
+  RecordReader::Format format = RecordReader::Auto;
+  unsigned threads = 0;
+  uint64_t startIndex = 0;
+  std::string startHash = GENESIS;
+  bool quiet = false;
+};
+
+// Hash expected in the next record's previousHash, as in verifyChain()
+static const std::string &linkHash(const Record &r) {
+  static const std::string empty;
+  return r.hasHash ? r.hash : empty;
+}
+
+static void verifyBatch(Batch &b) {
+  for (size_t k = 0; k < b.records.size(); k++) {
+    const Record &r = b.records[k];
+    // The link of record 0 is checked by the collector
+    if (k > 0 && (!r.hasPreviousHash ||
+                  r.previousHash != linkHash(b.records[k - 1]))) {
+      b.failAt = k;
+      b.reason = "Previous hash mismatch";
+      return;
+    }
+    if (!r.hasTimestamp) {
+      b.failAt = k;
+      b.reason = "Missing timestamp";
+      return;
+    }
+    if (!r.hasHash || blockHash(r) != r.hash) {
+      b.failAt = k;
+      b.reason = "Hash mismatch";
+      return;
+    }
+  }
+}
+
+class Pipeline {
+public:
+  explicit Pipeline(unsigned threads) : maxQueued_(threads * 2 + 2) {
+    for (unsigned i = 0; i < threads; i++)
+      workers_.emplace_back([this] { work(); });
+  }
+
+  ~Pipeline() {
+    {
+      std::lock_guard<std::mutex> g(lock_);
+      closing_ = true;
+    }
+    pending_.notify_all();
+    for (std::thread &t : workers_)
+      t.join();
+  }
+
+  void push(std::unique_ptr<Batch> b) {
+    std::lock_guard<std::mutex> g(lock_);
+    todo_.push_back(b.get());
+    inFlight_.push_back(std::move(b));
+    pending_.notify_one();
+  }
+
+  // Oldest batch once it is verified. Waits for it while the queue is
+  // full (or, with all, while anything is in flight), otherwise returns
+  // null when it is not done yet.
+  std::unique_ptr<Batch> pop(bool all) {
+    std::unique_lock<std::mutex> lk(lock_);
+    size_t limit = all ? 1 : maxQueued_;
+    finished_.wait(lk, [this, limit] {
+      return inFlight_.size() < limit || inFlight_.front()->done;
+    });
+    if (inFlight_.empty() || !inFlight_.front()->done)
+      return nullptr;
+    std::unique_ptr<Batch> b = std::move(inFlight_.front());
+    inFlight_.pop_front();
+    return b;
+  }
+
+  void cancel() { cancelled_ = true; }
+
+private:
+  void work() {
+    for (;;) {
+      Batch *b;
+      {
+        std::unique_lock<std::mutex> lk(lock_);
+        pending_.wait(lk, [this] { return closing_ || !todo_.empty(); });
+        if (todo_.empty())
+          return;
+        b = todo_.front();
+        todo_.pop_front();
+      }
+      if (!cancelled_)
+        verifyBatch(*b);
+      {
+        std::lock_guard<std::mutex> g(lock_);
+        b->done = true;
+      }
+      finished_.notify_all();
+    }
+  }
+
+  const size_t maxQueued_;
+  std::mutex lock_;
+  std::condition_variable pending_, finished_;
+  std::deque<Batch *> todo_;
+  std::deque<std::unique_ptr<Batch>> inFlight_;
+  std::vector<std::thread> workers_;
+  bool closing_ = false;
+  std::atomic<bool> cancelled_{false};
+};
+
+struct Result {
+  uint64_t records = 0; // chain index verification got to
+  uint64_t total = 0;   // records in the export, counted past a break too
+  bool broken = false;
+  uint64_t brokenAt = 0;
+  Record invalid;
+  std::string reason;
+};
+
+// Checks batches in chain order; false once the chain is broken
+class Collector {
+public:
+  Collector(const Options &opt, Result &res)
+      : res_(res), lastHash_(opt.startHash) {
+    res_.records = opt.startIndex;
+  }
+
+  bool take(const Batch &b) {
+    if (res_.broken)
+      return false;
+    const Record &first = b.records.front();
+    if (!first.hasPreviousHash || first.previousHash != lastHash_)
+      return fail(b, 0, "Previous hash mismatch");
+    if (b.failAt >= 0)
+      return fail(b, b.failAt, b.reason);
+    lastHash_ = linkHash(b.records.back());
+    res_.records = b.firstIndex + b.records.size();
+    return true;
+  }
+
+private:
+  bool fail(const Batch &b, size_t k, const char *reason) {
+    res_.broken = true;
+    res_.brokenAt = b.firstIndex + k;
+    res_.records = res_.brokenAt;
+    res_.invalid = b.records[k];
+    res_.reason = reason;
+    return false;
+  }
+
+  Result &res_;
+  std::string lastHash_;
+};
+
+static void printResult(const Result &res, const Options &opt) {
+  std::string out = "{\"valid\":";
+  out += res.broken ? "false" : "true";
+  out += ",\"totalRecords\":" + std::to_string(res.total);
+  out += ",\"verifiedRecords\":" + std::to_string(res.records - opt.startIndex);
+  if (res.broken) {
+    const Record &r = res.invalid;
+    out += ",\"brokenAt\":" + std::to_string(res.brokenAt);
+    out += ",\"invalidRecord\":{\"_id\":";
+    jsonQuote(r.id, out);
+    out += ",\"uid\":" + (r.uid.empty() ? std::string("null") : r.uid);
+    out += ",\"timestamp\":";
+    if (r.hasTimestamp)
+      jsonQuote(isoTimestamp(r.timestampMs), out);
+    else
+      out += "null";
+    out += ",\"reason\":";
+    jsonQuote(res.reason, out);
+    out += "}";
+  }
+  out += "}";
+  puts(out.c_str());
+}
+
+static void usage() {
+  fprintf(stderr,
+          "usage: chainverify [options] FILE...   (- reads stdin)\n"
+          "       chainverify --hash UID TIMESTAMP STATUS PREVIOUS_HASH\n"
+          "       chainverify --self-test\n"
+          "\n"
+          "  -j N               worker threads (default: all cores)\n"
+          "  --format F         json or bson (default: detect)\n"
+          "  --start-index N    chain index of the first record in FILE\n"
+          "  --start-hash HASH  hash the first record links to\n"
+          "                     (default GENESIS_BLOCK)\n"
+          "  --portable         do not use SHA-NI\n"
+          "  -q                 no summary on stderr\n"
+          "\n"
+          "Files are read in the order given, each in chain order, e.g.\n"
+          "  mongoexport -c attendances --sort '{\"seq\":1}'\n"
+          "Exit status: 0 valid, 1 broken, 2 error.\n");
+}
+
+// --hash: print the block hash for one set of fields
+static int hashOne(char **argv) {
+  Record r;
+  // UID is JSON text: 5, 5.5 or "5"
+  r.uid = argv[0][0] == '"' ? std::string(argv[0]) : jsNumber(atof(argv[0]));
+  if (!parseIsoTimestamp(argv[1], &r.timestampMs)) {
+    fprintf(stderr, "chainverify: bad timestamp '%s'\n", argv[1]);
+    return 2;
+  }
+  r.hasTimestamp = true;
+  r.status = argv[2];
+  r.hasStatus = true;
+  r.previousHash = argv[3];
+  r.hasPreviousHash = true;
+  fprintf(stderr, "%s\n", canonicalBlock(r).c_str());
+  printf("%s\n", blockHash(r).c_str());
+  return 0;
+}
+
+static int verify(const Options &opt) {
+  unsigned threads = opt.threads;
+  if (!threads)
+    threads = std::max(1u, std::thread::hardware_concurrency());
+
+  auto started = std::chrono::steady_clock::now();
+  Result res;
+  Collector collector(opt, res);
+  Pipeline pipeline(threads);
+  uint64_t index = opt.startIndex;
+  bool ok = true, ioError = false;
+
+  auto drain = [&](bool all) {
+    while (std::unique_ptr<Batch> b = pipeline.pop(all))
+      if (!collector.take(*b)) {
+        ok = false;
+        pipeline.cancel();
+      }
+  };
+
+  for (const char *path : opt.files) {
+    bool stdinFile = !strcmp(path, "-");
+    FILE *f = stdinFile ? stdin : fopen(path, "rb");
+    if (!f) {
+      fprintf(stderr, "chainverify: cannot open %s\n", path);
+      ioError = true;
+      break;
+    }
+    RecordReader::Format format = opt.format;
+    size_t len = strlen(path);
+    if (format == RecordReader::Auto && len > 5 &&
+        !strcmp(path + len - 5, ".bson"))
+      format = RecordReader::Bson;
+    RecordReader reader(f, format);
+
+    std::unique_ptr<Batch> batch;
+    Record r;
+    while (reader.next(r)) {
+      if (!ok) {
+        // Chain broken: the rest is only counted, like /api/verify-chain
+        index++;
+        continue;
+      }
+      if (!batch) {
+        batch.reset(new Batch);
+        batch->firstIndex = index;
+        batch->records.reserve(BATCH_RECORDS);
+      }
+      batch->records.push_back(std::move(r));
+      index++;
+      if (batch->records.size() == BATCH_RECORDS) {
+        pipeline.push(std::move(batch));
+        drain(false);
+      }
+    }
+    if (ok && batch)
+      pipeline.push(std::move(batch));
+    if (!reader.error().empty()) {
+      fprintf(stderr, "chainverify: %s: %s\n", path, reader.error().c_str());
+      ioError = true;
+    }
+    if (!stdinFile)
+      fclose(f);
+    if (ioError)
+      break;
+  }
+  drain(true);
+  res.total = index;
+
+  double secs = std::chrono::duration<double>(
+                    std::chrono::steady_clock::now() - started)
+                    .count();
+  if (ioError && !res.broken)
+    return 2;
+  printResult(res, opt);
+  if (!opt.quiet) {
+    uint64_t n = res.records - opt.startIndex;
+    fprintf(stderr, "%llu records in %.2f s (%.0f/s), %u threads, %s\n",
+            (unsigned long long)n, secs, secs > 0 ? n / secs : 0.0, threads,
+            sha256Name(sha256Active()));
+  }
+  return res.broken ? 1 : 0;
+}
+
+int main(int argc, char **argv) {
+  Options opt;
+  for (int i = 1; i < argc; i++) {
+    const char *a = argv[i];
+    bool more = i + 1 < argc;
+    if (!strcmp(a, "--self-test")) {
+      bool ok = selfTest(stderr);
+      fprintf(stderr, "self-test %s (%s)\n", ok ? "passed" : "FAILED",
+              sha256Name(sha256Active()));
+      return ok ? 0 : 1;
+    } else if (!strcmp(a, "--hash") && i + 4 < argc) {
+      return hashOne(argv + i + 1);
+    } else if (!strcmp(a, "-j") && more) {
+      opt.threads = atoi(argv[++i]);
+    } else if (!strcmp(a, "--format") && more) {
+      const char *f = argv[++i];
+      opt.format = !strcmp(f, "bson") ? RecordReader::Bson : RecordReader::Json;
+    } else if (!strcmp(a, "--start-index") && more) {
+      opt.startIndex = strtoull(argv[++i], nullptr, 10);
+    } else if (!strcmp(a, "--start-hash") && more) {
+      opt.startHash = argv[++i];
+    } else if (!strcmp(a, "--portable")) {
+      sha256Select(ShaImpl::Portable);
+    } else if (!strcmp(a, "-q")) {
+      opt.quiet = true;
+    } else if (a[0] == '-' && a[1]) {
+      usage();
+      return 2;
+    } else {
+      opt.files.push_back(a);
+    }
+  }
+  if (opt.files.empty()) {
+    usage();
+    return 2;
+  }
+  return verify(opt);
+}
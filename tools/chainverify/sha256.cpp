@@ -0,0 +1,214 @@
+#include "sha256.h"
+
+#include <string.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define CHAIN_X86 1
+#include <cpuid.h>
+#include <immintrin.h>
+#endif
+
+namespace chain {
+
+static const uint32_t K[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1,
+    0x923f82a4, 0xab1c5ed5, 0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3,
+    0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174, 0xe49b69c1, 0xefbe4786,
+    0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147,
+    0x06ca6351, 0x14292967, 0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13,
+    0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85, 0xa2bfe8a1, 0xa81a664b,
+    0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a,
+    0x5b9cca4f, 0x682e6ff3, 0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208,
+    0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2};
+
+static const uint32_t H0[8] = {0x6a09e667, 0xbb67ae85, 0x3c6ef372,
+                               0xa54ff53a, 0x510e527f, 0x9b05688c,
+                               0x1f83d9ab, 0x5be0cd19};
+
+typedef void (*CompressFn)(uint32_t state[8], const uint8_t *data,
+                           size_t blocks);
+
+static inline uint32_t rotr(uint32_t x, int n) {
+  return (x >> n) | (x << (32 - n));
+}
+
+static void compressPortable(uint32_t state[8], const uint8_t *data,
+                             size_t blocks) {
+  uint32_t w[64];
+  for (; blocks--; data += 64) {
+    for (int i = 0; i < 16; i++)
+      w[i] = (uint32_t)data[4 * i] << 24 | (uint32_t)data[4 * i + 1] << 16 |
+             (uint32_t)data[4 * i + 2] << 8 | data[4 * i + 3];
+    for (int i = 16; i < 64; i++) {
+      uint32_t s0 = rotr(w[i - 15], 7) ^ rotr(w[i - 15], 18) ^ (w[i - 15] >> 3);
+      uint32_t s1 = rotr(w[i - 2], 17) ^ rotr(w[i - 2], 19) ^ (w[i - 2] >> 10);
+      w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+    }
+
+    uint32_t a = state[0], b = state[1], c = state[2], d = state[3];
+    uint32_t e = state[4], f = state[5], g = state[6], h = state[7];
+    for (int i = 0; i < 64; i++) {
+      uint32_t t1 = h + (rotr(e, 6) ^ rotr(e, 11) ^ rotr(e, 25)) +
+                    ((e & f) ^ (~e & g)) + K[i] + w[i];
+      uint32_t t2 = (rotr(a, 2) ^ rotr(a, 13) ^ rotr(a, 22)) +
+                    ((a & b) ^ (a & c) ^ (b & c));
+      h = g;
+      g = f;
+      f = e;
+      e = d + t1;
+      d = c;
+      c = b;
+      b = a;
+      a = t1 + t2;
+    }
+    state[0] += a;
+    state[1] += b;
+    state[2] += c;
+    state[3] += d;
+    state[4] += e;
+    state[5] += f;
+    state[6] += g;
+    state[7] += h;
+  }
+}
+
+#ifdef CHAIN_X86
+// SHA-NI: four rounds per pair of sha256rnds2, the message schedule for
+// group g is finished by sha256msg1 at g - 3 and sha256msg2 at g - 1.
+__attribute__((target("sha,sse4.1,ssse3"))) static void
+compressShaNi(uint32_t state[8], const uint8_t *data, size_t blocks) {
+  const __m128i mask =
+      _mm_set_epi64x(0x0c0d0e0f08090a0bULL, 0x0405060700010203ULL);
+
+  // Working order is ABEF / CDGH
+  __m128i tmp = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i *)&state[0]),
+                                  0xB1); // CDAB
+  __m128i state1 = _mm_shuffle_epi32(
+      _mm_loadu_si128((const __m128i *)&state[4]), 0x1B); // EFGH
+  __m128i state0 = _mm_alignr_epi8(tmp, state1, 8);       // ABEF
+  state1 = _mm_blend_epi16(state1, tmp, 0xF0);            // CDGH
+
+  for (; blocks--; data += 64) {
+    __m128i abef = state0, cdgh = state1;
+    __m128i m[4];
+    for (int i = 0; i < 16; i++) {
+      if (i < 4)
+        m[i] = _mm_shuffle_epi8(
+            _mm_loadu_si128((const __m128i *)(data + 16 * i)), mask);
+      __m128i msg =
+          _mm_add_epi32(m[i & 3], _mm_loadu_si128((const __m128i *)&K[4 * i]));
+      state1 = _mm_sha256rnds2_epu32(state1, state0, msg);
+      if (i >= 3 && i < 15) {
+        __m128i &next = m[(i + 1) & 3];
+        next = _mm_add_epi32(next, _mm_alignr_epi8(m[i & 3], m[(i + 3) & 3], 4));
+        next = _mm_sha256msg2_epu32(next, m[i & 3]);
+      }
+      msg = _mm_shuffle_epi32(msg, 0x0E);
+      state0 = _mm_sha256rnds2_epu32(state0, state1, msg);
+      if (i >= 1 && i < 13)
+        m[(i + 3) & 3] = _mm_sha256msg1_epu32(m[(i + 3) & 3], m[i & 3]);
+    }
+    state0 = _mm_add_epi32(state0, abef);
+    state1 = _mm_add_epi32(state1, cdgh);
+  }
+
+  tmp = _mm_shuffle_epi32(state0, 0x1B);           // FEBA
+  state1 = _mm_shuffle_epi32(state1, 0xB1);        // DCHG
+  state0 = _mm_blend_epi16(tmp, state1, 0xF0);     // DCBA
+  state1 = _mm_alignr_epi8(state1, tmp, 8);        // HGFE
+  _mm_storeu_si128((__m128i *)&state[0], state0);
+  _mm_storeu_si128((__m128i *)&state[4], state1);
+}
+
+static bool cpuHasShaNi() {
+  unsigned a, b, c, d;
+  if (!__get_cpuid(1, &a, &b, &c, &d))
+    return false;
+  bool sse41 = c & (1u << 19), ssse3 = c & (1u << 9);
+  if (!__get_cpuid_count(7, 0, &a, &b, &c, &d))
+    return false;
+  return sse41 && ssse3 && (b & (1u << 29));
+}
+#endif
+
+ShaImpl sha256Detect() {
+#ifdef CHAIN_X86
+  if (cpuHasShaNi())
+    return ShaImpl::ShaNi;
+#endif
+  return ShaImpl::Portable;
+}
+
+static ShaImpl active = sha256Detect();
+static CompressFn compress =
+#ifdef CHAIN_X86
+    active == ShaImpl::ShaNi ? compressShaNi :
+#endif
+                             compressPortable;
+
+void sha256Select(ShaImpl impl) {
+  if (impl == ShaImpl::ShaNi && sha256Detect() != ShaImpl::ShaNi)
+    impl = ShaImpl::Portable;
+  active = impl;
+#ifdef CHAIN_X86
+  if (impl == ShaImpl::ShaNi) {
+    compress = compressShaNi;
+    return;
+  }
+#endif
+  compress = compressPortable;
+}
+
+ShaImpl sha256Active() { return active; }
+
+const char *sha256Name(ShaImpl impl) {
+  return impl == ShaImpl::ShaNi ? "sha-ni" : "portable";
+}
+
+void sha256(const void *data, size_t len, uint8_t out[32]) {
+  uint32_t state[8];
+  memcpy(state, H0, sizeof(state));
+
+  const uint8_t *p = (const uint8_t *)data;
+  size_t full = len / 64;
+  if (full)
+    compress(state, p, full);
+
+  // Padding: 0x80, zeros, 64-bit big-endian bit length
+  uint8_t tail[128] = {0};
+  size_t rest = len - full * 64;
+  memcpy(tail, p + full * 64, rest);
+  tail[rest] = 0x80;
+  size_t tailBlocks = rest + 9 > 64 ? 2 : 1;
+  uint64_t bits = (uint64_t)len * 8;
+  for (int i = 0; i < 8; i++)
+    tail[tailBlocks * 64 - 1 - i] = (uint8_t)(bits >> (8 * i));
+  compress(state, tail, tailBlocks);
+
+  for (int i = 0; i < 8; i++) {
+    out[4 * i] = state[i] >> 24;
+    out[4 * i + 1] = state[i] >> 16;
+    out[4 * i + 2] = state[i] >> 8;
+    out[4 * i + 3] = state[i];
+  }
+}
+
+void toHex(const uint8_t *bytes, size_t len, char *out) {
+  static const char digits[] = "0123456789abcdef";
+  for (size_t i = 0; i < len; i++) {
+    out[2 * i] = digits[bytes[i] >> 4];
+    out[2 * i + 1] = digits[bytes[i] & 15];
+  }
+}
+
+std::string sha256Hex(const std::string &data) {
+  uint8_t digest[32];
+  sha256(data.data(), data.size(), digest);
+  std::string hex(64, '0');
+  toHex(digest, 32, &hex[0]);
+  return hex;
+}
+
+} // namespace chain
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <string>
+
+// SHA-256 with a portable implementation and an x86 SHA-NI one, picked at
+// run time. Only one-shot hashing is needed: every block is hashed from a
+// short canonical JSON string.
+
+namespace chain {
+
+enum class ShaImpl { Portable, ShaNi };
+
+// Best implementation this CPU supports
+ShaImpl sha256Detect();
+// Force an implementation (falls back to portable when unsupported)
+void sha256Select(ShaImpl impl);
+ShaImpl sha256Active();
+const char *sha256Name(ShaImpl impl);
+
+void sha256(const void *data, size_t len, uint8_t out[32]);
+// Lowercase hex digest, same as crypto.createHash('sha256').digest('hex')
+std::string sha256Hex(const std::string &data);
+void toHex(const uint8_t *bytes, size_t len, char *out);
+
+} // namespace chain